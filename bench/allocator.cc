@@ -0,0 +1,313 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <benchmark/benchmark.h>
+#include <pycpp/allocator/fixed_pool.h>
+#include <pycpp/allocator/gc.h>
+#include <pycpp/allocator/micro.h>
+#include <pycpp/allocator/pool.h>
+#include <pycpp/allocator/standard.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/map.h>
+#include <pycpp/stl/unordered_map.h>
+#include <pycpp/stl/vector.h>
+
+PYCPP_USING_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr int ELEMENT_COUNT = 1 << 14;
+static constexpr int NODE_COUNT = 1 << 16;
+static constexpr int TEARDOWN_ITERATIONS = 64;
+
+// ALIAS
+// -----
+
+template <typename Allocator, typename T>
+using rebind_t = typename allocator_traits<Allocator>::template rebind_alloc<T>;
+
+template <typename Allocator>
+using list_t = std::list<int, rebind_t<Allocator, int>>;
+
+template <typename Allocator>
+using map_t = std::map<int, int, std::less<int>, rebind_t<Allocator, std::pair<const int, int>>>;
+
+template <typename Allocator>
+using unordered_map_t = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, rebind_t<Allocator, std::pair<const int, int>>>;
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Node of a binary search tree.
+ */
+struct tree_node
+{
+    tree_node* left;
+    tree_node* right;
+    int value;
+};
+
+
+/**
+ *  \brief Node of a cyclic graph, with edges from `Allocator`.
+ */
+template <typename Allocator>
+struct graph_node
+{
+    using allocator_type = rebind_t<Allocator, graph_node*>;
+
+    std::vector<graph_node*, allocator_type> edges;
+    int value;
+
+    graph_node(int v, const allocator_type& allocator = allocator_type()):
+        edges(allocator),
+        value(v)
+    {}
+};
+
+// HELPERS
+// -------
+
+
+template <typename Create>
+static tree_node* make_tree(int first, int last, Create& create)
+{
+    if (first >= last) {
+        return nullptr;
+    }
+    int middle = first + (last - first) / 2;
+    tree_node* left = make_tree(first, middle, create);
+    tree_node* right = make_tree(middle + 1, last, create);
+    return create(left, right, middle);
+}
+
+
+static void delete_tree(tree_node* node)
+{
+    if (node) {
+        delete_tree(node->left);
+        delete_tree(node->right);
+        delete node;
+    }
+}
+
+
+template <typename Node>
+static void connect_graph(vector<Node*>& nodes)
+{
+    size_t size = nodes.size();
+    for (size_t i = 0; i < size; ++i) {
+        nodes[i]->edges.push_back(nodes[(i + 1) % size]);
+        nodes[i]->edges.push_back(nodes[(i * 7919) % size]);
+        nodes[i]->edges.push_back(nodes[i / 2]);
+    }
+}
+
+// BENCHMARKS
+// ----------
+
+/**
+ *  \brief Fill a list, then drain it from both ends.
+ */
+template <typename Allocator>
+static void list_churn(benchmark::State& state)
+{
+    for (auto _ : state) {
+        list_t<Allocator> l;
+        for (int i = 0; i < ELEMENT_COUNT; ++i) {
+            l.push_back(i);
+        }
+        while (!l.empty()) {
+            l.pop_front();
+            if (!l.empty()) {
+                l.pop_back();
+            }
+        }
+        benchmark::DoNotOptimize(l);
+    }
+    state.SetItemsProcessed(state.iterations() * ELEMENT_COUNT);
+}
+
+
+/**
+ *  \brief Insert keys into an ordered map, then erase every other key.
+ */
+template <typename Allocator>
+static void map_churn(benchmark::State& state)
+{
+    for (auto _ : state) {
+        map_t<Allocator> m;
+        for (int i = 0; i < ELEMENT_COUNT; ++i) {
+            m.emplace((i * 7919) % ELEMENT_COUNT, i);
+        }
+        for (int i = 0; i < ELEMENT_COUNT; i += 2) {
+            m.erase(i);
+        }
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(state.iterations() * ELEMENT_COUNT);
+}
+
+
+/**
+ *  \brief Insert keys into a hash map, then erase every other key.
+ */
+template <typename Allocator>
+static void unordered_map_churn(benchmark::State& state)
+{
+    for (auto _ : state) {
+        unordered_map_t<Allocator> m;
+        for (int i = 0; i < ELEMENT_COUNT; ++i) {
+            m.emplace(i, i);
+        }
+        for (int i = 0; i < ELEMENT_COUNT; i += 2) {
+            m.erase(i);
+        }
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(state.iterations() * ELEMENT_COUNT);
+}
+
+
+/**
+ *  \brief Allocate slots from a bitmapped arena, then scan and free them.
+ */
+template <bool Bulk>
+static void fixed_pool_slots(benchmark::State& state)
+{
+    using arena_type = fixed_pool_arena<32>;
+    vector<void*> slots(ELEMENT_COUNT);
+    for (auto _ : state) {
+        arena_type arena;
+        if (Bulk) {
+            arena.allocate(slots.data(), slots.size());
+        } else {
+            for (void*& p: slots) {
+                p = arena.allocate();
+            }
+        }
+        size_t live = 0;
+        for (void* p: arena) {
+            benchmark::DoNotOptimize(p);
+            ++live;
+        }
+        arena.deallocate(slots.data(), slots.size());
+        benchmark::DoNotOptimize(live);
+    }
+    state.SetItemsProcessed(state.iterations() * ELEMENT_COUNT);
+}
+
+
+/**
+ *  \brief Tear down a large tree by deleting each node.
+ */
+static void tree_teardown_delete(benchmark::State& state)
+{
+    auto create = [](tree_node* left, tree_node* right, int value) {
+        return new tree_node {left, right, value};
+    };
+    for (auto _ : state) {
+        state.PauseTiming();
+        tree_node* root = make_tree(0, NODE_COUNT, create);
+        benchmark::DoNotOptimize(root);
+        state.ResumeTiming();
+        delete_tree(root);
+    }
+    state.SetItemsProcessed(state.iterations() * NODE_COUNT);
+}
+
+
+/**
+ *  \brief Tear down a large tree by retiring its epoch.
+ */
+static void tree_teardown_gc(benchmark::State& state)
+{
+    gc_arena<> arena;
+    auto create = [&arena](tree_node* left, tree_node* right, int value) {
+        return arena.create<tree_node>(tree_node {left, right, value});
+    };
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto epoch = arena.epoch();
+        tree_node* root = make_tree(0, NODE_COUNT, create);
+        benchmark::DoNotOptimize(root);
+        state.ResumeTiming();
+        arena.retire(epoch);
+    }
+    state.SetItemsProcessed(state.iterations() * NODE_COUNT);
+}
+
+
+/**
+ *  \brief Tear down a cyclic graph by deleting each node.
+ */
+static void graph_teardown_delete(benchmark::State& state)
+{
+    using node_type = graph_node<std::allocator<int>>;
+    vector<node_type*> nodes(NODE_COUNT);
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int i = 0; i < NODE_COUNT; ++i) {
+            nodes[i] = new node_type(i);
+        }
+        connect_graph(nodes);
+        state.ResumeTiming();
+        for (node_type* node: nodes) {
+            delete node;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * NODE_COUNT);
+}
+
+
+/**
+ *  \brief Tear down a cyclic graph by retiring its epoch.
+ */
+static void graph_teardown_gc(benchmark::State& state)
+{
+    using node_type = graph_node<gc_allocator<int>>;
+    using allocator_type = typename node_type::allocator_type;
+    gc_arena<> arena;
+    allocator_type allocator(arena);
+    vector<node_type*> nodes(NODE_COUNT);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto epoch = arena.epoch();
+        for (int i = 0; i < NODE_COUNT; ++i) {
+            nodes[i] = arena.create<node_type>(i, allocator);
+        }
+        connect_graph(nodes);
+        state.ResumeTiming();
+        arena.retire(epoch);
+    }
+    state.SetItemsProcessed(state.iterations() * NODE_COUNT);
+}
+
+// REGISTER
+// --------
+
+BENCHMARK_TEMPLATE(list_churn, standard_allocator<int>);
+BENCHMARK_TEMPLATE(list_churn, pool_unlocked_allocator<int>);
+BENCHMARK_TEMPLATE(list_churn, pool_locked_allocator<int>);
+BENCHMARK_TEMPLATE(list_churn, pool_lock_free_allocator<int>);
+BENCHMARK_TEMPLATE(list_churn, micro_allocator<int>);
+BENCHMARK_TEMPLATE(map_churn, standard_allocator<int>);
+BENCHMARK_TEMPLATE(map_churn, pool_unlocked_allocator<int>);
+BENCHMARK_TEMPLATE(map_churn, pool_locked_allocator<int>);
+BENCHMARK_TEMPLATE(map_churn, pool_lock_free_allocator<int>);
+BENCHMARK_TEMPLATE(map_churn, micro_allocator<int>);
+BENCHMARK_TEMPLATE(unordered_map_churn, standard_allocator<int>);
+BENCHMARK_TEMPLATE(unordered_map_churn, pool_unlocked_allocator<int>);
+BENCHMARK_TEMPLATE(unordered_map_churn, pool_locked_allocator<int>);
+BENCHMARK_TEMPLATE(unordered_map_churn, pool_lock_free_allocator<int>);
+BENCHMARK_TEMPLATE(unordered_map_churn, micro_allocator<int>);
+BENCHMARK_TEMPLATE(fixed_pool_slots, false);
+BENCHMARK_TEMPLATE(fixed_pool_slots, true);
+BENCHMARK(tree_teardown_delete)->Iterations(TEARDOWN_ITERATIONS);
+BENCHMARK(tree_teardown_gc)->Iterations(TEARDOWN_ITERATIONS);
+BENCHMARK(graph_teardown_delete)->Iterations(TEARDOWN_ITERATIONS);
+BENCHMARK(graph_teardown_gc)->Iterations(TEARDOWN_ITERATIONS);
+
+BENCHMARK_MAIN();
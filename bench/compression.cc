@@ -0,0 +1,349 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <benchmark/benchmark.h>
+#include <pycpp/compression/stream.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/fstream.h>
+#include <pycpp/stl/sstream.h>
+#include <pycpp/stl/string.h>
+#include <pycpp/stl/vector.h>
+#include <stdio.h>
+#include <string.h>
+
+PYCPP_USING_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t CORPUS_SIZE = 1 << 20;
+static const char* const TEMPORARY_PATH = "compression_bench.tmp";
+
+// CORPORA
+// -------
+
+enum corpus_type
+{
+    corpus_text = 0,
+    corpus_json,
+    corpus_numeric,
+    corpus_random,
+};
+
+
+/**
+ *  \brief Deterministic xorshift generator, so corpora are reproducible.
+ */
+struct xorshift64
+{
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t operator()()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+
+static const char* const WORDS[] = {
+    "the", "of", "and", "to", "in", "a", "is", "that", "for", "it",
+    "as", "was", "with", "be", "by", "on", "not", "he", "this", "are",
+    "or", "his", "from", "at", "which", "but", "have", "an", "had", "they",
+    "you", "were", "their", "one", "all", "we", "can", "her", "has", "there",
+    "been", "if", "more", "when", "will", "would", "who", "so", "no", "compression",
+    "stream", "buffer", "archive", "dictionary", "throughput", "window", "block", "entropy",
+    "software", "permission", "copyright", "license", "distribute", "warranty",
+};
+static constexpr size_t WORD_COUNT = sizeof(WORDS) / sizeof(const char*);
+
+
+static string make_text()
+{
+    // skew towards common words, approximating natural language
+    xorshift64 rng;
+    string data;
+    data.reserve(CORPUS_SIZE + 64);
+    for (size_t i = 1; data.size() < CORPUS_SIZE; ++i) {
+        size_t index = min(rng() % WORD_COUNT, rng() % WORD_COUNT);
+        data += WORDS[index];
+        data += (i % 12 == 0) ? ".\n" : " ";
+    }
+    data.resize(CORPUS_SIZE);
+
+    return data;
+}
+
+
+static string make_json()
+{
+    xorshift64 rng;
+    string data;
+    char buffer[256];
+    data.reserve(CORPUS_SIZE + 256);
+    data += "[\n";
+    for (size_t i = 0; data.size() < CORPUS_SIZE; ++i) {
+        uint64_t value = rng();
+        int length = snprintf(buffer, sizeof(buffer),
+            "  {\"id\": %zu, \"name\": \"user_%u\", \"active\": %s, \"score\": %u.%02u, \"tags\": [\"%s\", \"%s\"]},\n",
+            i, (unsigned) (value % 100000), (value & 1) ? "true" : "false",
+            (unsigned) ((value >> 8) % 1000), (unsigned) ((value >> 20) % 100),
+            WORDS[(value >> 32) % WORD_COUNT], WORDS[(value >> 40) % WORD_COUNT]);
+        data.append(buffer, length);
+    }
+    data.resize(CORPUS_SIZE);
+
+    return data;
+}
+
+
+static string make_numeric()
+{
+    // random walk of doubles, typical of sampled measurements
+    xorshift64 rng;
+    string data;
+    data.reserve(CORPUS_SIZE);
+    double value = 100.0;
+    while (data.size() < CORPUS_SIZE) {
+        value += (double) (rng() % 2001) / 1000.0 - 1.0;
+        char bytes[sizeof(double)];
+        memcpy(bytes, &value, sizeof(double));
+        data.append(bytes, sizeof(double));
+    }
+
+    return data;
+}
+
+
+static string make_random()
+{
+    xorshift64 rng;
+    string data;
+    data.reserve(CORPUS_SIZE);
+    while (data.size() < CORPUS_SIZE) {
+        uint64_t value = rng();
+        data.append((const char*) &value, sizeof(value));
+    }
+
+    return data;
+}
+
+
+static const string& corpus(int64_t type)
+{
+    static const string corpora[] = {
+        make_text(),
+        make_json(),
+        make_numeric(),
+        make_random(),
+    };
+    return corpora[type];
+}
+
+// HELPERS
+// -------
+
+static const char* corpus_name(int64_t type)
+{
+    static const char* const names[] = {"text", "json", "numeric", "random"};
+    return names[type];
+}
+
+
+/**
+ *  \brief Report throughput, in uncompressed bytes, and the compression ratio.
+ */
+static void report(benchmark::State& state, size_t uncompressed, size_t compressed)
+{
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(uncompressed));
+    state.counters["ratio"] = double(uncompressed) / double(max<size_t>(compressed, 1));
+    state.SetLabel(corpus_name(state.range(0)));
+}
+
+
+static void write_file(const char* path, const string& data)
+{
+    ofstream stream(path, ios_base::out | ios_base::binary);
+    stream.write(data.data(), data.size());
+}
+
+
+static void corpus_args(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t type = corpus_text; type <= corpus_random; ++type) {
+        bench->Args({type});
+    }
+}
+
+
+static void level_args(benchmark::internal::Benchmark* bench, const vector<int64_t>& levels)
+{
+    for (int64_t type = corpus_text; type <= corpus_random; ++type) {
+        for (int64_t level: levels) {
+            bench->Args({type, level});
+        }
+    }
+}
+
+// BENCHMARKS
+// ----------
+
+/**
+ *  \brief Define the one-shot and streaming benchmarks for a codec.
+ */
+#define CODEC_BENCHMARKS(name)                                                          \
+    static void name##_oneshot_compress(benchmark::State& state)                        \
+    {                                                                                   \
+        const string& data = corpus(state.range(0));                                    \
+        size_t compressed = 0;                                                          \
+        for (auto _ : state) {                                                          \
+            compressed = name##_compress(data).size();                                  \
+        }                                                                               \
+        report(state, data.size(), compressed);                                         \
+    }                                                                                   \
+                                                                                        \
+    static void name##_oneshot_decompress(benchmark::State& state)                      \
+    {                                                                                   \
+        const string& data = corpus(state.range(0));                                    \
+        string compressed = name##_compress(data);                                      \
+        for (auto _ : state) {                                                          \
+            benchmark::DoNotOptimize(name##_decompress(compressed));                    \
+        }                                                                               \
+        report(state, data.size(), compressed.size());                                  \
+    }                                                                                   \
+                                                                                        \
+    static void name##_oneshot_decompress_bound(benchmark::State& state)                \
+    {                                                                                   \
+        const string& data = corpus(state.range(0));                                    \
+        string compressed = name##_compress(data);                                      \
+        for (auto _ : state) {                                                          \
+            benchmark::DoNotOptimize(name##_decompress(compressed, data.size()));       \
+        }                                                                               \
+        report(state, data.size(), compressed.size());                                  \
+    }                                                                                   \
+                                                                                        \
+    static void name##_ostream_compress(benchmark::State& state)                        \
+    {                                                                                   \
+        const string& data = corpus(state.range(0));                                    \
+        int level = static_cast<int>(state.range(1));                                   \
+        size_t compressed = 0;                                                          \
+        for (auto _ : state) {                                                          \
+            ostringstream sink;                                                         \
+            {                                                                           \
+                name##_ostream stream(sink, level);                                     \
+                stream.write(data.data(), data.size());                                 \
+            }                                                                           \
+            compressed = static_cast<size_t>(sink.tellp());                             \
+        }                                                                               \
+        report(state, data.size(), compressed);                                         \
+    }                                                                                   \
+                                                                                        \
+    static void name##_istream_decompress(benchmark::State& state)                      \
+    {                                                                                   \
+        const string& data = corpus(state.range(0));                                    \
+        string compressed = name##_compress(data);                                      \
+        for (auto _ : state) {                                                          \
+            istringstream source(compressed);                                           \
+            ostringstream sink;                                                         \
+            name##_istream stream(source);                                              \
+            sink << stream.rdbuf();                                                     \
+            benchmark::DoNotOptimize(sink);                                             \
+        }                                                                               \
+        report(state, data.size(), compressed.size());                                  \
+    }                                                                                   \
+                                                                                        \
+    static void name##_detect_decompress(benchmark::State& state)                       \
+    {                                                                                   \
+        const string& data = corpus(state.range(0));                                    \
+        string compressed = name##_compress(data);                                      \
+        write_file(TEMPORARY_PATH, compressed);                                         \
+        for (auto _ : state) {                                                          \
+            ostringstream sink;                                                         \
+            decompressing_ifstream stream(TEMPORARY_PATH);                              \
+            sink << stream.rdbuf();                                                     \
+            benchmark::DoNotOptimize(sink);                                             \
+        }                                                                               \
+        ::remove(TEMPORARY_PATH);                                                       \
+        report(state, data.size(), compressed.size());                                  \
+    }
+
+
+/**
+ *  \brief Register the benchmarks for a codec, with the levels to test.
+ */
+#define REGISTER_CODEC_BENCHMARKS(name, ...)                                            \
+    BENCHMARK(name##_oneshot_compress)->Apply(corpus_args);                             \
+    BENCHMARK(name##_oneshot_decompress)->Apply(corpus_args);                           \
+    BENCHMARK(name##_oneshot_decompress_bound)->Apply(corpus_args);                     \
+    BENCHMARK(name##_ostream_compress)->Apply([](benchmark::internal::Benchmark* bench) { \
+        level_args(bench, {__VA_ARGS__});                                               \
+    });                                                                                 \
+    BENCHMARK(name##_istream_decompress)->Apply(corpus_args);                           \
+    BENCHMARK(name##_detect_decompress)->Apply(corpus_args)
+
+#if defined(HAVE_BZIP2)
+    CODEC_BENCHMARKS(bz2)
+#endif                  // HAVE_BZIP2
+
+#if defined(HAVE_ZLIB)
+    CODEC_BENCHMARKS(zlib)
+    CODEC_BENCHMARKS(gzip)
+#endif                  // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)
+    CODEC_BENCHMARKS(lzma)
+#endif                  // HAVE_LZMA
+
+#if defined(HAVE_BLOSC)
+
+static void blosc_oneshot_compress(benchmark::State& state)
+{
+    const string& data = corpus(state.range(0));
+    blosc_options options;
+    options.level = static_cast<int>(state.range(1));
+    size_t compressed = 0;
+    for (auto _ : state) {
+        compressed = blosc_compress(data, options).size();
+    }
+    report(state, data.size(), compressed);
+}
+
+
+static void blosc_oneshot_decompress(benchmark::State& state)
+{
+    const string& data = corpus(state.range(0));
+    string compressed = blosc_compress(data);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(blosc_decompress(compressed));
+    }
+    report(state, data.size(), compressed.size());
+}
+
+#endif                  // HAVE_BLOSC
+
+// REGISTER
+// --------
+
+#if defined(HAVE_BZIP2)
+    REGISTER_CODEC_BENCHMARKS(bz2, 1, 9);
+#endif                  // HAVE_BZIP2
+
+#if defined(HAVE_ZLIB)
+    REGISTER_CODEC_BENCHMARKS(zlib, 1, 6, 9);
+    REGISTER_CODEC_BENCHMARKS(gzip, 1, 6, 9);
+#endif                  // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)
+    REGISTER_CODEC_BENCHMARKS(lzma, 0, 6, 9);
+#endif                  // HAVE_LZMA
+
+#if defined(HAVE_BLOSC)
+    BENCHMARK(blosc_oneshot_compress)->Apply([](benchmark::internal::Benchmark* bench) {
+        level_args(bench, {1, 5, 9});
+    });
+    BENCHMARK(blosc_oneshot_decompress)->Apply(corpus_args);
+#endif                  // HAVE_BLOSC
+
+BENCHMARK_MAIN();
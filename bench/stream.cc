@@ -0,0 +1,316 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <benchmark/benchmark.h>
+#include <pycpp/filesystem.h>
+#include <pycpp/stream/random_access.h>
+#include <pycpp/stream/sequential.h>
+#include <pycpp/stl/fstream.h>
+#include <pycpp/stl/string.h>
+#include <pycpp/stl/vector.h>
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(HAVE_MMAP)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+
+PYCPP_USING_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t FILE_SIZE = 16 << 20;
+static constexpr size_t RECORD_SIZE = 64;
+static constexpr size_t RECORD_COUNT = 4096;
+static const char* const INPUT_PATH = "stream_bench_input.tmp";
+static const char* const OUTPUT_PATH = "stream_bench_output.tmp";
+
+// buffer size 0 benchmarks an adaptive buffer, starting from the default
+static const vector<int64_t> BUFFER_SIZES = {0, 512, 4096, 65536, 1 << 20};
+
+enum access_pattern
+{
+    access_pattern_sequential = 0,
+    access_pattern_strided,
+    access_pattern_random,
+};
+
+// HELPERS
+// -------
+
+
+/**
+ *  \brief Deterministic xorshift generator, so offsets are reproducible.
+ */
+struct xorshift64
+{
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t operator()()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+
+static const char* pattern_name(int64_t pattern)
+{
+    switch (pattern) {
+        case access_pattern_sequential:
+            return "sequential";
+        case access_pattern_strided:
+            return "strided";
+        case access_pattern_random:
+            return "random";
+        default:
+            return "unknown";
+    }
+}
+
+
+static void make_file()
+{
+    static bool created = false;
+    if (!created) {
+        string data(FILE_SIZE, '\0');
+        xorshift64 rng;
+        for (char& c: data) {
+            c = static_cast<char>(rng());
+        }
+        ofstream stream(INPUT_PATH, ios_base::out | ios_base::binary);
+        stream.write(data.data(), data.size());
+        atexit([]() { ::remove(INPUT_PATH); });
+        created = true;
+    }
+}
+
+
+static vector<streamoff> make_offsets(int64_t pattern)
+{
+    vector<streamoff> offsets;
+    xorshift64 rng;
+    for (size_t i = 0; i < RECORD_COUNT; ++i) {
+        switch (pattern) {
+            case access_pattern_strided:
+                offsets.push_back(static_cast<streamoff>(i * (FILE_SIZE / RECORD_COUNT)));
+                break;
+            case access_pattern_random:
+                offsets.push_back(static_cast<streamoff>(rng() % (FILE_SIZE - RECORD_SIZE)));
+                break;
+            default:
+                break;
+        }
+    }
+
+    return offsets;
+}
+
+
+template <typename Stream>
+static void configure(Stream& stream, int64_t size)
+{
+    stream.adaptive(size == 0);
+}
+
+
+static size_t buffer_size(int64_t size)
+{
+    return size == 0 ? DEFAULT_BUFFER_SIZE : static_cast<size_t>(size);
+}
+
+
+/**
+ *  \brief Drop the cached pages of a file, so reads hit the device.
+ */
+static void evict_file(const char* path)
+{
+#if defined(HAVE_MMAP) && defined(POSIX_FADV_DONTNEED)
+    int fd = ::open(path, O_RDONLY);
+    if (fd != -1) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#endif
+}
+
+
+/**
+ *  \brief Bytes of a file resident in the page cache, as if by `fincore`.
+ */
+static double cached_bytes(const char* path)
+{
+    double bytes = 0;
+#if defined(HAVE_MMAP)
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1) {
+        return bytes;
+    }
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    void* addr = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (addr != MAP_FAILED) {
+        size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        vector<unsigned char> pages((size + page - 1) / page);
+        if (::mincore(addr, size, pages.data()) == 0) {
+            for (unsigned char resident: pages) {
+                bytes += (resident & 1) ? page : 0;
+            }
+        }
+        ::munmap(addr, size);
+    }
+    ::close(fd);
+#endif
+    return bytes;
+}
+
+
+static void matrix_args(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t pattern = access_pattern_sequential; pattern <= access_pattern_random; ++pattern) {
+        for (int64_t size: BUFFER_SIZES) {
+            bench->Args({pattern, size});
+        }
+    }
+}
+
+
+static void write_args(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t size: BUFFER_SIZES) {
+        bench->Args({access_pattern_sequential, size});
+    }
+}
+
+// BENCHMARKS
+// ----------
+
+/**
+ *  \brief Read the file, or a set of records, for each buffer size.
+ */
+template <typename Stream>
+static void stream_read(benchmark::State& state)
+{
+    make_file();
+    int64_t pattern = state.range(0);
+    vector<streamoff> offsets = make_offsets(pattern);
+    char record[RECORD_SIZE];
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        Stream stream(INPUT_PATH, ios_base::in, buffer_size(state.range(1)));
+        configure(stream, state.range(1));
+        if (pattern == access_pattern_sequential) {
+            while (stream.read(record, RECORD_SIZE)) {
+                bytes += RECORD_SIZE;
+            }
+        } else {
+            for (streamoff offset: offsets) {
+                stream.seekg(offset);
+                stream.read(record, RECORD_SIZE);
+                bytes += RECORD_SIZE;
+            }
+        }
+        benchmark::DoNotOptimize(record);
+    }
+
+    state.SetBytesProcessed(int64_t(bytes));
+    state.SetLabel(pattern_name(pattern));
+}
+
+
+/**
+ *  \brief Read the file sequentially with direct I/O, bypassing the page cache.
+ */
+template <typename Stream>
+static void stream_read_direct(benchmark::State& state)
+{
+    make_file();
+    char record[RECORD_SIZE];
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        evict_file(INPUT_PATH);
+        state.ResumeTiming();
+
+        Stream stream(INPUT_PATH, ios_base::in, buffer_size(state.range(1)));
+        configure(stream, state.range(1));
+        stream.direct(true);
+        while (stream.read(record, RECORD_SIZE)) {
+            bytes += RECORD_SIZE;
+        }
+        benchmark::DoNotOptimize(record);
+    }
+
+    state.SetBytesProcessed(int64_t(bytes));
+    state.counters["cached_bytes"] = cached_bytes(INPUT_PATH);
+    state.SetLabel("direct");
+}
+
+
+/**
+ *  \brief Write the file sequentially, in records, for each buffer size.
+ */
+template <typename Stream>
+static void stream_write(benchmark::State& state)
+{
+    char record[RECORD_SIZE] = {};
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        Stream stream(OUTPUT_PATH, ios_base::out, buffer_size(state.range(1)));
+        configure(stream, state.range(1));
+        for (size_t i = 0; i < FILE_SIZE / RECORD_SIZE; ++i) {
+            stream.write(record, RECORD_SIZE);
+        }
+        bytes += FILE_SIZE;
+    }
+    state.counters["cached_bytes"] = cached_bytes(OUTPUT_PATH);
+    ::remove(OUTPUT_PATH);
+
+    state.SetBytesProcessed(int64_t(bytes));
+    state.SetLabel(pattern_name(access_pattern_sequential));
+}
+
+
+/**
+ *  \brief Write the file sequentially with direct I/O, bypassing the page cache.
+ */
+template <typename Stream>
+static void stream_write_direct(benchmark::State& state)
+{
+    char record[RECORD_SIZE] = {};
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        Stream stream(OUTPUT_PATH, ios_base::out, buffer_size(state.range(1)));
+        configure(stream, state.range(1));
+        stream.direct(true);
+        for (size_t i = 0; i < FILE_SIZE / RECORD_SIZE; ++i) {
+            stream.write(record, RECORD_SIZE);
+        }
+        bytes += FILE_SIZE;
+    }
+    state.counters["cached_bytes"] = cached_bytes(OUTPUT_PATH);
+    ::remove(OUTPUT_PATH);
+
+    state.SetBytesProcessed(int64_t(bytes));
+    state.SetLabel("direct");
+}
+
+// REGISTER
+// --------
+
+BENCHMARK_TEMPLATE(stream_read, sequential_ifstream)->Apply(matrix_args);
+BENCHMARK_TEMPLATE(stream_read, random_access_ifstream)->Apply(matrix_args);
+BENCHMARK_TEMPLATE(stream_write, sequential_ofstream)->Apply(write_args);
+BENCHMARK_TEMPLATE(stream_write, random_access_ofstream)->Apply(write_args);
+BENCHMARK_TEMPLATE(stream_read_direct, sequential_ifstream)->Apply(write_args);
+BENCHMARK_TEMPLATE(stream_write_direct, sequential_ofstream)->Apply(write_args);
+
+BENCHMARK_MAIN();
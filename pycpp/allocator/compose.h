@@ -0,0 +1,714 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Allocator combinators for composing allocation strategies.
+ *
+ *  Combinators build an allocator from other allocators, to tune
+ *  the allocation strategy for a container without writing a new
+ *  allocator:
+ *
+ *  - `segregator` routes requests up to `Threshold` bytes to one
+ *    allocator, and larger requests to another.
+ *  - `fallback_allocator` allocates from a primary allocator, and
+ *    from a secondary allocator if the primary is exhausted.
+ *  - `bucketizer` holds an allocator per size class, for requests
+ *    in `(Min, Max]` bytes, and rounds each request up to the upper
+ *    bound of its size class.
+ *
+ *  Combinators are allocators themselves, so they nest, and may be
+ *  used as a memory resource through `resource_adaptor`. For example,
+ *  the following allocates small requests from the stack, then the
+ *  C runtime:
+ *
+ *  \code
+ *      using small = linear_allocator<int, 4096>;
+ *      using large = crt_allocator<int>;
+ *      using allocator = segregator<256, fallback_allocator<small, large>, large>;
+ *  \endcode
+ *
+ *  Allocators may support non-throwing allocation through a
+ *  `try_allocate(n)` member, which returns null on failure. The
+ *  primary allocator of a `fallback_allocator` must provide an
+ *  `owns(p, n)` member, to check if it allocated `p`. Combinators
+ *  only provide `owns(p, n)` if every child allocator does.
+ *
+ *  \synopsis
+ *      template <typename Allocator>
+ *      struct allocator_has_try_allocate;
+ *
+ *      template <typename Allocator>
+ *      struct allocator_has_owns;
+ *
+ *      template <typename Allocator>
+ *      value_type* allocator_try_allocate(Allocator& allocator, size_t n) noexcept;
+ *
+ *      template <typename Allocator>
+ *      bool allocator_owns(const Allocator& allocator, const value_type* p, size_t n) noexcept;
+ *
+ *      template <size_t Threshold, typename Small, typename Large>
+ *      class segregator
+ *      {
+ *      public:
+ *          static constexpr size_t threshold = Threshold;
+ *          using value_type = typename allocator_traits<Small>::value_type;
+ *          using small_type = Small;
+ *          using large_type = Large;
+ *
+ *          segregator();
+ *          segregator(const small_type& small, const large_type& large);
+ *          template <typename S1, typename L1> segregator(const segregator<Threshold, S1, L1>&);
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          value_type* try_allocate(size_t n) noexcept;
+ *          void deallocate(value_type* p, size_t n);
+ *          bool owns(const value_type* p, size_t n) const noexcept;
+ *
+ *          small_type& small() noexcept;
+ *          large_type& large() noexcept;
+ *      };
+ *
+ *      template <typename Primary, typename Secondary>
+ *      class fallback_allocator
+ *      {
+ *      public:
+ *          using value_type = typename allocator_traits<Primary>::value_type;
+ *          using primary_type = Primary;
+ *          using secondary_type = Secondary;
+ *
+ *          fallback_allocator();
+ *          fallback_allocator(const primary_type& primary, const secondary_type& secondary);
+ *          template <typename P1, typename S1> fallback_allocator(const fallback_allocator<P1, S1>&);
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          value_type* try_allocate(size_t n) noexcept;
+ *          void deallocate(value_type* p, size_t n);
+ *          bool owns(const value_type* p, size_t n) const noexcept;
+ *
+ *          primary_type& primary() noexcept;
+ *          secondary_type& secondary() noexcept;
+ *      };
+ *
+ *      template <typename Allocator, size_t Min, size_t Max, size_t Step>
+ *      class bucketizer
+ *      {
+ *      public:
+ *          static constexpr size_t min_size = Min;
+ *          static constexpr size_t max_size = Max;
+ *          static constexpr size_t step = Step;
+ *          static constexpr size_t bucket_count = (Max - Min) / Step;
+ *          using value_type = typename allocator_traits<Allocator>::value_type;
+ *          using allocator_type = Allocator;
+ *
+ *          bucketizer();
+ *          explicit bucketizer(const allocator_type& allocator);
+ *          template <typename A1> bucketizer(const bucketizer<A1, Min, Max, Step>&);
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          value_type* try_allocate(size_t n) noexcept;
+ *          void deallocate(value_type* p, size_t n);
+ *          bool owns(const value_type* p, size_t n) const noexcept;
+ *
+ *          allocator_type& bucket(size_t i) noexcept;
+ *      };
+ */
+
+#pragma once
+
+#include <pycpp/misc/compressed_pair.h>
+#include <pycpp/stl/limits.h>
+#include <pycpp/stl/memory.h>
+#include <pycpp/stl/type_traits.h>
+#include <pycpp/stl/utility.h>
+#include <assert.h>
+#include <stddef.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// FORWARD
+// -------
+
+template <size_t Threshold, typename Small, typename Large>
+class segregator;
+
+template <typename Primary, typename Secondary>
+class fallback_allocator;
+
+template <typename Allocator, size_t Min, size_t Max, size_t Step>
+class bucketizer;
+
+// TRAITS
+// ------
+
+template <typename Allocator, typename = void>
+struct allocator_has_try_allocate: false_type
+{};
+
+template <typename Allocator>
+struct allocator_has_try_allocate<Allocator, void_t<decltype(declval<Allocator&>().try_allocate(size_t()))>>: true_type
+{};
+
+template <typename Allocator, typename = void>
+struct allocator_has_owns: false_type
+{};
+
+template <typename Allocator>
+struct allocator_has_owns<Allocator, void_t<decltype(declval<const Allocator&>().owns(nullptr, size_t()))>>: true_type
+{};
+
+// FUNCTIONS
+// ---------
+
+template <typename Allocator>
+using allocator_pointer_t = typename allocator_traits<Allocator>::value_type*;
+
+template <typename Allocator>
+inline allocator_pointer_t<Allocator> allocator_try_allocate(Allocator& allocator, size_t n, true_type) noexcept
+{
+    return allocator.try_allocate(n);
+}
+
+
+template <typename Allocator>
+inline allocator_pointer_t<Allocator> allocator_try_allocate(Allocator& allocator, size_t n, false_type) noexcept
+{
+    try {
+        return allocator.allocate(n);
+    } catch (bad_alloc&) {
+        return nullptr;
+    }
+}
+
+
+/**
+ *  \brief Allocate `n` items, returning null on failure.
+ */
+template <typename Allocator>
+inline allocator_pointer_t<Allocator> allocator_try_allocate(Allocator& allocator, size_t n) noexcept
+{
+    return allocator_try_allocate(allocator, n, allocator_has_try_allocate<Allocator> {});
+}
+
+
+/**
+ *  \brief Check if `allocator` allocated `p`.
+ */
+template <typename Allocator>
+inline bool allocator_owns(const Allocator& allocator, const typename allocator_traits<Allocator>::value_type* p, size_t n) noexcept
+{
+    static_assert(allocator_has_owns<Allocator>::value, "Allocator must provide `owns(p, n)`.");
+    return allocator.owns(p, n);
+}
+
+// DECLARATIONS
+// ------------
+
+/**
+ *  \brief Route requests to an allocator by size.
+ */
+template <size_t Threshold, typename Small, typename Large>
+class segregator
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <typename U>
+    struct rebind
+    {
+        using other = segregator<
+            Threshold,
+            typename allocator_traits<Small>::template rebind_alloc<U>,
+            typename allocator_traits<Large>::template rebind_alloc<U>
+        >;
+    };
+
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr size_t threshold = Threshold;
+
+    // MEMBER TYPES
+    // ------------
+    using self_t = segregator<Threshold, Small, Large>;
+    using value_type = typename allocator_traits<Small>::value_type;
+    using small_type = Small;
+    using large_type = Large;
+    using propagate_on_container_move_assignment = true_type;
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    segregator() = default;
+    segregator(const self_t&) = default;
+    self_t& operator=(const self_t&) = default;
+    segregator(self_t&&) = default;
+    self_t& operator=(self_t&&) = default;
+
+    segregator(const small_type& small, const large_type& large):
+        data_(small, large)
+    {}
+
+    template <typename S1, typename L1>
+    segregator(const segregator<Threshold, S1, L1>& rhs):
+        data_(small_type(rhs.small()), large_type(rhs.large()))
+    {}
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        return is_small(n) ? small().allocate(n) : large().allocate(n);
+    }
+
+    value_type* try_allocate(size_t n) noexcept
+    {
+        return is_small(n) ? allocator_try_allocate(small(), n) : allocator_try_allocate(large(), n);
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        if (is_small(n)) {
+            small().deallocate(p, n);
+        } else {
+            large().deallocate(p, n);
+        }
+    }
+
+    template <typename S = Small, typename L = Large, enable_if_t<allocator_has_owns<S>::value && allocator_has_owns<L>::value, int> = 0>
+    bool owns(const value_type* p, size_t n) const noexcept
+    {
+        return is_small(n) ? allocator_owns(small(), p, n) : allocator_owns(large(), p, n);
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(value_type* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) value_type(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(value_type* p)
+    {
+        p->~value_type();
+    }
+
+    size_type max_size()
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // ALLOCATORS
+
+    small_type& small() noexcept
+    {
+        return data_.first();
+    }
+
+    const small_type& small() const noexcept
+    {
+        return data_.first();
+    }
+
+    large_type& large() noexcept
+    {
+        return data_.second();
+    }
+
+    const large_type& large() const noexcept
+    {
+        return data_.second();
+    }
+
+private:
+    compressed_pair<small_type, large_type> data_;
+
+    static bool is_small(size_t n) noexcept
+    {
+        return n <= Threshold / sizeof(value_type);
+    }
+
+    static_assert(is_same<value_type, typename allocator_traits<Large>::value_type>::value, "Allocators must have the same value type.");
+};
+
+
+/**
+ *  \brief Allocate from a secondary allocator when the primary fails.
+ */
+template <typename Primary, typename Secondary>
+class fallback_allocator
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <typename U>
+    struct rebind
+    {
+        using other = fallback_allocator<
+            typename allocator_traits<Primary>::template rebind_alloc<U>,
+            typename allocator_traits<Secondary>::template rebind_alloc<U>
+        >;
+    };
+
+    // MEMBER TYPES
+    // ------------
+    using self_t = fallback_allocator<Primary, Secondary>;
+    using value_type = typename allocator_traits<Primary>::value_type;
+    using primary_type = Primary;
+    using secondary_type = Secondary;
+    using propagate_on_container_move_assignment = true_type;
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    fallback_allocator() = default;
+    fallback_allocator(const self_t&) = default;
+    self_t& operator=(const self_t&) = default;
+    fallback_allocator(self_t&&) = default;
+    self_t& operator=(self_t&&) = default;
+
+    fallback_allocator(const primary_type& primary, const secondary_type& secondary):
+        data_(primary, secondary)
+    {}
+
+    template <typename P1, typename S1>
+    fallback_allocator(const fallback_allocator<P1, S1>& rhs):
+        data_(primary_type(rhs.primary()), secondary_type(rhs.secondary()))
+    {}
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        value_type* p = allocator_try_allocate(primary(), n);
+        return p ? p : secondary().allocate(n);
+    }
+
+    value_type* try_allocate(size_t n) noexcept
+    {
+        value_type* p = allocator_try_allocate(primary(), n);
+        return p ? p : allocator_try_allocate(secondary(), n);
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        if (allocator_owns(primary(), p, n)) {
+            primary().deallocate(p, n);
+        } else {
+            secondary().deallocate(p, n);
+        }
+    }
+
+    template <typename S = Secondary, enable_if_t<allocator_has_owns<S>::value, int> = 0>
+    bool owns(const value_type* p, size_t n) const noexcept
+    {
+        return allocator_owns(primary(), p, n) || allocator_owns(secondary(), p, n);
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(value_type* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) value_type(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(value_type* p)
+    {
+        p->~value_type();
+    }
+
+    size_type max_size()
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // ALLOCATORS
+
+    primary_type& primary() noexcept
+    {
+        return data_.first();
+    }
+
+    const primary_type& primary() const noexcept
+    {
+        return data_.first();
+    }
+
+    secondary_type& secondary() noexcept
+    {
+        return data_.second();
+    }
+
+    const secondary_type& secondary() const noexcept
+    {
+        return data_.second();
+    }
+
+private:
+    compressed_pair<primary_type, secondary_type> data_;
+
+    static_assert(allocator_has_owns<Primary>::value, "Primary allocator must provide `owns(p, n)`.");
+    static_assert(is_same<value_type, typename allocator_traits<Secondary>::value_type>::value, "Allocators must have the same value type.");
+};
+
+
+/**
+ *  \brief Hold an allocator per size class.
+ *
+ *  Bucket `i` allocates requests of `(Min + i*Step, Min + (i+1)*Step]`
+ *  bytes, each rounded up to the bucket's upper bound, so the bucket
+ *  only sees requests of a single size. Requests outside of
+ *  `(Min, Max]` bytes fail.
+ */
+template <typename Allocator, size_t Min, size_t Max, size_t Step>
+class bucketizer
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <typename U>
+    struct rebind
+    {
+        using other = bucketizer<typename allocator_traits<Allocator>::template rebind_alloc<U>, Min, Max, Step>;
+    };
+
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr size_t min_size = Min;
+    static constexpr size_t max_size = Max;
+    static constexpr size_t step = Step;
+    static constexpr size_t bucket_count = (Max - Min) / Step;
+
+    // MEMBER TYPES
+    // ------------
+    using self_t = bucketizer<Allocator, Min, Max, Step>;
+    using value_type = typename allocator_traits<Allocator>::value_type;
+    using allocator_type = Allocator;
+    using propagate_on_container_move_assignment = true_type;
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    bucketizer() = default;
+    bucketizer(const self_t&) = default;
+    self_t& operator=(const self_t&) = default;
+    bucketizer(self_t&&) = default;
+    self_t& operator=(self_t&&) = default;
+
+    explicit bucketizer(const allocator_type& allocator)
+    {
+        for (allocator_type& bucket: buckets_) {
+            bucket = allocator;
+        }
+    }
+
+    template <typename A1>
+    bucketizer(const bucketizer<A1, Min, Max, Step>& rhs)
+    {
+        for (size_t i = 0; i < bucket_count; ++i) {
+            buckets_[i] = allocator_type(rhs.bucket(i));
+        }
+    }
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        if (!in_range(n)) {
+            throw bad_alloc();
+        }
+        size_t i = index(n);
+        return buckets_[i].allocate(rounded(i));
+    }
+
+    value_type* try_allocate(size_t n) noexcept
+    {
+        if (!in_range(n)) {
+            return nullptr;
+        }
+        size_t i = index(n);
+        return allocator_try_allocate(buckets_[i], rounded(i));
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        assert(in_range(n) && "Request size out of range.");
+        size_t i = index(n);
+        buckets_[i].deallocate(p, rounded(i));
+    }
+
+    template <typename A = Allocator, enable_if_t<allocator_has_owns<A>::value, int> = 0>
+    bool owns(const value_type* p, size_t n) const noexcept
+    {
+        if (!in_range(n)) {
+            return false;
+        }
+        size_t i = index(n);
+        return allocator_owns(buckets_[i], p, rounded(i));
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(value_type* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) value_type(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(value_type* p)
+    {
+        p->~value_type();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // ALLOCATORS
+
+    allocator_type& bucket(size_t i) noexcept
+    {
+        assert(i < bucket_count && "Bucket out of range.");
+        return buckets_[i];
+    }
+
+    const allocator_type& bucket(size_t i) const noexcept
+    {
+        assert(i < bucket_count && "Bucket out of range.");
+        return buckets_[i];
+    }
+
+private:
+    allocator_type buckets_[bucket_count];
+
+    static bool in_range(size_t n) noexcept
+    {
+        return n <= Max / sizeof(value_type) && n * sizeof(value_type) > Min;
+    }
+
+    static size_t index(size_t n) noexcept
+    {
+        return (n * sizeof(value_type) - Min - 1) / Step;
+    }
+
+    static size_t rounded(size_t i) noexcept
+    {
+        return (Min + (i + 1) * Step + sizeof(value_type) - 1) / sizeof(value_type);
+    }
+
+    static_assert(Step > 0 && Max > Min && (Max - Min) % Step == 0, "Size classes must evenly divide (Min, Max].");
+};
+
+// SPECIALIZATION
+// --------------
+
+template <size_t T, typename S, typename L>
+struct is_relocatable<segregator<T, S, L>>: bool_constant<is_relocatable<S>::value && is_relocatable<L>::value>
+{};
+
+template <typename P, typename S>
+struct is_relocatable<fallback_allocator<P, S>>: bool_constant<is_relocatable<P>::value && is_relocatable<S>::value>
+{};
+
+template <typename A, size_t Min, size_t Max, size_t S>
+struct is_relocatable<bucketizer<A, Min, Max, S>>: is_relocatable<A>
+{};
+
+// IMPLEMENTATION
+// --------------
+
+template <size_t T, typename S, typename L>
+constexpr size_t segregator<T, S, L>::threshold;
+
+template <typename A, size_t Min, size_t Max, size_t S>
+constexpr size_t bucketizer<A, Min, Max, S>::min_size;
+
+template <typename A, size_t Min, size_t Max, size_t S>
+constexpr size_t bucketizer<A, Min, Max, S>::max_size;
+
+template <typename A, size_t Min, size_t Max, size_t S>
+constexpr size_t bucketizer<A, Min, Max, S>::step;
+
+template <typename A, size_t Min, size_t Max, size_t S>
+constexpr size_t bucketizer<A, Min, Max, S>::bucket_count;
+
+
+template <size_t T, typename S1, typename L1, typename S2, typename L2>
+inline bool operator==(const segregator<T, S1, L1>& lhs, const segregator<T, S2, L2>& rhs) noexcept
+{
+    return lhs.small() == rhs.small() && lhs.large() == rhs.large();
+}
+
+
+template <size_t T, typename S1, typename L1, typename S2, typename L2>
+inline bool operator!=(const segregator<T, S1, L1>& lhs, const segregator<T, S2, L2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+
+template <typename P1, typename S1, typename P2, typename S2>
+inline bool operator==(const fallback_allocator<P1, S1>& lhs, const fallback_allocator<P2, S2>& rhs) noexcept
+{
+    return lhs.primary() == rhs.primary() && lhs.secondary() == rhs.secondary();
+}
+
+
+template <typename P1, typename S1, typename P2, typename S2>
+inline bool operator!=(const fallback_allocator<P1, S1>& lhs, const fallback_allocator<P2, S2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+
+template <typename A1, typename A2, size_t Min, size_t Max, size_t S>
+inline bool operator==(const bucketizer<A1, Min, Max, S>& lhs, const bucketizer<A2, Min, Max, S>& rhs) noexcept
+{
+    for (size_t i = 0; i < lhs.bucket_count; ++i) {
+        if (lhs.bucket(i) != rhs.bucket(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template <typename A1, typename A2, size_t Min, size_t Max, size_t S>
+inline bool operator!=(const bucketizer<A1, Min, Max, S>& lhs, const bucketizer<A2, Min, Max, S>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+PYCPP_END_NAMESPACE
@@ -0,0 +1,445 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/fixed_pool.h>
+#include <pycpp/preprocessor/compiler.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/functional.h>
+#include <string.h>
+
+#if defined(HAVE_MSVC)
+#   include <intrin.h>
+#endif
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t WORD_BITS = 64;
+static constexpr uint64_t WORD_FULL = ~uint64_t(0);
+static constexpr size_t NPOS = SIZE_MAX;
+
+// HELPERS
+// -------
+
+
+static constexpr size_t align_up(size_t n, size_t alignment) noexcept
+{
+    return (n + (alignment-1)) & ~(alignment-1);
+}
+
+
+/**
+ *  \brief Count trailing zeros of a non-zero word.
+ */
+static inline unsigned ctz(uint64_t x) noexcept
+{
+#if defined(HAVE_GNUC)
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#elif defined(HAVE_MSVC) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<unsigned>(index);
+#else
+    unsigned n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+
+static inline unsigned popcnt(uint64_t x) noexcept
+{
+#if defined(HAVE_GNUC)
+    return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<unsigned>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
+/**
+ *  \brief Keep the `n` lowest set bits of `x`.
+ */
+static inline uint64_t lowest_bits(uint64_t x, size_t n) noexcept
+{
+    uint64_t r = 0;
+    for (; n; --n) {
+        r |= x & (~x + 1);
+        x &= x - 1;
+    }
+    return r;
+}
+
+// OBJECTS
+// -------
+
+
+fixed_pool_arena_base::fixed_pool_arena_base(size_t block_size, size_t block_count, size_t alignment, size_t max_size) noexcept:
+    block_size_(block_size),
+    block_count_(max_size < block_count ? align_up(max_size ? max_size : 1, WORD_BITS) : block_count),
+    words_(block_count_ / WORD_BITS),
+    offset_(align_up(sizeof(superblock) + words_ * sizeof(uint64_t), alignment)),
+    max_size_(max_size)
+{}
+
+
+fixed_pool_arena_base::~fixed_pool_arena_base() noexcept
+{
+    for (superblock* s: superblocks_) {
+        operator delete(s);
+    }
+}
+
+
+uint64_t* fixed_pool_arena_base::bitmap(superblock* s) const noexcept
+{
+    return reinterpret_cast<uint64_t*>(s + 1);
+}
+
+
+/**
+ *  \brief Get a superblock with a free slot, growing if all are full.
+ *
+ *  Every superblock before `hint_` is full, so slots are allocated
+ *  from the lowest superblock with a free slot.
+ */
+auto fixed_pool_arena_base::available() noexcept -> superblock*
+{
+    size_t count = superblocks_.size();
+    while (hint_ < count && superblocks_[hint_]->live == block_count_) {
+        ++hint_;
+    }
+    if (hint_ < count) {
+        return superblocks_[hint_];
+    }
+    return grow();
+}
+
+
+auto fixed_pool_arena_base::grow() noexcept -> superblock*
+{
+    void* p = operator new(offset_ + block_count_ * block_size_, std::nothrow);
+    if (!p) {
+        return nullptr;
+    }
+
+    superblock* s = static_cast<superblock*>(p);
+    s->data = static_cast<byte*>(p) + offset_;
+    s->live = 0;
+    s->first = 0;
+    memset(bitmap(s), 0, words_ * sizeof(uint64_t));
+
+    try {
+        auto it = upper_bound(superblocks_.begin(), superblocks_.end(), s, less<superblock*>());
+        size_t index = static_cast<size_t>(it - superblocks_.begin());
+        superblocks_.insert(it, s);
+        if (index <= hint_) {
+            hint_ = index;
+        }
+    } catch (...) {
+        operator delete(p);
+        return nullptr;
+    }
+
+    return s;
+}
+
+
+/**
+ *  \brief Claim the first free slot of a superblock with a free slot.
+ */
+void* fixed_pool_arena_base::take(superblock* s) noexcept
+{
+    uint64_t* words = bitmap(s);
+    size_t i = s->first;
+    while (words[i] == WORD_FULL) {
+        ++i;
+    }
+
+    unsigned bit = ctz(~words[i]);
+    words[i] |= uint64_t(1) << bit;
+    s->first = i;
+    ++s->live;
+
+    return s->data + (i * WORD_BITS + bit) * block_size_;
+}
+
+
+/**
+ *  \brief Claim up to `n` slots from a superblock, a word at a time.
+ */
+size_t fixed_pool_arena_base::take(superblock* s, void** p, size_t n) noexcept
+{
+    uint64_t* words = bitmap(s);
+    size_t count = 0;
+    for (size_t i = s->first; i < words_ && count < n; ++i) {
+        uint64_t free = ~words[i];
+        if (!free) {
+            continue;
+        }
+        if (popcnt(free) > n - count) {
+            free = lowest_bits(free, n - count);
+        }
+        words[i] |= free;
+
+        byte* data = s->data + i * WORD_BITS * block_size_;
+        for (; free; free &= free - 1) {
+            p[count++] = data + ctz(free) * block_size_;
+        }
+    }
+
+    while (s->first < words_ && words[s->first] == WORD_FULL) {
+        ++s->first;
+    }
+    s->live += count;
+
+    return count;
+}
+
+
+void fixed_pool_arena_base::release(size_t index, const void* p) noexcept
+{
+    superblock* s = superblocks_[index];
+    size_t offset = static_cast<size_t>(static_cast<const byte*>(p) - s->data);
+    assert(offset % block_size_ == 0 && "Pointer is not the start of a slot.");
+
+    size_t slot = offset / block_size_;
+    size_t i = slot / WORD_BITS;
+    uint64_t mask = uint64_t(1) << (slot % WORD_BITS);
+    uint64_t* words = bitmap(s);
+    assert((words[i] & mask) && "Slot is not allocated.");
+
+    words[i] &= ~mask;
+    --s->live;
+    --live_;
+    if (i < s->first) {
+        s->first = i;
+    }
+    if (index < hint_) {
+        hint_ = index;
+    }
+}
+
+
+/**
+ *  \brief Find the index of the superblock containing `p`, or NPOS.
+ */
+size_t fixed_pool_arena_base::find(const void* p) const noexcept
+{
+    const byte* b = static_cast<const byte*>(p);
+    auto it = upper_bound(superblocks_.begin(), superblocks_.end(), b, [](const byte* l, const superblock* r) {
+        return less<const byte*>()(l, r->data);
+    });
+    if (it == superblocks_.begin()) {
+        return NPOS;
+    }
+
+    size_t index = static_cast<size_t>(it - superblocks_.begin()) - 1;
+    return contains(index, p) ? index : NPOS;
+}
+
+
+bool fixed_pool_arena_base::contains(size_t index, const void* p) const noexcept
+{
+    const byte* b = static_cast<const byte*>(p);
+    const byte* data = superblocks_[index]->data;
+    return !less<const byte*>()(b, data) && less<const byte*>()(b, data + block_count_ * block_size_);
+}
+
+
+/**
+ *  \brief Move to the first live slot at or after `(index, slot)`.
+ */
+void fixed_pool_arena_base::advance(size_t& index, size_t& slot) const noexcept
+{
+    size_t count = superblocks_.size();
+    for (; index < count; ++index, slot = 0) {
+        superblock* s = superblocks_[index];
+        if (!s->live) {
+            continue;
+        }
+
+        uint64_t* words = bitmap(s);
+        size_t i = slot / WORD_BITS;
+        if (i >= words_) {
+            continue;
+        }
+        uint64_t live = words[i] & (WORD_FULL << (slot % WORD_BITS));
+        while (!live && ++i < words_) {
+            live = words[i];
+        }
+        if (live) {
+            slot = i * WORD_BITS + ctz(live);
+            return;
+        }
+    }
+    slot = 0;
+}
+
+
+void* fixed_pool_arena_base::try_allocate() noexcept
+{
+    if (live_ >= max_size_) {
+        return nullptr;
+    }
+
+    superblock* s = available();
+    if (!s) {
+        return nullptr;
+    }
+    ++live_;
+
+    return take(s);
+}
+
+
+void fixed_pool_arena_base::allocate(void** p, size_t n)
+{
+    if (n > max_size_ - live_) {
+        throw bad_alloc();
+    }
+
+    size_t count = 0;
+    while (count < n) {
+        superblock* s = available();
+        if (!s) {
+            deallocate(p, count);
+            throw bad_alloc();
+        }
+        size_t taken = take(s, p + count, n - count);
+        live_ += taken;
+        count += taken;
+    }
+}
+
+
+void fixed_pool_arena_base::deallocate(void* p) noexcept
+{
+    size_t index = find(p);
+    assert(index != NPOS && "Pointer not allocated from arena.");
+    release(index, p);
+}
+
+
+void fixed_pool_arena_base::deallocate(void* const* p, size_t n) noexcept
+{
+    // consecutive slots are likely from the same superblock
+    size_t index = NPOS;
+    for (size_t i = 0; i < n; ++i) {
+        if (index == NPOS || !contains(index, p[i])) {
+            index = find(p[i]);
+            assert(index != NPOS && "Pointer not allocated from arena.");
+        }
+        release(index, p[i]);
+    }
+}
+
+
+void fixed_pool_arena_base::reset() noexcept
+{
+    for (superblock* s: superblocks_) {
+        memset(bitmap(s), 0, words_ * sizeof(uint64_t));
+        s->live = 0;
+        s->first = 0;
+    }
+    live_ = 0;
+    hint_ = 0;
+}
+
+
+auto fixed_pool_arena_base::begin() const noexcept -> iterator
+{
+    size_t index = 0;
+    size_t slot = 0;
+    advance(index, slot);
+    return iterator(this, index, slot);
+}
+
+
+auto fixed_pool_arena_base::end() const noexcept -> iterator
+{
+    return iterator(this, superblocks_.size(), 0);
+}
+
+
+bool fixed_pool_arena_base::owns(const void* p) const noexcept
+{
+    return find(p) != NPOS;
+}
+
+
+size_t fixed_pool_arena_base::size() const noexcept
+{
+    return live_;
+}
+
+
+size_t fixed_pool_arena_base::capacity() const noexcept
+{
+    return superblocks_.size() * block_count_;
+}
+
+
+size_t fixed_pool_arena_base::max_size() const noexcept
+{
+    return max_size_;
+}
+
+
+size_t fixed_pool_arena_base::superblocks() const noexcept
+{
+    return superblocks_.size();
+}
+
+// ITERATOR
+
+
+fixed_pool_arena_base::iterator::iterator(const fixed_pool_arena_base* arena, size_t index, size_t slot) noexcept:
+    arena_(arena),
+    index_(index),
+    slot_(slot)
+{}
+
+
+void* fixed_pool_arena_base::iterator::operator*() const noexcept
+{
+    return arena_->superblocks_[index_]->data + slot_ * arena_->block_size_;
+}
+
+
+auto fixed_pool_arena_base::iterator::operator++() noexcept -> iterator&
+{
+    ++slot_;
+    arena_->advance(index_, slot_);
+    return *this;
+}
+
+
+auto fixed_pool_arena_base::iterator::operator++(int) noexcept -> iterator
+{
+    iterator copy(*this);
+    operator++();
+    return copy;
+}
+
+
+bool fixed_pool_arena_base::iterator::operator==(const iterator& rhs) const noexcept
+{
+    return index_ == rhs.index_ && slot_ == rhs.slot_;
+}
+
+
+bool fixed_pool_arena_base::iterator::operator!=(const iterator& rhs) const noexcept
+{
+    return !(*this == rhs);
+}
+
+PYCPP_END_NAMESPACE
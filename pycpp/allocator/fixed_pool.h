@@ -1,6 +1,711 @@
-// Like a pool but fixed pool size.
-// Throws bad_alloc if the pool is exceeded.
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Bitmapped block allocator for fixed-size slots.
+ *
+ *  An arena of fixed-size slots, carved from large superblocks of
+ *  `BlockCount` slots, which tracks occupancy in a bitmap per
+ *  superblock rather than an intrusive free list. The metadata is
+ *  a single bit per slot, and the first free slot is found by
+ *  scanning the bitmap a word at a time, so slots are packed
+ *  densely, lowest address first.
+ *
+ *  Slots never move, and superblocks are only returned to the
+ *  system when the arena is destroyed, so the arena suits object
+ *  pools that require stable addresses. The arena supports bulk
+ *  allocation and deallocation, which claim and release whole
+ *  words of the bitmap at once, and iteration over live slots, in
+ *  address order. Iterators are invalidated by any allocation or
+ *  deallocation.
+ *
+ *  The arena may be bounded to `max_size` slots, after which
+ *  allocation throws `bad_alloc`.
+ *
+ *  `fixed_pool_allocator` allocates single objects, or arrays that
+ *  fit in a slot, from the arena, and forwards larger requests to
+ *  `operator new`. Rebound copies share the arena, so `BlockSize`
+ *  must be large enough for the rebound type, such as a container
+ *  node, for the arena to be used.
+ *
+ *  By default, `fixed_pool_allocator` and `fixed_pool_arena` are not
+ *  thread-safe, for performance. Using the locked variant, by setting
+ *  `UseLocks`, ensures thread safety through a shared mutex, except
+ *  for iteration.
+ *
+ *  \synopsis
+ *      static constexpr size_t FIXED_POOL_BLOCK_COUNT = implementation-defined;
+ *
+ *      template <
+ *          size_t BlockSize,
+ *          size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+ *          size_t Alignment = implementation-defined,
+ *          bool UseLocks = false
+ *      >
+ *      class fixed_pool_arena
+ *      {
+ *      public:
+ *          static constexpr size_t block_size = implementation-defined;
+ *          static constexpr size_t block_count = BlockCount;
+ *          static constexpr size_t alignment = Alignment;
+ *          static constexpr bool use_locks = UseLocks;
+ *          using mutex_type = conditional_t<UseLocks, mutex, dummy_mutex>;
+ *          using iterator = implementation-defined;
+ *
+ *          explicit fixed_pool_arena(size_t max_size = numeric_limits<size_t>::max()) noexcept;
+ *          fixed_pool_arena(const fixed_pool_arena&) = delete;
+ *          fixed_pool_arena& operator=(const fixed_pool_arena&) = delete;
+ *          fixed_pool_arena(fixed_pool_arena&&) = delete;
+ *          fixed_pool_arena& operator=(fixed_pool_arena&&) = delete;
+ *          ~fixed_pool_arena() noexcept;
+ *
+ *          void* allocate();
+ *          void* try_allocate() noexcept;
+ *          void allocate(void** p, size_t n);
+ *          void deallocate(void* p) noexcept;
+ *          void deallocate(void* const* p, size_t n) noexcept;
+ *          void reset() noexcept;
+ *
+ *          iterator begin() const noexcept;
+ *          iterator end() const noexcept;
+ *
+ *          bool owns(const void* p) const noexcept;
+ *          size_t size() const noexcept;
+ *          size_t capacity() const noexcept;
+ *          size_t max_size() const noexcept;
+ *          size_t superblocks() const noexcept;
+ *      };
+ *
+ *      template <
+ *          typename T,
+ *          size_t BlockSize = sizeof(T),
+ *          size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+ *          size_t Alignment = alignof(T),
+ *          bool UseLocks = false
+ *      >
+ *      class fixed_pool_allocator
+ *      {
+ *      public:
+ *          static constexpr size_t block_size = BlockSize;
+ *          static constexpr size_t block_count = BlockCount;
+ *          static constexpr size_t alignment = Alignment;
+ *          static constexpr bool use_locks = UseLocks;
+ *
+ *          using value_type = T;
+ *          using arena_type = fixed_pool_arena<block_size, block_count, alignment, use_locks>;
+ *          using mutex_type = typename arena_type::mutex_type;
+ *          using propagate_on_container_move_assignment = true_type;
+ *
+ *          fixed_pool_allocator() noexcept;
+ *          fixed_pool_allocator(arena_type& arena) noexcept;
+ *          fixed_pool_allocator(const self_t&) noexcept;
+ *          self_t& operator=(const self_t&) noexcept;
+ *          fixed_pool_allocator(self_t&&) noexcept;
+ *          self_t& operator=(self_t&&) noexcept;
+ *          ~fixed_pool_allocator() noexcept;
+ *          template <typename T1> fixed_pool_allocator(const fixed_pool_allocator<T1, BlockSize, BlockCount, Alignment, UseLocks>&) noexcept;
+ *          template <typename T1> self_t& operator=(const fixed_pool_allocator<T1, BlockSize, BlockCount, Alignment, UseLocks>&) noexcept;
+ *          template <typename T1> fixed_pool_allocator(fixed_pool_allocator<T1, BlockSize, BlockCount, Alignment, UseLocks>&&) noexcept;
+ *          template <typename T1> self_t& operator=(fixed_pool_allocator<T1, BlockSize, BlockCount, Alignment, UseLocks>&&) noexcept;
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          value_type* try_allocate(size_t n) noexcept;
+ *          void deallocate(value_type* p, size_t n);
+ *          bool owns(const value_type* p, size_t n) const noexcept;
+ *
+ *      private:
+ *          arena_type* arena_ = nullptr;
+ *      };
+ *
+ *      template <
+ *          size_t BlockSize,
+ *          size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+ *          bool UseLocks = false
+ *      >
+ *      using fixed_pool_resource = resource_adaptor<
+ *          fixed_pool_allocator<byte, BlockSize, BlockCount, alignof(max_align_t), UseLocks>
+ *      >;
+ *
+ *      template <
+ *          typename T,
+ *          size_t BlockSize = sizeof(T),
+ *          size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+ *          size_t Alignment = alignof(T)
+ *      >
+ *      using fixed_pool_locked_allocator = fixed_pool_allocator<T, BlockSize, BlockCount, Alignment, true>;
+ *
+ *      template <
+ *          typename T,
+ *          size_t BlockSize = sizeof(T),
+ *          size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+ *          size_t Alignment = alignof(T)
+ *      >
+ *      using fixed_pool_unlocked_allocator = fixed_pool_allocator<T, BlockSize, BlockCount, Alignment, false>;
+ *
+ *      template <typename T1, size_t S1, size_t C1, size_t A1, bool UL1, typename T2, size_t S2, size_t C2, size_t A2, bool UL2>
+ *      bool operator==(const fixed_pool_allocator<T1, S1, C1, A1, UL1>& lhs,
+ *          const fixed_pool_allocator<T2, S2, C2, A2, UL2>& rhs) noexcept;
+ *
+ *      template <typename T1, size_t S1, size_t C1, size_t A1, bool UL1, typename T2, size_t S2, size_t C2, size_t A2, bool UL2>
+ *      bool operator!=(const fixed_pool_allocator<T1, S1, C1, A1, UL1>& lhs,
+ *          const fixed_pool_allocator<T2, S2, C2, A2, UL2>& rhs) noexcept;
+ */
 
 #pragma once
 
-#include <pycpp/config.h>
+#include <pycpp/stl/iterator.h>
+#include <pycpp/stl/limits.h>
+#include <pycpp/stl/memory.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/new.h>
+#include <pycpp/stl/type_traits.h>
+#include <pycpp/stl/vector.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t FIXED_POOL_BLOCK_COUNT = 4096;
+
+// FORWARD
+// -------
+
+template <
+    size_t BlockSize,
+    size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+    size_t Alignment = alignof(max_align_t),
+    bool UseLocks = false
+>
+class fixed_pool_arena;
+
+template <
+    typename T,
+    size_t BlockSize = sizeof(T),
+    size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+    size_t Alignment = alignof(T),
+    bool UseLocks = false
+>
+class fixed_pool_allocator;
+
+// DECLARATIONS
+// ------------
+
+/**
+ *  \brief Superblock and bitmap management shared by all arenas.
+ *
+ *  Superblocks are sorted by address, so the superblock owning a
+ *  slot is found by binary search. Each superblock header is
+ *  followed by its occupancy bitmap, where set bits are live
+ *  slots, and then by its slots.
+ */
+class fixed_pool_arena_base
+{
+protected:
+    struct superblock
+    {
+        byte* data;
+        size_t live;
+        size_t first;
+    };
+
+public:
+    /**
+     *  \brief Forward iterator over the live slots of an arena.
+     */
+    class iterator
+    {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = void*;
+        using difference_type = ptrdiff_t;
+        using pointer = void* const*;
+        using reference = void*;
+
+        iterator() noexcept = default;
+        iterator(const iterator&) noexcept = default;
+        iterator& operator=(const iterator&) noexcept = default;
+
+        void* operator*() const noexcept;
+        iterator& operator++() noexcept;
+        iterator operator++(int) noexcept;
+        bool operator==(const iterator& rhs) const noexcept;
+        bool operator!=(const iterator& rhs) const noexcept;
+
+    private:
+        friend class fixed_pool_arena_base;
+
+        const fixed_pool_arena_base* arena_ = nullptr;
+        size_t index_ = 0;
+        size_t slot_ = 0;
+
+        iterator(const fixed_pool_arena_base* arena, size_t index, size_t slot) noexcept;
+    };
+
+protected:
+    fixed_pool_arena_base(size_t block_size, size_t block_count, size_t alignment, size_t max_size) noexcept;
+    ~fixed_pool_arena_base() noexcept;
+
+    void* try_allocate() noexcept;
+    void allocate(void** p, size_t n);
+    void deallocate(void* p) noexcept;
+    void deallocate(void* const* p, size_t n) noexcept;
+    void reset() noexcept;
+    iterator begin() const noexcept;
+    iterator end() const noexcept;
+    bool owns(const void* p) const noexcept;
+    size_t size() const noexcept;
+    size_t capacity() const noexcept;
+    size_t max_size() const noexcept;
+    size_t superblocks() const noexcept;
+
+private:
+    size_t block_size_;
+    size_t block_count_;
+    size_t words_;
+    size_t offset_;
+    size_t max_size_;
+    size_t live_ = 0;
+    size_t hint_ = 0;
+    vector<superblock*> superblocks_;
+
+    uint64_t* bitmap(superblock* s) const noexcept;
+    superblock* available() noexcept;
+    superblock* grow() noexcept;
+    void* take(superblock* s) noexcept;
+    size_t take(superblock* s, void** p, size_t n) noexcept;
+    void release(size_t index, const void* p) noexcept;
+    size_t find(const void* p) const noexcept;
+    bool contains(size_t index, const void* p) const noexcept;
+    void advance(size_t& index, size_t& slot) const noexcept;
+};
+
+
+/**
+ *  \brief Arena of fixed-size slots, with an occupancy bitmap.
+ *
+ *  Slots are rounded up to a multiple of the alignment. Copy and
+ *  move constructors are disabled, since allocators refer to the
+ *  arena by address.
+ */
+template <
+    size_t BlockSize,
+    size_t BlockCount,
+    size_t Alignment,
+    bool UseLocks
+>
+class fixed_pool_arena: fixed_pool_arena_base
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <size_t S1 = BlockSize, size_t C1 = BlockCount, size_t A1 = Alignment, bool UL1 = UseLocks>
+    struct rebind { using other = fixed_pool_arena<S1, C1, A1, UL1>; };
+
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr size_t block_size = (BlockSize ? (BlockSize + Alignment - 1) & ~(Alignment - 1) : Alignment);
+    static constexpr size_t block_count = BlockCount;
+    static constexpr size_t alignment = Alignment;
+    static constexpr bool use_locks = UseLocks;
+
+    // MEMBER TYPES
+    // ------------
+    using mutex_type = conditional_t<UseLocks, mutex, dummy_mutex>;
+    using iterator = fixed_pool_arena_base::iterator;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    fixed_pool_arena(const fixed_pool_arena&) = delete;
+    fixed_pool_arena& operator=(const fixed_pool_arena&) = delete;
+    fixed_pool_arena(fixed_pool_arena&&) = delete;
+    fixed_pool_arena& operator=(fixed_pool_arena&&) = delete;
+
+    explicit fixed_pool_arena(size_t max_size = std::numeric_limits<size_t>::max()) noexcept:
+        fixed_pool_arena_base(block_size, block_count, alignment, max_size)
+    {}
+
+    ~fixed_pool_arena() noexcept = default;
+
+    // ALLOCATION
+
+    void* allocate();
+    void* try_allocate() noexcept;
+    void allocate(void** p, size_t n);
+    void deallocate(void* p) noexcept;
+    void deallocate(void* const* p, size_t n) noexcept;
+
+    void reset() noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        fixed_pool_arena_base::reset();
+    }
+
+    // ITERATORS
+
+    iterator begin() const noexcept
+    {
+        return fixed_pool_arena_base::begin();
+    }
+
+    iterator end() const noexcept
+    {
+        return fixed_pool_arena_base::end();
+    }
+
+    // PROPERTIES
+
+    bool owns(const void* p) const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return fixed_pool_arena_base::owns(p);
+    }
+
+    size_t size() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return fixed_pool_arena_base::size();
+    }
+
+    size_t capacity() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return fixed_pool_arena_base::capacity();
+    }
+
+    size_t max_size() const noexcept
+    {
+        return fixed_pool_arena_base::max_size();
+    }
+
+    size_t superblocks() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return fixed_pool_arena_base::superblocks();
+    }
+
+private:
+    mutable mutex_type mutex_;
+
+    static_assert(BlockCount > 0 && BlockCount % 64 == 0, "Superblocks must contain a multiple of 64 slots.");
+    static_assert((Alignment & (Alignment-1)) == 0, "Alignment must be a power of 2.");
+    static_assert(
+        Alignment <= alignof(max_align_t),
+        "Alignment is larger than alignof(max_align_t), and cannot be guaranteed by new."
+    );
+};
+
+// ALLOCATOR
+
+/**
+ *  \brief Allocator for objects of a fixed size, with stable addresses.
+ */
+template <
+    typename T,
+    size_t BlockSize,
+    size_t BlockCount,
+    size_t Alignment,
+    bool UseLocks
+>
+class fixed_pool_allocator
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <typename T1, size_t S1 = BlockSize, size_t C1 = BlockCount, size_t A1 = Alignment, bool UL1 = UseLocks>
+    struct rebind { using other = fixed_pool_allocator<T1, S1, C1, A1, UL1>; };
+
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr size_t block_size = BlockSize;
+    static constexpr size_t block_count = BlockCount;
+    static constexpr size_t alignment = Alignment;
+    static constexpr bool use_locks = UseLocks;
+
+    // MEMBER TYPES
+    // ------------
+    using self_t = fixed_pool_allocator<T, BlockSize, BlockCount, Alignment, UseLocks>;
+    using value_type = T;
+    using arena_type = fixed_pool_arena<block_size, block_count, alignment, use_locks>;
+    using mutex_type = typename arena_type::mutex_type;
+    using propagate_on_container_move_assignment = true_type;
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    fixed_pool_allocator() noexcept:
+        arena_(nullptr)
+    {}
+
+    fixed_pool_allocator(arena_type& arena) noexcept:
+        arena_(&arena)
+    {}
+
+    fixed_pool_allocator(const self_t& rhs) noexcept:
+        arena_(rhs.arena_)
+    {}
+
+    template <typename T1>
+    fixed_pool_allocator(const fixed_pool_allocator<T1, BlockSize, BlockCount, Alignment, UseLocks>& rhs) noexcept:
+        arena_(rhs.arena_)
+    {}
+
+    self_t& operator=(const self_t& rhs) noexcept
+    {
+        arena_ = rhs.arena_;
+        return *this;
+    }
+
+    template <typename T1>
+    self_t& operator=(const fixed_pool_allocator<T1, BlockSize, BlockCount, Alignment, UseLocks>& rhs) noexcept
+    {
+        arena_ = rhs.arena_;
+        return *this;
+    }
+
+    fixed_pool_allocator(self_t&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+    }
+
+    template <typename T1>
+    fixed_pool_allocator(fixed_pool_allocator<T1, BlockSize, BlockCount, Alignment, UseLocks>&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+    }
+
+    self_t& operator=(self_t&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+        return *this;
+    }
+
+    template <typename T1>
+    self_t& operator=(fixed_pool_allocator<T1, BlockSize, BlockCount, Alignment, UseLocks>&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+        return *this;
+    }
+
+    ~fixed_pool_allocator() noexcept
+    {
+        arena_ = nullptr;
+    }
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        if (pooled(n)) {
+            assert(arena_ && "Arena cannot be null.");
+            return reinterpret_cast<value_type*>(arena_->allocate());
+        }
+        return reinterpret_cast<value_type*>(operator new(sizeof(value_type) * n));
+    }
+
+    value_type* try_allocate(size_t n) noexcept
+    {
+        if (pooled(n)) {
+            assert(arena_ && "Arena cannot be null.");
+            return reinterpret_cast<value_type*>(arena_->try_allocate());
+        }
+        return reinterpret_cast<value_type*>(operator new(sizeof(value_type) * n, std::nothrow));
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        if (pooled(n)) {
+            assert(arena_ && "Arena cannot be null.");
+            arena_->deallocate(p);
+        } else {
+            operator delete(p);
+        }
+    }
+
+    bool owns(const value_type* p, size_t n) const noexcept
+    {
+        assert(arena_ && "Arena cannot be null.");
+        return pooled(n) && arena_->owns(p);
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(T* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) T(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(T* p)
+    {
+        p->~T();
+    }
+
+    size_type max_size()
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+private:
+    template <typename T1, size_t S, size_t C, size_t A, bool UL>
+    friend class fixed_pool_allocator;
+
+    template <typename T1, size_t S1, size_t C1, size_t A1, bool UL1, typename T2, size_t S2, size_t C2, size_t A2, bool UL2>
+    friend bool operator==(const fixed_pool_allocator<T1, S1, C1, A1, UL1>& lhs, const fixed_pool_allocator<T2, S2, C2, A2, UL2>& rhs) noexcept;
+
+    arena_type* arena_ = nullptr;
+
+    static bool pooled(size_t n) noexcept
+    {
+        return n && n <= arena_type::block_size / sizeof(value_type) && alignof(value_type) <= alignment;
+    }
+};
+
+// ALIAS
+// -----
+
+template <
+    size_t BlockSize,
+    size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+    bool UseLocks = false
+>
+using fixed_pool_resource = resource_adaptor<
+    fixed_pool_allocator<byte, BlockSize, BlockCount, alignof(max_align_t), UseLocks>
+>;
+
+template <
+    typename T,
+    size_t BlockSize = sizeof(T),
+    size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+    size_t Alignment = alignof(T)
+>
+using fixed_pool_locked_allocator = fixed_pool_allocator<T, BlockSize, BlockCount, Alignment, true>;
+
+template <
+    typename T,
+    size_t BlockSize = sizeof(T),
+    size_t BlockCount = FIXED_POOL_BLOCK_COUNT,
+    size_t Alignment = alignof(T)
+>
+using fixed_pool_unlocked_allocator = fixed_pool_allocator<T, BlockSize, BlockCount, Alignment, false>;
+
+// SPECIALIZATION
+// --------------
+
+template <size_t S, size_t C, size_t A, bool UL>
+struct is_relocatable<fixed_pool_arena<S, C, A, UL>>: false_type
+{};
+
+template <typename T, size_t S, size_t C, size_t A, bool UL>
+struct is_relocatable<fixed_pool_allocator<T, S, C, A, UL>>: true_type
+{};
+
+// IMPLEMENTATION
+// --------------
+
+// ARENA
+
+template <size_t S, size_t C, size_t A, bool UL>
+const size_t fixed_pool_arena<S, C, A, UL>::block_size;
+
+template <size_t S, size_t C, size_t A, bool UL>
+const size_t fixed_pool_arena<S, C, A, UL>::block_count;
+
+template <size_t S, size_t C, size_t A, bool UL>
+const size_t fixed_pool_arena<S, C, A, UL>::alignment;
+
+template <size_t S, size_t C, size_t A, bool UL>
+const bool fixed_pool_arena<S, C, A, UL>::use_locks;
+
+template <size_t S, size_t C, size_t A, bool UL>
+void* fixed_pool_arena<S, C, A, UL>::allocate()
+{
+    void* p = try_allocate();
+    if (!p) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+
+template <size_t S, size_t C, size_t A, bool UL>
+inline void* fixed_pool_arena<S, C, A, UL>::try_allocate() noexcept
+{
+    lock_guard<mutex_type> lock(mutex_);
+    return fixed_pool_arena_base::try_allocate();
+}
+
+
+/**
+ *  \brief Allocate `n` slots into `p`, or none of them.
+ */
+template <size_t S, size_t C, size_t A, bool UL>
+void fixed_pool_arena<S, C, A, UL>::allocate(void** p, size_t n)
+{
+    lock_guard<mutex_type> lock(mutex_);
+    fixed_pool_arena_base::allocate(p, n);
+}
+
+
+template <size_t S, size_t C, size_t A, bool UL>
+inline void fixed_pool_arena<S, C, A, UL>::deallocate(void* p) noexcept
+{
+    lock_guard<mutex_type> lock(mutex_);
+    fixed_pool_arena_base::deallocate(p);
+}
+
+
+template <size_t S, size_t C, size_t A, bool UL>
+void fixed_pool_arena<S, C, A, UL>::deallocate(void* const* p, size_t n) noexcept
+{
+    lock_guard<mutex_type> lock(mutex_);
+    fixed_pool_arena_base::deallocate(p, n);
+}
+
+// ALLOCATOR
+
+template <typename T, size_t S, size_t C, size_t A, bool UL>
+const size_t fixed_pool_allocator<T, S, C, A, UL>::block_size;
+
+template <typename T, size_t S, size_t C, size_t A, bool UL>
+const size_t fixed_pool_allocator<T, S, C, A, UL>::block_count;
+
+template <typename T, size_t S, size_t C, size_t A, bool UL>
+const size_t fixed_pool_allocator<T, S, C, A, UL>::alignment;
+
+template <typename T, size_t S, size_t C, size_t A, bool UL>
+const bool fixed_pool_allocator<T, S, C, A, UL>::use_locks;
+
+template <typename T1, size_t S1, size_t C1, size_t A1, bool UL1, typename T2, size_t S2, size_t C2, size_t A2, bool UL2>
+inline bool operator==(const fixed_pool_allocator<T1, S1, C1, A1, UL1>& lhs,
+    const fixed_pool_allocator<T2, S2, C2, A2, UL2>& rhs) noexcept
+{
+    return lhs.arena_ == rhs.arena_;
+}
+
+template <typename T1, size_t S1, size_t C1, size_t A1, bool UL1, typename T2, size_t S2, size_t C2, size_t A2, bool UL2>
+inline bool operator!=(const fixed_pool_allocator<T1, S1, C1, A1, UL1>& lhs,
+    const fixed_pool_allocator<T2, S2, C2, A2, UL2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+PYCPP_END_NAMESPACE
@@ -0,0 +1,301 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/gc.h>
+#include <pycpp/stl/new.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// OBJECTS
+// -------
+
+struct gc_arena_base::block
+{
+    block* prev;
+    size_t size;
+};
+
+
+struct gc_arena_base::region
+{
+    region* prev;
+    epoch_type epoch;
+    block* blocks;
+    finalizer* finalizers;
+    size_t next_size;
+    size_t used;
+};
+
+// HELPERS
+// -------
+
+static constexpr size_t MAX_ALIGN = alignof(max_align_t);
+static constexpr size_t BLOCK_HEADER = (sizeof(void*) + sizeof(size_t) + MAX_ALIGN - 1) & ~(MAX_ALIGN - 1);
+
+
+static size_t align_up(size_t n, size_t alignment) noexcept
+{
+    return (n + (alignment-1)) & ~(alignment-1);
+}
+
+
+static byte* align_up(byte* p, size_t alignment) noexcept
+{
+    return reinterpret_cast<byte*>(align_up(reinterpret_cast<uintptr_t>(p), alignment));
+}
+
+// ARENA
+// -----
+
+
+gc_arena_base::gc_arena_base(size_t block_size) noexcept:
+    block_size_(block_size ? block_size : GC_BLOCK_SIZE)
+{}
+
+
+gc_arena_base::~gc_arena_base() noexcept
+{
+    region* r = detach(epoch_);
+    finalize(r);
+    release(r);
+    operator delete(spare_);
+}
+
+
+/**
+ *  \brief Get the region of the current epoch, or null if it has no allocations.
+ */
+auto gc_arena_base::current() const noexcept -> region*
+{
+    return regions_ && regions_->epoch == epoch_ ? regions_ : nullptr;
+}
+
+
+byte* gc_arena_base::allocate(size_t n, size_t alignment)
+{
+    if (n > std::numeric_limits<size_t>::max() - alignment) {
+        throw bad_alloc();
+    }
+
+    size_t size = align_up(n, alignment);
+    region* r = current();
+    if (r) {
+        byte* p = align_up(cursor_, alignment);
+        if (p <= end_ && static_cast<size_t>(end_ - p) >= size) {
+            r->used += static_cast<size_t>(p - cursor_) + size;
+            cursor_ = p + size;
+            return p;
+        }
+    }
+
+    return grow(size, alignment);
+}
+
+
+void gc_arena_base::deallocate(byte* p, size_t n, size_t alignment) noexcept
+{
+    // only the most recent allocation of the current epoch can be returned
+    size_t size = align_up(n, alignment);
+    region* r = current();
+    if (r && p + size == cursor_) {
+        cursor_ = p;
+        r->used -= size;
+    }
+}
+
+
+/**
+ *  \brief Allocate an object and its finalizer record from the current region.
+ *
+ *  The record is registered without a function, so it is skipped
+ *  until the caller constructs the object and sets the function.
+ */
+auto gc_arena_base::reserve(size_t n, size_t alignment) -> finalizer*
+{
+    byte* object = allocate(n, alignment);
+    finalizer* f = reinterpret_cast<finalizer*>(allocate(sizeof(finalizer), alignof(finalizer)));
+    region* r = regions_;
+    f->prev = r->finalizers;
+    f->function = nullptr;
+    f->object = object;
+    r->finalizers = f;
+
+    return f;
+}
+
+
+auto gc_arena_base::epoch() const noexcept -> epoch_type
+{
+    return epoch_;
+}
+
+
+/**
+ *  \brief Start a new epoch, and return it.
+ */
+auto gc_arena_base::advance() noexcept -> epoch_type
+{
+    return ++epoch_;
+}
+
+
+/**
+ *  \brief Unlink the regions of every epoch up to and including `epoch`.
+ *
+ *  Retiring the current epoch starts a new epoch. Returns the most
+ *  recent unlinked region, to finalize and release.
+ */
+auto gc_arena_base::detach(epoch_type epoch) noexcept -> region*
+{
+    if (epoch >= epoch_) {
+        advance();
+    }
+
+    // regions are ordered by epoch, most recent first
+    region** link = &regions_;
+    while (*link && (*link)->epoch > epoch) {
+        link = &(*link)->prev;
+    }
+
+    region* r = *link;
+    *link = nullptr;
+    return r;
+}
+
+
+/**
+ *  \brief Run the finalizers of a chain of regions.
+ *
+ *  Does not modify the arena, so finalizers may use the arena.
+ */
+void gc_arena_base::finalize(region* r) noexcept
+{
+    for (; r; r = r->prev) {
+        for (finalizer* f = r->finalizers; f; f = f->prev) {
+            if (f->function) {
+                f->function(f->object);
+            }
+        }
+    }
+}
+
+
+size_t gc_arena_base::regions() const noexcept
+{
+    size_t count = 0;
+    for (region* r = regions_; r; r = r->prev) {
+        ++count;
+    }
+    return count;
+}
+
+
+size_t gc_arena_base::size() const noexcept
+{
+    size_t size = 0;
+    for (region* r = regions_; r; r = r->prev) {
+        for (block* b = r->blocks; b; b = b->prev) {
+            size += b->size;
+        }
+    }
+    return size;
+}
+
+
+size_t gc_arena_base::used() const noexcept
+{
+    size_t used = 0;
+    for (region* r = regions_; r; r = r->prev) {
+        used += r->used;
+    }
+    return used;
+}
+
+
+/**
+ *  \brief Chain a block large enough for `size` bytes and allocate from it.
+ *
+ *  Opens the region of the current epoch if it has no blocks, with
+ *  the region header stored at the start of its first block.
+ */
+byte* gc_arena_base::grow(size_t size, size_t alignment)
+{
+    region* r = current();
+    size_t padding = alignment > MAX_ALIGN ? alignment : 0;
+    size_t header = r ? 0 : align_up(sizeof(region), MAX_ALIGN);
+    if (size > std::numeric_limits<size_t>::max() - BLOCK_HEADER - header - padding) {
+        throw bad_alloc();
+    }
+
+    size_t required = size + padding + header;
+    size_t next_size = r ? r->next_size : block_size_;
+    block* b;
+    if (spare_ && spare_->size >= required) {
+        b = spare_;
+        spare_ = nullptr;
+    } else {
+        size_t capacity = next_size > required ? next_size : required;
+        b = static_cast<block*>(operator new(BLOCK_HEADER + capacity));
+        b->size = capacity;
+        if (next_size < GC_MAX_BLOCK_SIZE / 2) {
+            next_size *= 2;
+        } else if (next_size < GC_MAX_BLOCK_SIZE) {
+            next_size = GC_MAX_BLOCK_SIZE;
+        }
+    }
+
+    byte* data = reinterpret_cast<byte*>(b) + BLOCK_HEADER;
+    end_ = data + b->size;
+    if (!r) {
+        r = reinterpret_cast<region*>(data);
+        r->prev = regions_;
+        r->epoch = epoch_;
+        r->blocks = nullptr;
+        r->finalizers = nullptr;
+        r->used = 0;
+        regions_ = r;
+        data += header;
+    }
+    r->next_size = next_size;
+    b->prev = r->blocks;
+    r->blocks = b;
+
+    byte* p = align_up(data, alignment);
+    cursor_ = p + size;
+    r->used += static_cast<size_t>(cursor_ - data);
+
+    return p;
+}
+
+
+/**
+ *  \brief Free the blocks of a chain of regions.
+ */
+void gc_arena_base::release(region* r) noexcept
+{
+    while (r) {
+        // the region header lives in its first block
+        region* prev = r->prev;
+        block* b = r->blocks;
+        while (b) {
+            block* next = b->prev;
+            release(b);
+            b = next;
+        }
+        r = prev;
+    }
+}
+
+
+/**
+ *  \brief Release a block, keeping the largest as a spare.
+ */
+void gc_arena_base::release(block* b) noexcept
+{
+    if (!spare_ || spare_->size < b->size) {
+        swap(spare_, b);
+    }
+    operator delete(b);
+}
+
+PYCPP_END_NAMESPACE
@@ -1,4 +1,557 @@
-// TODO: wrap an allocator around this:
-//      https://github.com/ivmai/bdwgc
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Region-based allocator reclaiming memory by epoch.
+ *
+ *  An arena which allocates objects into regions, one per epoch,
+ *  and frees each region in bulk once its epoch retires, rather
+ *  than tracking or tracing individual objects. Suited for graphs,
+ *  including cyclic graphs, built from a single document or request,
+ *  where tearing down node by node is slow and ownership is unclear.
+ *
+ *  Allocations go to the region of the current epoch, by bumping a
+ *  pointer through geometrically growing blocks. `advance()` starts
+ *  a new epoch, and `retire(e)` frees the regions of every epoch up
+ *  to `e`. Deallocation is a no-op, except for the most recent
+ *  allocation, which is returned to the region.
+ *
+ *  Retiring a region does not run destructors, unless the object
+ *  was created with `create()`, which registers a finalizer for
+ *  types that are not trivially destructible. Finalizers run in
+ *  reverse order of creation when the region retires.
+ *
+ *  \code
+ *      gc_arena<> arena;
+ *      auto epoch = arena.epoch();
+ *      node* root = arena.create<node>(...);
+ *      // build a graph from `root`, with edges allocated by `gc_allocator`
+ *      arena.advance();
+ *      arena.retire(epoch);
+ *  \endcode
+ *
+ *  By default, `gc_allocator` and `gc_arena` are not thread-safe,
+ *  for performance. Using the locked variant, by setting `UseLocks`,
+ *  ensures thread safety through a shared mutex.
+ *
+ *  \synopsis
+ *      static constexpr size_t GC_BLOCK_SIZE = implementation-defined;
+ *      static constexpr size_t GC_MAX_BLOCK_SIZE = implementation-defined;
+ *
+ *      template <bool UseLocks = false>
+ *      class gc_arena
+ *      {
+ *      public:
+ *          static constexpr bool use_locks = UseLocks;
+ *          using mutex_type = conditional_t<UseLocks, mutex, dummy_mutex>;
+ *          using epoch_type = uint64_t;
+ *
+ *          explicit gc_arena(size_t block_size = GC_BLOCK_SIZE) noexcept;
+ *          gc_arena(const gc_arena&) = delete;
+ *          gc_arena& operator=(const gc_arena&) = delete;
+ *          gc_arena(gc_arena&&) = delete;
+ *          gc_arena& operator=(gc_arena&&) = delete;
+ *          ~gc_arena() noexcept;
+ *
+ *          byte* allocate(size_t n, size_t alignment);
+ *          void deallocate(byte* p, size_t n, size_t alignment) noexcept;
+ *          template <typename T, typename ... Ts> T* create(Ts&&... ts);
+ *
+ *          epoch_type epoch() const noexcept;
+ *          epoch_type advance() noexcept;
+ *          void retire(epoch_type epoch) noexcept;
+ *          void clear() noexcept;
+ *
+ *          size_t regions() const noexcept;
+ *          size_t size() const noexcept;
+ *          size_t used() const noexcept;
+ *      };
+ *
+ *      template <typename T, bool UseLocks = false>
+ *      class gc_allocator
+ *      {
+ *      public:
+ *          static constexpr bool use_locks = UseLocks;
+ *
+ *          using value_type = T;
+ *          using arena_type = gc_arena<use_locks>;
+ *          using mutex_type = typename arena_type::mutex_type;
+ *          using propagate_on_container_move_assignment = true_type;
+ *
+ *          gc_allocator() noexcept;
+ *          gc_allocator(arena_type& arena) noexcept;
+ *          gc_allocator(const self_t&) noexcept;
+ *          self_t& operator=(const self_t&) noexcept;
+ *          gc_allocator(self_t&&) noexcept;
+ *          self_t& operator=(self_t&&) noexcept;
+ *          ~gc_allocator() noexcept;
+ *          template <typename T1> gc_allocator(const gc_allocator<T1, UseLocks>&) noexcept;
+ *          template <typename T1> self_t& operator=(const gc_allocator<T1, UseLocks>&) noexcept;
+ *          template <typename T1> gc_allocator(gc_allocator<T1, UseLocks>&&) noexcept;
+ *          template <typename T1> self_t& operator=(gc_allocator<T1, UseLocks>&&) noexcept;
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          void deallocate(value_type* p, size_t n);
+ *
+ *      private:
+ *          arena_type* arena_ = nullptr;
+ *      };
+ *
+ *      template <bool UseLocks = false>
+ *      using gc_resource = resource_adaptor<gc_allocator<byte, UseLocks>>;
+ *
+ *      using gc_unlocked_resource = resource_adaptor<gc_allocator<byte, false>>;
+ *      using gc_locked_resource = resource_adaptor<gc_allocator<byte, true>>;
+ *
+ *      template <typename T>
+ *      using gc_locked_allocator = gc_allocator<T, true>;
+ *
+ *      template <typename T>
+ *      using gc_unlocked_allocator = gc_allocator<T, false>;
+ *
+ *      template <typename T1, bool UL1, typename T2, bool UL2>
+ *      bool operator==(const gc_allocator<T1, UL1>& lhs, const gc_allocator<T2, UL2>& rhs) noexcept;
+ *
+ *      template <typename T1, bool UL1, typename T2, bool UL2>
+ *      bool operator!=(const gc_allocator<T1, UL1>& lhs, const gc_allocator<T2, UL2>& rhs) noexcept;
+ */
 
-// A garbage collected allocator.
+#pragma once
+
+#include <pycpp/stl/limits.h>
+#include <pycpp/stl/memory.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/type_traits.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t GC_BLOCK_SIZE = 1 << 16;
+static constexpr size_t GC_MAX_BLOCK_SIZE = 1 << 24;
+
+// FORWARD
+// -------
+
+template <bool UseLocks = false>
+class gc_arena;
+
+template <
+    typename T,
+    bool UseLocks = false
+>
+class gc_allocator;
+
+// DECLARATIONS
+// ------------
+
+/**
+ *  \brief Region and epoch bookkeeping shared by all GC arenas.
+ *
+ *  Regions are stored as a singly-linked list, most recent first,
+ *  and each region chains its own blocks. The region header and
+ *  finalizer records are bump-allocated from the region itself.
+ */
+class gc_arena_base
+{
+public:
+    using epoch_type = uint64_t;
+
+protected:
+    struct block;
+    struct region;
+    using finalize_function = void (*)(void*);
+
+    struct finalizer
+    {
+        finalizer* prev;
+        finalize_function function;
+        void* object;
+    };
+
+    gc_arena_base(size_t block_size) noexcept;
+    ~gc_arena_base() noexcept;
+
+    byte* allocate(size_t n, size_t alignment);
+    void deallocate(byte* p, size_t n, size_t alignment) noexcept;
+    finalizer* reserve(size_t n, size_t alignment);
+    epoch_type epoch() const noexcept;
+    epoch_type advance() noexcept;
+    region* detach(epoch_type epoch) noexcept;
+    static void finalize(region* r) noexcept;
+    void release(region* r) noexcept;
+    size_t regions() const noexcept;
+    size_t size() const noexcept;
+    size_t used() const noexcept;
+
+private:
+    size_t block_size_;
+    epoch_type epoch_ = 0;
+    region* regions_ = nullptr;
+    block* spare_ = nullptr;
+    byte* cursor_ = nullptr;
+    byte* end_ = nullptr;
+
+    region* current() const noexcept;
+    byte* grow(size_t size, size_t alignment);
+    void release(block* b) noexcept;
+};
+
+
+/**
+ *  \brief Arena to allocate objects into regions retired by epoch.
+ */
+template <bool UseLocks>
+class gc_arena: gc_arena_base
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <bool UL1 = UseLocks>
+    struct rebind { using other = gc_arena<UL1>; };
+
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr bool use_locks = UseLocks;
+
+    // MEMBER TYPES
+    // ------------
+    using mutex_type = conditional_t<UseLocks, mutex, dummy_mutex>;
+    using epoch_type = gc_arena_base::epoch_type;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    gc_arena(const gc_arena&) = delete;
+    gc_arena& operator=(const gc_arena&) = delete;
+    gc_arena(gc_arena&&) = delete;
+    gc_arena& operator=(gc_arena&&) = delete;
+
+    explicit gc_arena(size_t block_size = GC_BLOCK_SIZE) noexcept:
+        gc_arena_base(block_size)
+    {}
+
+    ~gc_arena() noexcept = default;
+
+    // ALLOCATION
+
+    byte* allocate(size_t n, size_t alignment)
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return gc_arena_base::allocate(n, alignment);
+    }
+
+    void deallocate(byte* p, size_t n, size_t alignment) noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        gc_arena_base::deallocate(p, n, alignment);
+    }
+
+    template <typename T, typename ... Ts>
+    T* create(Ts&&... ts);
+
+    // EPOCHS
+
+    epoch_type epoch() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return gc_arena_base::epoch();
+    }
+
+    epoch_type advance() noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return gc_arena_base::advance();
+    }
+
+    void retire(epoch_type epoch) noexcept;
+
+    void clear() noexcept
+    {
+        retire(std::numeric_limits<epoch_type>::max());
+    }
+
+    // PROPERTIES
+
+    size_t regions() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return gc_arena_base::regions();
+    }
+
+    size_t size() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return gc_arena_base::size();
+    }
+
+    size_t used() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return gc_arena_base::used();
+    }
+
+private:
+    mutable mutex_type mutex_;
+
+    template <typename T>
+    static void destroy(void* p) noexcept
+    {
+        static_cast<T*>(p)->~T();
+    }
+};
+
+// ALLOCATOR
+
+/**
+ *  \brief Allocator for objects reclaimed in bulk by epoch.
+ */
+template <
+    typename T,
+    bool UseLocks
+>
+class gc_allocator
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <typename T1, bool UL1 = UseLocks>
+    struct rebind { using other = gc_allocator<T1, UL1>; };
+
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr bool use_locks = UseLocks;
+
+    // MEMBER TYPES
+    // ------------
+    using self_t = gc_allocator<T, UseLocks>;
+    using value_type = T;
+    using arena_type = gc_arena<use_locks>;
+    using mutex_type = typename arena_type::mutex_type;
+    using propagate_on_container_move_assignment = true_type;
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    gc_allocator() noexcept:
+        arena_(nullptr)
+    {}
+
+    gc_allocator(arena_type& arena) noexcept:
+        arena_(&arena)
+    {}
+
+    gc_allocator(const self_t& rhs) noexcept:
+        arena_(rhs.arena_)
+    {}
+
+    template <typename T1>
+    gc_allocator(const gc_allocator<T1, UseLocks>& rhs) noexcept:
+        arena_(rhs.arena_)
+    {}
+
+    self_t& operator=(const self_t& rhs) noexcept
+    {
+        arena_ = rhs.arena_;
+        return *this;
+    }
+
+    template <typename T1>
+    self_t& operator=(const gc_allocator<T1, UseLocks>& rhs) noexcept
+    {
+        arena_ = rhs.arena_;
+        return *this;
+    }
+
+    gc_allocator(self_t&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+    }
+
+    template <typename T1>
+    gc_allocator(gc_allocator<T1, UseLocks>&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+    }
+
+    self_t& operator=(self_t&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+        return *this;
+    }
+
+    template <typename T1>
+    self_t& operator=(gc_allocator<T1, UseLocks>&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+        return *this;
+    }
+
+    ~gc_allocator() noexcept
+    {
+        arena_ = nullptr;
+    }
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        assert(arena_ && "Arena cannot be null.");
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw bad_alloc();
+        }
+        return reinterpret_cast<T*>(arena_->allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        assert(arena_ && "Arena cannot be null.");
+        arena_->deallocate(reinterpret_cast<byte*>(p), sizeof(T) * n, alignof(T));
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(T* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) T(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(T* p)
+    {
+        p->~T();
+    }
+
+    size_type max_size()
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+private:
+    template <typename T1, bool UL>
+    friend class gc_allocator;
+
+    template <typename T1, bool UL1, typename T2, bool UL2>
+    friend bool operator==(const gc_allocator<T1, UL1>& lhs, const gc_allocator<T2, UL2>& rhs) noexcept;
+
+    arena_type* arena_ = nullptr;
+};
+
+// ALIAS
+// -----
+
+template <bool UseLocks = false>
+using gc_resource = resource_adaptor<gc_allocator<byte, UseLocks>>;
+
+using gc_unlocked_resource = resource_adaptor<gc_allocator<byte, false>>;
+using gc_locked_resource = resource_adaptor<gc_allocator<byte, true>>;
+
+template <typename T>
+using gc_locked_allocator = gc_allocator<T, true>;
+
+template <typename T>
+using gc_unlocked_allocator = gc_allocator<T, false>;
+
+// SPECIALIZATION
+// --------------
+
+template <bool UL>
+struct is_relocatable<gc_arena<UL>>: false_type
+{};
+
+template <typename T, bool UL>
+struct is_relocatable<gc_allocator<T, UL>>: true_type
+{};
+
+// IMPLEMENTATION
+// --------------
+
+// ARENA
+
+template <bool UL>
+const bool gc_arena<UL>::use_locks;
+
+/**
+ *  \brief Allocate and construct an object in the current region.
+ *
+ *  Objects that are not trivially destructible are destroyed when
+ *  their region retires. The object and its finalizer are reserved
+ *  together, so both belong to the same region.
+ */
+template <bool UL>
+template <typename T, typename ... Ts>
+T* gc_arena<UL>::create(Ts&&... ts)
+{
+    // construct outside the lock, so `T` may allocate from the arena
+    if (is_trivially_destructible<T>::value) {
+        T* p = reinterpret_cast<T*>(allocate(sizeof(T), alignof(T)));
+        return ::new (static_cast<void*>(p)) T(std::forward<Ts>(ts)...);
+    }
+
+    finalizer* f;
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        f = gc_arena_base::reserve(sizeof(T), alignof(T));
+    }
+    T* p = ::new (f->object) T(std::forward<Ts>(ts)...);
+    f->function = &destroy<T>;
+
+    return p;
+}
+
+/**
+ *  \brief Free the regions of every epoch up to and including `epoch`.
+ *
+ *  Retiring the current epoch starts a new epoch. Finalizers run
+ *  outside the lock, so they may use the arena.
+ */
+template <bool UL>
+void gc_arena<UL>::retire(epoch_type epoch) noexcept
+{
+    region* r;
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        r = gc_arena_base::detach(epoch);
+    }
+    gc_arena_base::finalize(r);
+
+    lock_guard<mutex_type> lock(mutex_);
+    gc_arena_base::release(r);
+}
+
+// ALLOCATOR
+
+template <typename T, bool UL>
+const bool gc_allocator<T, UL>::use_locks;
+
+template <typename T1, bool UL1, typename T2, bool UL2>
+inline bool operator==(const gc_allocator<T1, UL1>& lhs, const gc_allocator<T2, UL2>& rhs) noexcept
+{
+    return lhs.arena_ == rhs.arena_;
+}
+
+template <typename T1, bool UL1, typename T2, bool UL2>
+inline bool operator!=(const gc_allocator<T1, UL1>& lhs, const gc_allocator<T2, UL2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+PYCPP_END_NAMESPACE
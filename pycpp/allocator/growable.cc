@@ -0,0 +1,199 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/growable.h>
+#include <pycpp/stl/new.h>
+#include <stdint.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// HELPERS
+// -------
+
+static constexpr size_t BLOCK_HEADER = (sizeof(void*) + sizeof(size_t) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+
+static size_t align_up(size_t n, size_t alignment) noexcept
+{
+    return (n + (alignment-1)) & ~(alignment-1);
+}
+
+
+static byte* align_up(byte* p, size_t alignment) noexcept
+{
+    return reinterpret_cast<byte*>(align_up(reinterpret_cast<uintptr_t>(p), alignment));
+}
+
+// OBJECTS
+// -------
+
+
+growable_arena_base::growable_arena_base(byte* buffer, size_t size, size_t block_size) noexcept:
+    buffer_(buffer),
+    buffer_size_(size),
+    cursor_(buffer),
+    end_(buffer + size),
+    next_size_(block_size)
+{}
+
+
+growable_arena_base::~growable_arena_base() noexcept
+{
+    while (blocks_) {
+        block* prev = blocks_->prev;
+        operator delete(blocks_);
+        blocks_ = prev;
+    }
+    operator delete(spare_);
+}
+
+
+byte* growable_arena_base::allocate(size_t n, size_t alignment)
+{
+    if (n > std::numeric_limits<size_t>::max() - alignment) {
+        throw bad_alloc();
+    }
+
+    size_t size = align_up(n, alignment);
+    byte* p = align_up(cursor_, alignment);
+    if (p > end_ || static_cast<size_t>(end_ - p) < size) {
+        return grow(size, alignment);
+    }
+
+    used_ += static_cast<size_t>(p - cursor_) + size;
+    cursor_ = p + size;
+    return p;
+}
+
+
+void growable_arena_base::deallocate(byte* p, size_t n, size_t alignment) noexcept
+{
+    // only the most recent allocation can be returned
+    size_t size = align_up(n, alignment);
+    if (p + size == cursor_) {
+        cursor_ = p;
+        used_ -= size;
+    }
+}
+
+
+auto growable_arena_base::mark() const noexcept -> marker
+{
+    return marker {blocks_, cursor_, used_};
+}
+
+
+void growable_arena_base::rewind(const marker& m) noexcept
+{
+    restore(m.blocks, m.cursor);
+    used_ = m.used;
+}
+
+
+void growable_arena_base::reset() noexcept
+{
+    restore(nullptr, buffer_);
+    used_ = 0;
+}
+
+
+size_t growable_arena_base::size() const noexcept
+{
+    size_t size = buffer_size_;
+    for (block* b = blocks_; b; b = b->prev) {
+        size += b->size;
+    }
+    return size;
+}
+
+
+size_t growable_arena_base::used() const noexcept
+{
+    return used_;
+}
+
+
+size_t growable_arena_base::blocks() const noexcept
+{
+    size_t count = 0;
+    for (block* b = blocks_; b; b = b->prev) {
+        ++count;
+    }
+    return count;
+}
+
+
+/**
+ *  \brief Chain a block large enough for `size` bytes and allocate from it.
+ *
+ *  Reuses the spare block when it is large enough, otherwise
+ *  allocates the next block in the geometric sequence, or a block
+ *  sized for the request if larger.
+ */
+byte* growable_arena_base::grow(size_t size, size_t alignment)
+{
+    size_t padding = alignment > alignof(max_align_t) ? alignment : 0;
+    if (size > std::numeric_limits<size_t>::max() - BLOCK_HEADER - padding) {
+        throw bad_alloc();
+    }
+
+    size_t required = size + padding;
+    block* b;
+    if (spare_ && spare_->size >= required) {
+        b = spare_;
+        spare_ = nullptr;
+    } else {
+        size_t capacity = next_size_ > required ? next_size_ : required;
+        b = static_cast<block*>(operator new(BLOCK_HEADER + capacity));
+        b->size = capacity;
+        if (next_size_ < GROWABLE_MAX_BLOCK_SIZE / 2) {
+            next_size_ *= 2;
+        } else if (next_size_ < GROWABLE_MAX_BLOCK_SIZE) {
+            next_size_ = GROWABLE_MAX_BLOCK_SIZE;
+        }
+    }
+
+    b->prev = blocks_;
+    blocks_ = b;
+    byte* data = reinterpret_cast<byte*>(b) + BLOCK_HEADER;
+    byte* p = align_up(data, alignment);
+    cursor_ = p + size;
+    end_ = data + b->size;
+    used_ += static_cast<size_t>(cursor_ - data);
+
+    return p;
+}
+
+
+/**
+ *  \brief Release a block, keeping the largest as a spare.
+ */
+void growable_arena_base::release(block* b) noexcept
+{
+    if (!spare_ || spare_->size < b->size) {
+        swap(spare_, b);
+    }
+    operator delete(b);
+}
+
+
+/**
+ *  \brief Pop all blocks chained after `blocks`, and restore the cursor.
+ */
+void growable_arena_base::restore(block* blocks, byte* cursor) noexcept
+{
+    while (blocks_ != blocks) {
+        block* b = blocks_;
+        blocks_ = b->prev;
+        release(b);
+    }
+
+    cursor_ = cursor;
+    if (blocks_) {
+        end_ = reinterpret_cast<byte*>(blocks_) + BLOCK_HEADER + blocks_->size;
+    } else {
+        end_ = buffer_ + buffer_size_;
+    }
+}
+
+PYCPP_END_NAMESPACE
@@ -0,0 +1,604 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Linear allocator that grows by chaining heap blocks.
+ *
+ *  An arena with the performance of `linear_allocator`, which
+ *  allocates by bumping a pointer and never deallocates individual
+ *  objects, but which chains geometrically growing heap blocks
+ *  rather than throwing `bad_alloc` when exhausted. Suited for
+ *  request-scoped data of unpredictable size.
+ *
+ *  The arena first allocates from an optional initial buffer, either
+ *  an inline buffer of `InlineSize` bytes or a caller-supplied
+ *  (stack) buffer. `reset()` releases all memory but the largest heap
+ *  block, which is reused once the initial buffer is exhausted again.
+ *  `mark()` and `rewind()` release everything allocated after a
+ *  checkpoint. Freeing the most recent allocation also returns it to
+ *  the arena.
+ *
+ *  By default, `growable_allocator` and `growable_arena` are not
+ *  thread-safe, for performance. Using the locked variant, by setting
+ *  `UseLocks`, ensures thread safety through a shared mutex.
+ *
+ *  \synopsis
+ *      static constexpr size_t GROWABLE_BLOCK_SIZE = implementation-defined;
+ *      static constexpr size_t GROWABLE_MAX_BLOCK_SIZE = implementation-defined;
+ *
+ *      template <
+ *          size_t InlineSize = 0,
+ *          size_t Alignment = implementation-defined,
+ *          bool UseLocks = false
+ *      >
+ *      class growable_arena
+ *      {
+ *      public:
+ *          static constexpr size_t alignment = Alignment;
+ *          static constexpr size_t inline_size = InlineSize;
+ *          static constexpr bool use_locks = UseLocks;
+ *          using mutex_type = conditional_t<UseLocks, mutex, dummy_mutex>;
+ *          using marker = implementation-defined;
+ *
+ *          explicit growable_arena(size_t block_size = GROWABLE_BLOCK_SIZE) noexcept;
+ *          growable_arena(void* buffer, size_t size, size_t block_size = GROWABLE_BLOCK_SIZE) noexcept;
+ *          growable_arena(const growable_arena&) = delete;
+ *          growable_arena& operator=(const growable_arena&) = delete;
+ *          growable_arena(growable_arena&&) = delete;
+ *          growable_arena& operator=(growable_arena&&) = delete;
+ *          ~growable_arena() noexcept;
+ *
+ *          template <size_t RequiredAlignment> byte* allocate(size_t n);
+ *          void deallocate(byte* p, size_t n) noexcept;
+ *
+ *          marker mark() const noexcept;
+ *          void rewind(const marker& m) noexcept;
+ *          void reset() noexcept;
+ *
+ *          size_t size() const noexcept;
+ *          size_t used() const noexcept;
+ *          size_t blocks() const noexcept;
+ *      };
+ *
+ *      template <
+ *          typename T,
+ *          size_t InlineSize = 0,
+ *          size_t Alignment = implementation-defined,
+ *          bool UseLocks = false
+ *      >
+ *      class growable_allocator
+ *      {
+ *      public:
+ *          static constexpr size_t alignment = Alignment;
+ *          static constexpr size_t inline_size = InlineSize;
+ *          static constexpr bool use_locks = UseLocks;
+ *
+ *          using value_type = T;
+ *          using arena_type = growable_arena<inline_size, alignment, use_locks>;
+ *          using mutex_type = typename arena_type::mutex_type;
+ *          using propagate_on_container_move_assignment = true_type;
+ *
+ *          growable_allocator() noexcept;
+ *          growable_allocator(arena_type& arena) noexcept;
+ *          growable_allocator(const self_t&) noexcept;
+ *          self_t& operator=(const self_t&) noexcept;
+ *          growable_allocator(self_t&&) noexcept;
+ *          self_t& operator=(self_t&&) noexcept;
+ *          ~growable_allocator() noexcept;
+ *          template <typename T1> growable_allocator(const growable_allocator<T1, InlineSize, Alignment, UseLocks>&) noexcept;
+ *          template <typename T1> self_t& operator=(const growable_allocator<T1, InlineSize, Alignment, UseLocks>&) noexcept;
+ *          template <typename T1> growable_allocator(growable_allocator<T1, InlineSize, Alignment, UseLocks>&&) noexcept;
+ *          template <typename T1> self_t& operator=(growable_allocator<T1, InlineSize, Alignment, UseLocks>&&) noexcept;
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          void deallocate(value_type* p, size_t n);
+ *
+ *      private:
+ *          arena_type* arena_ = nullptr;
+ *      };
+ *
+ *      template <
+ *          size_t InlineSize = 0,
+ *          size_t Alignment = implementation-defined,
+ *          bool UseLocks = false
+ *      >
+ *      using growable_resource = resource_adaptor<
+ *          growable_allocator<byte, InlineSize, Alignment, UseLocks>
+ *      >;
+ *
+ *      template <
+ *          size_t InlineSize = 0,
+ *          size_t Alignment = implementation-defined
+ *      >
+ *      using growable_unlocked_resource = resource_adaptor<
+ *          growable_allocator<byte, InlineSize, Alignment, false>
+ *      >;
+ *
+ *      template <
+ *          size_t InlineSize = 0,
+ *          size_t Alignment = implementation-defined
+ *      >
+ *      using growable_locked_resource = resource_adaptor<
+ *          growable_allocator<byte, InlineSize, Alignment, true>
+ *      >;
+ *
+ *      template <
+ *          typename T,
+ *          size_t InlineSize = 0,
+ *          size_t Alignment = implementation-defined
+ *      >
+ *      using growable_locked_allocator = growable_allocator<T, InlineSize, Alignment, true>;
+ *
+ *      template <
+ *          typename T,
+ *          size_t InlineSize = 0,
+ *          size_t Alignment = implementation-defined
+ *      >
+ *      using growable_unlocked_allocator = growable_allocator<T, InlineSize, Alignment, false>;
+ *
+ *      template <typename T1, size_t S1, size_t A1, bool UL1, typename T2, size_t S2, size_t A2, bool UL2>
+ *      bool operator==(const growable_allocator<T1, S1, A1, UL1>& lhs,
+ *          const growable_allocator<T2, S2, A2, UL2>& rhs) noexcept;
+ *
+ *      template <typename T1, size_t S1, size_t A1, bool UL1, typename T2, size_t S2, size_t A2, bool UL2>
+ *      bool operator!=(const growable_allocator<T1, S1, A1, UL1>& lhs,
+ *          const growable_allocator<T2, S2, A2, UL2>& rhs) noexcept;
+ */
+
+#pragma once
+
+#include <pycpp/stl/limits.h>
+#include <pycpp/stl/memory.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/type_traits.h>
+#include <assert.h>
+#include <stddef.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t GROWABLE_BLOCK_SIZE = 4096;
+static constexpr size_t GROWABLE_MAX_BLOCK_SIZE = 1 << 24;
+
+// FORWARD
+// -------
+
+template <
+    size_t InlineSize = 0,
+    size_t Alignment = alignof(max_align_t),
+    bool UseLocks = false
+>
+class growable_arena;
+
+template <
+    typename T,
+    size_t InlineSize = 0,
+    size_t Alignment = alignof(max_align_t),
+    bool UseLocks = false
+>
+class growable_allocator;
+
+// DECLARATIONS
+// ------------
+
+/**
+ *  \brief Block chaining shared by all growable arenas.
+ *
+ *  Heap blocks are stored as a singly-linked list, most recent
+ *  first, with the header preceding each block's data.
+ */
+class growable_arena_base
+{
+protected:
+    struct block
+    {
+        block* prev;
+        size_t size;
+    };
+
+public:
+    /**
+     *  \brief Checkpoint to rewind the arena to.
+     */
+    struct marker
+    {
+        block* blocks;
+        byte* cursor;
+        size_t used;
+    };
+
+protected:
+    growable_arena_base(byte* buffer, size_t size, size_t block_size) noexcept;
+    ~growable_arena_base() noexcept;
+
+    byte* allocate(size_t n, size_t alignment);
+    void deallocate(byte* p, size_t n, size_t alignment) noexcept;
+    marker mark() const noexcept;
+    void rewind(const marker& m) noexcept;
+    void reset() noexcept;
+    size_t size() const noexcept;
+    size_t used() const noexcept;
+    size_t blocks() const noexcept;
+
+private:
+    byte* buffer_;
+    size_t buffer_size_;
+    byte* cursor_;
+    byte* end_;
+    block* blocks_ = nullptr;
+    block* spare_ = nullptr;
+    size_t next_size_;
+    size_t used_ = 0;
+
+    byte* grow(size_t n, size_t alignment);
+    void release(block* b) noexcept;
+    void restore(block* blocks, byte* cursor) noexcept;
+};
+
+
+/**
+ *  \brief Arena to allocate memory from an initial buffer, then the heap.
+ *
+ *  Copy and move constructors are disabled, since the inline buffer
+ *  would require an O(n) copy, and outstanding allocations point
+ *  into the arena's blocks.
+ */
+template <
+    size_t InlineSize,
+    size_t Alignment,
+    bool UseLocks
+>
+class growable_arena: growable_arena_base
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <size_t S1 = InlineSize, size_t A1 = Alignment, bool UL1 = UseLocks>
+    struct rebind { using other = growable_arena<S1, A1, UL1>; };
+
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr size_t alignment = Alignment;
+    static constexpr size_t inline_size = InlineSize;
+    static constexpr bool use_locks = UseLocks;
+
+    // MEMBER TYPES
+    // ------------
+    using mutex_type = conditional_t<UseLocks, mutex, dummy_mutex>;
+    using marker = growable_arena_base::marker;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    growable_arena(const growable_arena&) = delete;
+    growable_arena& operator=(const growable_arena&) = delete;
+    growable_arena(growable_arena&&) = delete;
+    growable_arena& operator=(growable_arena&&) = delete;
+
+    explicit growable_arena(size_t block_size = GROWABLE_BLOCK_SIZE) noexcept:
+        growable_arena_base(buf_, InlineSize, block_size)
+    {}
+
+    growable_arena(void* buffer, size_t size, size_t block_size = GROWABLE_BLOCK_SIZE) noexcept:
+        growable_arena_base(static_cast<byte*>(buffer), size, block_size)
+    {}
+
+    ~growable_arena() noexcept = default;
+
+    // ALLOCATION
+
+    template <size_t RequiredAlignment> byte* allocate(size_t n);
+    void deallocate(byte* p, size_t n) noexcept;
+
+    // CHECKPOINTS
+
+    marker mark() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return growable_arena_base::mark();
+    }
+
+    void rewind(const marker& m) noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        growable_arena_base::rewind(m);
+    }
+
+    void reset() noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        growable_arena_base::reset();
+    }
+
+    // PROPERTIES
+
+    size_t size() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return growable_arena_base::size();
+    }
+
+    size_t used() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return growable_arena_base::used();
+    }
+
+    size_t blocks() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return growable_arena_base::blocks();
+    }
+
+private:
+    alignas(Alignment) byte buf_[InlineSize ? InlineSize : 1];
+    mutable mutex_type mutex_;
+
+    static_assert((Alignment & (Alignment-1)) == 0, "Alignment must be a power of 2.");
+};
+
+// ALLOCATOR
+
+/**
+ *  \brief Allocator optimized for short-lived objects of any size.
+ */
+template <
+    typename T,
+    size_t InlineSize,
+    size_t Alignment,
+    bool UseLocks
+>
+class growable_allocator
+{
+public:
+    // MEMBER TEMPLATES
+    // ----------------
+    template <typename T1, size_t S1 = InlineSize, size_t A1 = Alignment, bool UL1 = UseLocks>
+    struct rebind { using other = growable_allocator<T1, S1, A1, UL1>; };
+
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr size_t alignment = Alignment;
+    static constexpr size_t inline_size = InlineSize;
+    static constexpr bool use_locks = UseLocks;
+
+    // MEMBER TYPES
+    // ------------
+    using self_t = growable_allocator<T, InlineSize, Alignment, UseLocks>;
+    using value_type = T;
+    using arena_type = growable_arena<inline_size, alignment, use_locks>;
+    using mutex_type = typename arena_type::mutex_type;
+    using propagate_on_container_move_assignment = true_type;
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    growable_allocator() noexcept:
+        arena_(nullptr)
+    {}
+
+    growable_allocator(arena_type& arena) noexcept:
+        arena_(&arena)
+    {}
+
+    growable_allocator(const self_t& rhs) noexcept:
+        arena_(rhs.arena_)
+    {}
+
+    template <typename T1>
+    growable_allocator(const growable_allocator<T1, InlineSize, Alignment, UseLocks>& rhs) noexcept:
+        arena_(rhs.arena_)
+    {}
+
+    self_t& operator=(const self_t& rhs) noexcept
+    {
+        arena_ = rhs.arena_;
+        return *this;
+    }
+
+    template <typename T1>
+    self_t& operator=(const growable_allocator<T1, InlineSize, Alignment, UseLocks>& rhs) noexcept
+    {
+        arena_ = rhs.arena_;
+        return *this;
+    }
+
+    growable_allocator(self_t&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+    }
+
+    template <typename T1>
+    growable_allocator(growable_allocator<T1, InlineSize, Alignment, UseLocks>&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+    }
+
+    self_t& operator=(self_t&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+        return *this;
+    }
+
+    template <typename T1>
+    self_t& operator=(growable_allocator<T1, InlineSize, Alignment, UseLocks>&& rhs) noexcept
+    {
+        swap(arena_, rhs.arena_);
+        return *this;
+    }
+
+    ~growable_allocator() noexcept
+    {
+        arena_ = nullptr;
+    }
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        assert(arena_ && "Arena cannot be null.");
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw bad_alloc();
+        }
+        return reinterpret_cast<T*>(arena_->template allocate<alignof(T)>(sizeof(T) * n));
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        assert(arena_ && "Arena cannot be null.");
+        arena_->deallocate(reinterpret_cast<byte*>(p), sizeof(T) * n);
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(T* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) T(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(T* p)
+    {
+        p->~T();
+    }
+
+    size_type max_size()
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+private:
+    template <typename T1, size_t S, size_t A, bool UL>
+    friend class growable_allocator;
+
+    template <typename T1, size_t S1, size_t A1, bool UL1, typename T2, size_t S2, size_t A2, bool UL2>
+    friend bool operator==(const growable_allocator<T1, S1, A1, UL1>& lhs, const growable_allocator<T2, S2, A2, UL2>& rhs) noexcept;
+
+    arena_type* arena_ = nullptr;
+};
+
+// ALIAS
+// -----
+
+template <
+    size_t InlineSize = 0,
+    size_t Alignment = alignof(max_align_t),
+    bool UseLocks = false
+>
+using growable_resource = resource_adaptor<
+    growable_allocator<byte, InlineSize, Alignment, UseLocks>
+>;
+
+template <
+    size_t InlineSize = 0,
+    size_t Alignment = alignof(max_align_t)
+>
+using growable_unlocked_resource = resource_adaptor<
+    growable_allocator<byte, InlineSize, Alignment, false>
+>;
+
+template <
+    size_t InlineSize = 0,
+    size_t Alignment = alignof(max_align_t)
+>
+using growable_locked_resource = resource_adaptor<
+    growable_allocator<byte, InlineSize, Alignment, true>
+>;
+
+template <
+    typename T,
+    size_t InlineSize = 0,
+    size_t Alignment = alignof(max_align_t)
+>
+using growable_locked_allocator = growable_allocator<T, InlineSize, Alignment, true>;
+
+template <
+    typename T,
+    size_t InlineSize = 0,
+    size_t Alignment = alignof(max_align_t)
+>
+using growable_unlocked_allocator = growable_allocator<T, InlineSize, Alignment, false>;
+
+// SPECIALIZATION
+// --------------
+
+template <size_t S, size_t A, bool UL>
+struct is_relocatable<growable_arena<S, A, UL>>: false_type
+{};
+
+template <typename T, size_t S, size_t A, bool UL>
+struct is_relocatable<growable_allocator<T, S, A, UL>>: true_type
+{};
+
+// IMPLEMENTATION
+// --------------
+
+// ARENA
+
+template <size_t S, size_t A, bool UL>
+const size_t growable_arena<S, A, UL>::alignment;
+
+template <size_t S, size_t A, bool UL>
+const size_t growable_arena<S, A, UL>::inline_size;
+
+template <size_t S, size_t A, bool UL>
+const bool growable_arena<S, A, UL>::use_locks;
+
+template <size_t S, size_t A, bool UL>
+template <size_t RequiredAlignment>
+byte* growable_arena<S, A, UL>::allocate(size_t n)
+{
+    lock_guard<mutex_type> lock(mutex_);
+    return growable_arena_base::allocate(n, RequiredAlignment > alignment ? RequiredAlignment : alignment);
+}
+
+
+template <size_t S, size_t A, bool UL>
+inline void growable_arena<S, A, UL>::deallocate(byte* p, size_t n) noexcept
+{
+    lock_guard<mutex_type> lock(mutex_);
+    growable_arena_base::deallocate(p, n, alignment);
+}
+
+// ALLOCATOR
+
+template <typename T, size_t S, size_t A, bool UL>
+const size_t growable_allocator<T, S, A, UL>::alignment;
+
+template <typename T, size_t S, size_t A, bool UL>
+const size_t growable_allocator<T, S, A, UL>::inline_size;
+
+template <typename T, size_t S, size_t A, bool UL>
+const bool growable_allocator<T, S, A, UL>::use_locks;
+
+template <typename T1, size_t S1, size_t A1, bool UL1, typename T2, size_t S2, size_t A2, bool UL2>
+inline bool operator==(const growable_allocator<T1, S1, A1, UL1>& lhs,
+    const growable_allocator<T2, S2, A2, UL2>& rhs) noexcept
+{
+    return lhs.arena_ == rhs.arena_;
+}
+
+template <typename T1, size_t S1, size_t A1, bool UL1, typename T2, size_t S2, size_t A2, bool UL2>
+inline bool operator!=(const growable_allocator<T1, S1, A1, UL1>& lhs,
+    const growable_allocator<T2, S2, A2, UL2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+PYCPP_END_NAMESPACE
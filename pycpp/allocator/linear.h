@@ -38,7 +38,9 @@
  *          ~linear_allocator_arena() noexcept;
  *
  *          template <size_t RequiredAlignment> byte* allocate(size_t n);
+ *          template <size_t RequiredAlignment> byte* try_allocate(size_t n) noexcept;
  *          void deallocate(byte* p, size_t n) noexcept;
+ *          bool owns(const byte* p) const noexcept;
  *
  *          static size_t size() noexcept;
  *          size_t used() const noexcept;
@@ -76,7 +78,9 @@
  *          template <typename T1> self_t& operator=(linear_allocator<T1, StackSize, Alignment, UseLocks>&&) noexcept;
  *
  *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          value_type* try_allocate(size_t n) noexcept;
  *          void deallocate(value_type* p, size_t n);
+ *          bool owns(const value_type* p, size_t n) const noexcept;
  *
  *      private:
  *          arena_type* arena_ = nullptr;
@@ -217,10 +221,16 @@ public:
     // ALLOCATION
 
     template <size_t RequiredAlignment> byte* allocate(size_t n);
+    template <size_t RequiredAlignment> byte* try_allocate(size_t n) noexcept;
     void deallocate(byte* p, size_t n) noexcept;
 
     // PROPERTIES
 
+    bool owns(const byte* p) const noexcept
+    {
+        return (buf_ <= p) && (p < buf_ + stack_size);
+    }
+
     static size_t size() noexcept
     {
         return stack_size;
@@ -385,12 +395,27 @@ public:
         return reinterpret_cast<T*>(arena_->template allocate<alignof(T)>(sizeof(T) * n));
     }
 
+    value_type* try_allocate(size_t n) noexcept
+    {
+        assert(arena_ && "Arena cannot be null.");
+        if (n > stack_size / sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(arena_->template try_allocate<alignof(T)>(sizeof(T) * n));
+    }
+
     void deallocate(value_type* p, size_t n)
     {
         assert(arena_ && "Arena cannot be null.");
         arena_->deallocate(reinterpret_cast<byte*>(p), sizeof(T) * n);
     }
 
+    bool owns(const value_type* p, size_t n) const noexcept
+    {
+        assert(arena_ && "Arena cannot be null.");
+        return arena_->owns(reinterpret_cast<const byte*>(p));
+    }
+
 #if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
 
     template <typename ... Ts>
@@ -491,11 +516,31 @@ const bool linear_allocator_arena<S, A, UL>::use_locks;
 template <size_t S, size_t A, bool UL>
 template <size_t RequiredAlignment>
 byte* linear_allocator_arena<S, A, UL>::allocate(size_t n)
+{
+    static_assert(
+        alignment <= alignof(max_align_t),
+        "Alignment is larger than alignof(max_align_t), and cannot be guaranteed by new."
+    );
+
+    byte* r = try_allocate<RequiredAlignment>(n);
+    if (!r) {
+        throw bad_alloc();
+    }
+    return r;
+}
+
+
+template <size_t S, size_t A, bool UL>
+template <size_t RequiredAlignment>
+byte* linear_allocator_arena<S, A, UL>::try_allocate(size_t n) noexcept
 {
     static_assert(RequiredAlignment <= alignment, "Alignment is too small for this arena");
     assert(pointer_in_buffer(ptr_()) && "Allocator has outlived arena.");
 
     lock_guard<mutex_type> lock(mutex_());
+    if (n > stack_size) {
+        return nullptr;
+    }
     size_t aligned_n = align_up(n);
     if (static_cast<size_t>(buf_ + stack_size - ptr_()) >= aligned_n) {
         byte* r = ptr_();
@@ -503,12 +548,7 @@ byte* linear_allocator_arena<S, A, UL>::allocate(size_t n)
         return r;
     }
 
-    static_assert(
-        alignment <= alignof(max_align_t),
-        "Alignment is larger than alignof(max_align_t), and cannot be guaranteed by new."
-    );
-
-    throw bad_alloc();
+    return nullptr;
 }
 
 
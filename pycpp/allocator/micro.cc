@@ -0,0 +1,318 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/micro.h>
+#include <pycpp/preprocessor/tls.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/new.h>
+#include <stdint.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t MICRO_GRANULARITY = 16;
+static constexpr size_t MICRO_CLASSES = MICRO_MAX_SIZE / MICRO_GRANULARITY;
+static constexpr size_t MICRO_BATCH = 32;
+static constexpr size_t MICRO_CHUNK_SIZE = 64 * 1024;
+
+static_assert(MICRO_CHUNK_SIZE >= MICRO_BATCH * MICRO_MAX_SIZE, "Chunks must hold a batch of each class.");
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Free block, which heads a batch in the depot.
+ */
+struct micro_node
+{
+    micro_node* next;
+    micro_node* batch;
+};
+
+static_assert(sizeof(micro_node) <= MICRO_GRANULARITY, "Blocks must hold a node.");
+
+
+/**
+ *  \brief Central free lists for a size class.
+ *
+ *  Full batches of `MICRO_BATCH` blocks are linked through their
+ *  heads, and single blocks accumulate in a loose list until they
+ *  form a batch. New blocks are carved from a chunk.
+ */
+struct micro_depot
+{
+    mutex mutex_;
+    micro_node* batches = nullptr;
+    micro_node* loose = nullptr;
+    size_t loose_count = 0;
+    byte* cursor = nullptr;
+    byte* end = nullptr;
+};
+
+
+/**
+ *  \brief Per-thread free lists for each size class.
+ *
+ *  Kept trivial so it may use `thread_local_storage`, which avoids
+ *  an initialization check on every access.
+ */
+struct micro_cache
+{
+    micro_node* lists[MICRO_CLASSES];
+    uint32_t counts[MICRO_CLASSES];
+    int state;
+};
+
+enum micro_cache_state
+{
+    micro_cache_uninitialized = 0,
+    micro_cache_live,
+    micro_cache_destroyed,
+};
+
+// HELPERS
+// -------
+
+
+static size_t size_class(size_t n) noexcept
+{
+    return n ? (n - 1) / MICRO_GRANULARITY : 0;
+}
+
+
+static size_t class_size(size_t c) noexcept
+{
+    return (c + 1) * MICRO_GRANULARITY;
+}
+
+
+/**
+ *  \brief Get the depots, which are never destroyed.
+ *
+ *  Caches may be flushed from thread-exit handlers during shutdown,
+ *  so the depots must outlive all static destructors.
+ */
+static micro_depot* get_depots() noexcept
+{
+    static micro_depot* depots = new micro_depot[MICRO_CLASSES];
+    return depots;
+}
+
+
+/**
+ *  \brief Return single blocks to the depot.
+ *
+ *  Requires the depot to be locked.
+ */
+static void release_loose(micro_depot& depot, micro_node* node) noexcept
+{
+    node->next = depot.loose;
+    depot.loose = node;
+    if (++depot.loose_count == MICRO_BATCH) {
+        depot.loose->batch = depot.batches;
+        depot.batches = depot.loose;
+        depot.loose = nullptr;
+        depot.loose_count = 0;
+    }
+}
+
+
+/**
+ *  \brief Carve `count` blocks from the depot's chunk.
+ *
+ *  Requires the depot to be locked.
+ */
+static micro_node* carve(micro_depot& depot, size_t c, size_t count)
+{
+    size_t size = class_size(c);
+    if (static_cast<size_t>(depot.end - depot.cursor) < count * size) {
+        // keep the remainder of the previous chunk
+        while (static_cast<size_t>(depot.end - depot.cursor) >= size) {
+            depot.end -= size;
+            release_loose(depot, reinterpret_cast<micro_node*>(depot.end));
+        }
+        depot.cursor = static_cast<byte*>(operator new(MICRO_CHUNK_SIZE));
+        depot.end = depot.cursor + MICRO_CHUNK_SIZE;
+    }
+
+    micro_node* head = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        micro_node* node = reinterpret_cast<micro_node*>(depot.end - size);
+        depot.end -= size;
+        node->next = head;
+        head = node;
+    }
+    return head;
+}
+
+
+/**
+ *  \brief Take a list of free blocks from the depot.
+ */
+static micro_node* fetch(size_t c, uint32_t& count)
+{
+    micro_depot& depot = get_depots()[c];
+    lock_guard<mutex> lock(depot.mutex_);
+    if (depot.batches) {
+        micro_node* head = depot.batches;
+        depot.batches = head->batch;
+        count = MICRO_BATCH;
+        return head;
+    } else if (depot.loose) {
+        micro_node* head = depot.loose;
+        count = static_cast<uint32_t>(depot.loose_count);
+        depot.loose = nullptr;
+        depot.loose_count = 0;
+        return head;
+    }
+
+    count = MICRO_BATCH;
+    return carve(depot, c, MICRO_BATCH);
+}
+
+
+/**
+ *  \brief Return a full batch to the depot.
+ */
+static void release_batch(size_t c, micro_node* head) noexcept
+{
+    micro_depot& depot = get_depots()[c];
+    lock_guard<mutex> lock(depot.mutex_);
+    head->batch = depot.batches;
+    depot.batches = head;
+}
+
+
+static void release_list(size_t c, micro_node* head) noexcept
+{
+    micro_depot& depot = get_depots()[c];
+    lock_guard<mutex> lock(depot.mutex_);
+    while (head) {
+        micro_node* next = head->next;
+        release_loose(depot, head);
+        head = next;
+    }
+}
+
+// GLOBALS
+// -------
+
+static thread_local_storage micro_cache CACHE = {};
+
+/**
+ *  \brief Flush the thread's cache to the depots on thread exit.
+ */
+struct micro_cache_guard
+{
+    bool registered = false;
+
+    ~micro_cache_guard() noexcept
+    {
+        for (size_t c = 0; c < MICRO_CLASSES; ++c) {
+            release_list(c, CACHE.lists[c]);
+            CACHE.lists[c] = nullptr;
+            CACHE.counts[c] = 0;
+        }
+        CACHE.state = micro_cache_destroyed;
+    }
+};
+
+static thread_local micro_cache_guard GUARD;
+
+// ALLOCATION
+// ----------
+
+
+/**
+ *  \brief Check if the thread's cache may be used, initializing it if required.
+ *
+ *  Threads that only free blocks must also use the cache, or every
+ *  free would lock the depot.
+ */
+static bool cache_live() noexcept
+{
+    if (CACHE.state == micro_cache_uninitialized) {
+        GUARD.registered = true;
+        CACHE.state = micro_cache_live;
+    }
+    return CACHE.state == micro_cache_live;
+}
+
+
+static void* allocate_small(size_t c)
+{
+    if (!cache_live()) {
+        // thread is exiting, bypass the cache
+        uint32_t count;
+        micro_node* head = fetch(c, count);
+        release_list(c, head->next);
+        return head;
+    }
+
+    micro_node* head = CACHE.lists[c];
+    if (!head) {
+        head = fetch(c, CACHE.counts[c]);
+    }
+    CACHE.lists[c] = head->next;
+    --CACHE.counts[c];
+
+    return head;
+}
+
+
+static void deallocate_small(void* p, size_t c) noexcept
+{
+    micro_node* node = static_cast<micro_node*>(p);
+    if (!cache_live()) {
+        // thread is exiting, bypass the cache
+        node->next = nullptr;
+        release_list(c, node);
+        return;
+    }
+
+    node->next = CACHE.lists[c];
+    CACHE.lists[c] = node;
+    if (++CACHE.counts[c] == 2 * MICRO_BATCH) {
+        // return the most recently freed batch, keeping older blocks cached
+        micro_node* tail = node;
+        for (size_t i = 1; i < MICRO_BATCH; ++i) {
+            tail = tail->next;
+        }
+        CACHE.lists[c] = tail->next;
+        CACHE.counts[c] -= MICRO_BATCH;
+        tail->next = nullptr;
+        release_batch(c, node);
+    }
+}
+
+// OBJECTS
+// -------
+
+
+void* micro_allocator_base::allocate(size_t n, size_t size, size_t alignment)
+{
+    if (n > std::numeric_limits<size_t>::max() / size) {
+        throw bad_alloc();
+    }
+
+    size_t bytes = n * size;
+    if (bytes <= MICRO_MAX_SIZE && alignment <= alignof(max_align_t)) {
+        return allocate_small(size_class(bytes));
+    }
+    return operator new(bytes);
+}
+
+
+void micro_allocator_base::deallocate(void* p, size_t n, size_t size, size_t alignment) noexcept
+{
+    size_t bytes = n * size;
+    if (bytes <= MICRO_MAX_SIZE && alignment <= alignof(max_align_t)) {
+        deallocate_small(p, size_class(bytes));
+    } else {
+        operator delete(p);
+    }
+}
+
+PYCPP_END_NAMESPACE
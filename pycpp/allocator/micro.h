@@ -1 +1,183 @@
-// https://blog.molecular-matters.com/2012/08/14/memory-allocation-strategies-a-linear-allocator/
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Thread-caching allocator for small objects.
+ *
+ *  An allocator optimized for small allocations in multithreaded
+ *  programs. Requests up to `MICRO_MAX_SIZE` bytes are rounded up to
+ *  one of a set of size classes, and served from a per-thread cache
+ *  of free blocks without locking. Caches exchange batches of blocks
+ *  with a central depot, which has a lock per size class, so blocks
+ *  freed by a different thread than the one that allocated them are
+ *  recycled through the depot. Caches are flushed to the depot when
+ *  their thread exits.
+ *
+ *  Larger or over-aligned requests are forwarded to `operator new`.
+ *  Memory for small blocks is never returned to the system, so the
+ *  allocator suits programs with a steady working set of small
+ *  objects, such as node-based containers.
+ *
+ *  `micro_allocator` is stateless, and `micro_resource` may be
+ *  installed as the default resource with `set_default_resource`.
+ *
+ *  \synopsis
+ *      static constexpr size_t MICRO_MAX_SIZE = implementation-defined;
+ *
+ *      template <typename T>
+ *      struct micro_allocator
+ *      {
+ *          using value_type = T;
+ *
+ *          micro_allocator() noexcept;
+ *          micro_allocator(const self_t&) noexcept;
+ *          template <typename U> micro_allocator(const micro_allocator<U>&) noexcept;
+ *          self_t& operator=(const self_t&) noexcept;
+ *          template <typename U> self_t& operator=(const micro_allocator<U>&) noexcept;
+ *          ~micro_allocator() = default;
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          void deallocate(value_type* p, size_t n);
+ *      };
+ *
+ *      using micro_resource = resource_adaptor<micro_allocator<byte>>;
+ *
+ *      template <typename T, typename U>
+ *      inline bool operator==(const micro_allocator<T>&, const micro_allocator<U>&) noexcept;
+ *
+ *      template <typename T, typename U>
+ *      inline bool operator!=(const micro_allocator<T>&, const micro_allocator<U>&) noexcept
+ */
+
+#pragma once
+
+#include <pycpp/stl/limits.h>
+#include <pycpp/stl/memory.h>
+#include <stddef.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t MICRO_MAX_SIZE = 256;
+
+// FORWARD
+// -------
+
+template <typename T>
+struct micro_allocator;
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Base for the small-object allocator.
+ */
+struct micro_allocator_base
+{
+    static void* allocate(size_t n, size_t size, size_t alignment);
+    static void deallocate(void* p, size_t n, size_t size, size_t alignment) noexcept;
+};
+
+
+/**
+ *  \brief Thread-caching small-object allocator.
+ */
+template <typename T>
+struct micro_allocator: private micro_allocator_base
+{
+    // MEMBER TYPES
+    // ------------
+    using self_t = micro_allocator<T>;
+    using value_type = T;
+    using is_always_equal = true_type;
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    template <typename U> struct rebind { using other = micro_allocator<U>; };
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // MEMBER FUNCTIONS
+    // ----------------
+    micro_allocator() noexcept = default;
+    micro_allocator(const self_t&) noexcept = default;
+    self_t& operator=(const self_t&) noexcept = default;
+    ~micro_allocator() noexcept = default;
+
+    template <typename U>
+    micro_allocator(const micro_allocator<U>&) noexcept
+    {}
+
+    template <typename U>
+    self_t& operator=(const micro_allocator<U>&) noexcept
+    {
+        return *this;
+    }
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        return reinterpret_cast<value_type*>(micro_allocator_base::allocate(n, sizeof(value_type), alignof(value_type)));
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        micro_allocator_base::deallocate(p, n, sizeof(value_type), alignof(value_type));
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(T* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) T(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(T* p)
+    {
+        p->~T();
+    }
+
+    size_type max_size()
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+};
+
+// ALIAS
+// -----
+
+using micro_resource = resource_adaptor<micro_allocator<byte>>;
+
+// SPECIALIZATION
+// --------------
+
+template <typename T>
+struct is_relocatable<micro_allocator<T>>: true_type
+{};
+
+// IMPLEMENTATION
+// --------------
+
+template <typename T, typename U>
+inline bool operator==(const micro_allocator<T>&, const micro_allocator<U>&) noexcept
+{
+    return true;
+}
+
+
+template <typename T, typename U>
+inline bool operator!=(const micro_allocator<T>& lhs, const micro_allocator<U>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+PYCPP_END_NAMESPACE
@@ -25,7 +25,9 @@
  *
  *          value_type* allocate(size_t n, const void* hint = nullptr);
  *          value_type* reallocate(value_type* p, size_t old_size, size_t new_size, const void* hint = nullptr);
+ *          value_type* try_allocate(size_t n) noexcept;
  *          void deallocate(value_type* p, size_t n);
+ *          bool owns(const value_type* p, size_t n) const noexcept;
  *      };
  *
  *      using null_resource = resource_adaptor<null_allocator<byte>>;
@@ -101,9 +103,19 @@ struct null_allocator
         throw bad_alloc();
     }
 
+    value_type* try_allocate(size_t n) noexcept
+    {
+        return nullptr;
+    }
+
     void deallocate(value_type* p, size_t n)
     {}
 
+    bool owns(const value_type* p, size_t n) const noexcept
+    {
+        return false;
+    }
+
 #if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
 
     template <typename ... Ts>
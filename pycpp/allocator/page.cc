@@ -0,0 +1,317 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/page.h>
+#include <pycpp/preprocessor/os.h>
+#include <pycpp/stl/new.h>
+#include <stdint.h>
+
+#if defined(OS_WINDOWS)
+#   include <pycpp/windows/winapi.h>
+#elif defined(HAVE_SYS_MMAN_H)
+#   include <sys/mman.h>
+#   include <stdio.h>
+#   include <unistd.h>
+#   if defined(OS_LINUX)
+#       include <sys/syscall.h>
+#   endif
+#endif
+
+PYCPP_BEGIN_NAMESPACE
+
+// MACROS
+// ------
+
+#if !defined(MAP_ANON) && defined(MAP_ANONYMOUS)
+#   define MAP_ANON MAP_ANONYMOUS
+#endif
+
+#if defined(OS_WINDOWS)
+#   define HAVE_VIRTUAL_ALLOC
+#elif defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP) && defined(MAP_ANON)
+#   define HAVE_ANONYMOUS_MMAP
+#endif
+
+#if defined(OS_LINUX) && defined(SYS_mbind)
+#   define HAVE_MBIND
+#endif
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t DEFAULT_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+#if defined(HAVE_MBIND)
+static constexpr int MPOL_BIND_MODE = 2;
+static constexpr size_t MBIND_MASK_WORDS = 16;
+#endif
+
+// HELPERS
+// -------
+
+
+static size_t round_up(size_t n, size_t alignment)
+{
+    if (n > std::numeric_limits<size_t>::max() - (alignment-1)) {
+        throw bad_alloc();
+    }
+    return (n + (alignment-1)) & ~(alignment-1);
+}
+
+
+static size_t get_page_size_impl() noexcept
+{
+#if defined(HAVE_VIRTUAL_ALLOC)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#elif defined(_SC_PAGESIZE)
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<size_t>(size) : 4096;
+#else
+    return 4096;
+#endif
+}
+
+
+static size_t get_huge_page_size_impl() noexcept
+{
+#if defined(HAVE_VIRTUAL_ALLOC)
+    size_t size = GetLargePageMinimum();
+    return size ? size : DEFAULT_HUGE_PAGE_SIZE;
+#elif defined(OS_LINUX)
+    size_t size = DEFAULT_HUGE_PAGE_SIZE;
+    FILE* file = fopen("/proc/meminfo", "r");
+    if (file) {
+        char line[128];
+        unsigned long kb;
+        while (fgets(line, sizeof(line), file)) {
+            if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+                size = static_cast<size_t>(kb) * 1024;
+                break;
+            }
+        }
+        fclose(file);
+    }
+    return size;
+#else
+    return DEFAULT_HUGE_PAGE_SIZE;
+#endif
+}
+
+
+/**
+ *  \brief Get the length of the mapping backing `bytes`.
+ */
+static size_t mapping_size(size_t bytes, const page_options& options)
+{
+    if (options.huge == page_huge_none) {
+        return round_up(bytes ? bytes : 1, page_allocator_base::page_size());
+    }
+    return round_up(bytes ? bytes : 1, page_allocator_base::huge_page_size());
+}
+
+
+static size_t checked_bytes(size_t n, size_t size)
+{
+    if (n > std::numeric_limits<size_t>::max() / size) {
+        throw bad_alloc();
+    }
+    return n * size;
+}
+
+
+#if defined(HAVE_ANONYMOUS_MMAP)                // MMAP
+
+static void* map_pages(size_t length, int flags) noexcept
+{
+    void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+
+/**
+ *  \brief Map pages aligned to `alignment`, trimming the excess.
+ */
+static void* map_aligned(size_t length, size_t alignment) noexcept
+{
+    if (length > std::numeric_limits<size_t>::max() - alignment) {
+        return nullptr;
+    }
+
+    byte* p = static_cast<byte*>(map_pages(length + alignment, 0));
+    if (!p) {
+        return nullptr;
+    }
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(p);
+    byte* aligned = p + ((alignment - (address & (alignment-1))) & (alignment-1));
+    if (aligned != p) {
+        ::munmap(p, static_cast<size_t>(aligned - p));
+    }
+    size_t tail = static_cast<size_t>((p + length + alignment) - (aligned + length));
+    if (tail) {
+        ::munmap(aligned + length, tail);
+    }
+
+    return aligned;
+}
+
+
+static void bind_pages(void* p, size_t length, int node) noexcept
+{
+#if defined(HAVE_MBIND)
+    // call the system directly, to avoid a dependency on libnuma
+    unsigned long mask[MBIND_MASK_WORDS] = {};
+    size_t bits = sizeof(unsigned long) * 8;
+    if (node >= 0 && static_cast<size_t>(node) < MBIND_MASK_WORDS * bits) {
+        mask[node / bits] |= 1UL << (node % bits);
+        syscall(SYS_mbind, p, length, MPOL_BIND_MODE, mask, MBIND_MASK_WORDS * bits + 1, 0);
+    }
+#endif
+}
+
+
+static void* allocate_pages(size_t length, const page_options& options) noexcept
+{
+    void* p = nullptr;
+#if defined(MAP_HUGETLB)
+    if (options.huge == page_huge_explicit) {
+        p = map_pages(length, MAP_HUGETLB);
+    }
+#endif
+
+    if (!p && options.huge != page_huge_none) {
+        p = map_aligned(length, page_allocator_base::huge_page_size());
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+        if (p) {
+            ::madvise(p, length, MADV_HUGEPAGE);
+        }
+#endif
+    } else if (!p) {
+        p = map_pages(length, 0);
+    }
+
+    if (p && options.node != PAGE_NODE_ANY) {
+        bind_pages(p, length, options.node);
+    }
+    return p;
+}
+
+
+static void deallocate_pages(void* p, size_t length) noexcept
+{
+    ::munmap(p, length);
+}
+
+
+static void release_pages(void* p, size_t length) noexcept
+{
+#if defined(HAVE_MADVISE)
+    ::madvise(p, length, MADV_DONTNEED);
+#endif
+}
+
+#elif defined(HAVE_VIRTUAL_ALLOC)               // VIRTUAL ALLOC
+
+static void* allocate_pages(size_t length, const page_options& options) noexcept
+{
+    void* p = nullptr;
+    DWORD type = MEM_RESERVE | MEM_COMMIT;
+    if (options.huge == page_huge_explicit && GetLargePageMinimum()) {
+        // requires SeLockMemoryPrivilege
+        type |= MEM_LARGE_PAGES;
+    }
+
+    for (;;) {
+        if (options.node != PAGE_NODE_ANY) {
+            p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, length, type, PAGE_READWRITE, static_cast<DWORD>(options.node));
+        } else {
+            p = VirtualAlloc(nullptr, length, type, PAGE_READWRITE);
+        }
+        if (p || !(type & MEM_LARGE_PAGES)) {
+            return p;
+        }
+        type &= ~MEM_LARGE_PAGES;
+    }
+}
+
+
+static void deallocate_pages(void* p, size_t) noexcept
+{
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+
+static void release_pages(void* p, size_t length) noexcept
+{
+    // decommit and recommit, so released pages read as zero
+    if (VirtualFree(p, length, MEM_DECOMMIT)) {
+        VirtualAlloc(p, length, MEM_COMMIT, PAGE_READWRITE);
+    }
+}
+
+#else                                           // HEAP
+
+static void* allocate_pages(size_t length, const page_options&) noexcept
+{
+    return operator new(length, std::nothrow);
+}
+
+
+static void deallocate_pages(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+
+static void release_pages(void*, size_t) noexcept
+{}
+
+#endif                                          // MMAP
+
+// OBJECTS
+// -------
+
+
+void* page_allocator_base::allocate(size_t n, size_t size, const page_options& options)
+{
+    void* p = allocate_pages(mapping_size(checked_bytes(n, size), options), options);
+    if (!p) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+
+void page_allocator_base::deallocate(void* p, size_t n, size_t size, const page_options& options) noexcept
+{
+    deallocate_pages(p, mapping_size(n * size, options));
+}
+
+
+void page_allocator_base::release(void* p, size_t n, size_t size) noexcept
+{
+    size_t mask = page_size() - 1;
+    uintptr_t first = (reinterpret_cast<uintptr_t>(p) + mask) & ~mask;
+    uintptr_t last = (reinterpret_cast<uintptr_t>(p) + n * size) & ~mask;
+    if (last > first) {
+        release_pages(reinterpret_cast<void*>(first), static_cast<size_t>(last - first));
+    }
+}
+
+
+size_t page_allocator_base::page_size() noexcept
+{
+    static size_t size = get_page_size_impl();
+    return size;
+}
+
+
+size_t page_allocator_base::huge_page_size() noexcept
+{
+    static size_t size = get_huge_page_size_impl();
+    return size;
+}
+
+PYCPP_END_NAMESPACE
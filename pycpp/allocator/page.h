@@ -1,2 +1,266 @@
-// Virtual page allocator....
-// TODO: here...
\ No newline at end of file
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Allocator that maps whole pages from the operating system.
+ *
+ *  An allocator for large, long-lived buffers, such as arenas, hash
+ *  tables and I/O buffers, which maps anonymous pages directly rather
+ *  than using the heap. Every allocation is rounded up to whole pages,
+ *  so the allocator is wasteful for small objects.
+ *
+ *  Allocations may be backed by huge pages, to reduce TLB misses:
+ *  `page_huge_transparent` aligns mappings to the huge page size and
+ *  advises the kernel to use transparent huge pages, while
+ *  `page_huge_explicit` requests pages from the reserved huge page
+ *  pool, falling back to transparent huge pages if the pool is
+ *  exhausted. Pages may also be bound to a NUMA node, when supported
+ *  by the system. Both are hints, and are ignored where unsupported.
+ *
+ *  `release()` returns the physical memory backing a range of pages
+ *  to the system, while keeping the range mapped: released pages
+ *  read as zero when next accessed.
+ *
+ *  \synopsis
+ *      static constexpr int PAGE_NODE_ANY = -1;
+ *
+ *      enum page_huge
+ *      {
+ *          page_huge_none = 0,
+ *          page_huge_transparent,
+ *          page_huge_explicit,
+ *      };
+ *
+ *      struct page_options
+ *      {
+ *          page_huge huge = page_huge_none;
+ *          int node = PAGE_NODE_ANY;
+ *      };
+ *
+ *      template <typename T>
+ *      class page_allocator
+ *      {
+ *      public:
+ *          using value_type = T;
+ *
+ *          page_allocator() noexcept;
+ *          page_allocator(const page_options& options) noexcept;
+ *          page_allocator(const self_t&) noexcept;
+ *          template <typename U> page_allocator(const page_allocator<U>&) noexcept;
+ *          self_t& operator=(const self_t&) noexcept;
+ *          template <typename U> self_t& operator=(const page_allocator<U>&) noexcept;
+ *          ~page_allocator() = default;
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          void deallocate(value_type* p, size_t n);
+ *          void release(value_type* p, size_t n) noexcept;
+ *
+ *          const page_options& options() const noexcept;
+ *          static size_t page_size() noexcept;
+ *          static size_t huge_page_size() noexcept;
+ *      };
+ *
+ *      using page_resource = resource_adaptor<page_allocator<byte>>;
+ *
+ *      template <typename T, typename U>
+ *      inline bool operator==(const page_allocator<T>&, const page_allocator<U>&) noexcept;
+ *
+ *      template <typename T, typename U>
+ *      inline bool operator!=(const page_allocator<T>&, const page_allocator<U>&) noexcept
+ */
+
+#pragma once
+
+#include <pycpp/stl/limits.h>
+#include <pycpp/stl/memory.h>
+#include <stddef.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr int PAGE_NODE_ANY = -1;
+
+// ENUMS
+// -----
+
+/**
+ *  \brief Huge page policy for page allocations.
+ */
+enum page_huge
+{
+    page_huge_none = 0,
+    page_huge_transparent,
+    page_huge_explicit,
+};
+
+// FORWARD
+// -------
+
+template <typename T>
+class page_allocator;
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Placement options for page allocations.
+ */
+struct page_options
+{
+    page_huge huge = page_huge_none;
+    int node = PAGE_NODE_ANY;
+};
+
+
+/**
+ *  \brief Base for the page allocator.
+ */
+struct page_allocator_base
+{
+    static void* allocate(size_t n, size_t size, const page_options& options);
+    static void deallocate(void* p, size_t n, size_t size, const page_options& options) noexcept;
+    static void release(void* p, size_t n, size_t size) noexcept;
+    static size_t page_size() noexcept;
+    static size_t huge_page_size() noexcept;
+};
+
+
+/**
+ *  \brief Page-granular memory allocator.
+ */
+template <typename T>
+class page_allocator: private page_allocator_base
+{
+public:
+    // MEMBER TYPES
+    // ------------
+    using self_t = page_allocator<T>;
+    using value_type = T;
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    template <typename U> struct rebind { using other = page_allocator<U>; };
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // MEMBER FUNCTIONS
+    // ----------------
+    page_allocator() noexcept = default;
+    page_allocator(const self_t&) noexcept = default;
+    self_t& operator=(const self_t&) noexcept = default;
+    ~page_allocator() noexcept = default;
+
+    page_allocator(const page_options& options) noexcept:
+        options_(options)
+    {}
+
+    template <typename U>
+    page_allocator(const page_allocator<U>& rhs) noexcept:
+        options_(rhs.options())
+    {}
+
+    template <typename U>
+    self_t& operator=(const page_allocator<U>& rhs) noexcept
+    {
+        options_ = rhs.options();
+        return *this;
+    }
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        return reinterpret_cast<value_type*>(page_allocator_base::allocate(n, sizeof(value_type), options_));
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        page_allocator_base::deallocate(p, n, sizeof(value_type), options_);
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(T* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) T(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(T* p)
+    {
+        p->~T();
+    }
+
+    size_type max_size()
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // PAGES
+
+    /**
+     *  \brief Return the pages spanned by `[p, p+n)` to the system.
+     *
+     *  Only pages entirely within the range are released.
+     */
+    void release(value_type* p, size_t n) noexcept
+    {
+        page_allocator_base::release(p, n, sizeof(value_type));
+    }
+
+    const page_options& options() const noexcept
+    {
+        return options_;
+    }
+
+    static size_t page_size() noexcept
+    {
+        return page_allocator_base::page_size();
+    }
+
+    static size_t huge_page_size() noexcept
+    {
+        return page_allocator_base::huge_page_size();
+    }
+
+private:
+    page_options options_;
+};
+
+// ALIAS
+// -----
+
+using page_resource = resource_adaptor<page_allocator<byte>>;
+
+// SPECIALIZATION
+// --------------
+
+template <typename T>
+struct is_relocatable<page_allocator<T>>: true_type
+{};
+
+// IMPLEMENTATION
+// --------------
+
+template <typename T, typename U>
+inline bool operator==(const page_allocator<T>& lhs, const page_allocator<U>& rhs) noexcept
+{
+    // placement does not affect deallocation, only the mapping size
+    return lhs.options().huge == rhs.options().huge;
+}
+
+
+template <typename T, typename U>
+inline bool operator!=(const page_allocator<T>& lhs, const page_allocator<U>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+PYCPP_END_NAMESPACE
@@ -1 +1,36 @@
-// TODO: implement
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/pool.h>
+#include <pycpp/stl/new.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// OBJECTS
+// -------
+
+
+/**
+ *  \brief Allocate a chunk, link it into `chunks`, and return its first block.
+ */
+byte* pool_arena_base::allocate_chunk(chunk*& chunks, size_t header, size_t size)
+{
+    byte* p = static_cast<byte*>(operator new(header + size));
+    chunk* c = reinterpret_cast<chunk*>(p);
+    c->next = chunks;
+    chunks = c;
+
+    return p + header;
+}
+
+
+void pool_arena_base::deallocate_chunks(chunk* chunks) noexcept
+{
+    while (chunks) {
+        chunk* next = chunks->next;
+        operator delete(chunks);
+        chunks = next;
+    }
+}
+
+PYCPP_END_NAMESPACE
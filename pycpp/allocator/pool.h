@@ -6,57 +6,549 @@
  *  \brief Memory pool allocator.
  *
  *  An allocator that optimizes for types of known size by using
- *  a memory pool to allocate each block.
+ *  a memory pool to allocate each block. Blocks are carved from
+ *  chunks of `N` blocks, and freed blocks are kept in an intrusive
+ *  free list, so allocation and deallocation are O(1). Chunks are
+ *  only returned to the system when the arena is destroyed.
+ *
+ *  Pool allocators take advantage of fixed-size allocations, and
+ *  therefore suit node-based containers (`list`, `map`, `set`, and
+ *  the nodes of `unordered_map`), which request items 1x1. Array
+ *  allocations, such as a `vector` buffer or hash table buckets,
+ *  are forwarded to `operator new`.
+ *
+ *  `pool_allocator` is stateless: every allocator for blocks of the
+ *  same size and alignment shares an arena, so rebound copies
+ *  allocate from the arena for the rebound type. Locked and lock-free
+ *  allocators share a process-wide arena, while unlocked allocators
+ *  use an arena per thread, so containers on different threads never
+ *  race. Blocks freed on another thread join that thread's arena,
+ *  and the arena of an exiting thread is handed to the next thread.
+ *  Arenas are never destroyed, so containers with static storage
+ *  duration may safely outlive them.
+ *
+ *  Three locking policies are available: `pool_unlocked` arenas are
+ *  not thread-safe, `pool_locked` arenas use a mutex, and
+ *  `pool_lock_free` arenas use a lock-free free list, with a tagged
+ *  pointer to avoid the ABA problem, and only lock to grow. Blocks
+ *  whose addresses overlap the tag bits, on systems with more than
+ *  48-bit virtual addresses, fall back to a locked free list.
+ *
+ *  `pool_resource` is a memory resource with its own arena, which
+ *  allocates requests up to `BlockSize` bytes from the pool, and
+ *  forwards larger requests to an upstream resource.
+ *
+ *  \synopsis
+ *      static constexpr size_t POOL_BLOCK_COUNT = implementation-defined;
+ *
+ *      enum pool_locking
+ *      {
+ *          pool_unlocked = 0,
+ *          pool_locked,
+ *          pool_lock_free,
+ *      };
+ *
+ *      template <
+ *          size_t BlockSize,
+ *          size_t BlockCount = POOL_BLOCK_COUNT,
+ *          size_t Alignment = implementation-defined,
+ *          pool_locking Locking = pool_unlocked
+ *      >
+ *      class pool_arena
+ *      {
+ *      public:
+ *          static constexpr size_t block_size = implementation-defined;
+ *          static constexpr size_t block_count = BlockCount;
+ *          static constexpr size_t alignment = Alignment;
+ *          static constexpr pool_locking locking = Locking;
+ *
+ *          pool_arena() noexcept;
+ *          pool_arena(const pool_arena&) = delete;
+ *          pool_arena& operator=(const pool_arena&) = delete;
+ *          pool_arena(pool_arena&&) = delete;
+ *          pool_arena& operator=(pool_arena&&) = delete;
+ *          ~pool_arena() noexcept;
+ *
+ *          void* allocate();
+ *          void deallocate(void* p) noexcept;
+ *          size_t chunks() const noexcept;
+ *      };
+ *
+ *      template <typename Arena>
+ *      Arena& shared_pool_arena() noexcept;
+ *
+ *      template <typename Arena>
+ *      Arena& thread_pool_arena() noexcept;
+ *
+ *      template <
+ *          typename T,
+ *          size_t N = POOL_BLOCK_COUNT,
+ *          size_t Alignment = alignof(T),
+ *          pool_locking Locking = pool_unlocked
+ *      >
+ *      class pool_allocator
+ *      {
+ *      public:
+ *          using value_type = T;
+ *          using arena_type = pool_arena<implementation-defined, N, implementation-defined, Locking>;
+ *
+ *          pool_allocator() noexcept;
+ *          pool_allocator(const self_t&) noexcept;
+ *          self_t& operator=(const self_t&) noexcept;
+ *          ~pool_allocator() noexcept;
+ *          template <typename T1, size_t A1> pool_allocator(const pool_allocator<T1, N, A1, Locking>&) noexcept;
+ *          template <typename T1, size_t A1> self_t& operator=(const pool_allocator<T1, N, A1, Locking>&) noexcept;
+ *
+ *          value_type* allocate(size_t n, const void* hint = nullptr);
+ *          void deallocate(value_type* p, size_t n);
+ *
+ *          static arena_type& arena() noexcept;
+ *      };
+ *
+ *      template <
+ *          size_t BlockSize,
+ *          size_t N = POOL_BLOCK_COUNT,
+ *          pool_locking Locking = pool_unlocked
+ *      >
+ *      class pool_resource: public memory_resource
+ *      {
+ *      public:
+ *          using arena_type = pool_arena<BlockSize, N, alignof(max_align_t), Locking>;
+ *
+ *          pool_resource(memory_resource* upstream = new_delete_resource()) noexcept;
+ *          memory_resource* upstream_resource() const noexcept;
+ *          arena_type& arena() noexcept;
+ *      };
+ *
+ *      template <typename T, size_t N = POOL_BLOCK_COUNT>
+ *      using pool_unlocked_allocator = pool_allocator<T, N, alignof(T), pool_unlocked>;
+ *
+ *      template <typename T, size_t N = POOL_BLOCK_COUNT>
+ *      using pool_locked_allocator = pool_allocator<T, N, alignof(T), pool_locked>;
+ *
+ *      template <typename T, size_t N = POOL_BLOCK_COUNT>
+ *      using pool_lock_free_allocator = pool_allocator<T, N, alignof(T), pool_lock_free>;
+ *
+ *      template <size_t BlockSize, size_t N = POOL_BLOCK_COUNT>
+ *      using pool_unlocked_resource = pool_resource<BlockSize, N, pool_unlocked>;
+ *
+ *      template <size_t BlockSize, size_t N = POOL_BLOCK_COUNT>
+ *      using pool_locked_resource = pool_resource<BlockSize, N, pool_locked>;
+ *
+ *      template <size_t BlockSize, size_t N = POOL_BLOCK_COUNT>
+ *      using pool_lock_free_resource = pool_resource<BlockSize, N, pool_lock_free>;
+ *
+ *      template <typename T1, size_t N1, size_t A1, pool_locking L1, typename T2, size_t N2, size_t A2, pool_locking L2>
+ *      bool operator==(const pool_allocator<T1, N1, A1, L1>& lhs,
+ *          const pool_allocator<T2, N2, A2, L2>& rhs) noexcept;
+ *
+ *      template <typename T1, size_t N1, size_t A1, pool_locking L1, typename T2, size_t N2, size_t A2, pool_locking L2>
+ *      bool operator!=(const pool_allocator<T1, N1, A1, L1>& lhs,
+ *          const pool_allocator<T2, N2, A2, L2>& rhs) noexcept;
  */
 
-//// TODO: implement
-//// Pool allocators take advantage of fixed-size allocations
-//// Array allocations make no sense, since they break this.
-//// It will therefore work with list, and not vector,
-//// since items must be requested 1x1.
-//
-//// Boost has a fast pool allocator, which works like this.
-//// It all has a pool allocator, which can handle custom shapes.
-//
-//// I might need a custom mutex for the implementation...
-//// This allocator is not thread-safe, which...
-
 #pragma once
 
-#include <pycpp/config.h>
-#include <limits.h>
+#include <pycpp/preprocessor/tls.h>
+#include <pycpp/stl/atomic.h>
+#include <pycpp/stl/limits.h>
+#include <pycpp/stl/memory.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/type_traits.h>
+#include <pycpp/stl/vector.h>
+#include <assert.h>
 #include <stddef.h>
+#include <stdint.h>
 
 PYCPP_BEGIN_NAMESPACE
 
+// CONSTANTS
+// ---------
+
+static constexpr size_t POOL_BLOCK_COUNT = 256;
+
+// ENUMS
+// -----
+
+/**
+ *  \brief Thread-safety of a pool arena.
+ */
+enum pool_locking
+{
+    pool_unlocked = 0,
+    pool_locked,
+    pool_lock_free,
+};
+
+// FORWARD
+// -------
+
+template <
+    size_t BlockSize,
+    size_t BlockCount = POOL_BLOCK_COUNT,
+    size_t Alignment = alignof(max_align_t),
+    pool_locking Locking = pool_unlocked
+>
+class pool_arena;
+
+template <
+    typename T,
+    size_t N = POOL_BLOCK_COUNT,
+    size_t Alignment = alignof(T),
+    pool_locking Locking = pool_unlocked
+>
+class pool_allocator;
+
 // DECLARATIONS
 // ------------
 
+/**
+ *  \brief Chunk and free list management shared by all arenas.
+ */
+struct pool_arena_base
+{
+protected:
+    struct slot
+    {
+        slot* next;
+    };
+
+    struct chunk
+    {
+        chunk* next;
+    };
+
+    static constexpr size_t align_up(size_t n, size_t alignment) noexcept
+    {
+        return (n + (alignment-1)) & ~(alignment-1);
+    }
+
+    static byte* allocate_chunk(chunk*& chunks, size_t header, size_t size);
+    static void deallocate_chunks(chunk* chunks) noexcept;
+};
+
+
+/**
+ *  \brief Arena of fixed-size blocks, with a free list.
+ *
+ *  Blocks are at least large enough to store a pointer, and are
+ *  rounded up to a multiple of the alignment. Copy and move
+ *  constructors are disabled, since outstanding blocks point
+ *  into the arena's chunks.
+ */
+template <
+    size_t BlockSize,
+    size_t BlockCount,
+    size_t Alignment,
+    pool_locking Locking
+>
+class pool_arena: pool_arena_base
+{
+public:
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr size_t block_size = align_up(BlockSize < sizeof(slot) ? sizeof(slot) : BlockSize, Alignment);
+    static constexpr size_t block_count = BlockCount;
+    static constexpr size_t alignment = Alignment;
+    static constexpr pool_locking locking = Locking;
+
+    // MEMBER TYPES
+    // ------------
+    using mutex_type = conditional_t<Locking == pool_locked, mutex, dummy_mutex>;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    pool_arena(const pool_arena&) = delete;
+    pool_arena& operator=(const pool_arena&) = delete;
+    pool_arena(pool_arena&&) = delete;
+    pool_arena& operator=(pool_arena&&) = delete;
+    pool_arena() noexcept = default;
+
+    ~pool_arena() noexcept
+    {
+        deallocate_chunks(chunks_);
+    }
+
+    // ALLOCATION
+
+    void* allocate();
+    void deallocate(void* p) noexcept;
+
+    // PROPERTIES
+
+    size_t chunks() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return count_;
+    }
+
+private:
+    static constexpr size_t header = align_up(sizeof(chunk), Alignment);
+
+    slot* free_ = nullptr;
+    byte* cursor_ = nullptr;
+    byte* end_ = nullptr;
+    chunk* chunks_ = nullptr;
+    size_t count_ = 0;
+    mutable mutex_type mutex_;
+
+    static_assert(BlockCount > 0, "Chunks must contain at least one block.");
+    static_assert((Alignment & (Alignment-1)) == 0, "Alignment must be a power of 2.");
+    static_assert(
+        Alignment <= alignof(max_align_t),
+        "Alignment is larger than alignof(max_align_t), and cannot be guaranteed by new."
+    );
+};
+
+
+/**
+ *  \brief Arena of fixed-size blocks, with a lock-free free list.
+ *
+ *  The head of the free list packs a modification tag beside the
+ *  pointer, so a block popped and pushed back concurrently cannot
+ *  be mistaken for an unchanged head. On 64-bit systems, the tag
+ *  uses the 16 bits above the 48-bit virtual address space. Chunks
+ *  mapped above it, with 52- or 57-bit address spaces, are kept in
+ *  a free list guarded by the mutex instead.
+ */
+template <
+    size_t BlockSize,
+    size_t BlockCount,
+    size_t Alignment
+>
+class pool_arena<BlockSize, BlockCount, Alignment, pool_lock_free>: pool_arena_base
+{
+public:
+    // STATIC VARIABLES
+    // ----------------
+    static constexpr size_t block_size = align_up(BlockSize < sizeof(slot) ? sizeof(slot) : BlockSize, Alignment);
+    static constexpr size_t block_count = BlockCount;
+    static constexpr size_t alignment = Alignment;
+    static constexpr pool_locking locking = pool_lock_free;
+
+    // MEMBER TYPES
+    // ------------
+    using mutex_type = mutex;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+
+    // CONSTRUCTORS
+
+    pool_arena(const pool_arena&) = delete;
+    pool_arena& operator=(const pool_arena&) = delete;
+    pool_arena(pool_arena&&) = delete;
+    pool_arena& operator=(pool_arena&&) = delete;
+    pool_arena() noexcept = default;
+
+    ~pool_arena() noexcept
+    {
+        deallocate_chunks(chunks_);
+    }
+
+    // ALLOCATION
+
+    void* allocate();
+    void deallocate(void* p) noexcept;
+
+    // PROPERTIES
+
+    size_t chunks() const noexcept
+    {
+        lock_guard<mutex_type> lock(mutex_);
+        return count_;
+    }
+
+private:
+    static constexpr size_t header = align_up(sizeof(chunk), Alignment);
+    static constexpr unsigned pointer_bits = sizeof(void*) == 8 ? 48 : 32;
+    static constexpr uint64_t pointer_mask = (uint64_t(1) << pointer_bits) - 1;
+
+    atomic<uint64_t> head_ = {0};
+    slot* spill_ = nullptr;
+    chunk* chunks_ = nullptr;
+    size_t count_ = 0;
+    mutable mutex_type mutex_;
+
+    static slot* pointer(uint64_t head) noexcept
+    {
+        return reinterpret_cast<slot*>(static_cast<uintptr_t>(head & pointer_mask));
+    }
+
+    static bool packable(const void* p) noexcept
+    {
+        return (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) & ~pointer_mask) == 0;
+    }
+
+    static uint64_t pack(slot* p, uint64_t head) noexcept
+    {
+        // `p` may be stale data, which the tag comparison rejects
+        uint64_t address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p));
+        return (address & pointer_mask) | ((head & ~pointer_mask) + (pointer_mask + 1));
+    }
+
+    /**
+     *  \brief Atomically access the link of a free block.
+     *
+     *  A stale popper may read a block after another thread popped
+     *  it, so links are only accessed through relaxed atomics.
+     */
+    static atomic<slot*>& link(slot* p) noexcept
+    {
+        return *reinterpret_cast<atomic<slot*>*>(&p->next);
+    }
+
+    slot* pop() noexcept;
+    void push(slot* first, slot* last) noexcept;
+
+    static_assert(BlockCount > 0, "Chunks must contain at least one block.");
+    static_assert((Alignment & (Alignment-1)) == 0, "Alignment must be a power of 2.");
+    static_assert(
+        Alignment <= alignof(max_align_t),
+        "Alignment is larger than alignof(max_align_t), and cannot be guaranteed by new."
+    );
+    static_assert(sizeof(atomic<slot*>) == sizeof(slot*), "Links must be accessible as atomics.");
+};
+
+// FUNCTIONS
+
+/**
+ *  \brief Get the process-wide arena of a given type.
+ *
+ *  The arena is never destroyed, so containers with static
+ *  storage duration may safely outlive it.
+ */
+template <typename Arena>
+Arena& shared_pool_arena() noexcept
+{
+    static Arena* instance = new Arena;
+    return *instance;
+}
+
+
+/**
+ *  \brief Per-thread arenas, recycled when threads exit.
+ *
+ *  Blocks may outlive the thread that allocated them, so arenas
+ *  are never destroyed: an exiting thread returns its arena to a
+ *  process-wide list, to be adopted by the next thread.
+ */
+template <typename Arena>
+class thread_pool_arenas
+{
+public:
+    static Arena& get() noexcept
+    {
+        Arena* arena = current();
+        return arena ? *arena : adopt();
+    }
+
+private:
+    struct orphan_list
+    {
+        mutex mutex_;
+        vector<Arena*> arenas_;
+    };
+
+    struct guard
+    {
+        ~guard() noexcept
+        {
+            exited() = true;
+            orphan_list& list = orphans();
+            lock_guard<mutex> lock(list.mutex_);
+            list.arenas_.push_back(current());
+            current() = nullptr;
+        }
+    };
+
+    static Arena*& current() noexcept
+    {
+        static thread_local_storage Arena* arena = nullptr;
+        return arena;
+    }
+
+    static bool& exited() noexcept
+    {
+        static thread_local_storage bool value = false;
+        return value;
+    }
+
+    static orphan_list& orphans() noexcept
+    {
+        static orphan_list* list = new orphan_list;
+        return *list;
+    }
+
+    static Arena& adopt() noexcept
+    {
+        Arena* arena = nullptr;
+        {
+            orphan_list& list = orphans();
+            lock_guard<mutex> lock(list.mutex_);
+            if (!list.arenas_.empty()) {
+                arena = list.arenas_.back();
+                list.arenas_.pop_back();
+            }
+        }
+        if (!arena) {
+            arena = new Arena;
+        }
+        current() = arena;
+
+        // an arena adopted during thread teardown is never returned
+        if (!exited()) {
+            static thread_local guard g;
+            (void) g;
+        }
+        return *arena;
+    }
+};
+
 
 /**
- *  \brief Allocator optimized for stack-based allocation.
+ *  \brief Get the arena of a given type for the current thread.
+ */
+template <typename Arena>
+Arena& thread_pool_arena() noexcept
+{
+    return thread_pool_arenas<Arena>::get();
+}
+
+// ALLOCATOR
+
+/**
+ *  \brief Allocator optimized for single objects of a fixed size.
  */
 template <
     typename T,
     size_t N,
-    size_t Alignment = alignof(max_align_t)
+    size_t Alignment,
+    pool_locking Locking
 >
 class pool_allocator
 {
 public:
     // MEMBER TEMPLATES
     // ----------------
-    template <typename T1, size_t N1 = N, size_t A1 = Alignment>
-    struct rebind { using other = pool_allocator<T1, N1, A1>; };
+    template <typename T1, size_t N1 = N, size_t A1 = (Alignment > alignof(T1) ? Alignment : alignof(T1)), pool_locking L1 = Locking>
+    struct rebind { using other = pool_allocator<T1, N1, A1, L1>; };
 
     // STATIC VARIABLES
     // ----------------
-    static constexpr size_t alignment = Alignment;
+    static constexpr size_t alignment = Alignment > alignof(T) ? Alignment : alignof(T);
     static constexpr size_t size = N;
+    static constexpr pool_locking locking = Locking;
 
     // MEMBER TYPES
     // ------------
+    using self_t = pool_allocator<T, N, Alignment, Locking>;
     using value_type = T;
+    using arena_type = pool_arena<(sizeof(T) + alignment - 1) & ~(alignment - 1), N, alignment, Locking>;
+    using is_always_equal = true_type;
 #if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
     using reference = value_type&;
     using const_reference = const value_type&;
@@ -65,34 +557,363 @@ public:
     using size_type = size_t;
     using difference_type = ptrdiff_t;
 #endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
-// TODO: here
 
     // MEMBER FUNCTIONS
     // ----------------
-//    pool_allocator() noexcept;
-//    pool_allocator(const pool_allocator<T, N, Alignment>&) noexcept;
-//    ~pool_allocator() noexcept;
 
-//    pool_allocator<T, N, Alignment>& operator=(const pool_allocator<T, N, Alignment>&) noexcept;
-//    pool_allocator<T, N, Alignment>& operator=(pool_allocator<T, N, Alignment>&&) noexcept;
+    // CONSTRUCTORS
+
+    pool_allocator() noexcept = default;
+    pool_allocator(const self_t&) noexcept = default;
+    self_t& operator=(const self_t&) noexcept = default;
+    ~pool_allocator() noexcept = default;
+
+    template <typename T1, size_t A1>
+    pool_allocator(const pool_allocator<T1, N, A1, Locking>&) noexcept
+    {}
+
+    template <typename T1, size_t A1>
+    self_t& operator=(const pool_allocator<T1, N, A1, Locking>&) noexcept
+    {
+        return *this;
+    }
+
+    // ALLOCATOR TRAITS
+
+    value_type* allocate(size_t n, const void* hint = nullptr)
+    {
+        if (n == 1) {
+            return reinterpret_cast<value_type*>(arena().allocate());
+        }
+        return reinterpret_cast<value_type*>(operator new(sizeof(value_type) * n));
+    }
+
+    void deallocate(value_type* p, size_t n)
+    {
+        if (n == 1) {
+            arena().deallocate(p);
+        } else {
+            operator delete(p);
+        }
+    }
+
+#if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
+
+    template <typename ... Ts>
+    void construct(T* p, Ts&&... ts)
+    {
+        ::new (static_cast<void*>(p)) T(std::forward<Ts>(ts)...);
+    }
+
+    void destroy(T* p)
+    {
+        p->~T();
+    }
+
+    size_type max_size()
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+#endif      // CPP11_PARTIAL_ALLOCATOR_TRAITS
+
+    // ARENA
+
+    static arena_type& arena() noexcept
+    {
+        // unlocked arenas are only safe within a single thread
+        if (Locking == pool_unlocked) {
+            return thread_pool_arena<arena_type>();
+        }
+        return shared_pool_arena<arena_type>();
+    }
 
 private:
-    union slot_
+    static_assert(alignment <= alignof(max_align_t), "Over-aligned types cannot be pooled.");
+};
+
+// RESOURCE
+
+/**
+ *  \brief Memory resource allocating small requests from a pool.
+ *
+ *  Requests up to `BlockSize` bytes, with at most fundamental
+ *  alignment, are allocated from the resource's arena, and others
+ *  from the upstream resource. Pooled memory is released when the
+ *  resource is destroyed.
+ */
+template <
+    size_t BlockSize,
+    size_t N = POOL_BLOCK_COUNT,
+    pool_locking Locking = pool_unlocked
+>
+class pool_resource: public memory_resource
+{
+public:
+    // MEMBER TYPES
+    // ------------
+    using arena_type = pool_arena<BlockSize, N, alignof(max_align_t), Locking>;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+    pool_resource(const pool_resource&) = delete;
+    pool_resource& operator=(const pool_resource&) = delete;
+
+    pool_resource(memory_resource* upstream = new_delete_resource()) noexcept:
+        upstream_(upstream)
+    {}
+
+    memory_resource* upstream_resource() const noexcept
     {
-        value_type element;
-        slot_* next;
-    };
+        return upstream_;
+    }
+
+    arena_type& arena() noexcept
+    {
+        return arena_;
+    }
+
+protected:
+    // MEMORY TRAITS
+
+    virtual void* do_allocate(size_t n, size_t alignment) override
+    {
+        if (n <= BlockSize && alignment <= arena_type::alignment) {
+            return arena_.allocate();
+        }
+        return upstream_->allocate(n, alignment);
+    }
+
+    virtual void do_deallocate(void* p, size_t n, size_t alignment) override
+    {
+        if (n <= BlockSize && alignment <= arena_type::alignment) {
+            arena_.deallocate(p);
+        } else {
+            upstream_->deallocate(p, n, alignment);
+        }
+    }
 
-    using data_pointer_ = char*;
-    using slot_type_ = slot_;
-    using slot_pointer_ = slot_*;
+    virtual bool do_is_equal(const memory_resource& rhs) const noexcept override
+    {
+        return this == &rhs;
+    }
+
+private:
+    arena_type arena_;
+    memory_resource* upstream_;
 };
 
-// TODO: specialize is_relocatable
-// TODO: add locked and unlocked variants
+// ALIAS
+// -----
+
+template <typename T, size_t N = POOL_BLOCK_COUNT>
+using pool_unlocked_allocator = pool_allocator<T, N, alignof(T), pool_unlocked>;
+
+template <typename T, size_t N = POOL_BLOCK_COUNT>
+using pool_locked_allocator = pool_allocator<T, N, alignof(T), pool_locked>;
+
+template <typename T, size_t N = POOL_BLOCK_COUNT>
+using pool_lock_free_allocator = pool_allocator<T, N, alignof(T), pool_lock_free>;
+
+template <size_t BlockSize, size_t N = POOL_BLOCK_COUNT>
+using pool_unlocked_resource = pool_resource<BlockSize, N, pool_unlocked>;
+
+template <size_t BlockSize, size_t N = POOL_BLOCK_COUNT>
+using pool_locked_resource = pool_resource<BlockSize, N, pool_locked>;
+
+template <size_t BlockSize, size_t N = POOL_BLOCK_COUNT>
+using pool_lock_free_resource = pool_resource<BlockSize, N, pool_lock_free>;
+
+// SPECIALIZATION
+// --------------
+
+template <size_t S, size_t N, size_t A, pool_locking L>
+struct is_relocatable<pool_arena<S, N, A, L>>: false_type
+{};
+
+template <typename T, size_t N, size_t A, pool_locking L>
+struct is_relocatable<pool_allocator<T, N, A, L>>: true_type
+{};
+
+template <size_t S, size_t N, pool_locking L>
+struct is_relocatable<pool_resource<S, N, L>>: false_type
+{};
 
 // IMPLEMENTATION
 // --------------
 
+// ARENA
+
+template <size_t S, size_t N, size_t A, pool_locking L>
+constexpr size_t pool_arena<S, N, A, L>::block_size;
+
+template <size_t S, size_t N, size_t A, pool_locking L>
+constexpr size_t pool_arena<S, N, A, L>::block_count;
+
+template <size_t S, size_t N, size_t A, pool_locking L>
+constexpr size_t pool_arena<S, N, A, L>::alignment;
+
+template <size_t S, size_t N, size_t A, pool_locking L>
+constexpr pool_locking pool_arena<S, N, A, L>::locking;
+
+template <size_t S, size_t N, size_t A, pool_locking L>
+constexpr size_t pool_arena<S, N, A, L>::header;
+
+
+template <size_t S, size_t N, size_t A, pool_locking L>
+void* pool_arena<S, N, A, L>::allocate()
+{
+    lock_guard<mutex_type> lock(mutex_);
+    if (free_) {
+        slot* p = free_;
+        free_ = p->next;
+        return p;
+    }
+
+    if (cursor_ == end_) {
+        cursor_ = allocate_chunk(chunks_, header, block_size * block_count);
+        end_ = cursor_ + block_size * block_count;
+        ++count_;
+    }
+    byte* p = cursor_;
+    cursor_ += block_size;
+    return p;
+}
+
+
+template <size_t S, size_t N, size_t A, pool_locking L>
+void pool_arena<S, N, A, L>::deallocate(void* p) noexcept
+{
+    lock_guard<mutex_type> lock(mutex_);
+    slot* s = static_cast<slot*>(p);
+    s->next = free_;
+    free_ = s;
+}
+
+// LOCK-FREE ARENA
+
+template <size_t S, size_t N, size_t A>
+constexpr size_t pool_arena<S, N, A, pool_lock_free>::block_size;
+
+template <size_t S, size_t N, size_t A>
+constexpr size_t pool_arena<S, N, A, pool_lock_free>::block_count;
+
+template <size_t S, size_t N, size_t A>
+constexpr size_t pool_arena<S, N, A, pool_lock_free>::alignment;
+
+template <size_t S, size_t N, size_t A>
+constexpr pool_locking pool_arena<S, N, A, pool_lock_free>::locking;
+
+template <size_t S, size_t N, size_t A>
+constexpr size_t pool_arena<S, N, A, pool_lock_free>::header;
+
+
+template <size_t S, size_t N, size_t A>
+auto pool_arena<S, N, A, pool_lock_free>::pop() noexcept -> slot*
+{
+    uint64_t head = head_.load(memory_order_acquire);
+    slot* p;
+    do {
+        p = pointer(head);
+        if (!p) {
+            return nullptr;
+        }
+        // chunks are never released while the arena is alive, so a
+        // stale `p` is readable, and the tag rejects a stale `next`
+    } while (!head_.compare_exchange_weak(head, pack(link(p).load(memory_order_relaxed), head), memory_order_acquire, memory_order_acquire));
+
+    return p;
+}
+
+
+template <size_t S, size_t N, size_t A>
+void pool_arena<S, N, A, pool_lock_free>::push(slot* first, slot* last) noexcept
+{
+    assert(packable(first) && "Pointer uses the tag bits.");
+    uint64_t head = head_.load(memory_order_relaxed);
+    do {
+        link(last).store(pointer(head), memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(head, pack(first, head), memory_order_release, memory_order_relaxed));
+}
+
+
+template <size_t S, size_t N, size_t A>
+void* pool_arena<S, N, A, pool_lock_free>::allocate()
+{
+    slot* p = pop();
+    if (p) {
+        return p;
+    }
+
+    // grow, unless another thread grew the arena first
+    lock_guard<mutex_type> lock(mutex_);
+    p = pop();
+    if (p) {
+        return p;
+    } else if (spill_) {
+        p = spill_;
+        spill_ = p->next;
+        return p;
+    }
+
+    byte* first = allocate_chunk(chunks_, header, block_size * block_count);
+    ++count_;
+    if (!packable(first + block_size * block_count - 1)) {
+        // the chunk overlaps the tag bits, free blocks under the lock
+        for (size_t i = 1; i < block_count; ++i) {
+            slot* s = reinterpret_cast<slot*>(first + i * block_size);
+            s->next = spill_;
+            spill_ = s;
+        }
+    } else if (block_count > 1) {
+        for (size_t i = 1; i < block_count - 1; ++i) {
+            reinterpret_cast<slot*>(first + i * block_size)->next = reinterpret_cast<slot*>(first + (i + 1) * block_size);
+        }
+        push(reinterpret_cast<slot*>(first + block_size), reinterpret_cast<slot*>(first + (block_count - 1) * block_size));
+    }
+
+    return first;
+}
+
+
+template <size_t S, size_t N, size_t A>
+void pool_arena<S, N, A, pool_lock_free>::deallocate(void* p) noexcept
+{
+    slot* s = static_cast<slot*>(p);
+    if (packable(s)) {
+        push(s, s);
+    } else {
+        lock_guard<mutex_type> lock(mutex_);
+        s->next = spill_;
+        spill_ = s;
+    }
+}
+
+// ALLOCATOR
+
+template <typename T, size_t N, size_t A, pool_locking L>
+constexpr size_t pool_allocator<T, N, A, L>::alignment;
+
+template <typename T, size_t N, size_t A, pool_locking L>
+constexpr size_t pool_allocator<T, N, A, L>::size;
+
+template <typename T, size_t N, size_t A, pool_locking L>
+constexpr pool_locking pool_allocator<T, N, A, L>::locking;
+
+
+template <typename T1, size_t N1, size_t A1, pool_locking L1, typename T2, size_t N2, size_t A2, pool_locking L2>
+inline bool operator==(const pool_allocator<T1, N1, A1, L1>&,
+    const pool_allocator<T2, N2, A2, L2>&) noexcept
+{
+    return N1 == N2 && L1 == L2;
+}
+
+
+template <typename T1, size_t N1, size_t A1, pool_locking L1, typename T2, size_t N2, size_t A2, pool_locking L2>
+inline bool operator!=(const pool_allocator<T1, N1, A1, L1>& lhs,
+    const pool_allocator<T2, N2, A2, L2>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
 
 PYCPP_END_NAMESPACE
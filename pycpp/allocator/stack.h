@@ -48,6 +48,7 @@
  *
  *          template <size_t RequiredAlignment> byte* allocate(size_t n);
  *          void deallocate(byte* p, size_t n) noexcept;
+ *          bool owns(const byte* p) const noexcept;
  *
  *          // PROPERTIES
  *          static size_t size() noexcept;
@@ -91,6 +92,7 @@
  *
  *          value_type* allocate(size_t n, const void* hint = nullptr);
  *          void deallocate(value_type* p, size_t n);
+ *          bool owns(const value_type* p, size_t n) const noexcept;
  *
  *      private:
  *          arena_type* arena_ = nullptr;
@@ -255,6 +257,18 @@ public:
     void deallocate(byte* p, size_t n) noexcept;
 
     // PROPERTIES
+
+    /**
+     *  \brief Check if the arena can deallocate `p`.
+     *
+     *  Arenas with a fallback deallocate any pointer outside the
+     *  buffer through the fallback.
+     */
+    bool owns(const byte* p) const noexcept
+    {
+        return use_fallback || ((buf_ <= p) && (p < buf_ + stack_size));
+    }
+
     static size_t size() noexcept
     {
         return stack_size;
@@ -442,6 +456,12 @@ public:
         arena_->deallocate(reinterpret_cast<byte*>(p), sizeof(T) * n);
     }
 
+    bool owns(const value_type* p, size_t n) const noexcept
+    {
+        assert(arena_ && "Arena cannot be null.");
+        return arena_->owns(reinterpret_cast<const byte*>(p));
+    }
+
 #if defined(CPP11_PARTIAL_ALLOCATOR_TRAITS)
 
     template <typename ... Ts>
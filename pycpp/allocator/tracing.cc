@@ -0,0 +1,209 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/tracing.h>
+#include <pycpp/preprocessor/compiler.h>
+#include <pycpp/preprocessor/os.h>
+#include <pycpp/stl/limits.h>
+
+#if defined(OS_WINDOWS)
+#   include <pycpp/windows/winapi.h>
+#elif defined(HAVE_EXECINFO_H)
+#   include <execinfo.h>
+#endif
+
+PYCPP_BEGIN_NAMESPACE
+
+// HELPERS
+// -------
+
+
+/**
+ *  \brief Capture up to `depth` return addresses of the calling thread.
+ */
+static size_t capture_stack(void** frames, size_t depth) noexcept
+{
+#if defined(OS_WINDOWS)
+    return CaptureStackBackTrace(0, static_cast<DWORD>(depth), frames, nullptr);
+#elif defined(HAVE_EXECINFO_H)
+    int count = backtrace(frames, static_cast<int>(depth));
+    return count > 0 ? static_cast<size_t>(count) : 0;
+#else
+    return 0;
+#endif
+}
+
+
+static void update_peak(atomic<size_t>& peak, size_t live) noexcept
+{
+    size_t current = peak.load(memory_order_relaxed);
+    while (live > current && !peak.compare_exchange_weak(current, live, memory_order_relaxed)) {
+    }
+}
+
+// OBJECTS
+// -------
+
+
+tracing_resource::tracing_resource(memory_resource* upstream, const tracing_options& options) noexcept:
+    upstream_(upstream),
+    options_(options)
+{
+    if (options_.stack_depth > TRACING_MAX_FRAMES) {
+        options_.stack_depth = TRACING_MAX_FRAMES;
+    }
+}
+
+
+void* tracing_resource::do_allocate(size_t n, size_t alignment)
+{
+    void* p = upstream_->allocate(n, alignment);
+
+    counters& c = classes_[size_class(n)];
+    c.allocations.fetch_add(1, memory_order_relaxed);
+    c.bytes.fetch_add(n, memory_order_relaxed);
+    update_peak(peak_, live_.fetch_add(n, memory_order_relaxed) + n);
+
+    size_t rate = options_.sample_rate;
+    if (rate && sample_counter_.fetch_add(1, memory_order_relaxed) % rate == 0) {
+        sample(n);
+    }
+
+    return p;
+}
+
+
+void tracing_resource::do_deallocate(void* p, size_t n, size_t alignment)
+{
+    upstream_->deallocate(p, n, alignment);
+
+    classes_[size_class(n)].deallocations.fetch_add(1, memory_order_relaxed);
+    live_.fetch_sub(n, memory_order_relaxed);
+}
+
+
+bool tracing_resource::do_is_equal(const memory_resource& rhs) const noexcept
+{
+    return this == &rhs;
+}
+
+
+/**
+ *  \brief Record the call stack of an allocation.
+ */
+void tracing_resource::sample(size_t n) noexcept
+{
+    tracing_sample s;
+    s.size = n;
+    s.depth = capture_stack(s.frames, options_.stack_depth);
+
+    lock_guard<mutex> lock(mutex_);
+    samples_[sample_next_] = s;
+    sample_next_ = (sample_next_ + 1) % TRACING_SAMPLE_COUNT;
+    if (sample_count_ < TRACING_SAMPLE_COUNT) {
+        ++sample_count_;
+    }
+}
+
+
+tracing_snapshot tracing_resource::snapshot() const noexcept
+{
+    tracing_snapshot s;
+    s.allocations = 0;
+    s.deallocations = 0;
+    s.bytes = 0;
+    for (size_t i = 0; i < TRACING_SIZE_CLASSES; ++i) {
+        tracing_size_class& c = s.classes[i];
+        c.size = i < TRACING_SIZE_CLASSES - 1 ? size_t(1) << i : std::numeric_limits<size_t>::max();
+        c.allocations = classes_[i].allocations.load(memory_order_relaxed);
+        c.deallocations = classes_[i].deallocations.load(memory_order_relaxed);
+        c.bytes = classes_[i].bytes.load(memory_order_relaxed);
+        s.allocations += c.allocations;
+        s.deallocations += c.deallocations;
+        s.bytes += c.bytes;
+    }
+    s.live_bytes = live_.load(memory_order_relaxed);
+    s.peak_bytes = peak_.load(memory_order_relaxed);
+
+    return s;
+}
+
+
+/**
+ *  \brief Copy up to `n` of the most recent samples, oldest first.
+ */
+size_t tracing_resource::samples(tracing_sample* samples, size_t n) const noexcept
+{
+    lock_guard<mutex> lock(mutex_);
+    size_t count = n < sample_count_ ? n : sample_count_;
+    size_t first = (sample_next_ + TRACING_SAMPLE_COUNT - count) % TRACING_SAMPLE_COUNT;
+    for (size_t i = 0; i < count; ++i) {
+        samples[i] = samples_[(first + i) % TRACING_SAMPLE_COUNT];
+    }
+
+    return count;
+}
+
+
+size_t tracing_resource::live_bytes() const noexcept
+{
+    return live_.load(memory_order_relaxed);
+}
+
+
+size_t tracing_resource::peak_bytes() const noexcept
+{
+    return peak_.load(memory_order_relaxed);
+}
+
+
+/**
+ *  \brief Reset counters and samples, keeping the live bytes.
+ *
+ *  The peak is reset to the live bytes.
+ */
+void tracing_resource::reset() noexcept
+{
+    for (counters& c: classes_) {
+        c.allocations.store(0, memory_order_relaxed);
+        c.deallocations.store(0, memory_order_relaxed);
+        c.bytes.store(0, memory_order_relaxed);
+    }
+    peak_.store(live_.load(memory_order_relaxed), memory_order_relaxed);
+    sample_counter_.store(0, memory_order_relaxed);
+
+    lock_guard<mutex> lock(mutex_);
+    sample_count_ = 0;
+    sample_next_ = 0;
+}
+
+
+memory_resource* tracing_resource::upstream_resource() const noexcept
+{
+    return upstream_;
+}
+
+
+const tracing_options& tracing_resource::options() const noexcept
+{
+    return options_;
+}
+
+
+size_t tracing_resource::size_class(size_t n) noexcept
+{
+    if (n <= 1) {
+        return 0;
+    }
+#if defined(HAVE_GNUC)
+    return sizeof(unsigned long long) * 8 - static_cast<size_t>(__builtin_clzll(static_cast<unsigned long long>(n - 1)));
+#else
+    size_t i = 0;
+    for (--n; n; n >>= 1) {
+        ++i;
+    }
+    return i;
+#endif
+}
+
+PYCPP_END_NAMESPACE
@@ -0,0 +1,224 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Memory resource that records allocation statistics.
+ *
+ *  A memory resource wrapping an upstream resource, which counts
+ *  allocations, deallocations and bytes by size class, and tracks
+ *  the live and peak bytes, to find the containers causing
+ *  allocation churn. Size classes are powers of 2: class `i` holds
+ *  requests of `(2^(i-1), 2^i]` bytes.
+ *
+ *  Counters are lock-free, and updated with relaxed atomics, so the
+ *  resource may be installed as the default resource of a running
+ *  process. `snapshot()` reads each counter individually, so a
+ *  snapshot taken during concurrent allocation may not be
+ *  consistent across counters.
+ *
+ *  The resource can also sample the call stack of every `n`th
+ *  allocation, when supported by the system. The most recent
+ *  `TRACING_SAMPLE_COUNT` samples are kept in a fixed buffer, so
+ *  tracing never allocates memory itself. For example:
+ *
+ *  \code
+ *      tracing_options options;
+ *      options.sample_rate = 1000;
+ *      tracing_resource tracing(get_default_resource(), options);
+ *      memory_resource* previous = set_default_resource(&tracing);
+ *      ...
+ *      tracing_snapshot snapshot = tracing.snapshot();
+ *      set_default_resource(previous);
+ *  \endcode
+ *
+ *  \synopsis
+ *      static constexpr size_t TRACING_SIZE_CLASSES = implementation-defined;
+ *      static constexpr size_t TRACING_SAMPLE_COUNT = implementation-defined;
+ *      static constexpr size_t TRACING_MAX_FRAMES = implementation-defined;
+ *
+ *      struct tracing_options
+ *      {
+ *          size_t sample_rate = 0;
+ *          size_t stack_depth = TRACING_MAX_FRAMES;
+ *      };
+ *
+ *      struct tracing_size_class
+ *      {
+ *          size_t size;
+ *          uint64_t allocations;
+ *          uint64_t deallocations;
+ *          uint64_t bytes;
+ *      };
+ *
+ *      struct tracing_snapshot
+ *      {
+ *          uint64_t allocations;
+ *          uint64_t deallocations;
+ *          uint64_t bytes;
+ *          size_t live_bytes;
+ *          size_t peak_bytes;
+ *          tracing_size_class classes[TRACING_SIZE_CLASSES];
+ *      };
+ *
+ *      struct tracing_sample
+ *      {
+ *          size_t size;
+ *          size_t depth;
+ *          void* frames[TRACING_MAX_FRAMES];
+ *      };
+ *
+ *      class tracing_resource: public memory_resource
+ *      {
+ *      public:
+ *          tracing_resource(memory_resource* upstream = get_default_resource(), const tracing_options& options = {}) noexcept;
+ *          tracing_resource(const tracing_resource&) = delete;
+ *          tracing_resource& operator=(const tracing_resource&) = delete;
+ *
+ *          tracing_snapshot snapshot() const noexcept;
+ *          size_t samples(tracing_sample* samples, size_t n) const noexcept;
+ *          size_t live_bytes() const noexcept;
+ *          size_t peak_bytes() const noexcept;
+ *          void reset() noexcept;
+ *
+ *          memory_resource* upstream_resource() const noexcept;
+ *          const tracing_options& options() const noexcept;
+ *          static size_t size_class(size_t n) noexcept;
+ *      };
+ */
+
+#pragma once
+
+#include <pycpp/stl/atomic.h>
+#include <pycpp/stl/memory.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/type_traits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t TRACING_SIZE_CLASSES = sizeof(size_t) * 8 + 1;
+static constexpr size_t TRACING_SAMPLE_COUNT = 64;
+static constexpr size_t TRACING_MAX_FRAMES = 16;
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Options to trace allocations.
+ *
+ *  `sample_rate` samples the call stack of every `n`th allocation,
+ *  and 0 disables sampling.
+ */
+struct tracing_options
+{
+    size_t sample_rate = 0;
+    size_t stack_depth = TRACING_MAX_FRAMES;
+};
+
+
+/**
+ *  \brief Counters for requests of up to `size` bytes.
+ */
+struct tracing_size_class
+{
+    size_t size;
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t bytes;
+};
+
+
+/**
+ *  \brief Histogram of allocations by size class.
+ */
+struct tracing_snapshot
+{
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t bytes;
+    size_t live_bytes;
+    size_t peak_bytes;
+    tracing_size_class classes[TRACING_SIZE_CLASSES];
+};
+
+
+/**
+ *  \brief Call stack of a sampled allocation.
+ */
+struct tracing_sample
+{
+    size_t size;
+    size_t depth;
+    void* frames[TRACING_MAX_FRAMES];
+};
+
+
+/**
+ *  \brief Memory resource recording allocation statistics.
+ */
+class tracing_resource: public memory_resource
+{
+public:
+    // MEMBER FUNCTIONS
+    // ----------------
+    tracing_resource(const tracing_resource&) = delete;
+    tracing_resource& operator=(const tracing_resource&) = delete;
+
+    tracing_resource(memory_resource* upstream = get_default_resource(), const tracing_options& options = tracing_options()) noexcept;
+
+    // STATISTICS
+
+    tracing_snapshot snapshot() const noexcept;
+    size_t samples(tracing_sample* samples, size_t n) const noexcept;
+    size_t live_bytes() const noexcept;
+    size_t peak_bytes() const noexcept;
+    void reset() noexcept;
+
+    // PROPERTIES
+
+    memory_resource* upstream_resource() const noexcept;
+    const tracing_options& options() const noexcept;
+    static size_t size_class(size_t n) noexcept;
+
+protected:
+    // MEMORY TRAITS
+
+    virtual void* do_allocate(size_t n, size_t alignment) override;
+    virtual void do_deallocate(void* p, size_t n, size_t alignment) override;
+    virtual bool do_is_equal(const memory_resource& rhs) const noexcept override;
+
+private:
+    struct counters
+    {
+        atomic<uint64_t> allocations = {0};
+        atomic<uint64_t> deallocations = {0};
+        atomic<uint64_t> bytes = {0};
+    };
+
+    memory_resource* upstream_;
+    tracing_options options_;
+    counters classes_[TRACING_SIZE_CLASSES];
+    atomic<size_t> live_ = {0};
+    atomic<size_t> peak_ = {0};
+    atomic<size_t> sample_counter_ = {0};
+
+    mutable mutex mutex_;
+    tracing_sample samples_[TRACING_SAMPLE_COUNT];
+    size_t sample_count_ = 0;
+    size_t sample_next_ = 0;
+
+    void sample(size_t n) noexcept;
+};
+
+// SPECIALIZATION
+// --------------
+
+template <>
+struct is_relocatable<tracing_resource>: false_type
+{};
+
+PYCPP_END_NAMESPACE
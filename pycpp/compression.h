@@ -9,8 +9,11 @@
 
 #include <pycpp/compression/blosc.h>
 #include <pycpp/compression/bzip2.h>
-#include <pycpp/compression/xz.h>
+#include <pycpp/compression/dictionary.h>
+#include <pycpp/compression/lzma.h>
+#include <pycpp/compression/pool.h>
 #include <pycpp/compression/zlib.h>
 #if defined(BUILD_STREAM)
+#   include <pycpp/compression/mmap.h>
 #   include <pycpp/compression/stream.h>
 #endif
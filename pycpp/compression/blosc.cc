@@ -27,11 +27,6 @@ PYCPP_BEGIN_NAMESPACE
 
 static const int THREADS = min<int>(4, max<int>(1, thread::hardware_concurrency()));
 static const int PADDING = BLOSC_MAX_OVERHEAD + 4 * THREADS;
-static const int CLEVEL = 5;
-static const int DOSHUFFLE = BLOSC_DOSHUFFLE;
-static const char* COMPNAME = BLOSC_BLOSCLZ_COMPNAME;
-static const size_t TYPESIZE = 8;
-static const size_t BLOCKSIZE = 0;
 
 #if SYSTEM_ARCHITECTURE == 16
     static const uint16_t UNCOMPRESSED_MAX = numeric_limits<uint16_t>::max() - PADDING;
@@ -57,18 +52,209 @@ static size_t blosc_compress_bound(size_t size)
     return size + PADDING;
 }
 
+
+static const char* blosc_compname(blosc_codec codec)
+{
+    switch (codec) {
+        case blosc_blosclz:
+            return BLOSC_BLOSCLZ_COMPNAME;
+        case blosc_lz4:
+            return BLOSC_LZ4_COMPNAME;
+        case blosc_lz4hc:
+            return BLOSC_LZ4HC_COMPNAME;
+        case blosc_snappy:
+            return BLOSC_SNAPPY_COMPNAME;
+        case blosc_zlib:
+            return BLOSC_ZLIB_COMPNAME;
+        case blosc_zstd:
+            return BLOSC_ZSTD_COMPNAME;
+        default:
+            throw compression_error(compression_invalid_parameter);
+    }
+}
+
+
+static int blosc_threads(int threads)
+{
+    return threads > 0 ? threads : THREADS;
+}
+
+// OBJECTS
+// -------
+
+
+blosc_superchunk::blosc_superchunk(size_t chunk_size, const blosc_options& options):
+    options_(options)
+{
+    // chunks must hold a whole number of items, for partial reads
+    if (options_.typesize > BLOSC_MAX_ITEM_SIZE) {
+        throw compression_error(compression_invalid_parameter);
+    }
+    size_t typesize = max<size_t>(1, options_.typesize);
+    chunk_size_ = max(typesize, chunk_size - chunk_size % typesize);
+}
+
+
+blosc_superchunk::blosc_superchunk(blosc_superchunk&& rhs) noexcept:
+    options_(rhs.options_),
+    chunk_size_(rhs.chunk_size_)
+{
+    swap(rhs);
+}
+
+
+blosc_superchunk& blosc_superchunk::operator=(blosc_superchunk&& rhs) noexcept
+{
+    swap(rhs);
+    return *this;
+}
+
+
+blosc_superchunk::~blosc_superchunk() noexcept
+{}
+
+
+void blosc_superchunk::append(const void* src, size_t srclen)
+{
+    const char* first = (const char*) src;
+    const char* last = first + srclen;
+    while (first < last) {
+        size_t length = min<size_t>(chunk_size_ - tail_.size(), distance(first, last));
+        tail_.append(first, length);
+        first += length;
+        size_ += length;
+
+        // compress full chunks
+        if (tail_.size() == chunk_size_) {
+            chunks_.emplace_back(blosc_compress(tail_, options_));
+            compressed_size_ += chunks_.back().size();
+            tail_.clear();
+        }
+    }
+}
+
+
+void blosc_superchunk::clear() noexcept
+{
+    size_ = 0;
+    compressed_size_ = 0;
+    chunks_.clear();
+    tail_.clear();
+}
+
+
+void blosc_superchunk::swap(blosc_superchunk& rhs) noexcept
+{
+    using PYCPP_NAMESPACE::swap;
+    swap(options_, rhs.options_);
+    swap(chunk_size_, rhs.chunk_size_);
+    swap(size_, rhs.size_);
+    swap(compressed_size_, rhs.compressed_size_);
+    swap(chunks_, rhs.chunks_);
+    swap(tail_, rhs.tail_);
+}
+
+
+void blosc_superchunk::read(size_t offset, void* dst, size_t dstlen) const
+{
+    if (offset > size_ || dstlen > size_ - offset) {
+        throw out_of_range("Read exceeds the superchunk size.");
+    }
+
+    int threads = blosc_threads(options_.threads);
+    size_t typesize = max<size_t>(1, options_.typesize);
+    char* out = (char*) dst;
+    string buffer;
+    while (dstlen) {
+        size_t index = offset / chunk_size_;
+        size_t first = offset % chunk_size_;
+        size_t length = min(dstlen, chunk_size_ - first);
+
+        if (index == chunks_.size()) {
+            // uncompressed tail
+            memcpy(out, tail_.data() + first, length);
+        } else if (length == chunk_size_) {
+            // entire chunk
+            PYCPP_CHECK(blosc_decompress_ctx(chunks_[index].data(), out, length, threads));
+        } else {
+            // decompress only the overlapping items
+            size_t item = first / typesize;
+            size_t items = (first + length + typesize - 1) / typesize - item;
+            buffer.resize(items * typesize);
+            PYCPP_CHECK(blosc_getitem(chunks_[index].data(), static_cast<int>(item), static_cast<int>(items), &buffer[0]));
+            memcpy(out, buffer.data() + (first - item * typesize), length);
+        }
+
+        out += length;
+        offset += length;
+        dstlen -= length;
+    }
+}
+
+
+string blosc_superchunk::read(size_t offset, size_t length) const
+{
+    string output(length, '\0');
+    if (length) {
+        read(offset, &output[0], length);
+    }
+    return output;
+}
+
+
+string blosc_superchunk::decompress() const
+{
+    return read(0, size_);
+}
+
+
+size_t blosc_superchunk::size() const noexcept
+{
+    return size_;
+}
+
+
+size_t blosc_superchunk::compressed_size() const noexcept
+{
+    return compressed_size_ + tail_.size();
+}
+
+
+size_t blosc_superchunk::chunk_size() const noexcept
+{
+    return chunk_size_;
+}
+
+
+size_t blosc_superchunk::chunk_count() const noexcept
+{
+    return chunks_.size() + !tail_.empty();
+}
+
+
+const blosc_options& blosc_superchunk::options() const noexcept
+{
+    return options_;
+}
+
 // FUNCTIONS
 // ---------
 
 void blosc_compress(const void*& src, size_t srclen, void* &dst, size_t dstlen)
+{
+    blosc_compress(src, srclen, dst, dstlen, blosc_options());
+}
+
+
+void blosc_compress(const void*& src, size_t srclen, void*& dst, size_t dstlen, const blosc_options& options)
 {
     // configurations
-    static const int clevel = CLEVEL;
-    static const int doshuffle = DOSHUFFLE;
-    static const int typesize = TYPESIZE;
-    static const char* compressor = COMPNAME;
-    static const int blocksize = BLOCKSIZE;
-    static const int threads = THREADS;
+    int clevel = options.level;
+    int doshuffle = static_cast<int>(options.shuffle);
+    size_t typesize = options.typesize;
+    const char* compressor = blosc_compname(options.codec);
+    size_t blocksize = options.blocksize;
+    int threads = blosc_threads(options.threads);
 
     // compress bytes
     int dstlen_ = static_cast<int>(dstlen);
@@ -87,10 +273,16 @@ void blosc_compress(const void*& src, size_t srclen, void* &dst, size_t dstlen)
 
 
 string blosc_compress(const string_wrapper& str)
+{
+    return blosc_compress(str, blosc_options());
+}
+
+
+string blosc_compress(const string_wrapper& str, const blosc_options& options)
 {
     size_t dstlen = blosc_compress_bound(str.size());
-    return compress_bound(str, dstlen, [](const void*& src, size_t srclen, void* &dst, size_t dstlen) {
-        return blosc_compress(src, srclen, dst, dstlen);
+    return compress_bound(str, dstlen, [&options](const void*& src, size_t srclen, void* &dst, size_t dstlen) {
+        return blosc_compress(src, srclen, dst, dstlen, options);
     });
 }
 
@@ -114,6 +306,22 @@ string blosc_decompress(const string_wrapper& str)
 }
 
 
+size_t blosc_decompressed_size(const string_wrapper& str)
+{
+    if (str.size() < BLOSC_MIN_HEADER_LENGTH) {
+        throw compression_error(compression_unexpected_eof);
+    }
+
+    size_t nbytes, cbytes, blocksize;
+    blosc_cbuffer_sizes((void*) str.data(), &nbytes, &cbytes, &blocksize);
+    if (str.size() < cbytes) {
+        throw compression_error(compression_unexpected_eof);
+    }
+
+    return nbytes;
+}
+
+
 void blosc_decompress(const void*& src, size_t srclen, void* &dst, size_t dstlen, size_t bound)
 {
     // configurations
@@ -3,6 +3,12 @@
 /**
  *  \addtogroup PyCPP
  *  \brief BLOSC compression and decompression.
+ *
+ *  BLOSC is optimized for binary, numeric data, where shuffling the
+ *  bytes (or bits) of each element by significance groups similar
+ *  bytes together. The typed API sets the typesize from the element
+ *  type, and `blosc_array` stores large arrays as independently
+ *  compressed chunks, which may be partially decompressed.
  */
 
 #pragma once
@@ -11,10 +17,151 @@
 
 #include <pycpp/compression/exception.h>
 #include <pycpp/stl/memory.h>
+#include <pycpp/stl/stdexcept.h>
+#include <pycpp/stl/type_traits.h>
+#include <pycpp/stl/vector.h>
+#include <pycpp/stl/vector_view.h>
 #include <pycpp/string/string.h>
 
 PYCPP_BEGIN_NAMESPACE
 
+// CONSTANTS
+// ---------
+
+static constexpr size_t BLOSC_DEFAULT_CHUNK_SIZE = 1 << 22;
+// larger typesizes are stored as 1 in the chunk header
+static constexpr size_t BLOSC_MAX_ITEM_SIZE = 255;
+
+// ENUMS
+// -----
+
+/**
+ *  \brief Pre-conditioning filter applied before compression.
+ */
+enum blosc_shuffle_mode
+{
+    blosc_noshuffle = 0,
+    blosc_byteshuffle,
+    blosc_bitshuffle,
+};
+
+/**
+ *  \brief Internal codec used by BLOSC.
+ */
+enum blosc_codec
+{
+    blosc_blosclz = 0,
+    blosc_lz4,
+    blosc_lz4hc,
+    blosc_snappy,
+    blosc_zlib,
+    blosc_zstd,
+};
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Compression parameters for BLOSC.
+ *
+ *  A `blocksize` of 0 lets BLOSC choose the block size, and a
+ *  `threads` count of 0 uses the default thread count.
+ */
+struct blosc_options
+{
+    int level = 5;
+    blosc_shuffle_mode shuffle = blosc_byteshuffle;
+    blosc_codec codec = blosc_blosclz;
+    size_t typesize = 8;
+    size_t blocksize = 0;
+    int threads = 0;
+};
+
+
+/**
+ *  \brief Byte array stored as independently-compressed BLOSC chunks.
+ *
+ *  Data is appended to an uncompressed tail, which is compressed
+ *  once it fills a chunk. Reads only decompress the chunks, or the
+ *  items within a chunk, that overlap the requested range.
+ */
+struct blosc_superchunk
+{
+public:
+    blosc_superchunk(size_t chunk_size = BLOSC_DEFAULT_CHUNK_SIZE, const blosc_options& options = blosc_options());
+    blosc_superchunk(blosc_superchunk&&) noexcept;
+    blosc_superchunk& operator=(blosc_superchunk&&) noexcept;
+    ~blosc_superchunk() noexcept;
+
+    // MODIFIERS
+    void append(const void* src, size_t srclen);
+    void clear() noexcept;
+    void swap(blosc_superchunk&) noexcept;
+
+    // DATA
+    void read(size_t offset, void* dst, size_t dstlen) const;
+    string read(size_t offset, size_t length) const;
+    string decompress() const;
+
+    // PROPERTIES
+    size_t size() const noexcept;
+    size_t compressed_size() const noexcept;
+    size_t chunk_size() const noexcept;
+    size_t chunk_count() const noexcept;
+    const blosc_options& options() const noexcept;
+
+private:
+    blosc_options options_;
+    size_t chunk_size_;
+    size_t size_ = 0;
+    size_t compressed_size_ = 0;
+    vector<string> chunks_;
+    string tail_;
+};
+
+
+/**
+ *  \brief Typed array stored as BLOSC chunks.
+ */
+template <typename T>
+struct blosc_array
+{
+public:
+    static_assert(is_trivially_copyable<T>::value, "BLOSC arrays require trivially copyable types.");
+    static_assert(sizeof(T) <= BLOSC_MAX_ITEM_SIZE, "BLOSC arrays require types of at most 255 bytes.");
+
+    // MEMBER TYPES
+    // ------------
+    using value_type = T;
+    using size_type = size_t;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+    blosc_array(size_t chunk_items = BLOSC_DEFAULT_CHUNK_SIZE / sizeof(T), blosc_options options = blosc_options());
+    blosc_array(blosc_array&&) noexcept = default;
+    blosc_array& operator=(blosc_array&&) noexcept = default;
+
+    // MODIFIERS
+    void append(const vector_view<T>& data);
+    void push_back(const T& value);
+    void clear() noexcept;
+
+    // DATA
+    T operator[](size_t index) const;
+    vector<T> slice(size_t first, size_t last) const;
+    vector<T> decompress() const;
+
+    // PROPERTIES
+    size_t size() const noexcept;
+    size_t compressed_size() const noexcept;
+    const blosc_superchunk& superchunk() const noexcept;
+
+private:
+    blosc_superchunk chunks_;
+
+    static blosc_options typed_options(blosc_options options) noexcept;
+};
+
 // FUNCTIONS
 // ---------
 
@@ -23,11 +170,27 @@ PYCPP_BEGIN_NAMESPACE
  */
 void blosc_compress(const void*& src, size_t srclen, void*& dst, size_t dstlen);
 
+/**
+ *  \brief BLOSC-compress data with custom parameters.
+ */
+void blosc_compress(const void*& src, size_t srclen, void*& dst, size_t dstlen, const blosc_options& options);
+
 /**
  *  \brief BLOSC-compress data.
  */
 string blosc_compress(const string_wrapper& str);
 
+/**
+ *  \brief BLOSC-compress data with custom parameters.
+ */
+string blosc_compress(const string_wrapper& str, const blosc_options& options);
+
+/**
+ *  \brief BLOSC-compress typed data, using the element size as the typesize.
+ */
+template <typename T>
+string blosc_compress(const vector_view<T>& data, blosc_options options = blosc_options());
+
 /**
  *  \brief BLOSC-decompress data.
  */
@@ -47,6 +210,137 @@ void blosc_decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen
  */
 string blosc_decompress(const string_wrapper& str, size_t bound);
 
+/**
+ *  \brief Get the decompressed size of a BLOSC buffer, from its header.
+ */
+size_t blosc_decompressed_size(const string_wrapper& str);
+
+/**
+ *  \brief BLOSC-decompress typed data.
+ */
+template <typename T>
+vector<T> blosc_decompress_array(const string_wrapper& str);
+
+// IMPLEMENTATION
+// --------------
+
+// ARRAY
+
+template <typename T>
+blosc_array<T>::blosc_array(size_t chunk_items, blosc_options options):
+    chunks_(chunk_items * sizeof(T), typed_options(options))
+{}
+
+
+template <typename T>
+blosc_options blosc_array<T>::typed_options(blosc_options options) noexcept
+{
+    options.typesize = sizeof(T);
+    return options;
+}
+
+
+template <typename T>
+void blosc_array<T>::append(const vector_view<T>& data)
+{
+    chunks_.append(data.data(), data.size() * sizeof(T));
+}
+
+
+template <typename T>
+void blosc_array<T>::push_back(const T& value)
+{
+    chunks_.append(&value, sizeof(T));
+}
+
+
+template <typename T>
+void blosc_array<T>::clear() noexcept
+{
+    chunks_.clear();
+}
+
+
+template <typename T>
+T blosc_array<T>::operator[](size_t index) const
+{
+    T value;
+    chunks_.read(index * sizeof(T), &value, sizeof(T));
+    return value;
+}
+
+
+template <typename T>
+vector<T> blosc_array<T>::slice(size_t first, size_t last) const
+{
+    if (last < first) {
+        throw out_of_range("Slice ends before it begins.");
+    }
+
+    vector<T> output(last - first);
+    chunks_.read(first * sizeof(T), output.data(), output.size() * sizeof(T));
+    return output;
+}
+
+
+template <typename T>
+vector<T> blosc_array<T>::decompress() const
+{
+    return slice(0, size());
+}
+
+
+template <typename T>
+size_t blosc_array<T>::size() const noexcept
+{
+    return chunks_.size() / sizeof(T);
+}
+
+
+template <typename T>
+size_t blosc_array<T>::compressed_size() const noexcept
+{
+    return chunks_.compressed_size();
+}
+
+
+template <typename T>
+const blosc_superchunk& blosc_array<T>::superchunk() const noexcept
+{
+    return chunks_;
+}
+
+// FUNCTIONS
+
+template <typename T>
+string blosc_compress(const vector_view<T>& data, blosc_options options)
+{
+    static_assert(is_trivially_copyable<T>::value, "BLOSC compression requires trivially copyable types.");
+    options.typesize = sizeof(T);
+    string_wrapper str((const char*) data.data(), data.size() * sizeof(T));
+    return blosc_compress(str, options);
+}
+
+
+template <typename T>
+vector<T> blosc_decompress_array(const string_wrapper& str)
+{
+    static_assert(is_trivially_copyable<T>::value, "BLOSC decompression requires trivially copyable types.");
+    size_t bound = blosc_decompressed_size(str);
+    if (bound % sizeof(T) != 0) {
+        throw compression_error(compression_data_error);
+    }
+
+    vector<T> output(bound / sizeof(T));
+    if (bound) {
+        const void* src = str.data();
+        void* dst = output.data();
+        blosc_decompress(src, str.size(), dst, bound, bound);
+    }
+
+    return output;
+}
+
 PYCPP_END_NAMESPACE
 
 #endif                  // HAVE_BLOSC
@@ -5,6 +5,7 @@
 
 #include <pycpp/compression/bzip2.h>
 #include <pycpp/compression/core.h>
+#include <pycpp/compression/pool.h>
 #include <pycpp/preprocessor/architecture.h>
 #include <pycpp/stl/stdexcept.h>
 #include <bzlib.h>
@@ -18,7 +19,6 @@ PYCPP_BEGIN_NAMESPACE
 static constexpr int BZ2_SMALL = 0;
 static constexpr int BZ2_BLOCK_SIZE = 9;
 static constexpr int BZ2_VERBOSITY = 0;
-static constexpr int BZ2_WORK_FACTOR = 30;
 
 // Calculated using `(numeric_limits<T>::max() / 1.01) - 600`.
 #if SYSTEM_ARCHITECTURE == 16
@@ -101,11 +101,15 @@ struct bz2_compressor_impl: filter_impl<bz_stream>
 
     virtual void call() override;
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     compression_status operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen);
+
+    int block_size;
 };
 
 
-bz2_compressor_impl::bz2_compressor_impl(int block_size)
+bz2_compressor_impl::bz2_compressor_impl(int block_size):
+    block_size(block_size)
 {
     status = BZ_OK;
     stream.bzalloc = nullptr;
@@ -145,6 +149,16 @@ bool bz2_compressor_impl::flush(void*& dst, size_t dstlen)
 }
 
 
+void bz2_compressor_impl::reset()
+{
+    // BZIP2 has no reset, re-initialize the stream
+    BZ2_bzCompressEnd(&stream);
+    check_bzstatus(BZ2_bzCompressInit(&stream, block_size, verbosity, small));
+    status = BZ_OK;
+    clear();
+}
+
+
 compression_status bz2_compressor_impl::operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
     return base::operator()(src, srclen, dst, dstlen, BZ_STREAM_END);
@@ -165,6 +179,7 @@ struct bz2_decompressor_impl: filter_impl<bz_stream>
 
     virtual void call();
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     compression_status operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen);
 };
 
@@ -201,6 +216,15 @@ bool bz2_decompressor_impl::flush(void*& dst, size_t dstlen)
 }
 
 
+void bz2_decompressor_impl::reset()
+{
+    BZ2_bzDecompressEnd(&stream);
+    check_bzstatus(BZ2_bzDecompressInit(&stream, verbosity, small));
+    status = BZ_OK;
+    clear();
+}
+
+
 compression_status bz2_decompressor_impl::operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
     return base::operator()(src, srclen, dst, dstlen, BZ_STREAM_END);
@@ -240,6 +264,12 @@ bool bz2_compressor::flush(void*& dst, size_t dstlen)
 }
 
 
+void bz2_compressor::reset()
+{
+    ptr_->reset();
+}
+
+
 void bz2_compressor::close() noexcept
 {
     ptr_.reset();
@@ -286,6 +316,12 @@ bool bz2_decompressor::flush(void*& dst, size_t dstlen)
 }
 
 
+void bz2_decompressor::reset()
+{
+    ptr_->reset();
+}
+
+
 void bz2_decompressor::close() noexcept
 {
     ptr_.reset();
@@ -304,24 +340,9 @@ void bz2_decompressor::swap(bz2_decompressor& rhs) noexcept
 
 void bz2_compress(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
-    // configurations
-    auto block_size = BZ2_BLOCK_SIZE;
-    auto verbosity = BZ2_VERBOSITY;
-    auto work_factor = BZ2_WORK_FACTOR;
-
-    unsigned int srclen_ = static_cast<unsigned int>(srclen);
-    unsigned int dstlen_ = static_cast<unsigned int>(dstlen);
-    if (srclen) {
-        PYCPP_CHECK(BZ2_bzBuffToBuffCompress((char*) dst, &dstlen_, (char*) src, srclen_, block_size, verbosity, work_factor));
-    } else {
-        // compression no bytes
-        char c = 0;
-        PYCPP_CHECK(BZ2_bzBuffToBuffCompress((char*) dst, &dstlen_, (char*) &c, 0, block_size, verbosity, work_factor));
-    }
-
-    // update pointers
-    src = ((char*) src) + srclen_;
-    dst = ((char*) dst) + dstlen_;
+    static context_pool<bz2_compressor> pool;
+    auto ctx = pool.acquire();
+    ctx_compress(*ctx, src, srclen, dst, dstlen);
 }
 
 
@@ -336,13 +357,16 @@ string bz2_compress(const string_wrapper& str)
 
 string bz2_decompress(const string_wrapper& str)
 {
-    return ctx_decompress<bz2_decompressor>(str);
+    static context_pool<bz2_decompressor> pool;
+    auto ctx = pool.acquire();
+    return ctx_decompress(str, *ctx);
 }
 
 
 void bz2_decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen, size_t bound)
 {
-    // configurations
+    // the buffer API reports truncated input and short output buffers,
+    // so it is preferred over a pooled context
     auto small = BZ2_SMALL;
     auto verbosity = BZ2_VERBOSITY;
 
@@ -39,6 +39,7 @@ public:
 
     compression_status compress(const void*& src, size_t srclen, void*& dst, size_t dstlen);
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     void close() noexcept;
     void swap(bz2_compressor&) noexcept;
 
@@ -60,6 +61,7 @@ public:
 
     compression_status decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen);
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     void close() noexcept;
     void swap(bz2_decompressor&) noexcept;
 
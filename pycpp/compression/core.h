@@ -9,6 +9,7 @@
 
 #include <pycpp/compression/exception.h>
 #include <pycpp/misc/safe_stdlib.h>
+#include <pycpp/stl/limits.h>
 #include <pycpp/stl/type_traits.h>
 #include <pycpp/stl/utility.h>
 #include <pycpp/string/string.h>
@@ -51,6 +52,8 @@ struct filter_impl
     // ----------------
     filter_impl() noexcept;
 
+    template <typename T> static T clamp(size_t length) noexcept;
+    void clear() noexcept;
     void before(void* dst, size_t dstlen) noexcept;
     void before(const void* src, size_t srclen, void* dst, size_t dstlen) noexcept;
     void after(void*& dst) noexcept;
@@ -67,6 +70,13 @@ struct filter_impl
 
 template <typename S>
 filter_impl<S>::filter_impl() noexcept
+{
+    clear();
+}
+
+
+template <typename S>
+void filter_impl<S>::clear() noexcept
 {
     stream.avail_in = 0;
     stream.next_in = nullptr;
@@ -75,13 +85,29 @@ filter_impl<S>::filter_impl() noexcept
 }
 
 
+/**
+ *  \brief Clamp a buffer length to the codec's length type.
+ *
+ *  zlib and bzip2 use 32-bit lengths, so larger buffers are fed in
+ *  chunks: the codec consumes at most the clamped length, and the
+ *  caller passes the remainder back on the next call.
+ */
+template <typename S>
+template <typename T>
+T filter_impl<S>::clamp(size_t length) noexcept
+{
+    using limits = numeric_limits<T>;
+    return length > static_cast<size_t>(limits::max()) ? limits::max() : static_cast<T>(length);
+}
+
+
 template <typename S>
 void filter_impl<S>::before(void* dst, size_t dstlen) noexcept
 {
     stream.next_in = nullptr;
     stream.avail_in = 0;
     stream.next_out = (next_out_type) dst;
-    stream.avail_out = (avail_out_type) dstlen;
+    stream.avail_out = clamp<avail_out_type>(dstlen);
 }
 
 
@@ -92,9 +118,9 @@ void filter_impl<S>::before(const void* src, size_t srclen, void* dst, size_t ds
     // about integer size changes and bzip2 uses a non-const
     // input byte array.
     stream.next_in = (next_in_type) (src);
-    stream.avail_in = (avail_in_type) srclen;
+    stream.avail_in = clamp<avail_in_type>(srclen);
     stream.next_out = (next_out_type) dst;
-    stream.avail_out = (avail_out_type) dstlen;
+    stream.avail_out = clamp<avail_out_type>(dstlen);
 }
 
 
@@ -154,12 +180,15 @@ compression_status filter_impl<S>::operator()(const void*& src, size_t srclen, v
         return compression_need_output;
     }
 
-    bool use_src = (stream.next_in == nullptr || stream.avail_in == 0);
+    // unconsumed input is returned to the caller, which passes it
+    // back on the next call
+    bool use_src = srclen != 0;
     if (use_src) {
         before(src, srclen, dst, dstlen);
     } else {
         // have remaining input data
-        before(dst, dstlen);
+        stream.next_out = (next_out_type) dst;
+        stream.avail_out = clamp<avail_out_type>(dstlen);
     }
 
     call();
@@ -179,7 +208,7 @@ compression_status filter_impl<S>::operator()(const void*& src, size_t srclen, v
 
 
 template <typename Ctx>
-string ctx_decompress(const string_wrapper& str)
+string ctx_decompress(const string_wrapper& str, Ctx& ctx)
 {
     // configurations
     size_t dstlen = BUFFER_SIZE;
@@ -193,7 +222,6 @@ string ctx_decompress(const string_wrapper& str)
     // initialize our decompression
     compression_status status = compression_ok;
     try {
-        Ctx ctx;
         while (status != compression_eof) {
             dstlen *= 2;
             buffer = (char*) safe_realloc(buffer, dstlen);
@@ -208,7 +236,7 @@ string ctx_decompress(const string_wrapper& str)
         dst_pos = distance(buffer, (char*) dst);
 
     } catch (...) {
-        safe_free(dst);
+        safe_free(buffer);
         throw;
     }
 
@@ -221,6 +249,51 @@ string ctx_decompress(const string_wrapper& str)
 }
 
 
+template <typename Ctx>
+string ctx_decompress(const string_wrapper& str)
+{
+    Ctx ctx;
+    return ctx_decompress(str, ctx);
+}
+
+
+/**
+ *  \brief Compress an entire buffer into a bounded output buffer.
+ *
+ *  Throws if the compressed stream does not fit in `dstlen` bytes.
+ */
+template <typename Ctx>
+void ctx_compress(Ctx& ctx, const void*& src, size_t srclen, void*& dst, size_t dstlen)
+{
+    // the codec may consume a chunk of the input per call
+    char* first = (char*) dst;
+    const char* last = (const char*) src + srclen;
+    while (src != (const void*) last) {
+        const void* src_first = src;
+        void* dst_first = dst;
+        ctx.compress(src, distance((const char*) src, last), dst, dstlen - distance(first, (char*) dst));
+        if (src == src_first && dst == dst_first) {
+            break;
+        }
+    }
+    // the stream cannot end without space for its trailer
+    size_t remaining = dstlen - distance(first, (char*) dst);
+    if (src != (const void*) last || remaining == 0 || !ctx.flush(dst, remaining)) {
+        throw compression_error(compression_unexpected_eof);
+    }
+
+    // a full buffer may hold a truncated stream, which has pending output
+    if (distance(first, (char*) dst) == dstlen) {
+        char c;
+        void* probe = &c;
+        ctx.flush(probe, 1);
+        if (probe != (void*) &c) {
+            throw compression_error(compression_unexpected_eof);
+        }
+    }
+}
+
+
 template <typename Function>
 string compress_bound(const string_wrapper& str, size_t dstlen, Function function)
 {
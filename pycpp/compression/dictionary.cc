@@ -0,0 +1,154 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/compression/dictionary.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/unordered_map.h>
+#include <pycpp/stl/unordered_set.h>
+#include <stdint.h>
+#include <string.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t KMER_SIZE = 8;
+static constexpr size_t SEGMENT_SIZE = 64;
+
+// HELPERS
+// -------
+
+using kmer_t = uint64_t;
+using kmer_map_t = unordered_map<kmer_t, size_t>;
+
+struct dictionary_segment
+{
+    size_t offset;
+    size_t score;
+};
+
+
+static kmer_t read_kmer(const char* p) noexcept
+{
+    kmer_t kmer;
+    memcpy(&kmer, p, KMER_SIZE);
+    return kmer;
+}
+
+
+/**
+ *  \brief Count the number of samples containing each k-mer.
+ *
+ *  K-mers unique to a single sample cannot be shared, and are dropped.
+ */
+static kmer_map_t count_kmers(const string_wrapper_list_t& samples)
+{
+    kmer_map_t counts;
+    unordered_set<kmer_t> seen;
+    for (const string_wrapper& sample: samples) {
+        if (sample.size() < KMER_SIZE) {
+            continue;
+        }
+        seen.clear();
+        for (size_t i = 0; i <= sample.size() - KMER_SIZE; ++i) {
+            kmer_t kmer = read_kmer(sample.data() + i);
+            if (seen.insert(kmer).second) {
+                ++counts[kmer];
+            }
+        }
+    }
+
+    for (auto it = counts.begin(); it != counts.end(); ) {
+        if (it->second < 2) {
+            it = counts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return counts;
+}
+
+
+static size_t kmer_score(const kmer_map_t& counts, const char* p)
+{
+    auto it = counts.find(read_kmer(p));
+    return it == counts.end() ? 0 : it->second;
+}
+
+
+/**
+ *  \brief Find the highest-scoring segment in `[first, last)`.
+ */
+static dictionary_segment best_segment(const kmer_map_t& counts, const string& data, size_t first, size_t last)
+{
+    const char* p = data.data();
+    const size_t width = SEGMENT_SIZE - KMER_SIZE + 1;
+    size_t score = 0;
+    for (size_t i = 0; i < width; ++i) {
+        score += kmer_score(counts, p + first + i);
+    }
+
+    dictionary_segment best = {first, score};
+    for (size_t i = first + 1; i + SEGMENT_SIZE <= last; ++i) {
+        score -= kmer_score(counts, p + i - 1);
+        score += kmer_score(counts, p + i + width - 1);
+        if (score > best.score) {
+            best = {i, score};
+        }
+    }
+
+    return best;
+}
+
+// FUNCTIONS
+// ---------
+
+
+string train_dictionary(const string_wrapper_list_t& samples, size_t max_size)
+{
+    string data;
+    for (const string_wrapper& sample: samples) {
+        data.append(sample.data(), sample.size());
+    }
+    if (data.size() <= max_size || max_size < SEGMENT_SIZE) {
+        // the samples themselves fit, keep the most recent bytes
+        size_t offset = data.size() - min(data.size(), max_size);
+        return data.substr(offset);
+    }
+
+    // divide the data into epochs, and select the best segment in each,
+    // similar to the COVER algorithm
+    kmer_map_t counts = count_kmers(samples);
+    size_t epochs = max_size / SEGMENT_SIZE;
+    size_t epoch_size = max(data.size() / epochs, SEGMENT_SIZE);
+    vector<dictionary_segment> segments;
+    for (size_t first = 0; first + SEGMENT_SIZE <= data.size(); first += epoch_size) {
+        size_t last = min(first + epoch_size, data.size());
+        dictionary_segment segment = best_segment(counts, data, first, max(last, first + SEGMENT_SIZE));
+        if (segment.score == 0) {
+            continue;
+        }
+        // k-mers already covered by the dictionary add no value
+        for (size_t i = 0; i <= SEGMENT_SIZE - KMER_SIZE; ++i) {
+            counts.erase(read_kmer(data.data() + segment.offset + i));
+        }
+        segments.push_back(segment);
+    }
+
+    // store the most valuable segments at the end of the dictionary
+    stable_sort(segments.begin(), segments.end(), [](const dictionary_segment& lhs, const dictionary_segment& rhs) {
+        return lhs.score < rhs.score;
+    });
+    size_t count = min(segments.size(), epochs);
+    string dictionary;
+    dictionary.reserve(count * SEGMENT_SIZE);
+    for (size_t i = segments.size() - count; i < segments.size(); ++i) {
+        dictionary.append(data, segments[i].offset, SEGMENT_SIZE);
+    }
+
+    return dictionary;
+}
+
+PYCPP_END_NAMESPACE
@@ -0,0 +1,48 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Shared dictionaries for small-message compression.
+ *
+ *  Small messages compress poorly on their own, since the compressor
+ *  has no history to find matches in. A preset dictionary, trained
+ *  from representative messages, primes the compressor with the
+ *  substrings the messages share.
+ *
+ *  \synopsis
+ *      static constexpr size_t DICTIONARY_SIZE = implementation-defined;
+ *
+ *      string train_dictionary(const string_wrapper_list_t& samples,
+ *          size_t max_size = DICTIONARY_SIZE);
+ */
+
+#pragma once
+
+#include <pycpp/string/string.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+/**
+ *  \brief Default dictionary size, the DEFLATE window size.
+ */
+static constexpr size_t DICTIONARY_SIZE = 32768;
+
+// FUNCTIONS
+// ---------
+
+/**
+ *  \brief Train a preset dictionary from sample messages.
+ *
+ *  Selects the segments containing the substrings shared by the most
+ *  samples, and orders them so the most valuable segments are last,
+ *  where back-references are shortest.
+ *
+ *  \param samples          Representative messages.
+ *  \param max_size         Maximum size of the dictionary, in bytes.
+ */
+string train_dictionary(const string_wrapper_list_t& samples, size_t max_size = DICTIONARY_SIZE);
+
+PYCPP_END_NAMESPACE
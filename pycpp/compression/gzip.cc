@@ -102,9 +102,11 @@ struct gzip_compressor_impl: filter_impl<z_stream>
 {
     using base = filter_impl<z_stream>;
 
+    int level;
     string header;
     uLong crc = 0;
     size_t size = 0;
+    bool footer_done = false;
 
     gzip_compressor_impl(int level = 9);
     ~gzip_compressor_impl() noexcept;
@@ -113,11 +115,13 @@ struct gzip_compressor_impl: filter_impl<z_stream>
     void write_footer(void*& dst);
     virtual void call();
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     compression_status operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen);
 };
 
 
-gzip_compressor_impl::gzip_compressor_impl(int level)
+gzip_compressor_impl::gzip_compressor_impl(int level):
+    level(level)
 {
     header = gzip_header(level);
 
@@ -149,7 +153,7 @@ void gzip_compressor_impl::write_header()
 
 void gzip_compressor_impl::write_footer(void*& dst)
 {
-    if (status == Z_STREAM_END && stream.avail_out >= 8) {
+    if (!footer_done && status == Z_STREAM_END && stream.avail_out >= 8) {
         // write CRC32
         uint32_t crc_le = htole32(crc);
         memcpy(stream.next_out, &crc_le, sizeof(uint32_t));
@@ -160,6 +164,7 @@ void gzip_compressor_impl::write_footer(void*& dst)
         memcpy(stream.next_out, &size_le, sizeof(uint32_t));
         stream.next_out += sizeof(uint32_t);
         after(dst);
+        footer_done = true;
     }
 }
 
@@ -172,12 +177,15 @@ void gzip_compressor_impl::call()
         return;
     }
 
-    size += stream.avail_in;
-    crc = crc32(crc, stream.next_in, stream.avail_in);
+    // only checksum the consumed input, the remainder is passed again
+    Bytef* src = stream.next_in;
     while (stream.avail_in && stream.avail_out && status != Z_STREAM_END) {
         status = deflate(&stream, Z_NO_FLUSH);
         check_zstatus(status);
     }
+    size_t length = distance(src, stream.next_in);
+    size += length;
+    crc = static_cast<uLong>(crc32(crc, src, static_cast<uInt>(length)));
 }
 
 
@@ -200,13 +208,27 @@ bool gzip_compressor_impl::flush(void*& dst, size_t dstlen)
         }
     });
     if (code) {
+        // the stream is incomplete until the footer fits
         write_footer(dst);
+        code = footer_done || status != Z_STREAM_END;
     }
 
     return code;
 }
 
 
+void gzip_compressor_impl::reset()
+{
+    check_zstatus(deflateReset(&stream));
+    status = Z_OK;
+    clear();
+    header = gzip_header(level);
+    crc = 0;
+    size = 0;
+    footer_done = false;
+}
+
+
 compression_status gzip_compressor_impl::operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
     return base::operator()(src, srclen, dst, dstlen, Z_STREAM_END);
@@ -231,6 +253,7 @@ struct gzip_decompressor_impl: filter_impl<z_stream>
     void read_footer();
     virtual void call();
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     compression_status operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen);
 };
 
@@ -331,6 +354,17 @@ bool gzip_decompressor_impl::flush(void*& dst, size_t dstlen)
 }
 
 
+void gzip_decompressor_impl::reset()
+{
+    check_zstatus(inflateReset(&stream));
+    status = Z_OK;
+    clear();
+    header_done = false;
+    crc = 0;
+    size = 0;
+}
+
+
 compression_status gzip_decompressor_impl::operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
     return base::operator()(src, srclen, dst, dstlen, Z_STREAM_END);
@@ -370,6 +404,12 @@ bool gzip_compressor::flush(void*& dst, size_t dstlen)
 }
 
 
+void gzip_compressor::reset()
+{
+    ptr_->reset();
+}
+
+
 void gzip_compressor::close() noexcept
 {
     ptr_.reset();
@@ -416,6 +456,12 @@ bool gzip_decompressor::flush(void*& dst, size_t dstlen)
 }
 
 
+void gzip_decompressor::reset()
+{
+    ptr_->reset();
+}
+
+
 void gzip_decompressor::close() noexcept
 {
     ptr_.reset();
@@ -434,9 +480,9 @@ void gzip_decompressor::swap(gzip_decompressor& rhs) noexcept
 
 void gzip_compress(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
-    gzip_compressor ctx;
-    ctx.compress(src, srclen, dst, dstlen);
-    ctx.flush(dst, dstlen);
+    static context_pool<gzip_compressor> pool;
+    auto ctx = pool.acquire();
+    ctx_compress(*ctx, src, srclen, dst, dstlen);
 }
 
 
@@ -449,16 +495,24 @@ string gzip_compress(const string_wrapper& str)
 }
 
 
+static context_pool<gzip_decompressor>& gzip_decompressor_pool()
+{
+    static context_pool<gzip_decompressor> pool;
+    return pool;
+}
+
+
 string gzip_decompress(const string_wrapper& str)
 {
-    return ctx_decompress<gzip_decompressor>(str);
+    auto ctx = gzip_decompressor_pool().acquire();
+    return ctx_decompress(str, *ctx);
 }
 
 
 void gzip_decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen, size_t bound)
 {
-    gzip_decompressor ctx;
-    ctx.decompress(src, srclen, dst, dstlen);
+    auto ctx = gzip_decompressor_pool().acquire();
+    ctx->decompress(src, srclen, dst, dstlen);
 }
 
 
@@ -469,6 +523,19 @@ string gzip_decompress(const string_wrapper& str, size_t bound)
     });
 }
 
+
+size_t gzip_decompressed_size(const string_wrapper& str)
+{
+    // 10-byte header and 8-byte footer
+    if (str.size() < 18) {
+        throw compression_error(compression_unexpected_eof);
+    }
+
+    uint32_t size_le;
+    memcpy(&size_le, str.data() + str.size() - 4, 4);
+    return le32toh(size_le);
+}
+
 PYCPP_END_NAMESPACE
 
 #endif                  // HAVE_ZLIB
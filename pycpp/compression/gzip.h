@@ -39,6 +39,7 @@ public:
 
     compression_status compress(const void*& src, size_t srclen, void*& dst, size_t dstlen);
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     void close() noexcept;
     void swap(gzip_compressor&) noexcept;
 
@@ -60,6 +61,7 @@ public:
 
     compression_status decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen);
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     void close() noexcept;
     void swap(gzip_decompressor&) noexcept;
 
@@ -110,6 +112,14 @@ void gzip_decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen,
  */
 string gzip_decompress(const string_wrapper& str, size_t bound);
 
+/**
+ *  \brief Get the decompressed size of GZIP data, from its trailer.
+ *
+ *  The trailer stores the size modulo 2^32, and only for the final
+ *  member, so the size is only exact for small, single-member files.
+ */
+size_t gzip_decompressed_size(const string_wrapper& str);
+
 PYCPP_END_NAMESPACE
 
 #endif                  // HAVE_ZLIB
@@ -5,10 +5,18 @@
 
 #include <pycpp/compression/core.h>
 #include <pycpp/compression/lzma.h>
+#include <pycpp/compression/pool.h>
+#include <pycpp/stl/algorithm.h>
 #include <lzma.h>
 
 PYCPP_BEGIN_NAMESPACE
 
+// CONSTANTS
+// ---------
+
+// idle encoders hold tens of megabytes at high presets, keep few
+static constexpr size_t LZMA_CONTEXT_POOL_SIZE = 2;
+
 // HELPERS
 // -------
 
@@ -18,6 +26,70 @@ static size_t lzma_compress_bound(size_t size)
 }
 
 
+static lzma_options lzma_level_options(int level)
+{
+    lzma_options options;
+    options.level = level;
+    return options;
+}
+
+
+/**
+ *  \brief Get the number of worker threads, 0 for one per processor.
+ */
+static uint32_t lzma_threads(size_t threads)
+{
+    if (threads == 0) {
+        threads = lzma_cputhreads();
+    }
+    return static_cast<uint32_t>(max<size_t>(threads, 1));
+}
+
+
+/**
+ *  \brief Initialize the encoder, using the block-parallel encoder for multiple threads.
+ */
+static lzma_ret lzma_encoder_init(lzma_stream& stream, const lzma_options& options)
+{
+    uint32_t threads = lzma_threads(options.threads);
+    if (threads == 1) {
+        return lzma_easy_encoder(&stream, options.level, LZMA_CHECK_CRC64);
+    }
+
+    lzma_mt mt = {};
+    mt.threads = threads;
+    mt.block_size = options.block_size;
+    mt.timeout = 0;
+    mt.preset = options.level;
+    mt.check = LZMA_CHECK_CRC64;
+    return lzma_stream_encoder_mt(&stream, &mt);
+}
+
+
+/**
+ *  \brief Initialize the decoder, using the block-parallel decoder for multiple threads.
+ *
+ *  Only streams with the compressed size stored in the block headers,
+ *  as written by the multi-threaded encoder, are decoded in parallel.
+ */
+static lzma_ret lzma_decoder_init(lzma_stream& stream, uint32_t threads, uint64_t memlimit, uint32_t flags)
+{
+#if LZMA_VERSION >= 50040002
+    if (threads > 1) {
+        lzma_mt mt = {};
+        mt.flags = flags;
+        mt.threads = threads;
+        mt.timeout = 0;
+        mt.memlimit_threading = memlimit;
+        mt.memlimit_stop = memlimit;
+        return lzma_stream_decoder_mt(&stream, &mt);
+    }
+#endif
+
+    return lzma_stream_decoder(&stream, memlimit, flags);
+}
+
+
 void check_xzstatus(int error)
 {
     switch (error) {
@@ -53,21 +125,25 @@ void check_xzstatus(int error)
 struct lzma_compressor_impl: filter_impl<lzma_stream>
 {
     using base = filter_impl<lzma_stream>;
-    lzma_compressor_impl(int level = LZMA_PRESET_DEFAULT);
+    lzma_compressor_impl(const lzma_options& options);
     ~lzma_compressor_impl() noexcept;
 
     virtual void call();
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     compression_status operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen);
+
+    lzma_options options;
 };
 
 
 
-lzma_compressor_impl::lzma_compressor_impl(int level)
+lzma_compressor_impl::lzma_compressor_impl(const lzma_options& options):
+    options(options)
 {
     stream = LZMA_STREAM_INIT;
     status = LZMA_OK;
-    PYCPP_CHECK(lzma_easy_encoder(&stream, level, LZMA_CHECK_CRC64));
+    PYCPP_CHECK(lzma_encoder_init(stream, options));
 }
 
 
@@ -91,7 +167,11 @@ bool lzma_compressor_impl::flush(void*& dst, size_t dstlen)
     return base::flush(dst, dstlen, [&]()
     {
         if (dstlen) {
-            status = lzma_code(&stream, LZMA_FINISH);
+            // the multi-threaded encoder may return partial output
+            // while blocks are still being compressed
+            do {
+                status = lzma_code(&stream, LZMA_FINISH);
+            } while (status == LZMA_OK && stream.avail_out);
             return status == LZMA_STREAM_END || status == LZMA_OK;
         } else {
             status = lzma_code(&stream, LZMA_FULL_FLUSH);
@@ -101,6 +181,15 @@ bool lzma_compressor_impl::flush(void*& dst, size_t dstlen)
 }
 
 
+void lzma_compressor_impl::reset()
+{
+    // re-initializing an existing encoder reuses its allocations
+    check_xzstatus(lzma_encoder_init(stream, options));
+    status = LZMA_OK;
+    clear();
+}
+
+
 compression_status lzma_compressor_impl::operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
     return base::operator()(src, srclen, dst, dstlen, LZMA_STREAM_END);
@@ -116,20 +205,24 @@ struct lzma_decompressor_impl: filter_impl<lzma_stream>
     static const uint64_t memlimit = UINT64_MAX;
     static const uint32_t flags = LZMA_TELL_ANY_CHECK | LZMA_TELL_NO_CHECK;
 
-    lzma_decompressor_impl();
+    lzma_decompressor_impl(size_t threads = 1);
     ~lzma_decompressor_impl() noexcept;
 
     virtual void call();
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     compression_status operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen);
+
+    uint32_t threads;
 };
 
 
-lzma_decompressor_impl::lzma_decompressor_impl()
+lzma_decompressor_impl::lzma_decompressor_impl(size_t threads):
+    threads(lzma_threads(threads))
 {
     stream = LZMA_STREAM_INIT;
     status = LZMA_OK;
-    PYCPP_CHECK(lzma_stream_decoder(&stream, memlimit, flags));
+    PYCPP_CHECK(lzma_decoder_init(stream, this->threads, memlimit, flags));
 }
 
 
@@ -163,6 +256,14 @@ bool lzma_decompressor_impl::flush(void*& dst, size_t dstlen)
 }
 
 
+void lzma_decompressor_impl::reset()
+{
+    check_xzstatus(lzma_decoder_init(stream, threads, memlimit, flags));
+    status = LZMA_OK;
+    clear();
+}
+
+
 compression_status lzma_decompressor_impl::operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
     return base::operator()(src, srclen, dst, dstlen, LZMA_STREAM_END);
@@ -170,7 +271,12 @@ compression_status lzma_decompressor_impl::operator()(const void*& src, size_t s
 
 
 lzma_compressor::lzma_compressor(int level):
-    ptr_(make_unique<lzma_compressor_impl>(level))
+    lzma_compressor(lzma_level_options(level))
+{}
+
+
+lzma_compressor::lzma_compressor(const lzma_options& options):
+    ptr_(make_unique<lzma_compressor_impl>(options))
 {}
 
 
@@ -202,6 +308,12 @@ bool lzma_compressor::flush(void*& dst, size_t dstlen)
 }
 
 
+void lzma_compressor::reset()
+{
+    ptr_->reset();
+}
+
+
 void lzma_compressor::close() noexcept
 {
     ptr_.reset();
@@ -220,6 +332,11 @@ lzma_decompressor::lzma_decompressor():
 {}
 
 
+lzma_decompressor::lzma_decompressor(size_t threads):
+    ptr_(make_unique<lzma_decompressor_impl>(threads))
+{}
+
+
 lzma_decompressor::lzma_decompressor(lzma_decompressor&& rhs) noexcept:
     ptr_(move(rhs.ptr_))
 {}
@@ -248,6 +365,12 @@ bool lzma_decompressor::flush(void*& dst, size_t dstlen)
 }
 
 
+void lzma_decompressor::reset()
+{
+    ptr_->reset();
+}
+
+
 void lzma_decompressor::close() noexcept
 {
     ptr_.reset();
@@ -266,20 +389,9 @@ void lzma_decompressor::swap(lzma_decompressor& rhs) noexcept
 
 void lzma_compress(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
-    static uint32_t level = LZMA_PRESET_DEFAULT;
-    static lzma_check check = LZMA_CHECK_CRC64;
-    size_t dstpos = 0;
-    if (srclen) {
-        PYCPP_CHECK(lzma_easy_buffer_encode(level, check, nullptr, (const uint8_t*) src, srclen, (uint8_t*) dst, &dstpos, dstlen));
-    } else {
-        // compression no bytes
-        char c = 0;
-        PYCPP_CHECK(lzma_easy_buffer_encode(level, check, nullptr, (const uint8_t*) &c, 0, (uint8_t*) dst, &dstpos, dstlen));
-    }
-
-    // update pointers
-    src = ((char*) src) + srclen;
-    dst = ((char*) dst) + dstpos;
+    static context_pool<lzma_compressor> pool(LZMA_CONTEXT_POOL_SIZE);
+    auto ctx = pool.acquire();
+    ctx_compress(*ctx, src, srclen, dst, dstlen);
 }
 
 
@@ -294,12 +406,16 @@ string lzma_compress(const string_wrapper& str)
 
 string lzma_decompress(const string_wrapper& str)
 {
-    return ctx_decompress<lzma_decompressor>(str);
+    static context_pool<lzma_decompressor> pool(LZMA_CONTEXT_POOL_SIZE);
+    auto ctx = pool.acquire();
+    return ctx_decompress(str, *ctx);
 }
 
 
 void lzma_decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen, size_t bound)
 {
+    // decoders only size their dictionary to the stream, unlike
+    // encoders, so the one-shot buffer API is used rather than a pool
     static uint64_t memlimit = UINT64_MAX;
     size_t srcpos = 0;
     size_t dstpos = 0;
@@ -324,6 +440,37 @@ string lzma_decompress(const string_wrapper& str, size_t bound)
     });
 }
 
+
+size_t lzma_decompressed_size(const string_wrapper& str)
+{
+    // skip the stream padding, which is a multiple of 4 null bytes
+    const uint8_t* first = (const uint8_t*) str.data();
+    const uint8_t* last = first + str.size();
+    while (last - first >= 4 && !(last[-1] | last[-2] | last[-3] | last[-4])) {
+        last -= 4;
+    }
+    if (last - first < 2 * LZMA_STREAM_HEADER_SIZE) {
+        throw compression_error(compression_unexpected_eof);
+    }
+
+    // the footer stores the size of the index, which precedes it
+    lzma_stream_flags flags;
+    check_xzstatus(lzma_stream_footer_decode(&flags, last - LZMA_STREAM_HEADER_SIZE));
+    if (static_cast<lzma_vli>(last - first) < 2 * LZMA_STREAM_HEADER_SIZE + flags.backward_size) {
+        throw compression_error(compression_unexpected_eof);
+    }
+
+    lzma_index* index = nullptr;
+    uint64_t memlimit = UINT64_MAX;
+    size_t position = 0;
+    const uint8_t* data = last - LZMA_STREAM_HEADER_SIZE - flags.backward_size;
+    check_xzstatus(lzma_index_buffer_decode(&index, &memlimit, nullptr, data, &position, flags.backward_size));
+    lzma_vli size = lzma_index_uncompressed_size(index);
+    lzma_index_end(index, nullptr);
+
+    return static_cast<size_t>(size);
+}
+
 PYCPP_END_NAMESPACE
 
 #endif                  // HAVE_LZMA
@@ -3,6 +3,10 @@
 /**
  *  \addtogroup PyCPP
  *  \brief LZMA compression and decompression.
+ *
+ *  The compressor and decompressor may be configured to use multiple
+ *  threads: the encoder splits the input into independent blocks,
+ *  which the decoder may then decode in parallel.
  */
 
 #pragma once
@@ -26,6 +30,22 @@ struct lzma_decompressor_impl;
 // OBJECTS
 // -------
 
+/**
+ *  \brief Compression parameters for LZMA2.
+ *
+ *  A `threads` count of 0 uses one thread per processor, and a
+ *  `block_size` of 0 lets liblzma choose the block size, 3 times the
+ *  dictionary size. Smaller blocks allow more parallelism, at the
+ *  cost of the compression ratio.
+ */
+struct lzma_options
+{
+    int level = 6;
+    size_t threads = 1;
+    size_t block_size = 0;
+};
+
+
 /**
  *  \brief Wrapper for a LZMA2 compressor.
  */
@@ -33,12 +53,14 @@ struct lzma_compressor
 {
 public:
     lzma_compressor(int compress_level = 6);
+    lzma_compressor(const lzma_options& options);
     lzma_compressor(lzma_compressor&&) noexcept;
     lzma_compressor & operator=(lzma_compressor&&) noexcept;
     ~lzma_compressor() noexcept;
 
     compression_status compress(const void*& src, size_t srclen, void*& dst, size_t dstlen);
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     void close() noexcept;
     void swap(lzma_compressor&) noexcept;
 
@@ -54,12 +76,14 @@ struct lzma_decompressor
 {
 public:
     lzma_decompressor();
+    explicit lzma_decompressor(size_t threads);
     lzma_decompressor(lzma_decompressor&&) noexcept;
     lzma_decompressor & operator=(lzma_decompressor&&) noexcept;
     ~lzma_decompressor() noexcept;
 
     compression_status decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen);
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     void close() noexcept;
     void swap(lzma_decompressor&) noexcept;
 
@@ -110,6 +134,13 @@ void lzma_decompress(const void*& src, size_t srclen, void*& dst, size_t dstlen,
  */
 string lzma_decompress(const string_wrapper& str, size_t bound);
 
+/**
+ *  \brief Get the decompressed size of an XZ stream, from its index.
+ *
+ *  Only the final stream is read for concatenated streams.
+ */
+size_t lzma_decompressed_size(const string_wrapper& str);
+
 PYCPP_END_NAMESPACE
 
 #endif                  // HAVE_LZMA
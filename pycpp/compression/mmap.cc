@@ -0,0 +1,394 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/compression/core.h>
+#include <pycpp/compression/mmap.h>
+#include <string.h>
+
+#if defined(HAVE_MMAP) || defined(OS_WINDOWS)           // MMAP
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+// DEFLATE cannot exceed a 1032:1 compression ratio.
+static constexpr size_t DEFLATE_MAX_RATIO = 1032;
+
+// MACROS
+// ------
+
+/**
+ *  \brief Callback function for decompression.
+ */
+#define DECOMPRESS_CALLBACK                                                                 \
+    [this](const void*& src, size_t srclen, void*& dst, size_t dstlen, size_t char_size)    \
+    {                                                                                       \
+        if (srclen) {                                                                       \
+            ctx.decompress(src, srclen, dst, dstlen);                                       \
+        } else {                                                                            \
+            ctx.flush(dst, dstlen);                                                         \
+        }                                                                                   \
+    }
+
+
+/**
+ *  \brief Macro to define a decompressing, memory-mapped ifstream.
+ */
+#define COMPRESSED_MMAP_IFSTREAM_DEFINITION(name)                                           \
+    name##_mmap_ifstream::name##_mmap_ifstream():                                           \
+        istream(&buffer)                                                                    \
+    {}                                                                                      \
+                                                                                            \
+    name##_mmap_ifstream::name##_mmap_ifstream(name##_decompressor&& context):              \
+        istream(&buffer),                                                                   \
+        ctx(PYCPP_NAMESPACE::move(context))                                                 \
+    {}                                                                                      \
+                                                                                            \
+    name##_mmap_ifstream::~name##_mmap_ifstream()                                           \
+    {                                                                                       \
+        close();                                                                            \
+    }                                                                                       \
+                                                                                            \
+    name##_mmap_ifstream::name##_mmap_ifstream(const string_view& path):                    \
+        name##_mmap_ifstream()                                                              \
+    {                                                                                       \
+        open(path);                                                                         \
+    }                                                                                       \
+                                                                                            \
+    name##_mmap_ifstream::name##_mmap_ifstream(const string_view& path, name##_decompressor&& context):    \
+        name##_mmap_ifstream(PYCPP_NAMESPACE::move(context))                                \
+    {                                                                                       \
+        open(path);                                                                         \
+    }                                                                                       \
+                                                                                            \
+    void name##_mmap_ifstream::open(const string_view& path)                                \
+    {                                                                                       \
+        close();                                                                            \
+        ctx.reset();                                                                        \
+        file.open(path);                                                                    \
+        if (!file.is_open()) {                                                              \
+            setstate(ios_base::failbit);                                                    \
+            return;                                                                         \
+        }                                                                                   \
+        /* empty files cannot be mapped, and have no data */                                \
+        file.map(0);                                                                        \
+        buffer.set_view(string_view(file.data(), file.size()));                             \
+        buffer.set_callback(DECOMPRESS_CALLBACK);                                           \
+        clear();                                                                            \
+    }                                                                                       \
+                                                                                            \
+    bool name##_mmap_ifstream::is_open() const                                              \
+    {                                                                                       \
+        return file.is_open();                                                              \
+    }                                                                                       \
+                                                                                            \
+    void name##_mmap_ifstream::close()                                                      \
+    {                                                                                       \
+        buffer.set_view(string_view());                                                     \
+        buffer.set_callback(nullptr);                                                       \
+        file.close();                                                                       \
+    }
+
+// HELPERS
+// -------
+
+/**
+ *  \brief Read-only view of a memory-mapped file.
+ */
+struct mapped_file
+{
+    mmap_ifstream stream;
+
+    mapped_file(const string_view& path):
+        stream(path)
+    {
+        if (!stream.is_open()) {
+            throw compression_error(compression_io_error);
+        }
+        // empty files cannot be mapped, and have no data
+        stream.map(0);
+    }
+
+    string_wrapper view() const
+    {
+        return string_wrapper(stream.data(), stream.size());
+    }
+};
+
+
+static compression_format detect_format(const string_wrapper& str)
+{
+#if defined(HAVE_BZIP2)
+    if (is_bz2::header(str)) {
+        return compression_bz2;
+    }
+#endif              // HAVE_BZIP2
+
+#if defined(HAVE_ZLIB)
+    if (is_zlib::header(str)) {
+        return compression_zlib;
+    } else if (is_gzip::header(str)) {
+        return compression_gzip;
+    }
+#endif              // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)
+    if (is_lzma::header(str)) {
+        return compression_lzma;
+    }
+#endif              // HAVE_LZMA
+
+#if defined(HAVE_BLOSC)
+    if (is_blosc::header(str)) {
+        return compression_blosc;
+    }
+#endif              // HAVE_BLOSC
+
+    return compression_none;
+}
+
+
+/**
+ *  \brief Decompress into a fixed buffer, returning false if it is too small.
+ */
+template <typename Ctx>
+static bool ctx_decompress_into(const string_wrapper& str, void* dst, size_t dstlen, size_t& length)
+{
+    Ctx ctx;
+    const void* src = (const void*) str.data();
+    void* out = dst;
+    compression_status status = compression_ok;
+    while (status != compression_eof) {
+        const void* src_first = src;
+        void* dst_first = out;
+        size_t src_pos = distance(str.data(), (const char*) src);
+        size_t dst_pos = distance((char*) dst, (char*) out);
+        status = ctx.decompress(src, str.size() - src_pos, out, dstlen - dst_pos);
+        if (src == src_first && out == dst_first) {
+            if (dst_pos == dstlen) {
+                length = dstlen;
+                return false;
+            }
+            throw compression_error(compression_unexpected_eof);
+        }
+    }
+
+    ctx.flush(out, dstlen - distance((char*) dst, (char*) out));
+    length = distance((char*) dst, (char*) out);
+
+    return true;
+}
+
+
+static bool decompress_into(const string_wrapper& str, void* dst, size_t dstlen, size_t& length)
+{
+    switch (detect_format(str)) {
+#if defined(HAVE_BZIP2)
+        case compression_bz2:
+            return ctx_decompress_into<bz2_decompressor>(str, dst, dstlen, length);
+#endif              // HAVE_BZIP2
+
+#if defined(HAVE_ZLIB)
+        case compression_zlib:
+            return ctx_decompress_into<zlib_decompressor>(str, dst, dstlen, length);
+
+        case compression_gzip:
+            return ctx_decompress_into<gzip_decompressor>(str, dst, dstlen, length);
+#endif              // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)
+        case compression_lzma:
+            return ctx_decompress_into<lzma_decompressor>(str, dst, dstlen, length);
+#endif              // HAVE_LZMA
+
+#if defined(HAVE_BLOSC)
+        case compression_blosc:
+        {
+            size_t size = blosc_decompressed_size(str);
+            if (size > dstlen) {
+                length = 0;
+                return false;
+            }
+            const void* src = (const void*) str.data();
+            void* out = dst;
+            blosc_decompress(src, str.size(), out, dstlen, size);
+            length = distance((char*) dst, (char*) out);
+            return true;
+        }
+#endif              // HAVE_BLOSC
+
+        default:
+            throw compression_error(compression_data_error);
+    }
+}
+
+
+static string decompress_string(const string_wrapper& str)
+{
+    switch (detect_format(str)) {
+#if defined(HAVE_BZIP2)
+        case compression_bz2:
+            return ctx_decompress<bz2_decompressor>(str);
+#endif              // HAVE_BZIP2
+
+#if defined(HAVE_ZLIB)
+        case compression_zlib:
+            return ctx_decompress<zlib_decompressor>(str);
+
+        case compression_gzip:
+            return ctx_decompress<gzip_decompressor>(str);
+#endif              // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)
+        case compression_lzma:
+            return ctx_decompress<lzma_decompressor>(str);
+#endif              // HAVE_LZMA
+
+#if defined(HAVE_BLOSC)
+        case compression_blosc:
+            return blosc_decompress(str);
+#endif              // HAVE_BLOSC
+
+        default:
+            throw compression_error(compression_data_error);
+    }
+}
+
+// OBJECTS
+// -------
+
+#if defined(HAVE_BZIP2)                     // HAVE_BZIP2
+    COMPRESSED_MMAP_IFSTREAM_DEFINITION(bz2);
+#endif                                      // HAVE_BZIP2
+
+#if defined(HAVE_ZLIB)                      // HAVE_ZLIB
+    COMPRESSED_MMAP_IFSTREAM_DEFINITION(zlib);
+    COMPRESSED_MMAP_IFSTREAM_DEFINITION(gzip);
+#endif                                      // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)                      // HAVE_LZMA
+    COMPRESSED_MMAP_IFSTREAM_DEFINITION(lzma);
+#endif                                      // HAVE_LZMA
+
+// FUNCTIONS
+// ---------
+
+
+size_t decompressed_size(const string_wrapper& str)
+{
+    switch (detect_format(str)) {
+#if defined(HAVE_ZLIB)
+        case compression_gzip:
+        {
+            // the trailer is not checksummed, reject impossible sizes
+            size_t size = gzip_decompressed_size(str);
+            if (size / DEFLATE_MAX_RATIO > str.size()) {
+                return DECOMPRESSED_SIZE_UNKNOWN;
+            }
+            return size;
+        }
+#endif              // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)
+        case compression_lzma:
+            return lzma_decompressed_size(str);
+#endif              // HAVE_LZMA
+
+#if defined(HAVE_BLOSC)
+        case compression_blosc:
+            return blosc_decompressed_size(str);
+#endif              // HAVE_BLOSC
+
+        default:
+            return DECOMPRESSED_SIZE_UNKNOWN;
+    }
+}
+
+
+size_t decompress(const string_wrapper& str, void* dst, size_t dstlen)
+{
+    size_t length;
+    if (!decompress_into(str, dst, dstlen, length)) {
+        throw compression_error(compression_invalid_parameter);
+    }
+
+    return length;
+}
+
+
+size_t mmap_decompressed_size(const string_view& path)
+{
+    mapped_file file(path);
+    return decompressed_size(file.view());
+}
+
+
+size_t mmap_decompress(const string_view& path, void* dst, size_t dstlen)
+{
+    mapped_file file(path);
+    return decompress(file.view(), dst, dstlen);
+}
+
+
+string mmap_decompress(const string_view& path)
+{
+    mapped_file file(path);
+    string_wrapper str = file.view();
+
+    // the stored size may be wrong, for example, with a concatenated
+    // GZIP file, so fallback to a growable buffer if it is too small
+    size_t size = decompressed_size(str);
+    if (size != DECOMPRESSED_SIZE_UNKNOWN) {
+        string output(size, '\0');
+        size_t length;
+        if (decompress_into(str, &output[0], size, length)) {
+            output.resize(length);
+            return output;
+        }
+    }
+
+    return decompress_string(str);
+}
+
+
+size_t mmap_decompress(const string_view& src, const string_view& dst)
+{
+    mapped_file file(src);
+    string_wrapper str = file.view();
+    mmap_ofstream output(dst, ios_base::out | ios_base::trunc);
+    if (!output.is_open()) {
+        throw compression_error(compression_io_error);
+    }
+
+    // decompress directly into the mapped output file
+    size_t size = decompressed_size(str);
+    if (size != DECOMPRESSED_SIZE_UNKNOWN && size != 0) {
+        output.map(0, size);
+        if (!output.has_mapping()) {
+            throw compression_error(compression_io_error);
+        }
+        size_t length;
+        if (decompress_into(str, output.data(), size, length) && length == size) {
+            return length;
+        }
+        output.close();
+        output.open(dst, ios_base::out | ios_base::trunc);
+    }
+
+    // size is unknown or incorrect, decompress to memory first
+    string data = decompress_string(str);
+    if (!data.empty()) {
+        output.map(0, data.size());
+        if (!output.has_mapping()) {
+            throw compression_error(compression_io_error);
+        }
+        memcpy(output.data(), data.data(), data.size());
+    }
+
+    return data.size();
+}
+
+PYCPP_END_NAMESPACE
+
+#endif                                                  // MMAP
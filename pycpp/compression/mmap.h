@@ -0,0 +1,126 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Zero-copy decompression from memory-mapped files.
+ *
+ *  The compressed file is mapped into memory, and the mapped region
+ *  is passed directly to the decompressor, rather than read into
+ *  an intermediate buffer. When the decompressed size is stored in
+ *  the compressed data (the GZIP trailer, the XZ index, or the
+ *  BLOSC header), the file may be decompressed in a single pass
+ *  into a caller-provided or memory-mapped output buffer.
+ */
+
+#pragma once
+
+#include <pycpp/compression/stream.h>
+#include <pycpp/stream/mmap.h>
+
+#if defined(HAVE_MMAP) || defined(OS_WINDOWS)           // MMAP
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t DECOMPRESSED_SIZE_UNKNOWN = SIZE_MAX;
+
+// MACROS
+// ------
+
+/**
+ *  \brief Macro to define a decompressing, memory-mapped ifstream.
+ */
+#define COMPRESSED_MMAP_IFSTREAM(name)                                                      \
+    struct name##_mmap_ifstream: istream                                                    \
+    {                                                                                       \
+    public:                                                                                 \
+        name##_mmap_ifstream();                                                             \
+        name##_mmap_ifstream(name##_decompressor&& context);                                \
+        name##_mmap_ifstream(const name##_mmap_ifstream&) = delete;                         \
+        name##_mmap_ifstream & operator=(const name##_mmap_ifstream&) = delete;             \
+        ~name##_mmap_ifstream();                                                            \
+                                                                                            \
+        name##_mmap_ifstream(const string_view& name);                                      \
+        name##_mmap_ifstream(const string_view& name, name##_decompressor&& context);       \
+        void open(const string_view& name);                                                 \
+        bool is_open() const;                                                               \
+        void close();                                                                       \
+                                                                                            \
+    private:                                                                                \
+        view_filter_streambuf buffer;                                                       \
+        mmap_ifstream file;                                                                 \
+        name##_decompressor ctx;                                                            \
+    }
+
+// OBJECTS
+// -------
+
+#if defined(HAVE_BZIP2)                     // HAVE_BZIP2
+    COMPRESSED_MMAP_IFSTREAM(bz2);
+#endif                                      // HAVE_BZIP2
+
+#if defined(HAVE_ZLIB)                      // HAVE_ZLIB
+    COMPRESSED_MMAP_IFSTREAM(zlib);
+    COMPRESSED_MMAP_IFSTREAM(gzip);
+#endif                                      // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)                      // HAVE_LZMA
+    COMPRESSED_MMAP_IFSTREAM(lzma);
+#endif                                      // HAVE_LZMA
+
+// FUNCTIONS
+// ---------
+
+/**
+ *  \brief Get the decompressed size stored in compressed data.
+ *
+ *  Returns `DECOMPRESSED_SIZE_UNKNOWN` if the format does not
+ *  store the size, such as BZ2 or ZLIB.
+ */
+size_t decompressed_size(const string_wrapper& str);
+
+/**
+ *  \brief Decompress data, detecting the format, into a buffer.
+ *
+ *  Returns the number of bytes written, and throws a
+ *  `compression_error` if the buffer is too small.
+ */
+size_t decompress(const string_wrapper& str, void* dst, size_t dstlen);
+
+/**
+ *  \brief Get the decompressed size stored in a compressed file.
+ */
+size_t mmap_decompressed_size(const string_view& path);
+
+/**
+ *  \brief Decompress a memory-mapped file into a buffer.
+ *
+ *  Returns the number of bytes written, and throws a
+ *  `compression_error` if the buffer is too small.
+ */
+size_t mmap_decompress(const string_view& path, void* dst, size_t dstlen);
+
+/**
+ *  \brief Decompress a memory-mapped file.
+ *
+ *  The output is allocated once if the decompressed size is known.
+ */
+string mmap_decompress(const string_view& path);
+
+/**
+ *  \brief Decompress a memory-mapped file into a memory-mapped file.
+ *
+ *  Returns the number of bytes written.
+ */
+size_t mmap_decompress(const string_view& src, const string_view& dst);
+
+// CLEANUP
+// -------
+
+#undef COMPRESSED_MMAP_IFSTREAM
+
+PYCPP_END_NAMESPACE
+
+#endif                                                  // MMAP
@@ -0,0 +1,189 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Thread-safe pool of reusable compression contexts.
+ *
+ *  Initializing a codec context is expensive, especially for LZMA,
+ *  where the encoder state is several megabytes. The pool keeps
+ *  idle contexts, which are reset and reused by subsequent callers,
+ *  rather than being destroyed.
+ *
+ *  \synopsis
+ *      static constexpr size_t CONTEXT_POOL_SIZE = implementation-defined;
+ *
+ *      template <typename Ctx>
+ *      struct pooled_context
+ *      {
+ *          pooled_context(context_pool<Ctx>& pool, Ctx&& ctx) noexcept;
+ *          pooled_context(pooled_context&&) noexcept;
+ *          ~pooled_context() noexcept;
+ *
+ *          Ctx& operator*() noexcept;
+ *          Ctx* operator->() noexcept;
+ *      };
+ *
+ *      template <typename Ctx>
+ *      struct context_pool
+ *      {
+ *          using value_type = Ctx;
+ *          using factory_type = function<Ctx()>;
+ *
+ *          context_pool(size_t max_size = CONTEXT_POOL_SIZE);
+ *          context_pool(factory_type factory, size_t max_size = CONTEXT_POOL_SIZE);
+ *
+ *          pooled_context<Ctx> acquire();
+ *          void release(Ctx&& ctx) noexcept;
+ *
+ *          size_t size() const;
+ *          size_t max_size() const noexcept;
+ *          void clear();
+ *      };
+ */
+
+#pragma once
+
+#include <pycpp/stl/functional.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/utility.h>
+#include <pycpp/stl/vector.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t CONTEXT_POOL_SIZE = 16;
+
+// FORWARD
+// -------
+
+template <typename Ctx>
+struct context_pool;
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Context acquired from a pool, returned to the pool on destruction.
+ */
+template <typename Ctx>
+struct pooled_context
+{
+public:
+    pooled_context(const pooled_context&) = delete;
+    pooled_context& operator=(const pooled_context&) = delete;
+
+    pooled_context(context_pool<Ctx>& pool, Ctx&& ctx) noexcept:
+        pool_(&pool),
+        ctx_(move(ctx))
+    {}
+
+    pooled_context(pooled_context&& rhs) noexcept:
+        pool_(rhs.pool_),
+        ctx_(move(rhs.ctx_))
+    {
+        rhs.pool_ = nullptr;
+    }
+
+    ~pooled_context() noexcept
+    {
+        if (pool_) {
+            pool_->release(move(ctx_));
+        }
+    }
+
+    Ctx& operator*() noexcept
+    {
+        return ctx_;
+    }
+
+    Ctx* operator->() noexcept
+    {
+        return &ctx_;
+    }
+
+private:
+    context_pool<Ctx>* pool_;
+    Ctx ctx_;
+};
+
+
+/**
+ *  \brief Thread-safe pool of compressor or decompressor contexts.
+ *
+ *  Contexts are reset when released, so an acquired context is always
+ *  ready for a new stream. At most `max_size` idle contexts are kept.
+ */
+template <typename Ctx>
+struct context_pool
+{
+public:
+    using value_type = Ctx;
+    using factory_type = function<Ctx()>;
+
+    context_pool(const context_pool&) = delete;
+    context_pool& operator=(const context_pool&) = delete;
+
+    context_pool(size_t max_size = CONTEXT_POOL_SIZE):
+        context_pool([]() { return Ctx(); }, max_size)
+    {}
+
+    context_pool(factory_type factory, size_t max_size = CONTEXT_POOL_SIZE):
+        factory_(move(factory)),
+        max_size_(max_size)
+    {}
+
+    pooled_context<Ctx> acquire()
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (!contexts_.empty()) {
+                Ctx ctx = move(contexts_.back());
+                contexts_.pop_back();
+                return pooled_context<Ctx>(*this, move(ctx));
+            }
+        }
+
+        // initialize outside of the lock
+        return pooled_context<Ctx>(*this, factory_());
+    }
+
+    void release(Ctx&& ctx) noexcept
+    {
+        try {
+            ctx.reset();
+            lock_guard<mutex> lock(mutex_);
+            if (contexts_.size() < max_size_) {
+                contexts_.emplace_back(move(ctx));
+            }
+        } catch (...) {
+            // context could not be reset, let it be destroyed
+        }
+    }
+
+    size_t size() const
+    {
+        lock_guard<mutex> lock(mutex_);
+        return contexts_.size();
+    }
+
+    size_t max_size() const noexcept
+    {
+        return max_size_;
+    }
+
+    void clear()
+    {
+        lock_guard<mutex> lock(mutex_);
+        contexts_.clear();
+    }
+
+private:
+    factory_type factory_;
+    size_t max_size_;
+    mutable mutex mutex_;
+    vector<Ctx> contexts_;
+};
+
+PYCPP_END_NAMESPACE
@@ -44,6 +44,12 @@ PYCPP_BEGIN_NAMESPACE
 #   define WIDE_PATH_IFSTREAM(name)                                                                             \
                                                                                                                 \
         name##_ifstream::name##_ifstream(const wstring_view& name, ios_base::openmode mode)                     \
+        {                                                                                                       \
+            open(name, mode);                                                                                   \
+        }                                                                                                       \
+                                                                                                                \
+        name##_ifstream::name##_ifstream(const wstring_view& name, name##_decompressor&& context, ios_base::openmode mode):  \
+            ctx(PYCPP_NAMESPACE::move(context))                                                               \
         {                                                                                                       \
             open(name, mode);                                                                                   \
         }                                                                                                       \
@@ -54,6 +60,12 @@ PYCPP_BEGIN_NAMESPACE
         }                                                                                                       \
                                                                                                                 \
         name##_ifstream::name##_ifstream(const u16string_view& name, ios_base::openmode mode)                   \
+        {                                                                                                       \
+            open(name, mode);                                                                                   \
+        }                                                                                                       \
+                                                                                                                \
+        name##_ifstream::name##_ifstream(const u16string_view& name, name##_decompressor&& context, ios_base::openmode mode):    \
+            ctx(PYCPP_NAMESPACE::move(context))                                                               \
         {                                                                                                       \
             open(name, mode);                                                                                   \
         }                                                                                                       \
@@ -76,6 +88,12 @@ PYCPP_BEGIN_NAMESPACE
             open(name, mode);                                                                                   \
         }                                                                                                       \
                                                                                                                 \
+        name##_ofstream::name##_ofstream(const wstring_view& name, name##_compressor&& context, ios_base::openmode mode):    \
+            ctx(PYCPP_NAMESPACE::move(context))                                                               \
+        {                                                                                                       \
+            open(name, mode);                                                                                   \
+        }                                                                                                       \
+                                                                                                                \
         void name##_ofstream::open(const wstring_view& name, ios_base::openmode mode)                           \
         {                                                                                                       \
             filter_ofstream::open(name, mode, COMPRESS_CALLBACK);                                               \
@@ -92,6 +110,12 @@ PYCPP_BEGIN_NAMESPACE
             open(name, mode);                                                                                   \
         }                                                                                                       \
                                                                                                                 \
+        name##_ofstream::name##_ofstream(const u16string_view& name, name##_compressor&& context, ios_base::openmode mode):  \
+            ctx(PYCPP_NAMESPACE::move(context))                                                               \
+        {                                                                                                       \
+            open(name, mode);                                                                                   \
+        }                                                                                                       \
+                                                                                                                \
         void name##_ofstream::open(const u16string_view& name, ios_base::openmode mode)                         \
         {                                                                                                       \
             filter_ofstream::open(name, mode, COMPRESS_CALLBACK);                                               \
@@ -109,7 +133,17 @@ PYCPP_BEGIN_NAMESPACE
  *  \brief Macro to define methods for a filtering istream base.
  */
 #define COMPRESSED_ISTREAM(name)                                        \
+    name##_istream::name##_istream(name##_decompressor&& context):      \
+        ctx(PYCPP_NAMESPACE::move(context))                           \
+    {}                                                                  \
+                                                                        \
     name##_istream::name##_istream(istream& stream)                     \
+    {                                                                   \
+        open(stream);                                                   \
+    }                                                                   \
+                                                                        \
+    name##_istream::name##_istream(istream& stream, name##_decompressor&& context):    \
+        ctx(PYCPP_NAMESPACE::move(context))                           \
     {                                                                   \
         open(stream);                                                   \
     }                                                                   \
@@ -152,6 +186,10 @@ PYCPP_BEGIN_NAMESPACE
         ctx(level)                                                      \
     {}                                                                  \
                                                                         \
+    name##_ostream::name##_ostream(name##_compressor&& context):        \
+        ctx(PYCPP_NAMESPACE::move(context))                           \
+    {}                                                                  \
+                                                                        \
     name##_ostream::name##_ostream(ostream& stream)                     \
     {                                                                   \
         open(stream);                                                   \
@@ -163,6 +201,12 @@ PYCPP_BEGIN_NAMESPACE
         open(stream);                                                   \
     }                                                                   \
                                                                         \
+    name##_ostream::name##_ostream(ostream& stream, name##_compressor&& context):      \
+        ctx(PYCPP_NAMESPACE::move(context))                           \
+    {                                                                   \
+        open(stream);                                                   \
+    }                                                                   \
+                                                                        \
     name##_ostream::~name##_ostream()                                   \
     {                                                                   \
         filter_ostream::close();                                        \
@@ -196,6 +240,10 @@ PYCPP_BEGIN_NAMESPACE
  *  \brief Macro to define methods for a filtering ifstream base.
  */
 #define COMPRESSED_IFSTREAM(name)                                                           \
+    name##_ifstream::name##_ifstream(name##_decompressor&& context):                        \
+        ctx(PYCPP_NAMESPACE::move(context))                                               \
+    {}                                                                                      \
+                                                                                            \
     name##_ifstream::name##_ifstream(name##_ifstream&& rhs)                                 \
     {                                                                                       \
         swap(rhs);                                                                          \
@@ -215,6 +263,12 @@ PYCPP_BEGIN_NAMESPACE
     }                                                                                       \
                                                                                             \
     name##_ifstream::name##_ifstream(const string_view& name, ios_base::openmode mode)      \
+    {                                                                                       \
+        open(name, mode);                                                                   \
+    }                                                                                       \
+                                                                                            \
+    name##_ifstream::name##_ifstream(const string_view& name, name##_decompressor&& context, ios_base::openmode mode):  \
+        ctx(PYCPP_NAMESPACE::move(context))                                               \
     {                                                                                       \
         open(name, mode);                                                                   \
     }                                                                                       \
@@ -241,6 +295,10 @@ PYCPP_BEGIN_NAMESPACE
         ctx(level)                                                                                  \
     {}                                                                                              \
                                                                                                     \
+    name##_ofstream::name##_ofstream(name##_compressor&& context):                                  \
+        ctx(PYCPP_NAMESPACE::move(context))                                                       \
+    {}                                                                                              \
+                                                                                                    \
     name##_ofstream::name##_ofstream(name##_ofstream&& rhs)                                         \
     {                                                                                               \
         swap(rhs);                                                                                  \
@@ -270,6 +328,12 @@ PYCPP_BEGIN_NAMESPACE
         open(name, mode);                                                                           \
     }                                                                                               \
                                                                                                     \
+    name##_ofstream::name##_ofstream(const string_view& name, name##_compressor&& context, ios_base::openmode mode):    \
+        ctx(PYCPP_NAMESPACE::move(context))                                                       \
+    {                                                                                               \
+        open(name, mode);                                                                           \
+    }                                                                                               \
+                                                                                                    \
     void name##_ofstream::open(const string_view& name, ios_base::openmode mode)                    \
     {                                                                                               \
         filter_ofstream::open(name, mode, COMPRESS_CALLBACK);                                       \
@@ -3,6 +3,9 @@
 /**
  *  \addtogroup PyCPP
  *  \brief Decompressing stream definitions.
+ *
+ *  Each stream may be constructed from a pre-configured context,
+ *  for example, a multi-threaded `lzma_compressor`.
  */
 
 #pragma once
@@ -27,16 +30,20 @@ PYCPP_BEGIN_NAMESPACE
 
 #   define WIDE_PATH_IFSTREAM(name)                                                                                     \
         name##_ifstream(const wstring_view& name, ios_base::openmode = ios_base::in | ios_base::binary);                \
+        name##_ifstream(const wstring_view& name, name##_decompressor&& context, ios_base::openmode = ios_base::in | ios_base::binary);      \
         void open(const wstring_view& name, ios_base::openmode = ios_base::in | ios_base::binary);                      \
         name##_ifstream(const u16string_view& name, ios_base::openmode = ios_base::in | ios_base::binary);              \
+        name##_ifstream(const u16string_view& name, name##_decompressor&& context, ios_base::openmode = ios_base::in | ios_base::binary);    \
         void open(const u16string_view& name, ios_base::openmode = ios_base::in | ios_base::binary);
 
 #   define WIDE_PATH_OFSTREAM(name)                                                                                     \
         name##_ofstream(const wstring_view& name, ios_base::openmode = ios_base::out | ios_base::binary);               \
         name##_ofstream(const wstring_view& name, int level, ios_base::openmode = ios_base::out | ios_base::binary);    \
+        name##_ofstream(const wstring_view& name, name##_compressor&& context, ios_base::openmode = ios_base::out | ios_base::binary);       \
         void open(const wstring_view& name, ios_base::openmode = ios_base::out | ios_base::binary);                     \
         name##_ofstream(const u16string_view& name, ios_base::openmode = ios_base::out | ios_base::binary);             \
         name##_ofstream(const u16string_view& name, int level, ios_base::openmode = ios_base::out | ios_base::binary);  \
+        name##_ofstream(const u16string_view& name, name##_compressor&& context, ios_base::openmode = ios_base::out | ios_base::binary);     \
         void open(const u16string_view& name, ios_base::openmode = ios_base::out | ios_base::binary);
 
 #else                                       // POSIX
@@ -55,11 +62,13 @@ PYCPP_BEGIN_NAMESPACE
     {                                                                   \
     public:                                                             \
         name##_istream() = default;                                     \
+        name##_istream(name##_decompressor&& context);                  \
         name##_istream(const name##_istream&) = delete;                 \
         name##_istream & operator=(const name##_istream&) = delete;     \
         ~name##_istream();                                              \
                                                                         \
         name##_istream(istream& stream);                                \
+        name##_istream(istream& stream, name##_decompressor&& context); \
         void open(istream& stream);                                     \
                                                                         \
     protected:                                                          \
@@ -81,12 +90,14 @@ PYCPP_BEGIN_NAMESPACE
     public:                                                             \
         name##_ostream() = default;                                     \
         name##_ostream(int level);                                      \
+        name##_ostream(name##_compressor&& context);                    \
         name##_ostream(const name##_ostream&) = delete;                 \
         name##_ostream & operator=(const name##_ostream&) = delete;     \
         ~name##_ostream();                                              \
                                                                         \
         name##_ostream(ostream& stream);                                \
         name##_ostream(ostream& stream, int level);                     \
+        name##_ostream(ostream& stream, name##_compressor&& context);    \
         void open(ostream& stream);                                     \
                                                                         \
     protected:                                                          \
@@ -107,6 +118,7 @@ PYCPP_BEGIN_NAMESPACE
     {                                                                                                           \
     public:                                                                                                     \
         name##_ifstream() = default;                                                                            \
+        name##_ifstream(name##_decompressor&& context);                                                         \
         name##_ifstream(const name##_ifstream&) = delete;                                                       \
         name##_ifstream & operator=(const name##_ifstream&) = delete;                                           \
         name##_ifstream(name##_ifstream&&);                                                                     \
@@ -114,6 +126,7 @@ PYCPP_BEGIN_NAMESPACE
         ~name##_ifstream();                                                                                     \
                                                                                                                 \
         name##_ifstream(const string_view& name, ios_base::openmode = ios_base::in | ios_base::binary);         \
+        name##_ifstream(const string_view& name, name##_decompressor&& context, ios_base::openmode = ios_base::in | ios_base::binary);   \
         void open(const string_view& name, ios_base::openmode = ios_base::in | ios_base::binary);               \
         WIDE_PATH_IFSTREAM(name)                                                                                \
         void swap(name##_ifstream&);                                                                            \
@@ -132,6 +145,7 @@ PYCPP_BEGIN_NAMESPACE
     public:                                                                                                             \
         name##_ofstream() = default;                                                                                    \
         name##_ofstream(int level);                                                                                     \
+        name##_ofstream(name##_compressor&& context);                                                                   \
         name##_ofstream(const name##_ofstream&) = delete;                                                               \
         name##_ofstream & operator=(const name##_ofstream&) = delete;                                                   \
         name##_ofstream(name##_ofstream&&);                                                                             \
@@ -140,6 +154,7 @@ PYCPP_BEGIN_NAMESPACE
                                                                                                                         \
         name##_ofstream(const string_view& name, ios_base::openmode = ios_base::out | ios_base::binary);                \
         name##_ofstream(const string_view& name, int level, ios_base::openmode = ios_base::out | ios_base::binary);     \
+        name##_ofstream(const string_view& name, name##_compressor&& context, ios_base::openmode = ios_base::out | ios_base::binary);    \
         void open(const string_view& name, ios_base::openmode = ios_base::out | ios_base::binary);                      \
         WIDE_PATH_OFSTREAM(name)                                                                                        \
         void swap(name##_ofstream&);                                                                                    \
@@ -4,6 +4,7 @@
 #if defined(HAVE_ZLIB)
 
 #include <pycpp/compression/core.h>
+#include <pycpp/compression/pool.h>
 #include <pycpp/compression/zlib.h>
 #include <zlib.h>
 
@@ -51,22 +52,39 @@ void check_zstatus(int error)
 struct zlib_compressor_impl: filter_impl<z_stream>
 {
     using base = filter_impl<z_stream>;
-    zlib_compressor_impl(int level = Z_DEFAULT_COMPRESSION);
+    zlib_compressor_impl(int level = Z_DEFAULT_COMPRESSION, const string_wrapper& dictionary = string_wrapper());
     ~zlib_compressor_impl() noexcept;
 
     virtual void call();
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     compression_status operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen);
+
+    string dictionary;
+
+private:
+    void set_dictionary();
 };
 
 
-zlib_compressor_impl::zlib_compressor_impl(int level)
+zlib_compressor_impl::zlib_compressor_impl(int level, const string_wrapper& dictionary):
+    dictionary(dictionary)
 {
     status = Z_OK;
     stream.zalloc = Z_NULL;
     stream.zfree = Z_NULL;
     stream.opaque = Z_NULL;
     PYCPP_CHECK(deflateInit(&stream, level));
+    set_dictionary();
+}
+
+
+void zlib_compressor_impl::set_dictionary()
+{
+    if (!dictionary.empty()) {
+        const Bytef* data = (const Bytef*) dictionary.data();
+        check_zstatus(deflateSetDictionary(&stream, data, static_cast<uInt>(dictionary.size())));
+    }
 }
 
 
@@ -100,6 +118,15 @@ bool zlib_compressor_impl::flush(void*& dst, size_t dstlen)
 }
 
 
+void zlib_compressor_impl::reset()
+{
+    check_zstatus(deflateReset(&stream));
+    status = Z_OK;
+    clear();
+    set_dictionary();
+}
+
+
 compression_status zlib_compressor_impl::operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
     return base::operator()(src, srclen, dst, dstlen, Z_STREAM_END);
@@ -112,16 +139,20 @@ compression_status zlib_compressor_impl::operator()(const void*& src, size_t src
 struct zlib_decompressor_impl: filter_impl<z_stream>
 {
     using base = filter_impl<z_stream>;
-    zlib_decompressor_impl();
+    zlib_decompressor_impl(const string_wrapper& dictionary = string_wrapper());
     ~zlib_decompressor_impl() noexcept;
 
     virtual void call();
     bool flush(void*& dst, size_t dstlen);
+    void reset();
     compression_status operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen);
+
+    string dictionary;
 };
 
 
-zlib_decompressor_impl::zlib_decompressor_impl()
+zlib_decompressor_impl::zlib_decompressor_impl(const string_wrapper& dictionary):
+    dictionary(dictionary)
 {
     status = Z_OK;
     stream.zalloc = Z_NULL;
@@ -141,12 +172,19 @@ void zlib_decompressor_impl::call()
 {
     while (stream.avail_in && stream.avail_out && status != Z_STREAM_END) {
         status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_NEED_DICT) {
+            // stream was compressed with a preset dictionary
+            if (dictionary.empty()) {
+                throw compression_error(compression_data_error);
+            }
+            const Bytef* data = (const Bytef*) dictionary.data();
+            status = inflateSetDictionary(&stream, data, static_cast<uInt>(dictionary.size()));
+        }
         check_zstatus(status);
     }
 }
 
 
-
 bool zlib_decompressor_impl::flush(void*& dst, size_t dstlen)
 {
     // null-op, always flushed
@@ -154,6 +192,14 @@ bool zlib_decompressor_impl::flush(void*& dst, size_t dstlen)
 }
 
 
+void zlib_decompressor_impl::reset()
+{
+    check_zstatus(inflateReset(&stream));
+    status = Z_OK;
+    clear();
+}
+
+
 compression_status zlib_decompressor_impl::operator()(const void*& src, size_t srclen, void*& dst, size_t dstlen)
 {
     return base::operator()(src, srclen, dst, dstlen, Z_STREAM_END);
@@ -165,6 +211,11 @@ zlib_compressor::zlib_compressor(int level):
 {}
 
 
+zlib_compressor::zlib_compressor(const string_wrapper& dictionary, int level):
+    ptr_(make_unique<zlib_compressor_impl>(level, dictionary))
+{}
+
+
 zlib_compressor::zlib_compressor(zlib_compressor&& rhs) noexcept:
     ptr_(move(rhs.ptr_))
 {}
@@ -193,6 +244,12 @@ bool zlib_compressor::flush(void*& dst, size_t dstlen)
 }
 
 
+void zlib_compressor::reset()
+{
+    ptr_->reset();
+}
+
+
 void zlib_compressor::close() noexcept
 {
     ptr_.reset();
@@ -211,6 +268,11 @@ zlib_decompressor::zlib_decompressor():
 {}
 
 
+zlib_decompressor::zlib_decompressor(const string_wrapper& dictionary):
+    ptr_(make_unique<zlib_decompressor_impl>(dictionary))
+{}
+
+
 zlib_decompressor::zlib_decompressor(zlib_decompressor&& rhs) noexcept:
     ptr_(move(rhs.ptr_))
 {}
@@ -239,6 +301,12 @@ bool zlib_decompressor::flush(void*& dst, size_t dstlen)
 }
 
 
+void zlib_decompressor::reset()
+{
+    ptr_->reset();
+}
+
+
 void zlib_decompressor::close() noexcept
 {
     ptr_.reset();
@@ -257,19 +325,9 @@ void zlib_decompressor::swap(zlib_decompressor& rhs) noexcept
 
 void zlib_compress(const void*& src, size_t srclen, void* &dst, size_t dstlen)
 {
-    uLong srclen_ = static_cast<uLong>(srclen);
-    uLong dstlen_ = static_cast<uLong>(dstlen);
-    if (srclen) {
-        PYCPP_CHECK(compress((Bytef*) dst, &dstlen_, (Bytef*) src, srclen_));
-    } else {
-        // compression no bytes
-        Bytef c = 0;
-        PYCPP_CHECK(compress((Bytef*) dst, &dstlen_, &c, 0));
-    }
-
-    // update pointers
-    src = ((char*) src) + srclen_;
-    dst = ((char*) dst) + dstlen_;
+    static context_pool<zlib_compressor> pool;
+    auto ctx = pool.acquire();
+    ctx_compress(*ctx, src, srclen, dst, dstlen);
 }
 
 
@@ -277,19 +335,72 @@ string zlib_compress(const string_wrapper& str)
 {
     size_t dstlen = zlib_compress_bound(str.size());
     return compress_bound(str, dstlen, [](const void*& src, size_t srclen, void* &dst, size_t dstlen) {
-        return zlib_compress(src, srclen, dst, dstlen);
+        zlib_compress(src, srclen, dst, dstlen);
+    });
+}
+
+
+/**
+ *  \brief Per-thread context, primed with the last dictionary used.
+ *
+ *  Messages sharing a dictionary reset and re-prime the context,
+ *  rather than initializing a new one for each message.
+ */
+template <typename Ctx>
+struct dictionary_context
+{
+    string dictionary;
+    Ctx ctx;
+    bool primed = false;
+
+    Ctx& acquire(const string_wrapper& dict)
+    {
+        if (primed && string_wrapper(dictionary) == dict) {
+            // a previous call may have thrown midway through a stream
+            ctx.reset();
+        } else {
+            Ctx fresh(dict);
+            string copy(dict.data(), dict.size());
+            ctx.swap(fresh);
+            dictionary.swap(copy);
+            primed = true;
+        }
+        return ctx;
+    }
+};
+
+
+string zlib_compress(const string_wrapper& str, const string_wrapper& dictionary)
+{
+    static thread_local dictionary_context<zlib_compressor> CONTEXT;
+
+    // the preset dictionary adds a 4-byte identifier to the header
+    size_t dstlen = zlib_compress_bound(str.size()) + 4;
+    return compress_bound(str, dstlen, [&dictionary](const void*& src, size_t srclen, void* &dst, size_t dstlen) {
+        ctx_compress(CONTEXT.acquire(dictionary), src, srclen, dst, dstlen);
     });
 }
 
 
 string zlib_decompress(const string_wrapper& str)
 {
-    return ctx_decompress<zlib_decompressor>(str);
+    static context_pool<zlib_decompressor> pool;
+    auto ctx = pool.acquire();
+    return ctx_decompress(str, *ctx);
+}
+
+
+string zlib_decompress(const string_wrapper& str, const string_wrapper& dictionary)
+{
+    static thread_local dictionary_context<zlib_decompressor> CONTEXT;
+    return ctx_decompress(str, CONTEXT.acquire(dictionary));
 }
 
 
 void zlib_decompress(const void*& src, size_t srclen, void* &dst, size_t dstlen, size_t bound)
 {
+    // `uncompress` rejects a truncated stream, which a pooled
+    // decompressor would silently accept, and its state is small
     uLong srclen_ = static_cast<uLong>(srclen);
     uLong dstlen_ = static_cast<uLong>(dstlen);
     if (srclen) {
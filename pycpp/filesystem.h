@@ -22,12 +22,14 @@
 #pragma once
 
 #include <pycpp/filesystem/access.h>
+#include <pycpp/filesystem/batch.h>
 #include <pycpp/filesystem/fd.h>
 #include <pycpp/filesystem/home.h>
 #include <pycpp/filesystem/iterator.h>
 #include <pycpp/filesystem/path.h>
 #include <pycpp/filesystem/stat.h>
 #include <pycpp/filesystem/tmp.h>
+#include <pycpp/filesystem/walk.h>
 #include <pycpp/iterator/range.h>
 #include <pycpp/stl/initializer_list.h>
 #include <pycpp/stl/ios.h>
@@ -431,6 +433,18 @@ int fd_allocate(fd_t fd, streamsize size);
  */
 int fd_truncate(fd_t fd, streamsize size);
 
+/**
+ *  \brief Flush file data to the device, as if by `fdatasync()`.
+ */
+int fd_sync(fd_t fd);
+
+/**
+ *  \brief Enable or disable direct I/O, bypassing the page cache.
+ *
+ *  Returns 0 on success, and -1 if direct I/O is not supported.
+ */
+int fd_direct(fd_t fd, bool enabled);
+
 /**
  *  \brief Change file permissions, as if by `fchmod()`.
  */
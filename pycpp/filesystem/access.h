@@ -16,12 +16,18 @@ PYCPP_BEGIN_NAMESPACE
 
 /**
  *  \brief File I/O access patterns.
+ *
+ *  `access_direct` is sequential access bypassing the page cache,
+ *  as if by `O_DIRECT`, which requires aligned buffers, offsets and
+ *  lengths. It falls back to `access_sequential` if the filesystem
+ *  does not support direct I/O.
  */
 enum io_access_pattern
 {
     access_normal = 0,
     access_sequential,
     access_random,
+    access_direct,
 };
 
 PYCPP_END_NAMESPACE
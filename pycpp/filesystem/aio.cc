@@ -0,0 +1,769 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/filesystem/aio.h>
+#include <pycpp/filesystem/exception.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/condition_variable.h>
+#include <pycpp/stl/deque.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/thread.h>
+#include <pycpp/stl/vector.h>
+#include <errno.h>
+#if defined(OS_WINDOWS)
+#   include <pycpp/windows/error.h>
+#else
+#   include <unistd.h>
+#endif
+#if defined(HAVE_LINUX_IO_URING_H)
+#   include <linux/io_uring.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#   include <sys/uio.h>
+#endif
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t AIO_MAX_THREADS = 4;
+
+// OBJECTS
+// -------
+
+enum aio_opcode
+{
+    aio_read = 0,
+    aio_write,
+    aio_read_fixed,
+    aio_write_fixed,
+};
+
+
+struct aio_request
+{
+    aio_opcode opcode;
+    fd_t fd;
+    void* buf;
+    size_t count;
+    streamoff offset;
+    size_t index;
+    aio_callback callback;
+};
+
+
+struct aio_engine_impl
+{
+    vector<aio_buffer> buffers;
+
+    virtual ~aio_engine_impl() = default;
+    virtual void queue(aio_request&& request) = 0;
+    virtual bool register_buffers(const aio_buffer* buffers, size_t count) = 0;
+    virtual void unregister_buffers() = 0;
+    virtual void submit() = 0;
+    virtual void wait() = 0;
+    virtual size_t pending() const = 0;
+    virtual aio_backend backend() const noexcept = 0;
+};
+
+// HELPERS
+// -------
+
+
+/**
+ *  \brief Invoke a completion callback, which must not propagate exceptions.
+ */
+static void complete(aio_callback& callback, streamsize result) noexcept
+{
+    if (callback) {
+        try {
+            callback(result);
+        } catch (...) {
+        }
+    }
+}
+
+
+/**
+ *  \brief Positional read or write, returning the bytes transferred or `-errno`.
+ */
+static streamsize positional_io(const aio_request& request)
+{
+    bool is_read = request.opcode == aio_read || request.opcode == aio_read_fixed;
+
+#if defined(OS_WINDOWS)
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(request.offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(request.offset) >> 32);
+    DWORD bytes;
+    BOOL status;
+    DWORD count = static_cast<DWORD>(min<size_t>(request.count, MAXDWORD));
+    if (is_read) {
+        status = ReadFile(request.fd, request.buf, count, &bytes, &overlapped);
+    } else {
+        status = WriteFile(request.fd, request.buf, count, &bytes, &overlapped);
+    }
+    if (!status) {
+        if (GetLastError() == ERROR_HANDLE_EOF) {
+            return 0;
+        }
+        set_errno_win32();
+        return -errno;
+    }
+    return bytes;
+#else
+    ssize_t bytes;
+    do {
+        if (is_read) {
+            bytes = ::pread(request.fd, request.buf, request.count, request.offset);
+        } else {
+            bytes = ::pwrite(request.fd, request.buf, request.count, request.offset);
+        }
+    } while (bytes == -1 && errno == EINTR);
+
+    return bytes == -1 ? -errno : bytes;
+#endif
+}
+
+
+template <typename Engine>
+static future<streamsize> queue_future(Engine& engine, aio_request&& request)
+{
+    auto value = make_shared<promise<streamsize>>();
+    future<streamsize> result = value->get_future();
+    request.callback = [value](streamsize bytes) {
+        value->set_value(bytes);
+    };
+    engine.queue(PYCPP_NAMESPACE::move(request));
+
+    return result;
+}
+
+// THREADS
+
+
+/**
+ *  \brief Portable backend, using positional I/O from worker threads.
+ */
+struct aio_threads: aio_engine_impl
+{
+    mutable mutex mutex_;
+    condition_variable work_;
+    condition_variable done_;
+    vector<aio_request> staged_;
+    deque<aio_request> queue_;
+    vector<thread> workers_;
+    size_t inflight_ = 0;
+    bool stop_ = false;
+
+    aio_threads(size_t depth)
+    {
+        size_t count = max<size_t>(1, min(depth, AIO_MAX_THREADS));
+        staged_.reserve(depth);
+        for (size_t i = 0; i < count; ++i) {
+            workers_.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~aio_threads()
+    {
+        wait();
+        {
+            lock_guard<mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_.notify_all();
+        for (thread& worker: workers_) {
+            worker.join();
+        }
+    }
+
+    void run()
+    {
+        for (;;) {
+            unique_lock<mutex> lock(mutex_);
+            work_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            aio_request request = PYCPP_NAMESPACE::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+
+            complete(request.callback, positional_io(request));
+
+            lock.lock();
+            --inflight_;
+            done_.notify_all();
+        }
+    }
+
+    virtual void queue(aio_request&& request) override
+    {
+        lock_guard<mutex> lock(mutex_);
+        staged_.emplace_back(PYCPP_NAMESPACE::move(request));
+    }
+
+    virtual bool register_buffers(const aio_buffer*, size_t) override
+    {
+        // no kernel mapping, buffers are only resolved by index
+        return true;
+    }
+
+    virtual void unregister_buffers() override
+    {}
+
+    virtual void submit() override
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (staged_.empty()) {
+                return;
+            }
+            inflight_ += staged_.size();
+            for (aio_request& request: staged_) {
+                queue_.emplace_back(PYCPP_NAMESPACE::move(request));
+            }
+            staged_.clear();
+        }
+        work_.notify_all();
+    }
+
+    virtual void wait() override
+    {
+        submit();
+        unique_lock<mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return inflight_ == 0; });
+    }
+
+    virtual size_t pending() const override
+    {
+        lock_guard<mutex> lock(mutex_);
+        return staged_.size() + inflight_;
+    }
+
+    virtual aio_backend backend() const noexcept override
+    {
+        return aio_backend_threads;
+    }
+};
+
+// URING
+
+#if defined(HAVE_LINUX_IO_URING_H)
+
+static int io_uring_setup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+
+static int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+
+static int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+
+/**
+ *  \brief Linux backend, using io_uring through the raw system calls.
+ *
+ *  Each SQE carries a heap-allocated callback as its user data, and
+ *  a reaper thread invokes callbacks as completions arrive. A NOP
+ *  with null user data stops the reaper. If waiting for completions
+ *  fails, the reaper completes every outstanding request with the
+ *  error before exiting, and later requests run synchronously.
+ */
+struct aio_uring: aio_engine_impl
+{
+    struct uring_request
+    {
+        aio_callback callback;
+        uring_request* prev;
+        uring_request* next;
+    };
+
+    int fd_ = -1;
+    void* sq_ring_ = MAP_FAILED;
+    void* cq_ring_ = MAP_FAILED;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = (io_uring_sqe*) MAP_FAILED;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_array_;
+    unsigned sq_mask_;
+    unsigned sq_entries_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    io_uring_cqe* cqes_;
+    unsigned cq_mask_;
+    unsigned cq_entries_;
+
+    mutable mutex mutex_;
+    condition_variable done_;
+    size_t queued_ = 0;
+    size_t inflight_ = 0;
+    uring_request* requests_ = nullptr;
+    int error_ = 0;
+    bool registered_ = false;
+    thread reaper_;
+
+    aio_uring() = default;
+
+    ~aio_uring()
+    {
+        if (reaper_.joinable()) {
+            wait();
+            {
+                lock_guard<mutex> lock(mutex_);
+                if (!error_) {
+                    push_locked(IORING_OP_NOP, -1, nullptr, 0, 0, 0, 0);
+                    flush_locked();
+                }
+            }
+            reaper_.join();
+        }
+        if (sqes_ != MAP_FAILED) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED) {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        if (fd_ != -1) {
+            ::close(fd_);
+        }
+    }
+
+    /**
+     *  \brief Create the ring, returning false if io_uring is unusable.
+     */
+    bool open(size_t depth)
+    {
+        io_uring_params params = {};
+        fd_ = io_uring_setup(static_cast<unsigned>(max<size_t>(depth, 1)), &params);
+        if (fd_ < 0) {
+            fd_ = -1;
+            return false;
+        }
+        // IORING_OP_READ and IORING_OP_WRITE were added alongside this feature
+        if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            sq_ring_size_ = cq_ring_size_ = max(sq_ring_size_, cq_ring_size_);
+        }
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        if (single) {
+            cq_ring_ = sq_ring_;
+        } else {
+            cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED) {
+                return false;
+            }
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = (io_uring_sqe*) ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = (char*) sq_ring_;
+        sq_head_ = (unsigned*) (sq + params.sq_off.head);
+        sq_tail_ = (unsigned*) (sq + params.sq_off.tail);
+        sq_array_ = (unsigned*) (sq + params.sq_off.array);
+        sq_mask_ = *(unsigned*) (sq + params.sq_off.ring_mask);
+        sq_entries_ = *(unsigned*) (sq + params.sq_off.ring_entries);
+
+        char* cq = (char*) cq_ring_;
+        cq_head_ = (unsigned*) (cq + params.cq_off.head);
+        cq_tail_ = (unsigned*) (cq + params.cq_off.tail);
+        cqes_ = (io_uring_cqe*) (cq + params.cq_off.cqes);
+        cq_mask_ = *(unsigned*) (cq + params.cq_off.ring_mask);
+        cq_entries_ = *(unsigned*) (cq + params.cq_off.ring_entries);
+
+        reaper_ = thread([this]() { run(); });
+        return true;
+    }
+
+    void run()
+    {
+        for (;;) {
+            unsigned head = *cq_head_;
+            unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                if (io_uring_enter(fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+                    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                        fail(-errno);
+                        return;
+                    }
+                }
+                continue;
+            }
+
+            bool stop = false;
+            for (unsigned i = head; i != tail; ++i) {
+                uring_request* request = (uring_request*) (uintptr_t) cqes_[i & cq_mask_].user_data;
+                if (request) {
+                    complete(request->callback, cqes_[i & cq_mask_].res);
+                } else {
+                    stop = true;
+                }
+            }
+
+            {
+                lock_guard<mutex> lock(mutex_);
+                for (; head != tail; ++head) {
+                    uring_request* request = (uring_request*) (uintptr_t) cqes_[head & cq_mask_].user_data;
+                    if (request) {
+                        unlink_locked(request);
+                        delete request;
+                        --inflight_;
+                    }
+                }
+                done_.notify_all();
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+            if (stop) {
+                return;
+            }
+        }
+    }
+
+    /**
+     *  \brief Complete every outstanding request with an error.
+     */
+    void fail(int error)
+    {
+        uring_request* requests;
+        {
+            lock_guard<mutex> lock(mutex_);
+            error_ = error;
+            requests = requests_;
+            requests_ = nullptr;
+        }
+
+        size_t done = 0;
+        while (requests) {
+            uring_request* next = requests->next;
+            complete(requests->callback, error);
+            delete requests;
+            requests = next;
+            ++done;
+        }
+
+        lock_guard<mutex> lock(mutex_);
+        inflight_ -= done;
+        done_.notify_all();
+    }
+
+    void unlink_locked(uring_request* request) noexcept
+    {
+        if (request->prev) {
+            request->prev->next = request->next;
+        } else {
+            requests_ = request->next;
+        }
+        if (request->next) {
+            request->next->prev = request->prev;
+        }
+    }
+
+    /**
+     *  \brief Send all queued SQEs to the kernel.
+     */
+    void flush_locked()
+    {
+        while (queued_) {
+            int submitted = io_uring_enter(fd_, static_cast<unsigned>(queued_), 0, 0);
+            if (submitted < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    continue;
+                }
+                throw filesystem_error(filesystem_unexpected_error);
+            }
+            queued_ -= submitted;
+        }
+    }
+
+    void push_locked(uint8_t opcode, int fd, void* buf, size_t count, streamoff offset, size_t index, uint64_t user_data)
+    {
+        unsigned tail = *sq_tail_;
+        if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == sq_entries_) {
+            flush_locked();
+        }
+
+        unsigned slot = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[slot];
+        sqe = {};
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = (uint64_t) (uintptr_t) buf;
+        sqe.len = static_cast<unsigned>(min<size_t>(count, 0x7FFFF000));
+        sqe.off = static_cast<uint64_t>(offset);
+        sqe.buf_index = static_cast<uint16_t>(index);
+        sqe.user_data = user_data;
+        sq_array_[slot] = slot;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        ++queued_;
+    }
+
+    virtual void queue(aio_request&& request) override
+    {
+        uint8_t opcode;
+        switch (request.opcode) {
+            case aio_read:
+                opcode = IORING_OP_READ;
+                break;
+            case aio_write:
+                opcode = IORING_OP_WRITE;
+                break;
+            case aio_read_fixed:
+                opcode = IORING_OP_READ_FIXED;
+                break;
+            case aio_write_fixed:
+            default:
+                opcode = IORING_OP_WRITE_FIXED;
+                break;
+        }
+
+        unique_lock<mutex> lock(mutex_);
+        // bound outstanding requests by the completion queue, so no completion is dropped
+        while (!error_ && inflight_ >= cq_entries_) {
+            flush_locked();
+            done_.wait(lock);
+        }
+        if (error_) {
+            // the ring failed, complete the request synchronously
+            lock.unlock();
+            complete(request.callback, positional_io(request));
+            return;
+        }
+
+        auto* pending = new uring_request{PYCPP_NAMESPACE::move(request.callback), nullptr, requests_};
+        try {
+            push_locked(opcode, request.fd, request.buf, request.count, request.offset, request.index, (uint64_t) (uintptr_t) pending);
+        } catch (...) {
+            delete pending;
+            throw;
+        }
+        if (requests_) {
+            requests_->prev = pending;
+        }
+        requests_ = pending;
+        ++inflight_;
+    }
+
+    virtual bool register_buffers(const aio_buffer* buffers, size_t count) override
+    {
+        unregister_buffers();
+        vector<iovec> iov(count);
+        for (size_t i = 0; i < count; ++i) {
+            iov[i].iov_base = buffers[i].data;
+            iov[i].iov_len = buffers[i].size;
+        }
+        registered_ = io_uring_register(fd_, IORING_REGISTER_BUFFERS, iov.data(), static_cast<unsigned>(count)) == 0;
+        return registered_;
+    }
+
+    virtual void unregister_buffers() override
+    {
+        if (registered_) {
+            wait();
+            io_uring_register(fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+            registered_ = false;
+        }
+    }
+
+    virtual void submit() override
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!error_) {
+            flush_locked();
+        }
+    }
+
+    virtual void wait() override
+    {
+        unique_lock<mutex> lock(mutex_);
+        if (!error_) {
+            flush_locked();
+        }
+        done_.wait(lock, [this]() { return inflight_ == 0; });
+    }
+
+    virtual size_t pending() const override
+    {
+        lock_guard<mutex> lock(mutex_);
+        return inflight_;
+    }
+
+    virtual aio_backend backend() const noexcept override
+    {
+        return aio_backend_uring;
+    }
+};
+
+#endif                  // HAVE_LINUX_IO_URING_H
+
+
+static unique_ptr<aio_engine_impl> make_engine(size_t depth, aio_backend backend)
+{
+#if defined(HAVE_LINUX_IO_URING_H)
+    if (backend != aio_backend_threads) {
+        unique_ptr<aio_uring> uring(new aio_uring);
+        if (uring->open(depth)) {
+            return unique_ptr<aio_engine_impl>(uring.release());
+        }
+    }
+#endif                  // HAVE_LINUX_IO_URING_H
+
+    // io_uring is unavailable, or was not requested
+    return unique_ptr<aio_engine_impl>(new aio_threads(depth));
+}
+
+
+static void* fixed_buffer(const aio_engine_impl& impl, size_t index, size_t count)
+{
+    if (index >= impl.buffers.size() || count > impl.buffers[index].size) {
+        throw filesystem_error(filesystem_invalid_parameter);
+    }
+
+    return impl.buffers[index].data;
+}
+
+// ENGINE
+
+
+aio_engine::aio_engine(size_t depth, aio_backend backend):
+    ptr_(make_engine(depth, backend))
+{}
+
+
+aio_engine::~aio_engine()
+{}
+
+
+void aio_engine::read(fd_t fd, void* buf, size_t count, streamoff offset, aio_callback callback)
+{
+    ptr_->queue({aio_read, fd, buf, count, offset, 0, PYCPP_NAMESPACE::move(callback)});
+}
+
+
+future<streamsize> aio_engine::read(fd_t fd, void* buf, size_t count, streamoff offset)
+{
+    return queue_future(*ptr_, {aio_read, fd, buf, count, offset, 0, nullptr});
+}
+
+
+void aio_engine::write(fd_t fd, const void* buf, size_t count, streamoff offset, aio_callback callback)
+{
+    ptr_->queue({aio_write, fd, const_cast<void*>(buf), count, offset, 0, PYCPP_NAMESPACE::move(callback)});
+}
+
+
+future<streamsize> aio_engine::write(fd_t fd, const void* buf, size_t count, streamoff offset)
+{
+    return queue_future(*ptr_, {aio_write, fd, const_cast<void*>(buf), count, offset, 0, nullptr});
+}
+
+
+bool aio_engine::register_buffers(const aio_buffer* buffers, size_t count)
+{
+    if (!ptr_->register_buffers(buffers, count)) {
+        ptr_->buffers.clear();
+        return false;
+    }
+    ptr_->buffers.assign(buffers, buffers + count);
+    return true;
+}
+
+
+void aio_engine::unregister_buffers()
+{
+    ptr_->unregister_buffers();
+    ptr_->buffers.clear();
+}
+
+
+void aio_engine::read_fixed(fd_t fd, size_t index, size_t count, streamoff offset, aio_callback callback)
+{
+    void* buf = fixed_buffer(*ptr_, index, count);
+    ptr_->queue({aio_read_fixed, fd, buf, count, offset, index, PYCPP_NAMESPACE::move(callback)});
+}
+
+
+future<streamsize> aio_engine::read_fixed(fd_t fd, size_t index, size_t count, streamoff offset)
+{
+    void* buf = fixed_buffer(*ptr_, index, count);
+    return queue_future(*ptr_, {aio_read_fixed, fd, buf, count, offset, index, nullptr});
+}
+
+
+void aio_engine::write_fixed(fd_t fd, size_t index, size_t count, streamoff offset, aio_callback callback)
+{
+    void* buf = fixed_buffer(*ptr_, index, count);
+    ptr_->queue({aio_write_fixed, fd, buf, count, offset, index, PYCPP_NAMESPACE::move(callback)});
+}
+
+
+future<streamsize> aio_engine::write_fixed(fd_t fd, size_t index, size_t count, streamoff offset)
+{
+    void* buf = fixed_buffer(*ptr_, index, count);
+    return queue_future(*ptr_, {aio_write_fixed, fd, buf, count, offset, index, nullptr});
+}
+
+
+void aio_engine::submit()
+{
+    ptr_->submit();
+}
+
+
+void aio_engine::wait()
+{
+    ptr_->wait();
+}
+
+
+size_t aio_engine::pending() const
+{
+    return ptr_->pending();
+}
+
+
+aio_backend aio_engine::backend() const noexcept
+{
+    return ptr_->backend();
+}
+
+// FUNCTIONS
+// ---------
+
+
+aio_engine& default_aio_engine()
+{
+    static aio_engine engine;
+    return engine;
+}
+
+PYCPP_END_NAMESPACE
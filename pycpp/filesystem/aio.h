@@ -0,0 +1,174 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Asynchronous, positional file I/O.
+ *
+ *  Reads and writes are queued at explicit file offsets, and sent
+ *  to the kernel in a single batch by `submit()`. On Linux, the
+ *  engine uses io_uring, so a batch costs a single system call and
+ *  completions are reaped without blocking the submitting thread.
+ *  On other systems, or if io_uring is unavailable, a small pool
+ *  of threads performs positional reads and writes instead.
+ *
+ *  Completion callbacks run on an engine thread, and must not
+ *  throw or block on other requests from the same engine.
+ *
+ *  \synopsis
+ *      static constexpr size_t AIO_QUEUE_DEPTH = implementation-defined;
+ *
+ *      enum aio_backend
+ *      {
+ *          aio_backend_default = 0,
+ *          aio_backend_uring,
+ *          aio_backend_threads,
+ *      };
+ *
+ *      using aio_callback = function<void(streamsize)>;
+ *
+ *      struct aio_buffer
+ *      {
+ *          void* data;
+ *          size_t size;
+ *      };
+ *
+ *      class aio_engine
+ *      {
+ *      public:
+ *          aio_engine(size_t depth = AIO_QUEUE_DEPTH, aio_backend backend = aio_backend_default);
+ *          ~aio_engine();
+ *
+ *          // REQUESTS
+ *          void read(fd_t fd, void* buf, size_t count, streamoff offset, aio_callback callback);
+ *          future<streamsize> read(fd_t fd, void* buf, size_t count, streamoff offset);
+ *          void write(fd_t fd, const void* buf, size_t count, streamoff offset, aio_callback callback);
+ *          future<streamsize> write(fd_t fd, const void* buf, size_t count, streamoff offset);
+ *
+ *          // REGISTERED BUFFERS
+ *          bool register_buffers(const aio_buffer* buffers, size_t count);
+ *          void unregister_buffers();
+ *          void read_fixed(fd_t fd, size_t index, size_t count, streamoff offset, aio_callback callback);
+ *          future<streamsize> read_fixed(fd_t fd, size_t index, size_t count, streamoff offset);
+ *          void write_fixed(fd_t fd, size_t index, size_t count, streamoff offset, aio_callback callback);
+ *          future<streamsize> write_fixed(fd_t fd, size_t index, size_t count, streamoff offset);
+ *
+ *          // SUBMISSION
+ *          void submit();
+ *          void wait();
+ *
+ *          // PROPERTIES
+ *          size_t pending() const;
+ *          aio_backend backend() const noexcept;
+ *      };
+ *
+ *      aio_engine& default_aio_engine();
+ */
+
+#pragma once
+
+#include <pycpp/filesystem/fd.h>
+#include <pycpp/stl/functional.h>
+#include <pycpp/stl/future.h>
+#include <pycpp/stl/ios.h>
+#include <pycpp/stl/memory.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+static constexpr size_t AIO_QUEUE_DEPTH = 64;
+
+// FORWARD
+// -------
+
+struct aio_engine_impl;
+
+// ENUMS
+// -----
+
+/**
+ *  \brief Implementation used by the I/O engine.
+ *
+ *  `aio_backend_default` uses io_uring where it is supported,
+ *  otherwise a thread pool.
+ */
+enum aio_backend
+{
+    aio_backend_default = 0,
+    aio_backend_uring,
+    aio_backend_threads,
+};
+
+// ALIAS
+// -----
+
+/**
+ *  \brief Completion callback, with the bytes transferred or `-errno`.
+ */
+using aio_callback = function<void(streamsize)>;
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Buffer registered with the engine.
+ */
+struct aio_buffer
+{
+    void* data;
+    size_t size;
+};
+
+
+/**
+ *  \brief Asynchronous file I/O engine.
+ *
+ *  Requests are queued until `submit()` or `wait()`. The destructor
+ *  waits for all outstanding requests. Like `pread` and `pwrite`,
+ *  requests do not modify the file offset, and may transfer fewer
+ *  bytes than requested.
+ */
+class aio_engine
+{
+public:
+    aio_engine(size_t depth = AIO_QUEUE_DEPTH, aio_backend backend = aio_backend_default);
+    aio_engine(const aio_engine&) = delete;
+    aio_engine& operator=(const aio_engine&) = delete;
+    ~aio_engine();
+
+    // REQUESTS
+    void read(fd_t fd, void* buf, size_t count, streamoff offset, aio_callback callback);
+    future<streamsize> read(fd_t fd, void* buf, size_t count, streamoff offset);
+    void write(fd_t fd, const void* buf, size_t count, streamoff offset, aio_callback callback);
+    future<streamsize> write(fd_t fd, const void* buf, size_t count, streamoff offset);
+
+    // REGISTERED BUFFERS
+    bool register_buffers(const aio_buffer* buffers, size_t count);
+    void unregister_buffers();
+    void read_fixed(fd_t fd, size_t index, size_t count, streamoff offset, aio_callback callback);
+    future<streamsize> read_fixed(fd_t fd, size_t index, size_t count, streamoff offset);
+    void write_fixed(fd_t fd, size_t index, size_t count, streamoff offset, aio_callback callback);
+    future<streamsize> write_fixed(fd_t fd, size_t index, size_t count, streamoff offset);
+
+    // SUBMISSION
+    void submit();
+    void wait();
+
+    // PROPERTIES
+    size_t pending() const;
+    aio_backend backend() const noexcept;
+
+private:
+    unique_ptr<aio_engine_impl> ptr_;
+};
+
+// FUNCTIONS
+// ---------
+
+/**
+ *  \brief Get the process-wide engine, created on first use.
+ */
+aio_engine& default_aio_engine();
+
+PYCPP_END_NAMESPACE
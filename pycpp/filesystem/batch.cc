@@ -0,0 +1,281 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/batch.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/atomic.h>
+#include <pycpp/stl/thread.h>
+#include <errno.h>
+#include <string.h>
+#if !defined(OS_WINDOWS)
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#endif
+#if defined(OS_LINUX)
+#   include <sys/sysmacros.h>
+#endif
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+// paths claimed by a worker at a time, and the smallest batch per thread
+static constexpr size_t STAT_MANY_CHUNK = 64;
+static constexpr size_t STAT_MANY_MIN_BATCH = 256;
+static constexpr size_t STAT_MANY_MAX_THREADS = 8;
+
+// HELPERS
+// -------
+
+
+static filesystem_code error_code(int code)
+{
+    switch (code) {
+        case 0:
+            return filesystem_no_error;
+        case ENOENT:
+            return filesystem_file_not_found;
+        case ENOTDIR:
+            return filesystem_no_such_directory;
+        case EACCES:
+            return filesystem_permissions_error;
+        case EINVAL:
+        case EBADF:
+            return filesystem_invalid_parameter;
+        case ENOMEM:
+            return filesystem_out_of_memory;
+        default:
+            return filesystem_unexpected_error;
+    }
+}
+
+
+/**
+ *  \brief Call `function(i)` for each index, over a pool of threads.
+ */
+template <typename Function>
+static void parallel_for(size_t size, size_t threads, Function function)
+{
+    if (threads == 0) {
+        threads = min(max<size_t>(1, thread::hardware_concurrency()), STAT_MANY_MAX_THREADS);
+    }
+    threads = min(threads, (size + STAT_MANY_MIN_BATCH - 1) / STAT_MANY_MIN_BATCH);
+
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t first = next.fetch_add(STAT_MANY_CHUNK); first < size; first = next.fetch_add(STAT_MANY_CHUNK)) {
+            size_t last = min(size, first + STAT_MANY_CHUNK);
+            for (size_t i = first; i < last; ++i) {
+                function(i);
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (size_t i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (thread& t: pool) {
+        t.join();
+    }
+}
+
+
+#if defined(OS_WINDOWS)                     // WINDOWS
+
+template <typename Path>
+static void stat_one(const Path& path, stat_result& result, bool follow)
+{
+    try {
+        result.stat = follow ? stat(path) : lstat(path);
+        result.error = filesystem_no_error;
+    } catch (filesystem_error& error) {
+        result.error = error.code();
+    }
+}
+
+
+template <typename List>
+static vector<stat_result> stat_many_impl(const List& paths, const stat_many_options& options)
+{
+    vector<stat_result> results(paths.size());
+    parallel_for(paths.size(), options.threads, [&](size_t i) {
+        stat_one(paths[i], results[i], options.follow_symlinks);
+    });
+
+    return results;
+}
+
+#else                                       // POSIX
+
+static void copy_native(const struct stat& src, stat_t& dst)
+{
+    dst.st_dev = src.st_dev;
+    dst.st_ino = src.st_ino;
+    dst.st_mode = src.st_mode;
+    dst.st_nlink = src.st_nlink;
+    dst.st_uid = src.st_uid;
+    dst.st_gid = src.st_gid;
+    dst.st_rdev = src.st_rdev;
+    dst.st_size = src.st_size;
+
+    // match the precision of `stat`
+    dst.st_atim = {src.st_atime, 0};
+    dst.st_mtim = {src.st_mtime, 0};
+    dst.st_ctim = {src.st_ctime, 0};
+}
+
+
+static void stat_at(int dirfd, const char* name, stat_result& result, bool follow)
+{
+    struct stat sb;
+    if (::fstatat(dirfd, name, &sb, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+        result.error = error_code(errno);
+    } else {
+        copy_native(sb, result.stat);
+        result.error = filesystem_no_error;
+    }
+}
+
+
+#if defined(STATX_BASIC_STATS)              // STATX
+
+// cleared once the kernel reports statx as unsupported
+static atomic<bool> HAVE_STATX(true);
+
+
+static unsigned statx_mask(unsigned fields)
+{
+    unsigned mask = 0;
+    if (fields & stat_field_type) {
+        mask |= STATX_TYPE;
+    }
+    if (fields & stat_field_mode) {
+        mask |= STATX_TYPE | STATX_MODE;
+    }
+    if (fields & stat_field_nlink) {
+        mask |= STATX_NLINK;
+    }
+    if (fields & stat_field_owner) {
+        mask |= STATX_UID | STATX_GID;
+    }
+    if (fields & stat_field_ino) {
+        mask |= STATX_INO;
+    }
+    if (fields & stat_field_size) {
+        mask |= STATX_SIZE;
+    }
+    if (fields & stat_field_atime) {
+        mask |= STATX_ATIME;
+    }
+    if (fields & stat_field_mtime) {
+        mask |= STATX_MTIME;
+    }
+    if (fields & stat_field_ctime) {
+        mask |= STATX_CTIME;
+    }
+
+    return mask;
+}
+
+
+static void copy_statx(const struct statx& src, stat_t& dst)
+{
+    dst.st_dev = makedev(src.stx_dev_major, src.stx_dev_minor);
+    dst.st_ino = src.stx_ino;
+    dst.st_mode = src.stx_mode;
+    dst.st_nlink = src.stx_nlink;
+    dst.st_uid = src.stx_uid;
+    dst.st_gid = src.stx_gid;
+    dst.st_rdev = makedev(src.stx_rdev_major, src.stx_rdev_minor);
+    dst.st_size = src.stx_size;
+
+    // match the precision of `stat`
+    dst.st_atim = {static_cast<time_t>(src.stx_atime.tv_sec), 0};
+    dst.st_mtim = {static_cast<time_t>(src.stx_mtime.tv_sec), 0};
+    dst.st_ctim = {static_cast<time_t>(src.stx_ctime.tv_sec), 0};
+}
+
+
+static void statx_at(int dirfd, const char* name, stat_result& result, unsigned mask, bool follow)
+{
+    if (!HAVE_STATX) {
+        stat_at(dirfd, name, result, follow);
+        return;
+    }
+
+    struct statx sb;
+    memset(&sb, 0, sizeof(sb));
+    if (::statx(dirfd, name, follow ? 0 : AT_SYMLINK_NOFOLLOW, mask, &sb) != 0) {
+        if (errno == ENOSYS) {
+            HAVE_STATX = false;
+            stat_at(dirfd, name, result, follow);
+        } else {
+            result.error = error_code(errno);
+        }
+    } else {
+        copy_statx(sb, result.stat);
+        result.error = filesystem_no_error;
+    }
+}
+
+#endif                                      // STATX
+
+
+static vector<stat_result> stat_many_impl(int dirfd, const path_list_t& names, const stat_many_options& options)
+{
+    vector<stat_result> results(names.size());
+    bool follow = options.follow_symlinks;
+
+#if defined(STATX_BASIC_STATS)
+    unsigned mask = statx_mask(options.fields);
+    parallel_for(names.size(), options.threads, [&](size_t i) {
+        statx_at(dirfd, names[i].data(), results[i], mask, follow);
+    });
+#else
+    parallel_for(names.size(), options.threads, [&](size_t i) {
+        stat_at(dirfd, names[i].data(), results[i], follow);
+    });
+#endif
+
+    return results;
+}
+
+#endif                                      // WINDOWS
+
+// FUNCTIONS
+// ---------
+
+
+#if defined(OS_WINDOWS)                     // WINDOWS
+
+vector<stat_result> stat_many(const path_list_t& paths, const stat_many_options& options)
+{
+    return stat_many_impl(paths, options);
+}
+
+
+vector<stat_result> stat_many(const backup_path_list_t& paths, const stat_many_options& options)
+{
+    return stat_many_impl(paths, options);
+}
+
+#else                                       // POSIX
+
+vector<stat_result> stat_many(const path_list_t& paths, const stat_many_options& options)
+{
+    return stat_many_impl(AT_FDCWD, paths, options);
+}
+
+
+vector<stat_result> stat_many(fd_t dirfd, const path_list_t& names, const stat_many_options& options)
+{
+    return stat_many_impl(dirfd, names, options);
+}
+
+#endif                                      // WINDOWS
+
+PYCPP_END_NAMESPACE
@@ -0,0 +1,132 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Batched metadata queries.
+ *
+ *  Stat many paths with a single call, spreading the system calls
+ *  over a small pool of threads. On Linux, `statx` only requests
+ *  the fields selected by the field mask, which lets network and
+ *  FUSE filesystems skip work for unused fields. Names may also be
+ *  resolved relative to an open directory descriptor, avoiding a
+ *  path lookup from the root and the cost of building full paths.
+ *
+ *  Unlike `stat`, a missing or unreadable path does not throw: the
+ *  error is stored in the result, and the remaining paths are still
+ *  queried.
+ *
+ *  \synopsis
+ *      enum stat_field
+ *      {
+ *          stat_field_type  = 1,
+ *          stat_field_mode  = 2,
+ *          stat_field_nlink = 4,
+ *          stat_field_owner = 8,
+ *          stat_field_ino   = 16,
+ *          stat_field_size  = 32,
+ *          stat_field_atime = 64,
+ *          stat_field_mtime = 128,
+ *          stat_field_ctime = 256,
+ *          stat_field_all   = 511,
+ *      };
+ *
+ *      struct stat_result
+ *      {
+ *          stat_t stat;
+ *          filesystem_code error;
+ *      };
+ *
+ *      struct stat_many_options
+ *      {
+ *          unsigned fields = stat_field_all;
+ *          size_t threads = 0;
+ *          bool follow_symlinks = true;
+ *      };
+ *
+ *      vector<stat_result> stat_many(const path_list_t& paths, const stat_many_options& options = {});
+ *      vector<stat_result> stat_many(fd_t dirfd, const path_list_t& names, const stat_many_options& options = {});
+ */
+
+#pragma once
+
+#include <pycpp/filesystem/exception.h>
+#include <pycpp/filesystem/fd.h>
+#include <pycpp/filesystem/path.h>
+#include <pycpp/filesystem/stat.h>
+#include <pycpp/stl/vector.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// ENUMS
+// -----
+
+/**
+ *  \brief Fields requested from the filesystem.
+ *
+ *  Fields not requested may be left zero. `stat_field_owner` covers
+ *  the user and group, and `stat_field_ino` the device and inode.
+ */
+enum stat_field
+{
+    stat_field_type  = 1 << 0,
+    stat_field_mode  = 1 << 1,
+    stat_field_nlink = 1 << 2,
+    stat_field_owner = 1 << 3,
+    stat_field_ino   = 1 << 4,
+    stat_field_size  = 1 << 5,
+    stat_field_atime = 1 << 6,
+    stat_field_mtime = 1 << 7,
+    stat_field_ctime = 1 << 8,
+    stat_field_all   = (1 << 9) - 1,
+};
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Metadata for a single path, or the reason it is missing.
+ */
+struct stat_result
+{
+    stat_t stat;
+    filesystem_code error;
+};
+
+
+/**
+ *  \brief Options for the batched stat.
+ *
+ *  `threads` is the maximum number of threads, or 0 to pick one
+ *  from the hardware. Small batches are always queried inline.
+ */
+struct stat_many_options
+{
+    unsigned fields = stat_field_all;
+    size_t threads = 0;
+    bool follow_symlinks = true;
+};
+
+// FUNCTIONS
+// ---------
+
+/**
+ *  \brief Stat each path, as if by `stat` or `lstat`.
+ *
+ *  Results are returned in the same order as the paths.
+ */
+vector<stat_result> stat_many(const path_list_t& paths, const stat_many_options& options = stat_many_options());
+
+#if defined(OS_WINDOWS)                         // BACKUP PATH
+
+vector<stat_result> stat_many(const backup_path_list_t& paths, const stat_many_options& options = stat_many_options());
+
+#else                                           // POSIX
+
+/**
+ *  \brief Stat each name relative to the open directory `dirfd`.
+ */
+vector<stat_result> stat_many(fd_t dirfd, const path_list_t& names, const stat_many_options& options = stat_many_options());
+
+#endif                                          // WINDOWS
+
+PYCPP_END_NAMESPACE
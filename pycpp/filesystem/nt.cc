@@ -582,6 +582,10 @@ static DWORD convert_acess_pattern(io_access_pattern pattern)
             return 0;
         case access_sequential:
             return FILE_FLAG_SEQUENTIAL_SCAN;
+        case access_direct:
+            // unbuffered handles cannot write an unaligned tail, and
+            // cannot be made buffered after opening
+            return FILE_FLAG_SEQUENTIAL_SCAN;
         case access_random:
             return FILE_FLAG_RANDOM_ACCESS;
         default:
@@ -988,6 +992,25 @@ int fd_truncate(fd_t fd, streamsize size)
 }
 
 
+int fd_sync(fd_t fd)
+{
+    if (!::FlushFileBuffers(fd)) {
+        return translate_win32_error(GetLastError());
+    }
+    return 0;
+}
+
+int fd_direct(fd_t fd, bool enabled)
+{
+    // FILE_FLAG_NO_BUFFERING may only be set when opening the file
+    if (enabled) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+
 int fd_chmod(const path_view_t& path, mode_t permissions)
 {
     return fd_chmod_impl(path, permissions);
@@ -0,0 +1,686 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/exception.h>
+#include <pycpp/filesystem/walk.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/atomic.h>
+#include <pycpp/stl/condition_variable.h>
+#include <pycpp/stl/deque.h>
+#include <pycpp/stl/exception.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/set.h>
+#include <pycpp/stl/thread.h>
+#include <pycpp/stl/utility.h>
+#include <pycpp/stl/vector.h>
+#include <errno.h>
+#if defined(OS_WINDOWS)
+#   include <pycpp/filesystem/iterator.h>
+#else
+#   include <dirent.h>
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+#if defined(OS_LINUX)
+#   include <sys/syscall.h>
+#endif
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+// getdents64 buffer, large enough for several hundred entries
+static constexpr size_t WALK_BUFFER_SIZE = 1 << 16;
+
+// HELPERS
+// -------
+
+
+static void handle_error(int code)
+{
+    switch (code) {
+        case 0:
+            return;
+        case EACCES:
+            throw filesystem_error(filesystem_permissions_error);
+        case EMFILE:
+        case ENFILE:
+            throw filesystem_error(filesystem_too_many_file_descriptors);
+        case ENOENT:
+        case ENOTDIR:
+            throw filesystem_error(filesystem_no_such_directory);
+        case ENOMEM:
+            throw filesystem_error(filesystem_out_of_memory);
+        default:
+            throw filesystem_error(filesystem_unexpected_error);
+    }
+}
+
+
+static path_t join_walk_path(const path_t& dirname, const path_view_t& basename)
+{
+    path_t path;
+    path.reserve(dirname.size() + basename.size() + 1);
+    path.append(dirname.data(), dirname.size());
+    if (!path.empty() && path_separators.find(path.back()) == path_t::npos) {
+        path.push_back(path_separator);
+    }
+    path.append(basename.data(), basename.size());
+
+    return path;
+}
+
+
+#if !defined(OS_WINDOWS)                    // POSIX
+
+static walk_type mode_type(mode_t mode)
+{
+    if (S_ISREG(mode)) {
+        return walk_file;
+    } else if (S_ISDIR(mode)) {
+        return walk_directory;
+#if defined(S_ISLNK)
+    } else if (S_ISLNK(mode)) {
+        return walk_symlink;
+#endif
+    }
+    return walk_other;
+}
+
+
+static void copy_native(const struct stat& src, stat_t& dst)
+{
+    dst.st_dev = src.st_dev;
+    dst.st_ino = src.st_ino;
+    dst.st_mode = src.st_mode;
+    dst.st_nlink = src.st_nlink;
+    dst.st_uid = src.st_uid;
+    dst.st_gid = src.st_gid;
+    dst.st_rdev = src.st_rdev;
+    dst.st_size = src.st_size;
+    dst.st_atim = {src.st_atime, 0};
+    dst.st_mtim = {src.st_mtime, 0};
+    dst.st_ctim = {src.st_ctime, 0};
+}
+
+
+static bool stat_at(int dirfd, const char* name, stat_t& data, bool follow)
+{
+    struct stat sb;
+    if (::fstatat(dirfd, name, &sb, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    copy_native(sb, data);
+    return true;
+}
+
+
+static walk_type dirent_type(unsigned char type)
+{
+    switch (type) {
+#if defined(DT_REG)
+        case DT_REG:
+            return walk_file;
+        case DT_DIR:
+            return walk_directory;
+        case DT_LNK:
+            return walk_symlink;
+        case DT_UNKNOWN:
+            return walk_unknown;
+        default:
+            return walk_other;
+#else
+        default:
+            return walk_unknown;
+#endif
+    }
+}
+
+
+static bool is_relative_dot(const char* name)
+{
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+
+/**
+ *  \brief Skip an unreadable directory, or throw from `errno`.
+ */
+static bool directory_error(bool ignore)
+{
+    if (!ignore) {
+        handle_error(errno);
+    }
+    return false;
+}
+
+#endif                                      // POSIX
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Open directory, shared by its pending subdirectories.
+ */
+struct walk_handle
+{
+    fd_t fd;
+
+    walk_handle(fd_t fd):
+        fd(fd)
+    {}
+
+    ~walk_handle()
+    {
+#if !defined(OS_WINDOWS)
+        ::close(fd);
+#endif
+    }
+};
+
+
+/**
+ *  \brief Directory waiting to be read.
+ *
+ *  Subdirectories are opened relative to their parent, which stays
+ *  open until all of its pending subdirectories have been read.
+ */
+struct walk_item
+{
+    shared_ptr<walk_handle> parent;
+    path_t path;
+    size_t name;
+    size_t depth;
+    bool follow;
+};
+
+
+struct walk_worker
+{
+    mutex mutex_;
+    deque<walk_item> items;
+    vector<char> buffer;
+};
+
+
+/**
+ *  \brief Shared state for a walk, with a work-stealing queue per worker.
+ *
+ *  Each worker pops its newest directory, walking depth-first,
+ *  and steals the oldest directory from another worker when idle.
+ */
+struct walk_state
+{
+    const walk_callback& callback;
+    const walk_options& options;
+    vector<unique_ptr<walk_worker>> workers;
+
+    atomic<size_t> outstanding;
+    atomic<size_t> queued;
+    atomic<size_t> idle;
+    atomic<bool> stop;
+    mutex idle_mutex;
+    condition_variable idle_cv;
+
+    mutex error_mutex;
+    exception_ptr error;
+
+    mutex visited_mutex;
+    set<pair<dev_t, ino_t>> visited;
+
+    walk_state(const walk_callback& callback, const walk_options& options, size_t threads):
+        callback(callback),
+        options(options),
+        outstanding(0),
+        queued(0),
+        idle(0),
+        stop(false)
+    {
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back(new walk_worker);
+        }
+    }
+
+    void push(size_t index, walk_item&& item)
+    {
+        ++outstanding;
+        {
+            walk_worker& worker = *workers[index];
+            lock_guard<mutex> lock(worker.mutex_);
+            worker.items.emplace_back(PYCPP_NAMESPACE::move(item));
+        }
+        ++queued;
+        if (idle.load() > 0) {
+            lock_guard<mutex> lock(idle_mutex);
+            idle_cv.notify_one();
+        }
+    }
+
+    bool pop(size_t index, walk_item& item)
+    {
+        // own queue, newest first
+        {
+            walk_worker& worker = *workers[index];
+            lock_guard<mutex> lock(worker.mutex_);
+            if (!worker.items.empty()) {
+                item = PYCPP_NAMESPACE::move(worker.items.back());
+                worker.items.pop_back();
+                --queued;
+                return true;
+            }
+        }
+
+        // steal, oldest first
+        for (size_t i = 1; i < workers.size(); ++i) {
+            walk_worker& victim = *workers[(index + i) % workers.size()];
+            lock_guard<mutex> lock(victim.mutex_);
+            if (!victim.items.empty()) {
+                item = PYCPP_NAMESPACE::move(victim.items.front());
+                victim.items.pop_front();
+                --queued;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void finish()
+    {
+        if (--outstanding == 0) {
+            lock_guard<mutex> lock(idle_mutex);
+            idle_cv.notify_all();
+        }
+    }
+
+    void fail(exception_ptr ptr)
+    {
+        {
+            lock_guard<mutex> lock(error_mutex);
+            if (!error) {
+                error = ptr;
+            }
+        }
+        stop = true;
+        lock_guard<mutex> lock(idle_mutex);
+        idle_cv.notify_all();
+    }
+
+    /**
+     *  \brief Check if a followed directory was already visited.
+     */
+    bool visit(const stat_t& data)
+    {
+        lock_guard<mutex> lock(visited_mutex);
+        return visited.emplace(data.st_dev, data.st_ino).second;
+    }
+};
+
+// PLATFORM
+
+#if defined(OS_WINDOWS)                     // WINDOWS
+
+template <typename Emit>
+static bool read_directory(walk_worker&, const walk_item& item, shared_ptr<walk_handle>&, bool ignore, Emit emit)
+{
+    directory_iterator first;
+    try {
+        first = directory_iterator(item.path);
+    } catch (filesystem_error&) {
+        if (!ignore) {
+            throw;
+        }
+        return false;
+    }
+    directory_iterator last;
+    for (; first != last; ++first) {
+        walk_type type = walk_other;
+        if (first->islink()) {
+            type = walk_symlink;
+        } else if (first->isdir()) {
+            type = walk_directory;
+        } else if (first->isfile()) {
+            type = walk_file;
+        }
+        path_t basename = first->basename();
+        if (!emit(path_view_t(basename), type, &first->stat())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#else                                       // POSIX
+
+static fd_t open_directory(const walk_item& item)
+{
+    int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    if (!item.follow) {
+        flags |= O_NOFOLLOW;
+    }
+
+    fd_t fd;
+    do {
+        if (item.parent) {
+            fd = ::openat(item.parent->fd, item.path.data() + item.name, flags);
+        } else {
+            fd = ::open(item.path.data(), flags);
+        }
+    } while (fd == -1 && errno == EINTR);
+
+    return fd;
+}
+
+
+template <typename Emit>
+static bool read_directory(walk_worker& worker, const walk_item& item, shared_ptr<walk_handle>& handle, bool ignore, Emit emit)
+{
+    fd_t fd = open_directory(item);
+    if (fd == -1) {
+        return directory_error(ignore);
+    }
+    handle = make_shared<walk_handle>(fd);
+
+#if defined(OS_LINUX) && defined(SYS_getdents64)
+    // read entries in bulk, without the buffering of readdir
+    struct linux_dirent64
+    {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    worker.buffer.resize(WALK_BUFFER_SIZE);
+    char* buffer = worker.buffer.data();
+    for (;;) {
+        long bytes = ::syscall(SYS_getdents64, fd, buffer, WALK_BUFFER_SIZE);
+        if (bytes == 0) {
+            return true;
+        } else if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return directory_error(ignore);
+        }
+        for (long offset = 0; offset < bytes; ) {
+            auto* entry = reinterpret_cast<linux_dirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            if (is_relative_dot(entry->d_name)) {
+                continue;
+            }
+            if (!emit(path_view_t(entry->d_name), dirent_type(entry->d_type), nullptr)) {
+                return false;
+            }
+        }
+    }
+#else
+    // readdir takes ownership of the descriptor
+    int copy = ::dup(fd);
+    DIR* dir = copy == -1 ? nullptr : ::fdopendir(copy);
+    if (!dir) {
+        if (copy != -1) {
+            ::close(copy);
+        }
+        return directory_error(ignore);
+    }
+
+    bool status = true;
+    try {
+        while (dirent* entry = ::readdir(dir)) {
+            if (is_relative_dot(entry->d_name)) {
+                continue;
+            }
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(DT_UNKNOWN)
+            walk_type type = dirent_type(entry->d_type);
+#else
+            walk_type type = walk_unknown;
+#endif
+            if (!emit(path_view_t(entry->d_name), type, nullptr)) {
+                status = false;
+                break;
+            }
+        }
+    } catch (...) {
+        ::closedir(dir);
+        throw;
+    }
+    ::closedir(dir);
+
+    return status;
+#endif
+}
+
+#endif                                      // WINDOWS
+
+
+static void read_item(walk_state& state, size_t index, const walk_item& item)
+{
+    const walk_options& options = state.options;
+    shared_ptr<walk_handle> handle;
+
+    auto emit = [&](const path_view_t& basename, walk_type type, const stat_t* data) -> bool {
+        if (state.stop) {
+            return false;
+        }
+
+        fd_t dirfd = handle ? handle->fd : INVALID_FD_VALUE;
+        stat_t buffer;
+#if !defined(OS_WINDOWS)
+        if (type == walk_unknown) {
+            // filesystem without d_type, stat without following links
+            if (stat_at(dirfd, basename.data(), buffer, false)) {
+                type = mode_type(buffer.st_mode);
+                data = &buffer;
+            }
+        }
+#endif
+
+        walk_entry entry(item.path, basename, type, item.depth, dirfd, data);
+        if (options.filter && !options.filter(entry)) {
+            return true;
+        }
+        state.callback(entry);
+
+        bool descend = type == walk_directory;
+        bool follow = false;
+        if (options.follow_symlinks && (descend || type == walk_symlink)) {
+            // resolve links, and visit each directory once
+            stat_t target;
+#if defined(OS_WINDOWS)
+            bool found = true;
+            target = PYCPP_NAMESPACE::stat(entry.path());
+#else
+            bool found = stat_at(dirfd, basename.data(), target, true);
+#endif
+            descend = found && isdir(target) && state.visit(target);
+            follow = type == walk_symlink;
+        }
+        if (descend) {
+            path_t path = join_walk_path(item.path, basename);
+            size_t name = path.size() - basename.size();
+            state.push(index, {handle, PYCPP_NAMESPACE::move(path), name, item.depth + 1, follow});
+        }
+
+        return true;
+    };
+
+    read_directory(*state.workers[index], item, handle, options.ignore_errors, emit);
+}
+
+
+static void walk_worker_run(walk_state& state, size_t index)
+{
+    walk_item item;
+    while (!state.stop) {
+        if (state.pop(index, item)) {
+            try {
+                read_item(state, index, item);
+            } catch (...) {
+                state.fail(current_exception());
+            }
+            item.parent.reset();
+            state.finish();
+            continue;
+        }
+
+        unique_lock<mutex> lock(state.idle_mutex);
+        ++state.idle;
+        state.idle_cv.wait(lock, [&state]() {
+            return state.queued > 0 || state.outstanding == 0 || state.stop;
+        });
+        --state.idle;
+        if (state.outstanding == 0) {
+            return;
+        }
+    }
+}
+
+
+static void walk_impl(const path_view_t& root, const walk_callback& callback, const walk_options& options)
+{
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = max<size_t>(1, thread::hardware_concurrency());
+    }
+
+    walk_state state(callback, options, threads);
+    walk_item item = {nullptr, path_t(root), 0, 0, true};
+    if (options.follow_symlinks) {
+        state.visit(PYCPP_NAMESPACE::stat(root));
+    }
+
+    // the root must be readable, even when ignoring errors
+#if !defined(OS_WINDOWS)
+    fd_t fd = open_directory(item);
+    if (fd == -1) {
+        handle_error(errno);
+    }
+    ::close(fd);
+#endif
+    state.push(0, PYCPP_NAMESPACE::move(item));
+
+    vector<thread> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back([&state, i]() {
+            walk_worker_run(state, i);
+        });
+    }
+    walk_worker_run(state, 0);
+    for (thread& worker: workers) {
+        worker.join();
+    }
+
+    if (state.error) {
+        rethrow_exception(state.error);
+    }
+}
+
+// ENTRY
+
+
+walk_entry::walk_entry(const path_t& dirname, const path_view_t& basename, walk_type type, size_t depth, fd_t dirfd, const stat_t* stat) noexcept:
+    dirname_(dirname),
+    basename_(basename),
+    type_(type),
+    depth_(depth),
+    dirfd_(dirfd)
+{
+    if (stat) {
+        stat_ = *stat;
+        has_stat_ = true;
+    }
+}
+
+
+path_t walk_entry::path() const
+{
+    return join_walk_path(dirname_, basename_);
+}
+
+
+const path_t& walk_entry::dirname() const noexcept
+{
+    return dirname_;
+}
+
+
+path_view_t walk_entry::basename() const noexcept
+{
+    return basename_;
+}
+
+
+size_t walk_entry::depth() const noexcept
+{
+    return depth_;
+}
+
+
+walk_type walk_entry::type() const noexcept
+{
+    return type_;
+}
+
+
+bool walk_entry::isfile() const noexcept
+{
+    return type_ == walk_file;
+}
+
+
+bool walk_entry::isdir() const noexcept
+{
+    return type_ == walk_directory;
+}
+
+
+bool walk_entry::islink() const noexcept
+{
+    return type_ == walk_symlink;
+}
+
+
+const stat_t& walk_entry::stat() const
+{
+    if (!has_stat_) {
+#if defined(OS_WINDOWS)
+        stat_ = lstat(path());
+#else
+        struct stat sb;
+        if (::fstatat(dirfd_, basename_.data(), &sb, AT_SYMLINK_NOFOLLOW) != 0) {
+            handle_error(errno);
+        }
+        copy_native(sb, stat_);
+#endif
+        has_stat_ = true;
+    }
+
+    return stat_;
+}
+
+// FUNCTIONS
+// ---------
+
+
+void walk(const path_view_t& root, const walk_callback& callback, const walk_options& options)
+{
+    walk_impl(root, callback, options);
+}
+
+#if defined(OS_WINDOWS)                         // BACKUP PATH
+
+
+void walk(const backup_path_view_t& root, const walk_callback& callback, const walk_options& options)
+{
+    walk_impl(backup_path_to_path(root), callback, options);
+}
+
+#endif                                          // WINDOWS
+
+PYCPP_END_NAMESPACE
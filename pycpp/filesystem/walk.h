@@ -0,0 +1,167 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief High-performance directory tree walker.
+ *
+ *  Unlike `recursive_directory_iterator`, the walker reads entries
+ *  relative to an open directory descriptor (`openat`/`fstatat`),
+ *  takes the file type from the directory entry (`d_type`) so most
+ *  entries never need a `stat` call, and on Linux reads entries in
+ *  bulk with `getdents64`. Directories may be traversed in parallel,
+ *  with each worker walking depth-first and idle workers stealing
+ *  the shallowest pending directories from busy workers.
+ *
+ *  The filter is called for each entry before the callback, and
+ *  returning false skips the entry, pruning the subtree for a
+ *  directory. In parallel mode, the filter and the callback are
+ *  called concurrently, from multiple threads, and entries are
+ *  visited in an unspecified order.
+ *
+ *  \synopsis
+ *      enum walk_type
+ *      {
+ *          walk_unknown = 0,
+ *          walk_file,
+ *          walk_directory,
+ *          walk_symlink,
+ *          walk_other,
+ *      };
+ *
+ *      struct walk_entry
+ *      {
+ *          path_t path() const;
+ *          const path_t& dirname() const noexcept;
+ *          path_view_t basename() const noexcept;
+ *          size_t depth() const noexcept;
+ *          walk_type type() const noexcept;
+ *          bool isfile() const noexcept;
+ *          bool isdir() const noexcept;
+ *          bool islink() const noexcept;
+ *          const stat_t& stat() const;
+ *      };
+ *
+ *      using walk_filter = function<bool(const walk_entry&)>;
+ *      using walk_callback = function<void(const walk_entry&)>;
+ *
+ *      struct walk_options
+ *      {
+ *          walk_filter filter = nullptr;
+ *          size_t threads = 1;
+ *          bool follow_symlinks = false;
+ *          bool ignore_errors = false;
+ *      };
+ *
+ *      void walk(const path_view_t& root, const walk_callback& callback, const walk_options& options = {});
+ */
+
+#pragma once
+
+#include <pycpp/filesystem/fd.h>
+#include <pycpp/filesystem/path.h>
+#include <pycpp/filesystem/stat.h>
+#include <pycpp/stl/functional.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// ENUMS
+// -----
+
+/**
+ *  \brief File type, as reported by the directory entry.
+ */
+enum walk_type
+{
+    walk_unknown = 0,
+    walk_file,
+    walk_directory,
+    walk_symlink,
+    walk_other,
+};
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Entry visited by the tree walker.
+ *
+ *  The entry, and the views it returns, are only valid for the
+ *  duration of the filter or callback. The depth is the number of
+ *  directories between the root and the entry.
+ */
+struct walk_entry
+{
+public:
+    walk_entry(const path_t& dirname, const path_view_t& basename, walk_type type, size_t depth, fd_t dirfd, const stat_t* stat = nullptr) noexcept;
+    walk_entry(const walk_entry&) = delete;
+    walk_entry& operator=(const walk_entry&) = delete;
+
+    // PATHS
+    path_t path() const;
+    const path_t& dirname() const noexcept;
+    path_view_t basename() const noexcept;
+    size_t depth() const noexcept;
+
+    // TYPE
+    walk_type type() const noexcept;
+    bool isfile() const noexcept;
+    bool isdir() const noexcept;
+    bool islink() const noexcept;
+
+    // STAT
+    const stat_t& stat() const;
+
+private:
+    const path_t& dirname_;
+    path_view_t basename_;
+    walk_type type_;
+    size_t depth_;
+    fd_t dirfd_;
+    mutable bool has_stat_ = false;
+    mutable stat_t stat_;
+};
+
+// ALIAS
+// -----
+
+using walk_filter = function<bool(const walk_entry&)>;
+using walk_callback = function<void(const walk_entry&)>;
+
+// OPTIONS
+// -------
+
+/**
+ *  \brief Options for the tree walker.
+ *
+ *  `threads` is the number of workers, or 0 to use one per
+ *  hardware thread. Symbolic links to directories are only
+ *  followed with `follow_symlinks`, and each directory is then
+ *  visited once. With `ignore_errors`, unreadable directories
+ *  are skipped, rather than throwing a `filesystem_error`.
+ */
+struct walk_options
+{
+    walk_filter filter = nullptr;
+    size_t threads = 1;
+    bool follow_symlinks = false;
+    bool ignore_errors = false;
+};
+
+// FUNCTIONS
+// ---------
+
+/**
+ *  \brief Visit every entry below `root`, excluding `root` itself.
+ *
+ *  Directories are visited before their contents. Exceptions thrown
+ *  by the filter or the callback stop the walk, and are rethrown.
+ */
+void walk(const path_view_t& root, const walk_callback& callback, const walk_options& options = walk_options());
+
+#if defined(OS_WINDOWS)                         // BACKUP PATH
+
+void walk(const backup_path_view_t& root, const walk_callback& callback, const walk_options& options = walk_options());
+
+#endif                                          // WINDOWS
+
+PYCPP_END_NAMESPACE
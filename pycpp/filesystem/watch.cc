@@ -0,0 +1,606 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/exception.h>
+#include <pycpp/filesystem/iterator.h>
+#include <pycpp/filesystem/watch.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/atomic.h>
+#include <pycpp/stl/condition_variable.h>
+#include <pycpp/stl/limits.h>
+#include <pycpp/stl/map.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/unordered_map.h>
+#include <pycpp/stl/utility.h>
+#include <errno.h>
+#if defined(HAVE_SYS_INOTIFY_H)
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <string.h>
+#   include <sys/inotify.h>
+#   include <unistd.h>
+#endif
+
+PYCPP_BEGIN_NAMESPACE
+
+// CONSTANTS
+// ---------
+
+#if defined(HAVE_SYS_INOTIFY_H)
+
+static constexpr uint32_t INOTIFY_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+static constexpr size_t INOTIFY_BUFFER_SIZE = 1 << 16;
+
+#endif                  // HAVE_SYS_INOTIFY_H
+
+// OBJECTS
+// -------
+
+using watch_clock = chrono::steady_clock;
+using watch_pending = map<path_t, int>;
+
+
+struct file_watcher_impl
+{
+    watch_options options;
+    path_list_t roots;
+    mutex mutex_;
+    atomic<bool> stopping;
+
+    file_watcher_impl(const watch_options& options);
+    virtual ~file_watcher_impl() = default;
+    virtual void add(const path_t& path) = 0;
+    virtual void remove(const path_t& path) = 0;
+    virtual int read(watch_pending& pending, chrono::milliseconds timeout) = 0;
+    virtual void wake() = 0;
+    virtual watch_backend backend() const noexcept = 0;
+};
+
+
+file_watcher_impl::file_watcher_impl(const watch_options& options):
+    options(options),
+    stopping(false)
+{}
+
+// HELPERS
+// -------
+
+
+/**
+ *  \brief Check if a path is a root, or below a root.
+ */
+static bool is_within(const path_t& path, const path_t& root)
+{
+    if (path.size() < root.size() || path.compare(0, root.size(), root) != 0) {
+        return false;
+    }
+    return path.size() == root.size() || path_separators.find(path[root.size()]) != path_t::npos;
+}
+
+
+/**
+ *  \brief Merge an event into the pending changes for a path.
+ *
+ *  A path created and removed within a batch is dropped, and a path
+ *  removed and created again is reported as modified.
+ */
+static void merge(watch_pending& pending, const path_t& path, int event)
+{
+    auto it = pending.find(path);
+    if (it == pending.end()) {
+        pending.emplace(path, event);
+        return;
+    }
+
+    int& events = it->second;
+    switch (event) {
+        case watch_created:
+            events = (events & watch_removed) ? (events & ~watch_removed) | watch_modified : events | watch_created;
+            break;
+        case watch_removed:
+            if (events & watch_created) {
+                pending.erase(it);
+            } else {
+                events = (events & ~watch_modified) | watch_removed;
+            }
+            break;
+        case watch_modified:
+            if (!(events & watch_created)) {
+                events |= watch_modified;
+            }
+            break;
+        default:
+            events |= event;
+            break;
+    }
+}
+
+
+static chrono::milliseconds remaining(watch_clock::time_point until, watch_clock::time_point now)
+{
+    // round up, so a pending deadline never polls with a zero timeout
+    auto duration = chrono::duration_cast<chrono::milliseconds>(until - now);
+    return duration + chrono::milliseconds(until - now > duration ? 1 : 0);
+}
+
+// POLLING
+
+
+/**
+ *  \brief State of a path, as of the last scan.
+ */
+struct watch_state
+{
+    timespec mtime;
+    off_t size;
+    bool isdir;
+};
+
+using watch_snapshot = map<path_t, watch_state>;
+
+
+static void scan(const path_t& root, bool recursive, watch_snapshot& snapshot)
+{
+    try {
+        stat_t sb = stat(root);
+        snapshot[root] = {sb.st_mtim, sb.st_size, isdir(sb)};
+        if (!isdir(sb)) {
+            return;
+        } else if (recursive) {
+            for (recursive_directory_iterator it(root), last; it != last; ++it) {
+                const stat_t& s = it->stat();
+                snapshot[it->path()] = {s.st_mtim, s.st_size, isdir(s)};
+            }
+        } else {
+            for (directory_iterator it(root), last; it != last; ++it) {
+                const stat_t& s = it->stat();
+                snapshot[it->path()] = {s.st_mtim, s.st_size, isdir(s)};
+            }
+        }
+    } catch (filesystem_error&) {
+        // removed during the scan, reported by the next scan
+    }
+}
+
+
+static int compare(const watch_snapshot& previous, const watch_snapshot& current, watch_pending& pending)
+{
+    int count = 0;
+    for (const auto& item: current) {
+        auto it = previous.find(item.first);
+        if (it == previous.end()) {
+            merge(pending, item.first, watch_created);
+            ++count;
+        } else if (item.second.isdir) {
+            // directory times change with their entries, which are reported instead
+            continue;
+        } else if (item.second.size != it->second.size || item.second.mtime.tv_sec != it->second.mtime.tv_sec || item.second.mtime.tv_nsec != it->second.mtime.tv_nsec) {
+            merge(pending, item.first, watch_modified);
+            ++count;
+        }
+    }
+    for (const auto& item: previous) {
+        if (current.find(item.first) == current.end()) {
+            merge(pending, item.first, watch_removed);
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+
+/**
+ *  \brief Portable backend, rescanning the trees at a fixed interval.
+ */
+struct watch_polling: file_watcher_impl
+{
+    condition_variable wake_;
+    watch_snapshot snapshot;
+    watch_clock::time_point next;
+
+    watch_polling(const watch_options& options):
+        file_watcher_impl(options),
+        next(watch_clock::now() + options.interval)
+    {}
+
+    virtual void add(const path_t& path) override
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (find(roots.begin(), roots.end(), path) == roots.end()) {
+            roots.push_back(path);
+            scan(path, options.recursive, snapshot);
+        }
+    }
+
+    virtual void remove(const path_t& path) override
+    {
+        lock_guard<mutex> lock(mutex_);
+        roots.erase(PYCPP_NAMESPACE::remove(roots.begin(), roots.end(), path), roots.end());
+        for (auto it = snapshot.begin(); it != snapshot.end(); ) {
+            it = is_within(it->first, path) ? snapshot.erase(it) : ++it;
+        }
+    }
+
+    virtual int read(watch_pending& pending, chrono::milliseconds timeout) override
+    {
+        unique_lock<mutex> lock(mutex_);
+        auto until = min(watch_clock::now() + timeout, next);
+        wake_.wait_until(lock, until, [this]() {
+            return stopping.load();
+        });
+        if (stopping) {
+            return -1;
+        }
+
+        auto now = watch_clock::now();
+        if (now < next) {
+            return 0;
+        }
+        next = now + options.interval;
+
+        watch_snapshot current;
+        for (const path_t& root: roots) {
+            scan(root, options.recursive, current);
+        }
+        int count = compare(snapshot, current, pending);
+        snapshot.swap(current);
+
+        return count;
+    }
+
+    virtual void wake() override
+    {
+        lock_guard<mutex> lock(mutex_);
+        wake_.notify_all();
+    }
+
+    virtual watch_backend backend() const noexcept override
+    {
+        return watch_backend_polling;
+    }
+};
+
+// INOTIFY
+
+#if defined(HAVE_SYS_INOTIFY_H)
+
+/**
+ *  \brief Linux backend, with an inotify watch for each directory.
+ */
+struct watch_inotify: file_watcher_impl
+{
+    int fd = -1;
+    int pipe_[2] = {-1, -1};
+    unordered_map<int, path_t> paths;
+    vector<char> buffer;
+
+    watch_inotify(const watch_options& options):
+        file_watcher_impl(options),
+        buffer(INOTIFY_BUFFER_SIZE)
+    {}
+
+    ~watch_inotify()
+    {
+        for (int descriptor: {fd, pipe_[0], pipe_[1]}) {
+            if (descriptor != -1) {
+                ::close(descriptor);
+            }
+        }
+    }
+
+    bool open()
+    {
+        fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        return fd != -1 && ::pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) == 0;
+    }
+
+    bool watch(const path_t& path)
+    {
+        int wd = ::inotify_add_watch(fd, path.data(), INOTIFY_MASK);
+        if (wd == -1) {
+            return false;
+        }
+        paths[wd] = path;
+        return true;
+    }
+
+    void unwatch(const path_t& path)
+    {
+        for (auto it = paths.begin(); it != paths.end(); ) {
+            if (is_within(it->second, path)) {
+                ::inotify_rm_watch(fd, it->first);
+                it = paths.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /**
+     *  \brief Watch a new directory, and report its existing entries.
+     *
+     *  Entries created before the watch was added have no events.
+     */
+    int watch_tree(const path_t& path, watch_pending* pending)
+    {
+        int count = 0;
+        watch(path);
+        try {
+            for (recursive_directory_iterator it(path), last; it != last; ++it) {
+                if (pending) {
+                    merge(*pending, it->path(), watch_created);
+                    ++count;
+                }
+                if (it->isdir() && !it->islink()) {
+                    watch(it->path());
+                }
+            }
+        } catch (filesystem_error&) {
+            // removed while iterating, reported by a later event
+        }
+
+        return count;
+    }
+
+    virtual void add(const path_t& path) override
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!watch(path)) {
+            throw filesystem_error(errno == ENOSPC ? filesystem_too_many_file_descriptors : filesystem_file_not_found);
+        }
+        if (find(roots.begin(), roots.end(), path) == roots.end()) {
+            roots.push_back(path);
+        }
+        if (options.recursive && isdir(path)) {
+            watch_tree(path, nullptr);
+        }
+    }
+
+    virtual void remove(const path_t& path) override
+    {
+        lock_guard<mutex> lock(mutex_);
+        roots.erase(PYCPP_NAMESPACE::remove(roots.begin(), roots.end(), path), roots.end());
+        unwatch(path);
+    }
+
+    int handle(watch_pending& pending, const inotify_event& event, const char* name)
+    {
+        if (event.mask & IN_Q_OVERFLOW) {
+            for (const path_t& root: roots) {
+                merge(pending, root, watch_overflow);
+            }
+            return 1;
+        }
+
+        auto it = paths.find(event.wd);
+        if (it == paths.end()) {
+            return 0;
+        } else if (event.mask & IN_IGNORED) {
+            paths.erase(it);
+            return 0;
+        }
+
+        path_t path = name ? join_path({it->second, name}) : it->second;
+        if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+            merge(pending, path, watch_created);
+            if ((event.mask & IN_ISDIR) && options.recursive) {
+                return 1 + watch_tree(path, &pending);
+            }
+        } else if (event.mask & (IN_DELETE | IN_MOVED_FROM)) {
+            merge(pending, path, watch_removed);
+            if (event.mask & IN_ISDIR) {
+                unwatch(path);
+            }
+        } else if (event.mask & (IN_MODIFY | IN_ATTRIB)) {
+            if (event.mask & IN_ISDIR) {
+                return 0;
+            }
+            merge(pending, path, watch_modified);
+        } else if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+            // subdirectories are reported by their parent
+            if (find(roots.begin(), roots.end(), path) == roots.end()) {
+                return 0;
+            }
+            merge(pending, path, watch_removed);
+        }
+
+        return 1;
+    }
+
+    virtual int read(watch_pending& pending, chrono::milliseconds timeout) override
+    {
+        if (stopping) {
+            return -1;
+        }
+
+        pollfd fds[2] = {{fd, POLLIN, 0}, {pipe_[0], POLLIN, 0}};
+        int timeout_ms = static_cast<int>(min<chrono::milliseconds::rep>(timeout.count(), numeric_limits<int>::max()));
+        if (::poll(fds, 2, timeout_ms) == -1) {
+            return 0;
+        }
+        if (fds[1].revents & POLLIN) {
+            char c;
+            while (::read(pipe_[0], &c, 1) == 1)
+                ;
+        }
+        if (stopping) {
+            return -1;
+        } else if (!(fds[0].revents & POLLIN)) {
+            return 0;
+        }
+
+        lock_guard<mutex> lock(mutex_);
+        int count = 0;
+        ssize_t length;
+        while ((length = ::read(fd, buffer.data(), buffer.size())) > 0) {
+            for (ssize_t offset = 0; offset < length; ) {
+                // copy the header, since events are not aligned in the buffer
+                inotify_event event;
+                memcpy(&event, buffer.data() + offset, sizeof(event));
+                const char* name = event.len ? buffer.data() + offset + sizeof(event) : nullptr;
+                count += handle(pending, event, name);
+                offset += sizeof(event) + event.len;
+            }
+        }
+
+        return count;
+    }
+
+    virtual void wake() override
+    {
+        // a full pipe (EAGAIN) already wakes the loop
+        char c = 0;
+        while (::write(pipe_[1], &c, 1) == -1 && errno == EINTR)
+            ;
+    }
+
+    virtual watch_backend backend() const noexcept override
+    {
+        return watch_backend_inotify;
+    }
+};
+
+#endif                  // HAVE_SYS_INOTIFY_H
+
+
+static unique_ptr<file_watcher_impl> make_watcher(const watch_options& options)
+{
+#if defined(HAVE_SYS_INOTIFY_H)
+    if (options.backend != watch_backend_polling) {
+        unique_ptr<watch_inotify> inotify(new watch_inotify(options));
+        if (inotify->open()) {
+            return unique_ptr<file_watcher_impl>(inotify.release());
+        }
+    }
+#endif                  // HAVE_SYS_INOTIFY_H
+
+    // inotify is unavailable, or was not requested
+    return unique_ptr<file_watcher_impl>(new watch_polling(options));
+}
+
+// WATCHER
+
+
+file_watcher::file_watcher(const watch_options& options):
+    ptr_(make_watcher(options))
+{}
+
+
+file_watcher::~file_watcher()
+{
+    stop();
+}
+
+
+/**
+ *  \brief Watch a file, or a directory and, if recursive, its subtree.
+ */
+void file_watcher::add(const path_view_t& path)
+{
+    path_t root = normpath(path);
+    if (!exists(root)) {
+        throw filesystem_error(filesystem_file_not_found);
+    }
+    ptr_->add(root);
+}
+
+
+/**
+ *  \brief Stop watching a path passed to `add()`.
+ */
+void file_watcher::remove(const path_view_t& path)
+{
+    ptr_->remove(normpath(path));
+}
+
+
+/**
+ *  \brief Wait up to `timeout` for a batch of changes.
+ *
+ *  Once the first event arrives, the batch may be delivered after
+ *  the timeout, but no later than `latency`. Returns false if no
+ *  changes were detected, or the watcher was stopped.
+ */
+bool file_watcher::wait(watch_changes& changes, chrono::milliseconds timeout)
+{
+    const watch_options& options = ptr_->options;
+    watch_pending pending;
+    auto now = watch_clock::now();
+    auto deadline = now + timeout;
+    auto first = now;
+    auto last = now;
+    bool active = false;
+
+    changes.clear();
+    while (true) {
+        auto until = active ? min(last + options.debounce, first + options.latency) : deadline;
+        now = watch_clock::now();
+        if (until <= now) {
+            if (!active || !pending.empty() || now >= deadline) {
+                break;
+            }
+            // every event was coalesced away, keep waiting
+            active = false;
+            continue;
+        }
+
+        int count = ptr_->read(pending, remaining(until, now));
+        if (count < 0) {
+            break;
+        } else if (count > 0) {
+            last = watch_clock::now();
+            if (!active) {
+                first = last;
+                active = true;
+            }
+        }
+    }
+
+    for (const auto& item: pending) {
+        changes.push_back({item.first, item.second});
+    }
+    return !changes.empty();
+}
+
+
+/**
+ *  \brief Deliver batches to `callback` from a watcher thread.
+ *
+ *  Exceptions thrown by the callback are discarded.
+ */
+void file_watcher::start(watch_callback callback)
+{
+    stop();
+    thread_ = thread([this, callback]() {
+        watch_changes changes;
+        while (!ptr_->stopping) {
+            if (wait(changes, ptr_->options.interval)) {
+                try {
+                    callback(changes);
+                } catch (...) {
+                }
+            }
+        }
+    });
+}
+
+
+void file_watcher::stop()
+{
+    if (thread_.joinable()) {
+        ptr_->stopping = true;
+        ptr_->wake();
+        thread_.join();
+        ptr_->stopping = false;
+    }
+}
+
+
+watch_backend file_watcher::backend() const noexcept
+{
+    return ptr_->backend();
+}
+
+PYCPP_END_NAMESPACE
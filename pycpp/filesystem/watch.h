@@ -0,0 +1,196 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Filesystem change watcher.
+ *
+ *  The watcher reports changes to files and directory trees as
+ *  batches, rather than as individual events. On Linux, the watcher
+ *  uses inotify, watching each directory below a recursive root,
+ *  including directories created later. Elsewhere, or if inotify is
+ *  unavailable, the watcher rescans the watched trees at a fixed
+ *  interval and compares the modification times and sizes.
+ *
+ *  Events are debounced: a batch is delivered once no new events
+ *  arrive for `debounce`, or `latency` after the first pending
+ *  event, so continuous writes cannot delay a batch indefinitely.
+ *  Events for the same path are coalesced, so a file created and
+ *  written is reported once as created, and a temporary file
+ *  created and removed within a batch is not reported at all.
+ *
+ *  Batches are either retrieved with `wait()`, or delivered to a
+ *  callback on a watcher thread, between `start()` and `stop()`.
+ *
+ *  \synopsis
+ *      enum watch_backend
+ *      {
+ *          watch_backend_default = 0,
+ *          watch_backend_inotify,
+ *          watch_backend_polling,
+ *      };
+ *
+ *      enum watch_event
+ *      {
+ *          watch_created   = 1,
+ *          watch_modified  = 2,
+ *          watch_removed   = 4,
+ *          watch_overflow  = 8,
+ *      };
+ *
+ *      struct watch_change
+ *      {
+ *          path_t path;
+ *          int events;
+ *      };
+ *
+ *      using watch_changes = vector<watch_change>;
+ *      using watch_callback = function<void(const watch_changes&)>;
+ *
+ *      struct watch_options
+ *      {
+ *          bool recursive = true;
+ *          chrono::milliseconds debounce = chrono::milliseconds(50);
+ *          chrono::milliseconds latency = chrono::milliseconds(1000);
+ *          chrono::milliseconds interval = chrono::milliseconds(1000);
+ *          watch_backend backend = watch_backend_default;
+ *      };
+ *
+ *      class file_watcher
+ *      {
+ *      public:
+ *          file_watcher(const watch_options& options = {});
+ *          ~file_watcher();
+ *
+ *          // PATHS
+ *          void add(const path_view_t& path);
+ *          void remove(const path_view_t& path);
+ *
+ *          // EVENTS
+ *          bool wait(watch_changes& changes, chrono::milliseconds timeout);
+ *          void start(watch_callback callback);
+ *          void stop();
+ *
+ *          // PROPERTIES
+ *          watch_backend backend() const noexcept;
+ *      };
+ */
+
+#pragma once
+
+#include <pycpp/filesystem/path.h>
+#include <pycpp/stl/chrono.h>
+#include <pycpp/stl/functional.h>
+#include <pycpp/stl/memory.h>
+#include <pycpp/stl/thread.h>
+#include <pycpp/stl/vector.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// FORWARD
+// -------
+
+struct file_watcher_impl;
+
+// ENUMS
+// -----
+
+/**
+ *  \brief Implementation used by the watcher.
+ *
+ *  `watch_backend_default` uses inotify where it is supported,
+ *  otherwise polling.
+ */
+enum watch_backend
+{
+    watch_backend_default = 0,
+    watch_backend_inotify,
+    watch_backend_polling,
+};
+
+
+/**
+ *  \brief Change to a path, as a bitmask in `watch_change`.
+ *
+ *  `watch_overflow` is reported for the watched roots when the
+ *  kernel dropped events, and the trees should be rescanned.
+ */
+enum watch_event
+{
+    watch_created   = 1,
+    watch_modified  = 2,
+    watch_removed   = 4,
+    watch_overflow  = 8,
+};
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Coalesced changes to a single path.
+ */
+struct watch_change
+{
+    path_t path;
+    int events;
+};
+
+// ALIAS
+// -----
+
+using watch_changes = vector<watch_change>;
+using watch_callback = function<void(const watch_changes&)>;
+
+// OPTIONS
+// -------
+
+/**
+ *  \brief Options for the watcher.
+ *
+ *  `interval` is the time between scans for the polling backend.
+ *  Without `recursive`, only the direct entries of a watched
+ *  directory are reported.
+ */
+struct watch_options
+{
+    bool recursive = true;
+    chrono::milliseconds debounce = chrono::milliseconds(50);
+    chrono::milliseconds latency = chrono::milliseconds(1000);
+    chrono::milliseconds interval = chrono::milliseconds(1000);
+    watch_backend backend = watch_backend_default;
+};
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Watcher delivering batches of changes to files and trees.
+ *
+ *  Paths may be added or removed while a callback thread is running.
+ *  Batches are sorted by path. The callback must not call `stop()`.
+ */
+class file_watcher
+{
+public:
+    file_watcher(const watch_options& options = watch_options());
+    file_watcher(const file_watcher&) = delete;
+    file_watcher& operator=(const file_watcher&) = delete;
+    ~file_watcher();
+
+    // PATHS
+    void add(const path_view_t& path);
+    void remove(const path_view_t& path);
+
+    // EVENTS
+    bool wait(watch_changes& changes, chrono::milliseconds timeout);
+    void start(watch_callback callback);
+    void stop();
+
+    // PROPERTIES
+    watch_backend backend() const noexcept;
+
+private:
+    unique_ptr<file_watcher_impl> ptr_;
+    thread thread_;
+};
+
+PYCPP_END_NAMESPACE
@@ -5,24 +5,788 @@
  *  \brief Memory-mapped file for larger-than-memory arrays.
  *
  *  Internally, the memory-mapped file is implemented like a deque,
- *  with an LRU-cache.
+ *  with an LRU-cache. The file is split into fixed-size windows,
+ *  each mapped on demand with `mmap_view` from the open file, and at most
+ *  `cache_size` windows are mapped at once, bounding the address
+ *  space used regardless of the file size.
+ *
+ *  Windows are a multiple of the element size and of the largest
+ *  allocation granularity (64 KB), so elements never straddle a
+ *  window and every window offset may be mapped.
+ *
+ *  References, pointers, and iterators dereferenced into the array
+ *  are only valid while their window is mapped: accessing more than
+ *  `cache_size` other windows, resizing or closing the array may
+ *  invalidate them. The iterators themselves remain valid, since
+ *  they store an index and map the window again on dereference.
+ *  The array is not thread-safe, even for const access.
+ *
+ *  \synopsis
+ *      template <typename T>
+ *      class memmap_array
+ *      {
+ *      public:
+ *          memmap_array();
+ *          memmap_array(const path_view_t& path, size_t window_size = MEMMAP_WINDOW_SIZE, int cache_size = MEMMAP_CACHE_SIZE);
+ *          void open(const path_view_t& path, size_t window_size = MEMMAP_WINDOW_SIZE, int cache_size = MEMMAP_CACHE_SIZE);
+ *
+ *          // ITERATORS
+ *          iterator begin();
+ *          iterator end();
+ *
+ *          // CAPACITY
+ *          size_t size() const noexcept;
+ *          bool empty() const noexcept;
+ *          size_t window_size() const noexcept;
+ *          void resize(size_t size);
+ *
+ *          // ELEMENT ACCESS
+ *          reference operator[](size_t index);
+ *          reference at(size_t index);
+ *          reference front();
+ *          reference back();
+ *
+ *          // BULK
+ *          void read(size_t first, T* dst, size_t count) const;
+ *          void write(size_t first, const T* src, size_t count);
+ *
+ *          // MODIFIERS
+ *          void flush(bool async = true);
+ *          void close();
+ *          void swap(memmap_array& rhs);
+ *      };
  */
 
 #pragma once
 
-#include <pycpp/config.h>
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/exception.h>
+#include <pycpp/cache/lru.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/iterator.h>
+#include <pycpp/stl/memory.h>
+#include <pycpp/stl/stdexcept.h>
+#include <pycpp/stl/type_traits.h>
+#include <pycpp/stl/utility.h>
+#include <pycpp/stream/mmap.h>
+#include <string.h>
+
+#if defined(HAVE_MMAP) || defined(OS_WINDOWS)           // MMAP
 
 PYCPP_BEGIN_NAMESPACE
 
+// CONSTANTS
+// ---------
+
+static constexpr size_t MEMMAP_WINDOW_SIZE = 1 << 24;
+static constexpr size_t MEMMAP_WINDOW_GRANULARITY = 1 << 16;
+static constexpr int MEMMAP_CACHE_SIZE = 16;
+
 // OBJECTS
 // -------
 
+/**
+ *  \brief Random-access iterator over a memory-mapped array.
+ *
+ *  Stores the index, and accesses the element through the
+ *  array, so the iterator survives window eviction.
+ */
+template <typename Array, typename T>
+struct memmap_array_iterator: iterator<random_access_iterator_tag, T>
+{
+    // MEMBER TYPES
+    // ------------
+    using self_t = memmap_array_iterator<Array, T>;
+    using base_t = iterator<random_access_iterator_tag, T>;
+    using typename base_t::value_type;
+    using typename base_t::difference_type;
+    using reference = T&;
+    using pointer = T*;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+    memmap_array_iterator(Array* array = nullptr, size_t index = 0) noexcept;
+    memmap_array_iterator(const memmap_array_iterator&) noexcept = default;
+    memmap_array_iterator& operator=(const memmap_array_iterator&) noexcept = default;
+
+    // RELATIONAL OPERATORS
+    bool operator==(const self_t&) const noexcept;
+    bool operator!=(const self_t&) const noexcept;
+    bool operator<(const self_t&) const noexcept;
+    bool operator<=(const self_t&) const noexcept;
+    bool operator>(const self_t&) const noexcept;
+    bool operator>=(const self_t&) const noexcept;
+
+    // INCREMENTORS
+    self_t& operator++() noexcept;
+    self_t operator++(int) noexcept;
+    self_t& operator--() noexcept;
+    self_t operator--(int) noexcept;
+    self_t& operator+=(difference_type) noexcept;
+    self_t& operator-=(difference_type) noexcept;
+    self_t operator+(difference_type) const noexcept;
+    self_t operator-(difference_type) const noexcept;
+    difference_type operator-(const self_t&) const noexcept;
+    reference operator[](difference_type) const;
+
+    // DEREFERENCE
+    reference operator*() const;
+    pointer operator->() const;
+
+    // OTHER
+    size_t index() const noexcept;
+    void swap(self_t&) noexcept;
+
+private:
+    Array* array_ = nullptr;
+    size_t index_ = 0;
+};
+
+
+/**
+ *  \brief Larger-than-memory array backed by a file.
+ */
+template <typename T>
+class memmap_array
+{
+public:
+    // MEMBER TYPES
+    // ------------
+    using self_t = memmap_array<T>;
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = memmap_array_iterator<self_t, T>;
+    using const_iterator = memmap_array_iterator<const self_t, const T>;
+    using reverse_iterator = PYCPP_NAMESPACE::reverse_iterator<iterator>;
+    using const_reverse_iterator = PYCPP_NAMESPACE::reverse_iterator<const_iterator>;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+    memmap_array();
+    ~memmap_array();
+    memmap_array(const self_t&) = delete;
+    self_t& operator=(const self_t&) = delete;
+    memmap_array(self_t&&);
+    self_t& operator=(self_t&&);
+
+    memmap_array(const path_view_t& path, size_t window_size = MEMMAP_WINDOW_SIZE, int cache_size = MEMMAP_CACHE_SIZE);
+    void open(const path_view_t& path, size_t window_size = MEMMAP_WINDOW_SIZE, int cache_size = MEMMAP_CACHE_SIZE);
+
+    // ITERATORS
+    iterator begin() noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator cbegin() const noexcept;
+    iterator end() noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cend() const noexcept;
+    reverse_iterator rbegin() noexcept;
+    const_reverse_iterator rbegin() const noexcept;
+    const_reverse_iterator crbegin() const noexcept;
+    reverse_iterator rend() noexcept;
+    const_reverse_iterator rend() const noexcept;
+    const_reverse_iterator crend() const noexcept;
+
+    // CAPACITY
+    size_type size() const noexcept;
+    bool empty() const noexcept;
+    size_type window_size() const noexcept;
+    void resize(size_type size);
+
+    // ELEMENT ACCESS
+    reference operator[](size_type index);
+    const_reference operator[](size_type index) const;
+    reference at(size_type index);
+    const_reference at(size_type index) const;
+    reference front();
+    const_reference front() const;
+    reference back();
+    const_reference back() const;
+
+    // BULK
+    void read(size_type first, T* dst, size_type count) const;
+    void write(size_type first, const T* src, size_type count);
+
+    // PROPERTIES
+    bool is_open() const;
+
+    // MODIFIERS
+    void flush(bool async = true);
+    void close();
+    void swap(self_t&);
+
+private:
+    static_assert(is_trivially_copyable<T>::value, "memmap_array must use trivially copyable types.");
+
+    using window_ptr = shared_ptr<mmap_view>;
+    using cache_type = lru_cache<size_t, window_ptr>;
+
+    char* window(size_t index) const;
+    void reset_cache();
+
+    fd_t fd_ = INVALID_FD_VALUE;
+    size_t size_ = 0;
+    size_t window_bytes_ = 0;
+    size_t window_length_ = 0;
+    mutable cache_type cache_;
+    mutable size_t last_index_ = 0;
+    mutable char* last_data_ = nullptr;
+};
+
+// SPECIALIZATION
+// --------------
+
+template <typename Array, typename T>
+struct is_relocatable<memmap_array_iterator<Array, T>>: true_type
+{};
+
+// DEFINITION
+// ----------
+
+// MEMMAP ARRAY ITERATOR
+
+
+template <typename A, typename T>
+memmap_array_iterator<A, T>::memmap_array_iterator(A* array, size_t index) noexcept:
+    array_(array),
+    index_(index)
+{}
+
+
+template <typename A, typename T>
+bool memmap_array_iterator<A, T>::operator==(const self_t& rhs) const noexcept
+{
+    return index_ == rhs.index_;
+}
+
+
+template <typename A, typename T>
+bool memmap_array_iterator<A, T>::operator!=(const self_t& rhs) const noexcept
+{
+    return index_ != rhs.index_;
+}
+
+
+template <typename A, typename T>
+bool memmap_array_iterator<A, T>::operator<(const self_t& rhs) const noexcept
+{
+    return index_ < rhs.index_;
+}
+
+
+template <typename A, typename T>
+bool memmap_array_iterator<A, T>::operator<=(const self_t& rhs) const noexcept
+{
+    return index_ <= rhs.index_;
+}
+
+
+template <typename A, typename T>
+bool memmap_array_iterator<A, T>::operator>(const self_t& rhs) const noexcept
+{
+    return index_ > rhs.index_;
+}
+
+
+template <typename A, typename T>
+bool memmap_array_iterator<A, T>::operator>=(const self_t& rhs) const noexcept
+{
+    return index_ >= rhs.index_;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator++() noexcept -> self_t&
+{
+    ++index_;
+    return *this;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator++(int) noexcept -> self_t
+{
+    self_t copy(*this);
+    operator++();
+    return copy;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator--() noexcept -> self_t&
+{
+    --index_;
+    return *this;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator--(int) noexcept -> self_t
+{
+    self_t copy(*this);
+    operator--();
+    return copy;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator+=(difference_type n) noexcept -> self_t&
+{
+    index_ += n;
+    return *this;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator-=(difference_type n) noexcept -> self_t&
+{
+    index_ -= n;
+    return *this;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator+(difference_type n) const noexcept -> self_t
+{
+    self_t copy(*this);
+    copy += n;
+    return copy;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator-(difference_type n) const noexcept -> self_t
+{
+    self_t copy(*this);
+    copy -= n;
+    return copy;
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator-(const self_t& rhs) const noexcept -> difference_type
+{
+    return static_cast<difference_type>(index_) - static_cast<difference_type>(rhs.index_);
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator[](difference_type n) const -> reference
+{
+    return (*array_)[index_ + n];
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator*() const -> reference
+{
+    return (*array_)[index_];
+}
+
+
+template <typename A, typename T>
+auto memmap_array_iterator<A, T>::operator->() const -> pointer
+{
+    return &(*array_)[index_];
+}
+
+
+template <typename A, typename T>
+size_t memmap_array_iterator<A, T>::index() const noexcept
+{
+    return index_;
+}
+
+
+template <typename A, typename T>
+void memmap_array_iterator<A, T>::swap(self_t& rhs) noexcept
+{
+    using PYCPP_NAMESPACE::swap;
+    swap(array_, rhs.array_);
+    swap(index_, rhs.index_);
+}
+
+
+template <typename A, typename T>
+memmap_array_iterator<A, T> operator+(ptrdiff_t n, const memmap_array_iterator<A, T>& it) noexcept
+{
+    return it + n;
+}
+
+// MEMMAP ARRAY
 
-// FUNCTIONS
-// ---------
 
-// TODO: this should be a NumPy-style array, so it can
-// be a matrix....
-// TODO: how do I estimate the blocksize then???
+template <typename T>
+memmap_array<T>::memmap_array()
+{}
+
+
+template <typename T>
+memmap_array<T>::~memmap_array()
+{
+    close();
+}
+
+
+template <typename T>
+memmap_array<T>::memmap_array(self_t&& rhs)
+{
+    swap(rhs);
+}
+
+
+template <typename T>
+auto memmap_array<T>::operator=(self_t&& rhs) -> self_t&
+{
+    close();
+    swap(rhs);
+    return *this;
+}
+
+
+template <typename T>
+memmap_array<T>::memmap_array(const path_view_t& path, size_t window_size, int cache_size)
+{
+    open(path, window_size, cache_size);
+}
+
+
+template <typename T>
+void memmap_array<T>::open(const path_view_t& path, size_t window_size, int cache_size)
+{
+    close();
+    if (cache_size < 1) {
+        throw filesystem_error(filesystem_invalid_parameter);
+    }
+
+    fd_ = fd_open(path, ios_base::in | ios_base::out);
+    if (fd_ == INVALID_FD_VALUE) {
+        throw filesystem_error(filesystem_file_not_found);
+    }
+
+    // the smallest window holding whole elements at mappable offsets
+    size_t step = MEMMAP_WINDOW_GRANULARITY;
+    while (step % sizeof(T) != 0) {
+        step += MEMMAP_WINDOW_GRANULARITY;
+    }
+
+    window_bytes_ = max(step, (window_size + step - 1) / step * step);
+    window_length_ = window_bytes_ / sizeof(T);
+    size_ = static_cast<size_t>(fd_seek(fd_, 0, ios_base::end)) / sizeof(T);
+    cache_ = cache_type(cache_size);
+}
+
+
+template <typename T>
+auto memmap_array<T>::begin() noexcept -> iterator
+{
+    return iterator(this, 0);
+}
+
+
+template <typename T>
+auto memmap_array<T>::begin() const noexcept -> const_iterator
+{
+    return const_iterator(this, 0);
+}
+
+
+template <typename T>
+auto memmap_array<T>::cbegin() const noexcept -> const_iterator
+{
+    return begin();
+}
+
+
+template <typename T>
+auto memmap_array<T>::end() noexcept -> iterator
+{
+    return iterator(this, size_);
+}
+
+
+template <typename T>
+auto memmap_array<T>::end() const noexcept -> const_iterator
+{
+    return const_iterator(this, size_);
+}
+
+
+template <typename T>
+auto memmap_array<T>::cend() const noexcept -> const_iterator
+{
+    return end();
+}
+
+
+template <typename T>
+auto memmap_array<T>::rbegin() noexcept -> reverse_iterator
+{
+    return reverse_iterator(end());
+}
+
+
+template <typename T>
+auto memmap_array<T>::rbegin() const noexcept -> const_reverse_iterator
+{
+    return const_reverse_iterator(end());
+}
+
+
+template <typename T>
+auto memmap_array<T>::crbegin() const noexcept -> const_reverse_iterator
+{
+    return rbegin();
+}
+
+
+template <typename T>
+auto memmap_array<T>::rend() noexcept -> reverse_iterator
+{
+    return reverse_iterator(begin());
+}
+
+
+template <typename T>
+auto memmap_array<T>::rend() const noexcept -> const_reverse_iterator
+{
+    return const_reverse_iterator(begin());
+}
+
+
+template <typename T>
+auto memmap_array<T>::crend() const noexcept -> const_reverse_iterator
+{
+    return rend();
+}
+
+
+template <typename T>
+auto memmap_array<T>::size() const noexcept -> size_type
+{
+    return size_;
+}
+
+
+template <typename T>
+bool memmap_array<T>::empty() const noexcept
+{
+    return size_ == 0;
+}
+
+
+template <typename T>
+auto memmap_array<T>::window_size() const noexcept -> size_type
+{
+    return window_bytes_;
+}
+
+
+template <typename T>
+void memmap_array<T>::resize(size_type size)
+{
+    if (fd_ == INVALID_FD_VALUE) {
+        throw filesystem_error(filesystem_file_descriptor_not_open);
+    }
+
+    // the trailing window is mapped with a partial length
+    reset_cache();
+    if (fd_truncate(fd_, static_cast<streamsize>(size * sizeof(T))) != 0) {
+        throw filesystem_error(filesystem_unexpected_error);
+    }
+    size_ = size;
+}
+
+
+template <typename T>
+auto memmap_array<T>::operator[](size_type index) -> reference
+{
+    char* data = window(index / window_length_);
+    return reinterpret_cast<pointer>(data)[index % window_length_];
+}
+
+
+template <typename T>
+auto memmap_array<T>::operator[](size_type index) const -> const_reference
+{
+    char* data = window(index / window_length_);
+    return reinterpret_cast<const_pointer>(data)[index % window_length_];
+}
+
+
+template <typename T>
+auto memmap_array<T>::at(size_type index) -> reference
+{
+    if (index >= size_) {
+        throw out_of_range("memmap_array::at(): index out of range.");
+    }
+    return operator[](index);
+}
+
+
+template <typename T>
+auto memmap_array<T>::at(size_type index) const -> const_reference
+{
+    if (index >= size_) {
+        throw out_of_range("memmap_array::at(): index out of range.");
+    }
+    return operator[](index);
+}
+
+
+template <typename T>
+auto memmap_array<T>::front() -> reference
+{
+    return operator[](0);
+}
+
+
+template <typename T>
+auto memmap_array<T>::front() const -> const_reference
+{
+    return operator[](0);
+}
+
+
+template <typename T>
+auto memmap_array<T>::back() -> reference
+{
+    return operator[](size_ - 1);
+}
+
+
+template <typename T>
+auto memmap_array<T>::back() const -> const_reference
+{
+    return operator[](size_ - 1);
+}
+
+
+template <typename T>
+void memmap_array<T>::read(size_type first, T* dst, size_type count) const
+{
+    if (first > size_ || count > size_ - first) {
+        throw out_of_range("memmap_array::read(): range out of bounds.");
+    }
+
+    while (count) {
+        size_t offset = first % window_length_;
+        size_t n = min(count, window_length_ - offset);
+        const char* data = window(first / window_length_);
+        memcpy(dst, data + offset * sizeof(T), n * sizeof(T));
+        first += n;
+        dst += n;
+        count -= n;
+    }
+}
+
+
+template <typename T>
+void memmap_array<T>::write(size_type first, const T* src, size_type count)
+{
+    if (first > size_ || count > size_ - first) {
+        throw out_of_range("memmap_array::write(): range out of bounds.");
+    }
+
+    while (count) {
+        size_t offset = first % window_length_;
+        size_t n = min(count, window_length_ - offset);
+        char* data = window(first / window_length_);
+        memcpy(data + offset * sizeof(T), src, n * sizeof(T));
+        first += n;
+        src += n;
+        count -= n;
+    }
+}
+
+
+template <typename T>
+bool memmap_array<T>::is_open() const
+{
+    return fd_ != INVALID_FD_VALUE;
+}
+
+
+template <typename T>
+void memmap_array<T>::flush(bool async)
+{
+    for (window_ptr& view: cache_) {
+        view->flush(async);
+    }
+}
+
+
+template <typename T>
+void memmap_array<T>::close()
+{
+    reset_cache();
+    if (fd_ != INVALID_FD_VALUE) {
+        fd_close(fd_);
+        fd_ = INVALID_FD_VALUE;
+    }
+    size_ = 0;
+}
+
+
+template <typename T>
+void memmap_array<T>::swap(self_t& rhs)
+{
+    using PYCPP_NAMESPACE::swap;
+    swap(fd_, rhs.fd_);
+    swap(size_, rhs.size_);
+    swap(window_bytes_, rhs.window_bytes_);
+    swap(window_length_, rhs.window_length_);
+    swap(cache_, rhs.cache_);
+    swap(last_index_, rhs.last_index_);
+    swap(last_data_, rhs.last_data_);
+}
+
+
+/**
+ *  \brief Get the mapped window at `index`, mapping it if required.
+ *
+ *  The last window accessed is always the most-recently used
+ *  item in the cache, so it is checked before the cache lookup.
+ */
+template <typename T>
+char* memmap_array<T>::window(size_t index) const
+{
+    if (last_data_ && index == last_index_) {
+        return last_data_;
+    }
+
+    auto it = cache_.find(index);
+    if (it == cache_.end()) {
+        size_t offset = index * window_bytes_;
+        size_t bytes = size_ * sizeof(T);
+        if (offset >= bytes) {
+            throw filesystem_error(filesystem_seek_offset_beyond_file);
+        }
+
+        window_ptr view = make_shared<mmap_view>(fd_, offset, min(window_bytes_, bytes - offset));
+        if (!view->has_mapping()) {
+            throw filesystem_error(filesystem_out_of_memory);
+        }
+        it = cache_.insert(index, move(view)).first;
+    }
+
+    last_index_ = index;
+    last_data_ = (*it)->data();
+    return last_data_;
+}
+
+
+template <typename T>
+void memmap_array<T>::reset_cache()
+{
+    cache_.clear();
+    last_data_ = nullptr;
+}
 
 PYCPP_END_NAMESPACE
+
+#endif                                                  // MMAP
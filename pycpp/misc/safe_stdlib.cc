@@ -2,9 +2,14 @@
 //  :license: MIT, see licenses/mit.md for more details.
 
 #include <pycpp/misc/safe_stdlib.h>
+#include <pycpp/preprocessor/os.h>
 #include <pycpp/stl/new.h>
 #include <pycpp/stl/stdexcept.h>
+#include <stdint.h>
 #include <stdlib.h>
+#if defined(OS_WINDOWS)
+#   include <malloc.h>
+#endif
 
 PYCPP_BEGIN_NAMESPACE
 
@@ -48,4 +53,63 @@ void safe_free(void* ptr) noexcept
     free(ptr);
 }
 
+
+#if defined(OS_WINDOWS)                         // WINDOWS
+
+void* safe_aligned_malloc(size_t size, size_t alignment)
+{
+    void* ptr = _aligned_malloc(size, alignment);
+    if (ptr == nullptr) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+
+void safe_aligned_free(void* ptr) noexcept
+{
+    _aligned_free(ptr);
+}
+
+#elif defined(HAVE_POSIX_MEMALIGN)              // POSIX_MEMALIGN
+
+void* safe_aligned_malloc(size_t size, size_t alignment)
+{
+    void* ptr;
+    alignment = alignment < sizeof(void*) ? sizeof(void*) : alignment;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+
+void safe_aligned_free(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+#else                                           // MALLOC
+
+void* safe_aligned_malloc(size_t size, size_t alignment)
+{
+    // over-allocate, and store the original pointer before the aligned block
+    char* base = static_cast<char*>(safe_malloc(size + alignment + sizeof(void*)));
+    uintptr_t address = reinterpret_cast<uintptr_t>(base + sizeof(void*));
+    address = (address + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    void** ptr = reinterpret_cast<void**>(address);
+    ptr[-1] = base;
+    return ptr;
+}
+
+
+void safe_aligned_free(void* ptr) noexcept
+{
+    if (ptr) {
+        free(static_cast<void**>(ptr)[-1]);
+    }
+}
+
+#endif                                          // WINDOWS
+
 PYCPP_END_NAMESPACE
@@ -35,4 +35,17 @@ void* safe_calloc(size_t num, size_t size);
  */
 void safe_free(void* ptr) noexcept;
 
+/**
+ *  \brief Allocate memory aligned to `alignment`, a power of 2.
+ *
+ *  Throws bad_alloc if memory cannot be allocated. The memory
+ *  must be released with `safe_aligned_free`.
+ */
+void* safe_aligned_malloc(size_t size, size_t alignment);
+
+/**
+ *  \brief Free memory from `safe_aligned_malloc`.
+ */
+void safe_aligned_free(void* ptr) noexcept;
+
 PYCPP_END_NAMESPACE
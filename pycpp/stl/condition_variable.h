@@ -0,0 +1,23 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief <condition_variable> aliases.
+ */
+
+#pragma once
+
+#include <pycpp/config.h>
+#include <condition_variable>
+
+PYCPP_BEGIN_NAMESPACE
+
+// ALIASES
+// -------
+
+using std::condition_variable;
+using std::condition_variable_any;
+using std::cv_status;
+using std::notify_all_at_thread_exit;
+
+PYCPP_END_NAMESPACE
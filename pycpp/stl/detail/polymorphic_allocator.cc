@@ -4,7 +4,10 @@
 
 #include <pycpp/stl/detail/polymorphic_allocator.h>
 #if defined(PYCPP_DEFINE_POLYMORPHIC_ALLOCATOR)
+#   include <pycpp/preprocessor/compiler.h>
+#   include <pycpp/preprocessor/tls.h>
 #   include <limits>
+#   include <thread>
 #endif
 
 
@@ -201,6 +204,727 @@ bool memory_resource::is_equal(const memory_resource& rhs) const noexcept
 }
 
 
+// POOLS
+// -----
+
+namespace polymorphic_detail
+{
+// CONSTANTS
+
+static constexpr size_t MAX_ALIGN = alignof(std::max_align_t);
+static constexpr size_t MIN_BLOCK_SIZE = sizeof(void*);
+static constexpr size_t DEFAULT_LARGEST_BLOCK = 4096;
+static constexpr size_t MAX_LARGEST_BLOCK = size_t(1) << 20;
+static constexpr size_t DEFAULT_BLOCKS_PER_CHUNK = 1024;
+static constexpr size_t MAX_BLOCKS_PER_CHUNK = size_t(1) << 16;
+static constexpr size_t INITIAL_CHUNK_SIZE = 4096;
+static constexpr size_t DEFAULT_MONOTONIC_SIZE = 1024;
+static constexpr size_t MAX_SHARDS = 64;
+
+// HELPERS
+
+
+/**
+ *  \brief Floor of the base-2 logarithm of a non-zero value.
+ */
+static inline size_t floor_log2(size_t n) noexcept
+{
+#if defined(HAVE_GNUC)
+    return sizeof(unsigned long long) * 8 - 1 - static_cast<size_t>(__builtin_clzll(static_cast<unsigned long long>(n)));
+#else
+    size_t i = 0;
+    while (n >>= 1) {
+        ++i;
+    }
+    return i;
+#endif
+}
+
+
+/**
+ *  \brief Round a non-zero value up to the nearest power of 2.
+ */
+static inline size_t ceil2(size_t n) noexcept
+{
+    return n <= 1 ? 1 : size_t(2) << floor_log2(n - 1);
+}
+
+
+static pool_options normalize(const pool_options& options) noexcept
+{
+    pool_options o = options;
+    if (o.max_blocks_per_chunk == 0) {
+        o.max_blocks_per_chunk = DEFAULT_BLOCKS_PER_CHUNK;
+    } else if (o.max_blocks_per_chunk > MAX_BLOCKS_PER_CHUNK) {
+        o.max_blocks_per_chunk = MAX_BLOCKS_PER_CHUNK;
+    }
+
+    if (o.largest_required_pool_block == 0) {
+        o.largest_required_pool_block = DEFAULT_LARGEST_BLOCK;
+    } else if (o.largest_required_pool_block > MAX_LARGEST_BLOCK) {
+        o.largest_required_pool_block = MAX_LARGEST_BLOCK;
+    } else if (o.largest_required_pool_block < MIN_BLOCK_SIZE) {
+        o.largest_required_pool_block = MIN_BLOCK_SIZE;
+    }
+    o.largest_required_pool_block = ceil2(o.largest_required_pool_block);
+
+    return o;
+}
+
+
+/**
+ *  \brief Unique, dense identifier for the calling thread.
+ */
+static size_t thread_index() noexcept
+{
+    static std::atomic<size_t> counter(0);
+    static thread_local_storage size_t index = 0;
+    if (index == 0) {
+        index = counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    return index - 1;
+}
+
+// POOL SET
+
+struct pool_set::chunk
+{
+    chunk* next;
+    size_t size;
+};
+
+static constexpr size_t CHUNK_OFFSET = (sizeof(void*) * 2 + MAX_ALIGN - 1) & ~(MAX_ALIGN - 1);
+
+
+pool_set::pool_set(const pool_options& options, memory_resource* upstream) noexcept:
+    upstream_(upstream),
+    options_(normalize(options)),
+    count_(floor_log2(options_.largest_required_pool_block) - floor_log2(MIN_BLOCK_SIZE) + 1)
+{}
+
+
+pool_set::~pool_set() noexcept
+{
+    release();
+}
+
+
+/**
+ *  \brief Find the pool serving a request, or `npos` if it is too large.
+ */
+size_t pool_set::find(size_t n, size_t alignment) const noexcept
+{
+    if (alignment > MAX_ALIGN || n > options_.largest_required_pool_block) {
+        return npos;
+    }
+
+    size_t size = n > alignment ? n : alignment;
+    if (size <= MIN_BLOCK_SIZE) {
+        return 0;
+    }
+    return floor_log2(size - 1) + 1 - floor_log2(MIN_BLOCK_SIZE);
+}
+
+
+void* pool_set::allocate(size_t index)
+{
+    pool& p = pools_[index];
+    if (p.free) {
+        void* block = p.free;
+        p.free = *static_cast<void**>(block);
+        return block;
+    }
+
+    if (p.next == p.end) {
+        grow(index);
+    }
+    void* block = p.next;
+    p.next += MIN_BLOCK_SIZE << index;
+
+    return block;
+}
+
+
+void pool_set::deallocate(void* block, size_t index) noexcept
+{
+    pool& p = pools_[index];
+    *static_cast<void**>(block) = p.free;
+    p.free = block;
+}
+
+
+/**
+ *  \brief Check if a pool can allocate without growing.
+ */
+bool pool_set::available(size_t index) const noexcept
+{
+    const pool& p = pools_[index];
+    return p.free || p.next != p.end;
+}
+
+
+/**
+ *  \brief Detach and return the free list of a pool.
+ */
+void* pool_set::take(size_t index) noexcept
+{
+    void* list = pools_[index].free;
+    pools_[index].free = nullptr;
+    return list;
+}
+
+
+/**
+ *  \brief Prepend a free list detached from another pool set.
+ */
+void pool_set::give(void* list, size_t index) noexcept
+{
+    if (!list) {
+        return;
+    }
+
+    void* last = list;
+    while (*static_cast<void**>(last)) {
+        last = *static_cast<void**>(last);
+    }
+    pool& p = pools_[index];
+    *static_cast<void**>(last) = p.free;
+    p.free = list;
+}
+
+
+/**
+ *  \brief Allocate a new chunk for a pool, twice as large as the last.
+ */
+void pool_set::grow(size_t index)
+{
+    pool& p = pools_[index];
+    size_t block_size = MIN_BLOCK_SIZE << index;
+    size_t blocks;
+    if (p.blocks == 0) {
+        blocks = block_size < INITIAL_CHUNK_SIZE ? INITIAL_CHUNK_SIZE / block_size : 1;
+    } else {
+        blocks = p.blocks * 2;
+    }
+    if (blocks > options_.max_blocks_per_chunk) {
+        blocks = options_.max_blocks_per_chunk;
+    }
+
+    size_t size = CHUNK_OFFSET + blocks * block_size;
+    chunk* c = static_cast<chunk*>(upstream_->allocate(size, MAX_ALIGN));
+    c->next = chunks_;
+    c->size = size;
+    chunks_ = c;
+
+    p.next = reinterpret_cast<byte*>(c) + CHUNK_OFFSET;
+    p.end = p.next + blocks * block_size;
+    p.blocks = blocks;
+}
+
+
+void pool_set::release() noexcept
+{
+    while (chunks_) {
+        chunk* next = chunks_->next;
+        upstream_->deallocate(chunks_, chunks_->size, MAX_ALIGN);
+        chunks_ = next;
+    }
+    for (size_t i = 0; i < count_; ++i) {
+        pools_[i] = pool();
+    }
+}
+
+
+const pool_options& pool_set::options() const noexcept
+{
+    return options_;
+}
+
+// OVERSIZED LIST
+
+struct oversized_list::header
+{
+    header* prev;
+    header* next;
+    void* base;
+    size_t size;
+};
+
+static constexpr size_t OVERSIZED_OFFSET = (sizeof(void*) * 3 + sizeof(size_t) + MAX_ALIGN - 1) & ~(MAX_ALIGN - 1);
+
+
+oversized_list::oversized_list(memory_resource* upstream) noexcept:
+    upstream_(upstream)
+{}
+
+
+oversized_list::~oversized_list() noexcept
+{
+    release();
+}
+
+
+/**
+ *  \brief Allocate from upstream, with the header before the block.
+ *
+ *  The upstream resource need not honor extended alignments, so
+ *  the request is padded by the alignment, and aligned here.
+ */
+void* oversized_list::allocate(size_t n, size_t alignment)
+{
+    if (alignment < MAX_ALIGN) {
+        alignment = MAX_ALIGN;
+    }
+    size_t offset = OVERSIZED_OFFSET + alignment - MAX_ALIGN;
+    if (n > max_size(offset)) {
+        throw std::bad_alloc();
+    }
+
+    void* base = upstream_->allocate(n + offset, MAX_ALIGN);
+    uintptr_t address = reinterpret_cast<uintptr_t>(base) + OVERSIZED_OFFSET;
+    byte* p = reinterpret_cast<byte*>(aligned_allocation_size(address, alignment));
+    header* h = reinterpret_cast<header*>(p) - 1;
+    h->prev = nullptr;
+    h->next = head_;
+    h->base = base;
+    h->size = n + offset;
+    if (head_) {
+        head_->prev = h;
+    }
+    head_ = h;
+
+    return p;
+}
+
+
+void oversized_list::deallocate(void* p, size_t, size_t) noexcept
+{
+    header* h = static_cast<header*>(p) - 1;
+    if (h->prev) {
+        h->prev->next = h->next;
+    } else {
+        head_ = h->next;
+    }
+    if (h->next) {
+        h->next->prev = h->prev;
+    }
+    free(h);
+}
+
+
+void oversized_list::release() noexcept
+{
+    while (head_) {
+        header* next = head_->next;
+        free(head_);
+        head_ = next;
+    }
+}
+
+
+void oversized_list::free(header* h) noexcept
+{
+    upstream_->deallocate(h->base, h->size, MAX_ALIGN);
+}
+
+// LOCKED RESOURCE
+
+
+locked_resource::locked_resource(memory_resource* upstream, std::mutex& mutex) noexcept:
+    upstream_(upstream),
+    mutex_(&mutex)
+{}
+
+
+void* locked_resource::do_allocate(size_t n, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(*mutex_);
+    return upstream_->allocate(n, alignment);
+}
+
+
+void locked_resource::do_deallocate(void* p, size_t n, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(*mutex_);
+    upstream_->deallocate(p, n, alignment);
+}
+
+
+bool locked_resource::do_is_equal(const memory_resource& rhs) const noexcept
+{
+    return this == &rhs;
+}
+
+// POOL SHARD
+
+
+pool_shard::pool_shard(const pool_options& options, memory_resource* upstream) noexcept:
+    pools(options, upstream)
+{}
+
+}   /* polymorphic_detail */
+
+// MONOTONIC BUFFER RESOURCE
+
+struct monotonic_buffer_resource::chunk
+{
+    chunk* next;
+    size_t size;
+};
+
+
+monotonic_buffer_resource::monotonic_buffer_resource():
+    monotonic_buffer_resource(get_default_resource())
+{}
+
+
+monotonic_buffer_resource::monotonic_buffer_resource(memory_resource* upstream):
+    monotonic_buffer_resource(polymorphic_detail::DEFAULT_MONOTONIC_SIZE, upstream)
+{}
+
+
+monotonic_buffer_resource::monotonic_buffer_resource(size_t initial_size):
+    monotonic_buffer_resource(initial_size, get_default_resource())
+{}
+
+
+monotonic_buffer_resource::monotonic_buffer_resource(size_t initial_size, memory_resource* upstream):
+    upstream_(upstream),
+    buffer_(nullptr),
+    buffer_size_(0),
+    initial_size_(initial_size ? initial_size : polymorphic_detail::DEFAULT_MONOTONIC_SIZE),
+    next_size_(initial_size_),
+    current_(nullptr),
+    space_(0)
+{}
+
+
+monotonic_buffer_resource::monotonic_buffer_resource(void* buffer, size_t buffer_size):
+    monotonic_buffer_resource(buffer, buffer_size, get_default_resource())
+{}
+
+
+monotonic_buffer_resource::monotonic_buffer_resource(void* buffer, size_t buffer_size, memory_resource* upstream):
+    upstream_(upstream),
+    buffer_(buffer),
+    buffer_size_(buffer_size),
+    initial_size_(buffer_size > polymorphic_detail::DEFAULT_MONOTONIC_SIZE / 2 ? buffer_size * 2 : polymorphic_detail::DEFAULT_MONOTONIC_SIZE),
+    next_size_(initial_size_),
+    current_(buffer),
+    space_(buffer_size)
+{}
+
+
+monotonic_buffer_resource::~monotonic_buffer_resource()
+{
+    release();
+}
+
+
+void* monotonic_buffer_resource::do_allocate(size_t n, size_t alignment)
+{
+    if (!std::align(alignment, n, current_, space_)) {
+        grow(n, alignment);
+        std::align(alignment, n, current_, space_);
+    }
+
+    void* p = current_;
+    current_ = static_cast<byte*>(current_) + n;
+    space_ -= n;
+
+    return p;
+}
+
+
+void monotonic_buffer_resource::do_deallocate(void*, size_t, size_t)
+{}
+
+
+bool monotonic_buffer_resource::do_is_equal(const memory_resource& rhs) const noexcept
+{
+    return this == &rhs;
+}
+
+
+/**
+ *  \brief Allocate a buffer fitting `n` bytes at `alignment`.
+ */
+void monotonic_buffer_resource::grow(size_t n, size_t alignment)
+{
+    using namespace polymorphic_detail;
+
+    if (n > max_size(CHUNK_OFFSET + alignment)) {
+        throw std::bad_alloc();
+    }
+    size_t size = n + alignment > next_size_ ? n + alignment : next_size_;
+    chunk* c = static_cast<chunk*>(upstream_->allocate(CHUNK_OFFSET + size, MAX_ALIGN));
+    c->next = chunks_;
+    c->size = CHUNK_OFFSET + size;
+    chunks_ = c;
+
+    current_ = reinterpret_cast<byte*>(c) + CHUNK_OFFSET;
+    space_ = size;
+    if (size <= std::numeric_limits<size_t>::max() / 2) {
+        next_size_ = size * 2;
+    }
+}
+
+
+/**
+ *  \brief Free all buffers from the upstream resource, and reuse the initial buffer.
+ */
+void monotonic_buffer_resource::release() noexcept
+{
+    while (chunks_) {
+        chunk* next = chunks_->next;
+        upstream_->deallocate(chunks_, chunks_->size, polymorphic_detail::MAX_ALIGN);
+        chunks_ = next;
+    }
+    current_ = buffer_;
+    space_ = buffer_size_;
+    next_size_ = initial_size_;
+}
+
+
+memory_resource* monotonic_buffer_resource::upstream_resource() const noexcept
+{
+    return upstream_;
+}
+
+// UNSYNCHRONIZED POOL RESOURCE
+
+
+unsynchronized_pool_resource::unsynchronized_pool_resource():
+    unsynchronized_pool_resource(pool_options(), get_default_resource())
+{}
+
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(memory_resource* upstream):
+    unsynchronized_pool_resource(pool_options(), upstream)
+{}
+
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(const pool_options& options):
+    unsynchronized_pool_resource(options, get_default_resource())
+{}
+
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(const pool_options& options, memory_resource* upstream):
+    upstream_(upstream),
+    pools_(options, upstream),
+    oversized_(upstream)
+{}
+
+
+unsynchronized_pool_resource::~unsynchronized_pool_resource()
+{}
+
+
+void* unsynchronized_pool_resource::do_allocate(size_t n, size_t alignment)
+{
+    size_t index = pools_.find(n, alignment);
+    if (index == polymorphic_detail::pool_set::npos) {
+        return oversized_.allocate(n, alignment);
+    }
+    return pools_.allocate(index);
+}
+
+
+void unsynchronized_pool_resource::do_deallocate(void* p, size_t n, size_t alignment)
+{
+    size_t index = pools_.find(n, alignment);
+    if (index == polymorphic_detail::pool_set::npos) {
+        oversized_.deallocate(p, n, alignment);
+    } else {
+        pools_.deallocate(p, index);
+    }
+}
+
+
+bool unsynchronized_pool_resource::do_is_equal(const memory_resource& rhs) const noexcept
+{
+    return this == &rhs;
+}
+
+
+/**
+ *  \brief Free all memory from the upstream resource.
+ */
+void unsynchronized_pool_resource::release() noexcept
+{
+    pools_.release();
+    oversized_.release();
+}
+
+
+memory_resource* unsynchronized_pool_resource::upstream_resource() const noexcept
+{
+    return upstream_;
+}
+
+
+pool_options unsynchronized_pool_resource::options() const noexcept
+{
+    return pools_.options();
+}
+
+// SYNCHRONIZED POOL RESOURCE
+
+
+synchronized_pool_resource::synchronized_pool_resource():
+    synchronized_pool_resource(pool_options(), get_default_resource())
+{}
+
+
+synchronized_pool_resource::synchronized_pool_resource(memory_resource* upstream):
+    synchronized_pool_resource(pool_options(), upstream)
+{}
+
+
+synchronized_pool_resource::synchronized_pool_resource(const pool_options& options):
+    synchronized_pool_resource(options, get_default_resource())
+{}
+
+
+/**
+ *  \brief Create a shard per hardware thread.
+ */
+synchronized_pool_resource::synchronized_pool_resource(const pool_options& options, memory_resource* upstream):
+    upstream_(upstream),
+    locked_(upstream, mutex_),
+    oversized_(upstream)
+{
+    using polymorphic_detail::pool_shard;
+
+    size_t count = std::thread::hardware_concurrency();
+    if (count == 0) {
+        count = 1;
+    } else if (count > polymorphic_detail::MAX_SHARDS) {
+        count = polymorphic_detail::MAX_SHARDS;
+    }
+
+    shards_ = static_cast<pool_shard*>(operator new(count * sizeof(pool_shard)));
+    for (shard_count_ = 0; shard_count_ < count; ++shard_count_) {
+        new (shards_ + shard_count_) pool_shard(options, &locked_);
+    }
+}
+
+
+synchronized_pool_resource::~synchronized_pool_resource()
+{
+    using polymorphic_detail::pool_shard;
+
+    for (size_t i = 0; i < shard_count_; ++i) {
+        shards_[i].~pool_shard();
+    }
+    operator delete(shards_);
+}
+
+
+auto synchronized_pool_resource::shard() noexcept -> polymorphic_detail::pool_shard&
+{
+    return shards_[polymorphic_detail::thread_index() % shard_count_];
+}
+
+
+void* synchronized_pool_resource::do_allocate(size_t n, size_t alignment)
+{
+    polymorphic_detail::pool_shard& s = shard();
+    size_t index = s.pools.find(n, alignment);
+    if (index == polymorphic_detail::pool_set::npos) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return oversized_.allocate(n, alignment);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.pools.available(index)) {
+            return s.pools.allocate(index);
+        }
+    }
+
+    void* list = reclaim(s, index);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.pools.give(list, index);
+    return s.pools.allocate(index);
+}
+
+
+/**
+ *  \brief Take the blocks of a size class freed into another shard.
+ *
+ *  Blocks join the shard of the thread freeing them, so a thread
+ *  that only allocates would otherwise keep growing while the
+ *  blocks it hands off pile up elsewhere. Called before growing,
+ *  so upstream memory is bounded by the peak of live blocks.
+ */
+void* synchronized_pool_resource::reclaim(polymorphic_detail::pool_shard& s, size_t index) noexcept
+{
+    for (size_t i = 0; i < shard_count_; ++i) {
+        polymorphic_detail::pool_shard& other = shards_[i];
+        if (&other == &s) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(other.mutex);
+        void* list = other.pools.take(index);
+        if (list) {
+            return list;
+        }
+    }
+
+    return nullptr;
+}
+
+
+void synchronized_pool_resource::do_deallocate(void* p, size_t n, size_t alignment)
+{
+    polymorphic_detail::pool_shard& s = shard();
+    size_t index = s.pools.find(n, alignment);
+    if (index == polymorphic_detail::pool_set::npos) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        oversized_.deallocate(p, n, alignment);
+    } else {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.pools.deallocate(p, index);
+    }
+}
+
+
+bool synchronized_pool_resource::do_is_equal(const memory_resource& rhs) const noexcept
+{
+    return this == &rhs;
+}
+
+
+/**
+ *  \brief Free all memory from the upstream resource.
+ *
+ *  Must not be called concurrently with allocation.
+ */
+void synchronized_pool_resource::release() noexcept
+{
+    for (size_t i = 0; i < shard_count_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        shards_[i].pools.release();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    oversized_.release();
+}
+
+
+memory_resource* synchronized_pool_resource::upstream_resource() const noexcept
+{
+    return upstream_;
+}
+
+
+pool_options synchronized_pool_resource::options() const noexcept
+{
+    return shards_[0].pools.options();
+}
+
+
 #endif                                      // PYCPP_DEFINE_POLYMORPHIC_ALLOCATOR
 
 PYCPP_END_NAMESPACE
@@ -47,6 +47,51 @@
  *          typename std::allocator_traits<Allocator>::template rebind_alloc<byte>
  *      >;
  *
+ *      struct pool_options
+ *      {
+ *          size_t max_blocks_per_chunk = 0;
+ *          size_t largest_required_pool_block = 0;
+ *      };
+ *
+ *      class monotonic_buffer_resource: public memory_resource
+ *      {
+ *      public:
+ *          monotonic_buffer_resource();
+ *          explicit monotonic_buffer_resource(memory_resource* upstream);
+ *          explicit monotonic_buffer_resource(size_t initial_size);
+ *          monotonic_buffer_resource(size_t initial_size, memory_resource* upstream);
+ *          monotonic_buffer_resource(void* buffer, size_t buffer_size);
+ *          monotonic_buffer_resource(void* buffer, size_t buffer_size, memory_resource* upstream);
+ *          monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+ *          monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+ *          ~monotonic_buffer_resource();
+ *
+ *          void release() noexcept;
+ *          memory_resource* upstream_resource() const noexcept;
+ *      };
+ *
+ *      class unsynchronized_pool_resource: public memory_resource
+ *      {
+ *      public:
+ *          unsynchronized_pool_resource();
+ *          explicit unsynchronized_pool_resource(memory_resource* upstream);
+ *          explicit unsynchronized_pool_resource(const pool_options& options);
+ *          unsynchronized_pool_resource(const pool_options& options, memory_resource* upstream);
+ *          unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+ *          unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+ *          ~unsynchronized_pool_resource();
+ *
+ *          void release() noexcept;
+ *          memory_resource* upstream_resource() const noexcept;
+ *          pool_options options() const noexcept;
+ *      };
+ *
+ *      class synchronized_pool_resource: public memory_resource
+ *      {
+ *      public:
+ *          // same interface as unsynchronized_pool_resource
+ *      };
+ *
  *      template <typename T>
  *      struct polymorphic_allocator
  *      {
@@ -74,6 +119,7 @@
 #   include <atomic>
 #   include <limits>
 #   include <memory>
+#   include <mutex>
 #   include <new>
 #   include <stdexcept>
 #   include <type_traits>
@@ -444,10 +490,277 @@ private:
     memory_resource* resource_;
 };
 
-// TODO: implement pool_options
-// TODO: implement synchronized_pool_resource
-// TODO: implement unsynchronized_pool_resource
-// TODO: implement monotonic_buffer_resource
+// POOL OPTIONS
+
+/**
+ *  \brief Options to configure the pool resources.
+ *
+ *  Zero values select implementation-defined defaults, and values
+ *  above the implementation limits are clamped to the limits.
+ */
+struct pool_options
+{
+    size_t max_blocks_per_chunk = 0;
+    size_t largest_required_pool_block = 0;
+};
+
+namespace polymorphic_detail
+{
+// POOL SET
+
+/**
+ *  \brief Power-of-2 size-class pools carving blocks from upstream chunks.
+ *
+ *  Each pool bumps blocks from its current chunk, and reuses freed
+ *  blocks from an intrusive free list. Chunks grow geometrically, up
+ *  to `max_blocks_per_chunk` blocks, and are only returned to the
+ *  upstream resource on `release()`.
+ */
+class pool_set
+{
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    pool_set(const pool_set&) = delete;
+    pool_set& operator=(const pool_set&) = delete;
+    pool_set(const pool_options& options, memory_resource* upstream) noexcept;
+    ~pool_set() noexcept;
+
+    size_t find(size_t n, size_t alignment) const noexcept;
+    void* allocate(size_t index);
+    void deallocate(void* p, size_t index) noexcept;
+    bool available(size_t index) const noexcept;
+    void* take(size_t index) noexcept;
+    void give(void* list, size_t index) noexcept;
+    void release() noexcept;
+    const pool_options& options() const noexcept;
+
+private:
+    struct chunk;
+    struct pool
+    {
+        void* free = nullptr;
+        byte* next = nullptr;
+        byte* end = nullptr;
+        size_t blocks = 0;
+    };
+
+    memory_resource* upstream_;
+    pool_options options_;
+    size_t count_;
+    chunk* chunks_ = nullptr;
+    pool pools_[sizeof(size_t) * 8];
+
+    void grow(size_t index);
+};
+
+// OVERSIZED LIST
+
+/**
+ *  \brief Tracks requests too large for the pools, to free on `release()`.
+ */
+class oversized_list
+{
+public:
+    oversized_list(const oversized_list&) = delete;
+    oversized_list& operator=(const oversized_list&) = delete;
+    oversized_list(memory_resource* upstream) noexcept;
+    ~oversized_list() noexcept;
+
+    void* allocate(size_t n, size_t alignment);
+    void deallocate(void* p, size_t n, size_t alignment) noexcept;
+    void release() noexcept;
+
+private:
+    struct header;
+
+    memory_resource* upstream_;
+    header* head_ = nullptr;
+
+    void free(header* h) noexcept;
+};
+
+// LOCKED RESOURCE
+
+/**
+ *  \brief Serializes calls to an upstream resource.
+ */
+class locked_resource: public memory_resource
+{
+public:
+    locked_resource(memory_resource* upstream, std::mutex& mutex) noexcept;
+
+protected:
+    virtual void* do_allocate(size_t n, size_t alignment) override;
+    virtual void do_deallocate(void* p, size_t n, size_t alignment) override;
+    virtual bool do_is_equal(const memory_resource& rhs) const noexcept override;
+
+private:
+    memory_resource* upstream_;
+    std::mutex* mutex_;
+};
+
+// POOL SHARD
+
+/**
+ *  \brief Pools and lock owned by a subset of threads.
+ */
+struct pool_shard
+{
+    std::mutex mutex;
+    pool_set pools;
+
+    pool_shard(const pool_options& options, memory_resource* upstream) noexcept;
+};
+
+}   /* polymorphic_detail */
+
+// MONOTONIC BUFFER RESOURCE
+
+/**
+ *  \brief Resource bumping allocations from a growing list of buffers.
+ *
+ *  Deallocation is a no-op, and memory is only returned to the
+ *  upstream resource on `release()` or destruction. The initial
+ *  buffer, if provided, is never freed, and each buffer allocated
+ *  from the upstream resource is twice as large as the last.
+ */
+class monotonic_buffer_resource: public memory_resource
+{
+public:
+    // MEMBER FUNCTIONS
+    // ----------------
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    monotonic_buffer_resource();
+    explicit monotonic_buffer_resource(memory_resource* upstream);
+    explicit monotonic_buffer_resource(size_t initial_size);
+    monotonic_buffer_resource(size_t initial_size, memory_resource* upstream);
+    monotonic_buffer_resource(void* buffer, size_t buffer_size);
+    monotonic_buffer_resource(void* buffer, size_t buffer_size, memory_resource* upstream);
+    ~monotonic_buffer_resource();
+
+    // PROPERTIES
+
+    void release() noexcept;
+    memory_resource* upstream_resource() const noexcept;
+
+protected:
+    // MEMORY TRAITS
+
+    virtual void* do_allocate(size_t n, size_t alignment) override;
+    virtual void do_deallocate(void* p, size_t n, size_t alignment) override;
+    virtual bool do_is_equal(const memory_resource& rhs) const noexcept override;
+
+private:
+    struct chunk;
+
+    memory_resource* upstream_;
+    void* buffer_;
+    size_t buffer_size_;
+    size_t initial_size_;
+    size_t next_size_;
+    void* current_;
+    size_t space_;
+    chunk* chunks_ = nullptr;
+
+    void grow(size_t n, size_t alignment);
+};
+
+// UNSYNCHRONIZED POOL RESOURCE
+
+/**
+ *  \brief Pooled resource for use from a single thread.
+ *
+ *  Requests up to `largest_required_pool_block` bytes are served
+ *  from power-of-2 size-class pools, and larger requests, or
+ *  requests aligned beyond `max_align_t`, from the upstream resource.
+ */
+class unsynchronized_pool_resource: public memory_resource
+{
+public:
+    // MEMBER FUNCTIONS
+    // ----------------
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+    unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+    unsynchronized_pool_resource();
+    explicit unsynchronized_pool_resource(memory_resource* upstream);
+    explicit unsynchronized_pool_resource(const pool_options& options);
+    unsynchronized_pool_resource(const pool_options& options, memory_resource* upstream);
+    ~unsynchronized_pool_resource();
+
+    // PROPERTIES
+
+    void release() noexcept;
+    memory_resource* upstream_resource() const noexcept;
+    pool_options options() const noexcept;
+
+protected:
+    // MEMORY TRAITS
+
+    virtual void* do_allocate(size_t n, size_t alignment) override;
+    virtual void do_deallocate(void* p, size_t n, size_t alignment) override;
+    virtual bool do_is_equal(const memory_resource& rhs) const noexcept override;
+
+private:
+    memory_resource* upstream_;
+    polymorphic_detail::pool_set pools_;
+    polymorphic_detail::oversized_list oversized_;
+};
+
+// SYNCHRONIZED POOL RESOURCE
+
+/**
+ *  \brief Pooled resource for concurrent use from many threads.
+ *
+ *  Rather than guard a single set of pools with a global mutex,
+ *  the pools are sharded by thread, so threads only contend when
+ *  they share a shard. Blocks freed by another thread join the
+ *  freeing thread's shard, and a shard reclaims them before growing,
+ *  so producer and consumer threads do not leak. Memory is returned
+ *  to the upstream resource only on `release()` or destruction.
+ *  Calls to the upstream resource are serialized.
+ */
+class synchronized_pool_resource: public memory_resource
+{
+public:
+    // MEMBER FUNCTIONS
+    // ----------------
+    synchronized_pool_resource(const synchronized_pool_resource&) = delete;
+    synchronized_pool_resource& operator=(const synchronized_pool_resource&) = delete;
+
+    synchronized_pool_resource();
+    explicit synchronized_pool_resource(memory_resource* upstream);
+    explicit synchronized_pool_resource(const pool_options& options);
+    synchronized_pool_resource(const pool_options& options, memory_resource* upstream);
+    ~synchronized_pool_resource();
+
+    // PROPERTIES
+
+    void release() noexcept;
+    memory_resource* upstream_resource() const noexcept;
+    pool_options options() const noexcept;
+
+protected:
+    // MEMORY TRAITS
+
+    virtual void* do_allocate(size_t n, size_t alignment) override;
+    virtual void do_deallocate(void* p, size_t n, size_t alignment) override;
+    virtual bool do_is_equal(const memory_resource& rhs) const noexcept override;
+
+private:
+    memory_resource* upstream_;
+    std::mutex mutex_;
+    polymorphic_detail::locked_resource locked_;
+    polymorphic_detail::oversized_list oversized_;
+    polymorphic_detail::pool_shard* shards_;
+    size_t shard_count_;
+
+    polymorphic_detail::pool_shard& shard() noexcept;
+    void* reclaim(polymorphic_detail::pool_shard& s, size_t index) noexcept;
+};
 
 // SPECIALIZATION
 // --------------
@@ -464,10 +777,21 @@ template <typename T>
 struct is_relocatable<polymorphic_allocator<T>>: std::true_type
 {};
 
-// TODO: specialize pool_options
-// TODO: specialize synchronized_pool_resource
-// TODO: specialize unsynchronized_pool_resource
-// TODO: specialize monotonic_buffer_resource
+template <>
+struct is_relocatable<pool_options>: std::true_type
+{};
+
+template <>
+struct is_relocatable<synchronized_pool_resource>: std::false_type
+{};
+
+template <>
+struct is_relocatable<unsynchronized_pool_resource>: std::false_type
+{};
+
+template <>
+struct is_relocatable<monotonic_buffer_resource>: std::false_type
+{};
 
 // IMPLEMENTATION
 // --------------
@@ -186,13 +186,15 @@ using std::make_unique;
 #else                       // CPP11
 
 template <typename T, typename ... Ts >
-unique_ptr<T> make_unique(Ts&&... ts)
+enable_if_t<!is_array<T>::value, unique_ptr<T>>
+make_unique(Ts&&... ts)
 {
     return unique_ptr<T>(new T(std::forward<Ts>(ts)...));
 }
 
 template <typename T>
-unique_ptr<T> make_unique(size_t size)
+enable_if_t<is_array<T>::value, unique_ptr<T>>
+make_unique(size_t size)
 {
     using type = remove_extent_t<T>;
     return unique_ptr<T>(new type[size]);
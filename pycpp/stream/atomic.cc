@@ -0,0 +1,443 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/tmp.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/future.h>
+#include <pycpp/stl/system_error.h>
+#include <pycpp/stl/utility.h>
+#include <pycpp/stream/atomic.h>
+
+#if defined(OS_WINDOWS)          // WINDOWS NT
+#   include <pycpp/windows/winapi.h>
+#else                           // POSIX
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+#if defined(OS_LINUX)           // LINUX
+#   include <sys/syscall.h>
+#endif
+
+#if defined(SYS_renameat2) && !defined(RENAME_NOREPLACE)
+#   define RENAME_NOREPLACE (1 << 0)
+#endif
+
+PYCPP_BEGIN_NAMESPACE
+
+// OBJECTS
+// -------
+
+/**
+ *  \brief Pending commit of a temporary file.
+ */
+struct fsync_request
+{
+    fd_t fd = INVALID_FD_VALUE;
+    path_t temporary;
+    path_t path;
+    bool replace = true;
+    bool done = false;
+    bool result = false;
+};
+
+// HELPERS
+// -------
+
+
+static path_t containing_directory(const path_t& path)
+{
+    path_view_t dir = dir_name(path);
+    return dir.empty() ? path_t(path_prefix(".")) : path_t(dir);
+}
+
+
+#if defined(OS_WINDOWS)                     // WINDOWS
+
+static fd_t open_temporary(const path_t& path, path_t& name)
+{
+    path_t dir = containing_directory(path);
+    path_t prefix = path_prefix(".") + path_t(base_name(path)) + path_prefix(".");
+    for (size_t i = 0; i < TMP_MAX_PATHS; ++i) {
+        name = gettempnam(dir, prefix);
+        auto file = reinterpret_cast<const wchar_t*>(name.data());
+        fd_t fd = CreateFileW(file, GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fd != INVALID_FD_VALUE) {
+            return fd;
+        } else if (GetLastError() != ERROR_FILE_EXISTS) {
+            break;
+        }
+    }
+
+    name.clear();
+    return INVALID_FD_VALUE;
+}
+
+
+static bool rename_file(const path_t& src, const path_t& dst, bool replace)
+{
+    // write-through makes the rename durable, without a directory flush
+    DWORD flags = MOVEFILE_WRITE_THROUGH;
+    if (replace) {
+        flags |= MOVEFILE_REPLACE_EXISTING;
+    }
+    auto from = reinterpret_cast<const wchar_t*>(src.data());
+    auto to = reinterpret_cast<const wchar_t*>(dst.data());
+    return ::MoveFileExW(from, to, flags) != 0;
+}
+
+
+static void sync_data(vector<fsync_request*>& batch)
+{
+    for (fsync_request* request: batch) {
+        request->result = fd_sync(request->fd) == 0;
+    }
+}
+
+
+static void sync_directories(vector<fsync_request*>&)
+{}
+
+#else                                       // POSIX
+
+static fd_t open_temporary(const path_t& path, path_t& name)
+{
+    path_t dir = containing_directory(path);
+    path_t prefix = path_prefix(".") + path_t(base_name(path)) + path_prefix(".");
+    int flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    for (size_t i = 0; i < TMP_MAX_PATHS; ++i) {
+        name = gettempnam(dir, prefix);
+        fd_t fd = ::open(name.data(), flags, S_IWR_USR_GRP);
+        if (fd != INVALID_FD_VALUE) {
+            // keep the permissions of a replaced file
+            struct stat sb;
+            if (::stat(path.data(), &sb) == 0) {
+                ::fchmod(fd, sb.st_mode & 07777);
+            }
+            return fd;
+        } else if (errno != EEXIST) {
+            break;
+        }
+    }
+
+    name.clear();
+    return INVALID_FD_VALUE;
+}
+
+
+static bool rename_file(const path_t& src, const path_t& dst, bool replace)
+{
+    if (replace) {
+        return ::rename(src.data(), dst.data()) == 0;
+    }
+
+#if defined(SYS_renameat2)
+    if (::syscall(SYS_renameat2, AT_FDCWD, src.data(), AT_FDCWD, dst.data(), RENAME_NOREPLACE) == 0) {
+        return true;
+    } else if (errno != ENOSYS && errno != EINVAL) {
+        return false;
+    }
+#endif
+
+    // the kernel or filesystem does not support renameat2,
+    // and a hard link fails if the destination exists
+    if (::link(src.data(), dst.data()) != 0) {
+        return false;
+    }
+    ::unlink(src.data());
+    return true;
+}
+
+
+static void sync_data(vector<fsync_request*>& batch)
+{
+    // flush each file, so writeback errors are reported per file,
+    // overlapping the flushes of a batch
+    vector<future<bool>> pending;
+    pending.reserve(batch.size());
+    for (size_t i = 1; i < batch.size(); ++i) {
+        fd_t fd = batch[i]->fd;
+        try {
+            pending.emplace_back(async(launch::async, [fd]() {
+                return fd_sync(fd) == 0;
+            }));
+        } catch (system_error&) {
+            pending.emplace_back(async(launch::deferred, [fd]() {
+                return fd_sync(fd) == 0;
+            }));
+        }
+    }
+
+    if (!batch.empty()) {
+        batch.front()->result = fd_sync(batch.front()->fd) == 0;
+    }
+    for (size_t i = 1; i < batch.size(); ++i) {
+        batch[i]->result = pending[i-1].get();
+    }
+}
+
+
+static bool sync_directory(const path_t& dir)
+{
+    int fd = ::open(dir.data(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    bool result = ::fsync(fd) == 0;
+    ::close(fd);
+
+    return result;
+}
+
+
+static void sync_directories(vector<fsync_request*>& batch)
+{
+    // flush each directory once, after every rename
+    path_list_t directories;
+    for (fsync_request* request: batch) {
+        if (request->result) {
+            path_t dir = containing_directory(request->path);
+            if (find(directories.begin(), directories.end(), dir) == directories.end()) {
+                directories.push_back(dir);
+            }
+        }
+    }
+
+    for (const path_t& dir: directories) {
+        if (!sync_directory(dir)) {
+            for (fsync_request* request: batch) {
+                if (containing_directory(request->path) == dir) {
+                    request->result = false;
+                }
+            }
+        }
+    }
+}
+
+#endif                                      // WINDOWS
+
+
+/**
+ *  \brief Flush the data, rename, and flush the directories for a batch.
+ */
+static void commit_batch(vector<fsync_request*>& batch)
+{
+    sync_data(batch);
+    for (fsync_request* request: batch) {
+        fd_close(request->fd);
+        request->fd = INVALID_FD_VALUE;
+        if (request->result) {
+            request->result = rename_file(request->temporary, request->path, request->replace);
+        }
+        if (!request->result) {
+            remove_file(request->temporary);
+        }
+    }
+    sync_directories(batch);
+}
+
+// OBJECTS
+// -------
+
+// FSYNC GROUP
+
+/**
+ *  \brief Finish a batch, even if the commit throws.
+ *
+ *  Requests of a batch that throws are completed as failed,
+ *  so queued writers never wait on a batch that never ends.
+ */
+struct fsync_group::sync_guard
+{
+    fsync_group& group;
+    unique_lock<mutex>& lock;
+    vector<fsync_request*>& batch;
+
+    sync_guard(fsync_group& g, unique_lock<mutex>& l, vector<fsync_request*>& b):
+        group(g),
+        lock(l),
+        batch(b)
+    {}
+
+    ~sync_guard()
+    {
+        lock.lock();
+        for (fsync_request* item: batch) {
+            item->done = true;
+        }
+        group.syncing_ = false;
+        group.done_.notify_all();
+    }
+};
+
+
+fsync_group::fsync_group()
+{}
+
+
+size_t fsync_group::batches() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return batches_;
+}
+
+
+bool fsync_group::commit(fsync_request& request)
+{
+    unique_lock<mutex> lock(mutex_);
+    queue_.push_back(&request);
+    while (!request.done) {
+        if (syncing_) {
+            done_.wait(lock);
+            continue;
+        }
+
+        // lead the next batch, with every request queued so far
+        vector<fsync_request*> batch;
+        batch.swap(queue_);
+        syncing_ = true;
+        ++batches_;
+        lock.unlock();
+        sync_guard guard(*this, lock, batch);
+        commit_batch(batch);
+    }
+
+    return request.result;
+}
+
+// ATOMIC OFSTREAM
+
+
+atomic_ofstream::atomic_ofstream():
+    buffer(ios_base::out, INVALID_FD_VALUE),
+    ostream(&buffer)
+{}
+
+
+atomic_ofstream::~atomic_ofstream()
+{
+    discard();
+}
+
+
+atomic_ofstream::atomic_ofstream(atomic_ofstream&& rhs):
+    atomic_ofstream()
+{
+    swap(rhs);
+}
+
+
+atomic_ofstream & atomic_ofstream::operator=(atomic_ofstream&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+atomic_ofstream::atomic_ofstream(const path_view_t& name, bool replace, size_t buffer_size):
+    buffer(ios_base::out, INVALID_FD_VALUE, buffer_size),
+    ostream(&buffer)
+{
+    open(name, replace);
+}
+
+
+void atomic_ofstream::open(const path_view_t& name, bool replace)
+{
+    discard();
+    path_ = path_t(name);
+    replace_ = replace;
+    buffer.fd(open_temporary(path_, temporary_));
+    if (!is_open()) {
+        setstate(ios_base::failbit);
+    }
+}
+
+
+bool atomic_ofstream::commit()
+{
+    fsync_request request;
+    if (!prepare(request)) {
+        return false;
+    }
+
+    vector<fsync_request*> batch = {&request};
+    commit_batch(batch);
+    return request.result;
+}
+
+
+bool atomic_ofstream::commit(fsync_group& group)
+{
+    fsync_request request;
+    if (!prepare(request)) {
+        return false;
+    }
+
+    return group.commit(request);
+}
+
+
+void atomic_ofstream::discard()
+{
+    if (is_open()) {
+        fd_t fd = buffer.fd();
+        buffer.fd(INVALID_FD_VALUE);
+        fd_close(fd);
+        remove_file(temporary_);
+    }
+    temporary_.clear();
+}
+
+
+bool atomic_ofstream::is_open() const
+{
+    return buffer.is_open();
+}
+
+
+const path_t& atomic_ofstream::path() const
+{
+    return path_;
+}
+
+
+void atomic_ofstream::swap(atomic_ofstream& rhs)
+{
+    using PYCPP_NAMESPACE::swap;
+    ostream::swap(rhs);
+    swap(buffer, rhs.buffer);
+    swap(path_, rhs.path_);
+    swap(temporary_, rhs.temporary_);
+    swap(replace_, rhs.replace_);
+}
+
+
+/**
+ *  \brief Write any buffered data, and hand the descriptor to the request.
+ */
+bool atomic_ofstream::prepare(fsync_request& request)
+{
+    if (!is_open()) {
+        return false;
+    }
+
+    flush();
+    if (!good()) {
+        discard();
+        return false;
+    }
+
+    request.fd = buffer.fd();
+    request.temporary = PYCPP_NAMESPACE::move(temporary_);
+    request.path = path_;
+    request.replace = replace_;
+    buffer.fd(INVALID_FD_VALUE);
+    temporary_.clear();
+
+    return true;
+}
+
+PYCPP_END_NAMESPACE
@@ -0,0 +1,129 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+/**
+ *  \addtogroup PyCPP
+ *  \brief Atomic, durable file replacement.
+ *
+ *  `atomic_ofstream` writes to a temporary file in the destination
+ *  directory, and `commit()` flushes the data to the device, renames
+ *  the temporary file over the destination, and flushes the directory.
+ *  Readers see the old or the new contents, never a partial file,
+ *  and the new contents survive a crash once `commit()` returns.
+ *  Streams destroyed without committing remove the temporary file.
+ *
+ *  Committing through an `fsync_group` lets concurrent writers
+ *  share the flushes: the first writer to commit flushes its file,
+ *  while writers committing in the meantime queue behind it, and the
+ *  next writer flushes the whole queue at once. A batch flushes its
+ *  files concurrently, and each directory once, rather than once
+ *  per file.
+ *
+ *  Write errors, including short writes, fail the commit and
+ *  remove the temporary file, leaving the destination untouched.
+ *
+ *  \synopsis
+ *      class fsync_group
+ *      {
+ *      public:
+ *          fsync_group();
+ *          size_t batches() const;
+ *      };
+ *
+ *      class atomic_ofstream: public ostream
+ *      {
+ *      public:
+ *          atomic_ofstream();
+ *          atomic_ofstream(const path_view_t& name, bool replace = true, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+ *          void open(const path_view_t& name, bool replace = true);
+ *
+ *          bool commit();
+ *          bool commit(fsync_group& group);
+ *          void discard();
+ *
+ *          bool is_open() const;
+ *          const path_t& path() const;
+ *          void swap(atomic_ofstream& other);
+ *      };
+ */
+
+#pragma once
+
+#include <pycpp/filesystem/path.h>
+#include <pycpp/stl/condition_variable.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/vector.h>
+#include <pycpp/stream/fd.h>
+
+PYCPP_BEGIN_NAMESPACE
+
+// FORWARD
+// -------
+
+struct fsync_request;
+
+// OBJECTS
+// -------
+
+
+/**
+ *  \brief Shared flush barrier for concurrent atomic writers.
+ */
+class fsync_group
+{
+public:
+    fsync_group();
+    fsync_group(const fsync_group&) = delete;
+    fsync_group& operator=(const fsync_group&) = delete;
+
+    // PROPERTIES
+    size_t batches() const;
+
+private:
+    friend class atomic_ofstream;
+    struct sync_guard;
+    bool commit(fsync_request& request);
+
+    mutable mutex mutex_;
+    condition_variable done_;
+    vector<fsync_request*> queue_;
+    bool syncing_ = false;
+    size_t batches_ = 0;
+};
+
+
+/**
+ *  \brief Output stream atomically replacing a file on commit.
+ */
+class atomic_ofstream: public ostream
+{
+public:
+    atomic_ofstream();
+    ~atomic_ofstream();
+    atomic_ofstream(const atomic_ofstream&) = delete;
+    atomic_ofstream & operator=(const atomic_ofstream&) = delete;
+    atomic_ofstream(atomic_ofstream &&other);
+    atomic_ofstream & operator=(atomic_ofstream &&other);
+
+    atomic_ofstream(const path_view_t& name, bool replace = true, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    void open(const path_view_t& name, bool replace = true);
+
+    // COMMIT
+    bool commit();
+    bool commit(fsync_group& group);
+    void discard();
+
+    // DATA
+    bool is_open() const;
+    const path_t& path() const;
+    void swap(atomic_ofstream &other);
+
+private:
+    bool prepare(fsync_request& request);
+
+    fd_streambuf buffer;
+    path_t path_;
+    path_t temporary_;
+    bool replace_ = true;
+};
+
+PYCPP_END_NAMESPACE
@@ -2,7 +2,11 @@
 //  :license: MIT, see licenses/mit.md for more details.
 
 #include <pycpp/filesystem.h>
+#include <pycpp/misc/safe_stdlib.h>
+#include <pycpp/stl/algorithm.h>
 #include <pycpp/stream/fd.h>
+#include <errno.h>
+#include <stddef.h>
 #if !defined(OS_WINDOWS)
 #   include <unistd.h>
 #endif
@@ -15,6 +19,37 @@ PYCPP_BEGIN_NAMESPACE
 
 size_t DEFAULT_BUFFER_SIZE = 4096;
 
+// HELPERS
+// -------
+
+
+static streamsize read_eintr(fd_t fd, void* data, size_t length)
+{
+    streamsize read;
+    do {
+        read = fd_read(fd, data, length);
+    } while (read == -1 && errno == EINTR);
+
+    return read;
+}
+
+
+static streamsize write_eintr(fd_t fd, const void* data, size_t length)
+{
+    streamsize wrote;
+    do {
+        wrote = fd_write(fd, data, length);
+    } while (wrote == -1 && errno == EINTR);
+
+    return wrote;
+}
+
+
+static size_t align_direct(size_t size)
+{
+    return (size + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+}
+
 // OBJECTS
 // -------
 
@@ -23,8 +58,9 @@ size_t DEFAULT_BUFFER_SIZE = 4096;
 
 fd_streambuf::fd_streambuf(ios_base::openmode mode, fd_t fd):
     mode(mode),
-    fd_(fd),
-    buffer_size(DEFAULT_BUFFER_SIZE)
+    buffer_size_(DEFAULT_BUFFER_SIZE),
+    initial_size_(DEFAULT_BUFFER_SIZE),
+    fd_(fd)
 {
     initialize_buffers();
 }
@@ -32,8 +68,9 @@ fd_streambuf::fd_streambuf(ios_base::openmode mode, fd_t fd):
 
 fd_streambuf::fd_streambuf(ios_base::openmode mode, fd_t fd, size_t buffer_size):
     mode(mode),
-    fd_(fd),
-    buffer_size(buffer_size)
+    buffer_size_(max<size_t>(buffer_size, 1)),
+    initial_size_(buffer_size_),
+    fd_(fd)
 {
     initialize_buffers();
 }
@@ -41,8 +78,11 @@ fd_streambuf::fd_streambuf(ios_base::openmode mode, fd_t fd, size_t buffer_size)
 
 fd_streambuf::~fd_streambuf()
 {
-    delete[] in_first;
-    delete[] out_first;
+    // the engine may still be writing to the prefetch buffer
+    wait_prefetch();
+    safe_aligned_free(in_first);
+    safe_aligned_free(ahead_);
+    safe_aligned_free(out_first);
 }
 
 
@@ -62,6 +102,8 @@ fd_streambuf& fd_streambuf::operator=(fd_streambuf&& rhs)
 void fd_streambuf::close()
 {
     sync();
+    write_tail();
+    wait_prefetch();
 }
 
 
@@ -76,12 +118,20 @@ void fd_streambuf::swap(fd_streambuf& rhs)
     using PYCPP_NAMESPACE::swap;
 
     swap(mode, rhs.mode);
-    swap(buffer_size, rhs.buffer_size);
+    swap(buffer_size_, rhs.buffer_size_);
+    swap(initial_size_, rhs.initial_size_);
+    swap(adaptive_, rhs.adaptive_);
+    swap(direct_, rhs.direct_);
+    swap(sequential_, rhs.sequential_);
     swap(fd_, rhs.fd_);
     swap(in_first, rhs.in_first);
     swap(in_last, rhs.in_last);
     swap(out_first, rhs.out_first);
     swap(out_last, rhs.out_last);
+    swap(engine_, rhs.engine_);
+    swap(ahead_, rhs.ahead_);
+    swap(pending_, rhs.pending_);
+    swap(position_, rhs.position_);
     streambuf::swap(rhs);
 }
 
@@ -92,12 +142,15 @@ auto fd_streambuf::underflow() -> int_type
         return traits_type::eof();
     }
 
+    if (engine_) {
+        return underflow_prefetch();
+    }
+
     streamsize read;
     if (fd_ != INVALID_FD_VALUE) {
+        adapt_buffers();
         set_readp();
-        do {
-            read = fd_read(fd_, in_first, buffer_size);
-        } while (read == -1 && errno == EINTR);
+        read = read_block(in_first, buffer_size_);
         if (read == 0 || read == -1) {
             // 0 indicates EOF, -1 indicates error.
             return traits_type::eof();
@@ -120,11 +173,16 @@ auto fd_streambuf::overflow(int_type c) -> int_type
     if (fd_ != INVALID_FD_VALUE) {
         set_writep();
         dist = distance(out_first, out_last);
-        if (dist == buffer_size) {
-            do {
-                wrote = fd_write(fd_, out_first, dist);
-            } while (wrote == -1 && errno == EINTR);
+        if (dist == buffer_size_) {
+            wrote = write_block(out_first, dist);
             out_last = out_first;
+            if (wrote != dist) {
+                return traits_type::eof();
+            }
+            if (adaptive_) {
+                adapt_buffers();
+                set_writep();
+            }
         }
 
         if (!traits_type::eq_int_type(c, traits_type::eof())) {
@@ -143,11 +201,16 @@ int fd_streambuf::sync()
     streamsize dist, wrote;
     if (fd_ != INVALID_FD_VALUE && mode & ios_base::out) {
         dist = distance(out_first, out_last);
+        if (direct_) {
+            // direct I/O only writes whole blocks, keep the tail
+            dist -= dist % DIRECT_IO_ALIGNMENT;
+        }
         if (dist > 0) {
-            do {
-                wrote = fd_write(fd_, out_first, dist);
-            } while (wrote == -1 && errno == EINTR);
-            out_last = out_first;
+            wrote = write_block(out_first, dist);
+            out_last = copy(out_first + dist, out_last, out_first);
+            if (wrote != dist) {
+                return -1;
+            }
         }
     }
 
@@ -160,12 +223,37 @@ int fd_streambuf::sync()
 
 auto fd_streambuf::seekoff(off_type off, ios_base::seekdir way, ios_base::openmode) -> pos_type
 {
+    if (engine_) {
+        return seekoff_prefetch(off, way);
+    }
+
+    // the file offset is past any unread input, and before any pending output
+    off_type unread = 0;
+    if (in_first && eback() == in_first) {
+        unread = distance(gptr(), egptr());
+    }
+    if (way == ios_base::cur && off == 0) {
+        off_type current = fd_seek(fd_, 0, ios_base::cur);
+        if (current < 0) {
+            return pos_type(off_type(-1));
+        }
+        return current - unread + distance(out_first, out_last);
+    }
+
+    discard_buffers();
+    if (way == ios_base::cur) {
+        off -= unread;
+    }
     return fd_seek(fd_, off, way);
 }
 
 
 auto fd_streambuf::seekpos(pos_type pos, ios_base::openmode) -> pos_type
 {
+    if (engine_) {
+        return seekoff_prefetch(pos, ios_base::beg);
+    }
+    discard_buffers();
     return fd_seek(fd_, pos);
 }
 
@@ -180,16 +268,110 @@ void fd_streambuf::fd(fd_t fd)
 {
     close();
     fd_ = fd;
+    if (direct_ && fd_ != INVALID_FD_VALUE) {
+        fd_direct(fd_, true);
+    }
+    if (engine_) {
+        setg(0, 0, 0);
+        position_ = fd_ != INVALID_FD_VALUE ? max<streamoff>(fd_tell(fd_), 0) : 0;
+    }
+}
+
+
+void fd_streambuf::prefetch(aio_engine* engine)
+{
+    if (mode & ios_base::out || engine == engine_) {
+        return;
+    }
+
+    wait_prefetch();
+    if (engine_ && !engine) {
+        // restore the file offset to the logical position
+        if (fd_ != INVALID_FD_VALUE) {
+            fd_seek(fd_, position_ - distance(gptr(), egptr()));
+        }
+        setg(0, 0, 0);
+    } else if (!engine_) {
+        // any buffered data ends at the file offset
+        position_ = fd_ != INVALID_FD_VALUE ? max<streamoff>(fd_tell(fd_), 0) : 0;
+        if (!ahead_) {
+            ahead_ = allocate_buffer();
+        }
+    }
+    engine_ = engine;
+}
+
+
+aio_engine* fd_streambuf::prefetch() const
+{
+    return engine_;
+}
+
+
+void fd_streambuf::adaptive(bool enabled)
+{
+    adaptive_ = enabled;
+    sequential_ = 0;
+}
+
+
+bool fd_streambuf::adaptive() const
+{
+    return adaptive_;
+}
+
+
+void fd_streambuf::direct(bool enabled)
+{
+    if (enabled == direct_) {
+        return;
+    }
+
+    if (enabled) {
+        // move the file offset to the logical position, and
+        // reallocate aligned buffers
+        if (fd_ != INVALID_FD_VALUE) {
+            pos_type position = seekoff(0, ios_base::cur);
+            if (position != pos_type(off_type(-1))) {
+                seekpos(position);
+            }
+        }
+        direct_ = true;
+        initial_size_ = align_direct(initial_size_);
+        resize_buffers(align_direct(buffer_size_));
+        if (fd_ != INVALID_FD_VALUE) {
+            fd_direct(fd_, true);
+        }
+    } else {
+        sync();
+        write_tail();
+        direct_ = false;
+        if (fd_ != INVALID_FD_VALUE) {
+            fd_direct(fd_, false);
+        }
+    }
+}
+
+
+bool fd_streambuf::direct() const
+{
+    return direct_;
+}
+
+
+size_t fd_streambuf::buffer_size() const
+{
+    return buffer_size_;
 }
 
 
 void fd_streambuf::initialize_buffers()
 {
     if (mode & ios_base::in) {
-        in_first = new char_type[buffer_size];
+        in_first = allocate_buffer();
     }
     if (mode & ios_base::out) {
-        out_first = new char_type[buffer_size];
+        out_first = allocate_buffer();
         out_last = out_first;
     }
 
@@ -198,20 +380,223 @@ void fd_streambuf::initialize_buffers()
 }
 
 
+auto fd_streambuf::allocate_buffer() const -> char_type*
+{
+    size_t alignment = direct_ ? DIRECT_IO_ALIGNMENT : alignof(std::max_align_t);
+    return static_cast<char_type*>(safe_aligned_malloc(buffer_size_, alignment));
+}
+
+
+void fd_streambuf::resize_buffers(size_t size)
+{
+    // any buffered data must be consumed or written first
+    wait_prefetch();
+    buffer_size_ = size;
+    if (in_first) {
+        safe_aligned_free(in_first);
+        in_first = allocate_buffer();
+        in_last = in_first;
+    }
+    if (out_first) {
+        safe_aligned_free(out_first);
+        out_first = allocate_buffer();
+        out_last = out_first;
+    }
+    safe_aligned_free(ahead_);
+    ahead_ = engine_ ? allocate_buffer() : nullptr;
+    setg(0, 0, 0);
+    setp(0, 0);
+}
+
+
+auto fd_streambuf::read_block(char_type* data, size_t length) -> streamsize
+{
+    streamsize read = read_eintr(fd_, data, length);
+    if (read == -1 && errno == EINVAL && direct_) {
+        // unaligned offset, or no direct I/O support: use the page cache
+        fd_direct(fd_, false);
+        read = read_eintr(fd_, data, length);
+    }
+
+    return read;
+}
+
+
+/**
+ *  \brief Write the whole block, returning -1 on an error or short write.
+ */
+auto fd_streambuf::write_block(const char_type* data, size_t length) -> streamsize
+{
+    size_t offset = 0;
+    while (offset < length) {
+        streamsize wrote = write_eintr(fd_, data + offset, length - offset);
+        if (wrote == -1 && errno == EINVAL && direct_) {
+            // unaligned offset, or no direct I/O support: use the page cache
+            fd_direct(fd_, false);
+            wrote = write_eintr(fd_, data + offset, length - offset);
+        }
+        if (wrote <= 0) {
+            return -1;
+        }
+        offset += static_cast<size_t>(wrote);
+    }
+
+    return static_cast<streamsize>(length);
+}
+
+
+void fd_streambuf::write_tail()
+{
+    if (!direct_ || fd_ == INVALID_FD_VALUE || out_last == out_first) {
+        return;
+    }
+
+    // direct I/O cannot write a partial block, use the page cache
+    fd_direct(fd_, false);
+    write_eintr(fd_, out_first, distance(out_first, out_last));
+    out_last = out_first;
+    fd_direct(fd_, true);
+}
+
+
 void fd_streambuf::set_readp()
 {
-    setp(in_first, in_first + buffer_size);
+    setp(in_first, in_first + buffer_size_);
     setg(0, 0, 0);
 }
 
 
 void fd_streambuf::set_writep()
 {
-    setg(out_first, out_first, out_first + buffer_size);
+    setg(out_first, out_first, out_first + buffer_size_);
     setp(0, 0);
 }
 
 
+void fd_streambuf::discard_buffers()
+{
+    // write pending output, and drop unread input, before a seek
+    if (out_first && out_last != out_first) {
+        sync();
+        write_tail();
+    }
+    setg(0, 0, 0);
+    setp(0, 0);
+    sequential_ = 0;
+}
+
+
+void fd_streambuf::adapt_buffers()
+{
+    // prefetching reads into two fixed-size buffers
+    if (!adaptive_ || engine_) {
+        return;
+    }
+
+    // double the buffer after each run of sequential blocks, and
+    // restore the initial size after a seek
+    size_t size = buffer_size_;
+    if (sequential_ == 0) {
+        size = initial_size_;
+    } else if (sequential_ % ADAPTIVE_BUFFER_STEP == 0) {
+        size = max(buffer_size_, min(2 * buffer_size_, ADAPTIVE_BUFFER_MAX));
+    }
+    ++sequential_;
+
+    // pending output must be written first
+    if (size == buffer_size_ || out_last != out_first) {
+        return;
+    }
+
+    resize_buffers(size);
+}
+
+
+void fd_streambuf::wait_prefetch()
+{
+    if (pending_.valid()) {
+        pending_.get();
+    }
+}
+
+
+auto fd_streambuf::underflow_prefetch() -> int_type
+{
+    if (fd_ == INVALID_FD_VALUE) {
+        return traits_type::eof();
+    }
+
+    // use the prefetched block, or read synchronously after a seek
+    streamsize read;
+    if (pending_.valid()) {
+        read = pending_.get();
+        PYCPP_NAMESPACE::swap(in_first, ahead_);
+    } else {
+        future<streamsize> result = engine_->read(fd_, in_first, buffer_size_, position_);
+        engine_->submit();
+        read = result.get();
+    }
+    if (read == -EINVAL && direct_) {
+        // unaligned offset, or no direct I/O support: use the page cache
+        fd_direct(fd_, false);
+        future<streamsize> result = engine_->read(fd_, in_first, buffer_size_, position_);
+        engine_->submit();
+        read = result.get();
+    }
+    if (read <= 0) {
+        // 0 indicates EOF, -errno indicates error.
+        setg(0, 0, 0);
+        return traits_type::eof();
+    }
+
+    position_ += read;
+    in_last = in_first + read;
+    setg(in_first, in_first, in_last);
+
+    // a short read is likely EOF, so only prefetch after a full block
+    if (static_cast<size_t>(read) == buffer_size_) {
+        pending_ = engine_->read(fd_, ahead_, buffer_size_, position_);
+        engine_->submit();
+    }
+
+    return traits_type::to_int_type(*gptr());
+}
+
+
+auto fd_streambuf::seekoff_prefetch(off_type off, ios_base::seekdir way) -> pos_type
+{
+    // the logical position excludes unread and prefetched data
+    streamoff current = position_ - distance(gptr(), egptr());
+    if (way == ios_base::cur && off == 0) {
+        return current;
+    }
+
+    wait_prefetch();
+    setg(0, 0, 0);
+    streamoff target;
+    switch (way) {
+        case ios_base::beg:
+            target = off;
+            break;
+        case ios_base::cur:
+            target = current + off;
+            break;
+        case ios_base::end:
+            target = fd_seek(fd_, off, ios_base::end);
+            break;
+        default:
+            target = -1;
+            break;
+    }
+    if (target < 0) {
+        return pos_type(off_type(-1));
+    }
+    position_ = target;
+
+    return target;
+}
+
+
 // ISTREAM
 
 
@@ -244,8 +629,8 @@ fd_stream & fd_stream::operator=(fd_stream&& rhs)
 }
 
 
-fd_stream::fd_stream(fd_t fd, bool close):
-    buffer(ios_base::in | ios_base::out, fd),
+fd_stream::fd_stream(fd_t fd, bool close, size_t buffer_size):
+    buffer(ios_base::in | ios_base::out, fd, buffer_size),
     iostream(&buffer),
     close_(close)
 {}
@@ -299,6 +684,12 @@ void fd_stream::swap(fd_stream& rhs)
 }
 
 
+void fd_stream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
+
 fd_istream::fd_istream():
     buffer(ios_base::in, INVALID_FD_VALUE),
     istream(&buffer),
@@ -328,8 +719,8 @@ fd_istream & fd_istream::operator=(fd_istream&& rhs)
 }
 
 
-fd_istream::fd_istream(fd_t fd, bool close):
-    buffer(ios_base::in, fd),
+fd_istream::fd_istream(fd_t fd, bool close, size_t buffer_size):
+    buffer(ios_base::in, fd, buffer_size),
     istream(&buffer),
     close_(close)
 {}
@@ -384,6 +775,12 @@ void fd_istream::swap(fd_istream& rhs)
 }
 
 
+void fd_istream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
+
 // OSTREAM
 
 
@@ -416,8 +813,8 @@ fd_ostream & fd_ostream::operator=(fd_ostream&& rhs)
 }
 
 
-fd_ostream::fd_ostream(fd_t fd, bool close):
-    buffer(ios_base::out, fd),
+fd_ostream::fd_ostream(fd_t fd, bool close, size_t buffer_size):
+    buffer(ios_base::out, fd, buffer_size),
     ostream(&buffer),
     close_(close)
 {}
@@ -472,4 +869,10 @@ void fd_ostream::swap(fd_ostream& rhs)
 }
 
 
+void fd_ostream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
+
 PYCPP_END_NAMESPACE
@@ -7,11 +7,22 @@
 
 #pragma once
 
+#include <pycpp/filesystem/aio.h>
 #include <pycpp/filesystem/fd.h>
 #include <pycpp/stl/iostream.h>
 
 PYCPP_BEGIN_NAMESPACE
 
+// CONSTANTS
+// ---------
+
+// sequential blocks between each doubling of an adaptive buffer
+static constexpr size_t ADAPTIVE_BUFFER_STEP = 2;
+static constexpr size_t ADAPTIVE_BUFFER_MAX = 1 << 20;
+
+// alignment of buffers, offsets and lengths for direct I/O
+static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
 // VARIABLES
 // ---------
 
@@ -22,6 +33,21 @@ extern size_t DEFAULT_BUFFER_SIZE;
 
 /**
  *  \brief Filtering streambuffer that wraps a file descriptor.
+ *
+ *  Input-only buffers may prefetch from an `aio_engine`: while the
+ *  consumer reads from one buffer, the next block is read into a
+ *  second buffer at the following file offset.
+ *
+ *  Adaptive buffers start at the requested size, and double, up to
+ *  `ADAPTIVE_BUFFER_MAX`, while blocks are read or written without
+ *  seeking. A seek restores the requested size.
+ *
+ *  Direct buffers bypass the page cache, as if by `O_DIRECT`: the
+ *  buffers are aligned and rounded to `DIRECT_IO_ALIGNMENT`, and
+ *  `sync` only writes whole blocks. The unaligned tail is written
+ *  through the page cache when the buffer is closed or seeks. If
+ *  the file offset is unaligned, or the filesystem does not support
+ *  direct I/O, the descriptor falls back to buffered I/O.
  */
 class fd_streambuf: public streambuf
 {
@@ -50,6 +76,13 @@ public:
     void swap(fd_streambuf&);
     fd_t fd() const;
     void fd(fd_t fd);
+    void prefetch(aio_engine* engine);
+    aio_engine* prefetch() const;
+    void adaptive(bool enabled);
+    bool adaptive() const;
+    void direct(bool enabled);
+    bool direct() const;
+    size_t buffer_size() const;
 
 protected:
     // MEMBER FUNCTIONS
@@ -62,16 +95,34 @@ protected:
 
 private:
     void initialize_buffers();
+    char_type* allocate_buffer() const;
+    void resize_buffers(size_t size);
+    streamsize read_block(char_type* data, size_t length);
+    streamsize write_block(const char_type* data, size_t length);
+    void write_tail();
     void set_readp();
     void set_writep();
+    void discard_buffers();
+    void adapt_buffers();
+    void wait_prefetch();
+    int_type underflow_prefetch();
+    pos_type seekoff_prefetch(off_type off, ios_base::seekdir way);
 
     ios_base::openmode mode;
-    size_t buffer_size;
+    size_t buffer_size_;
+    size_t initial_size_;
+    bool adaptive_ = false;
+    bool direct_ = false;
+    size_t sequential_ = 0;
     fd_t fd_ = INVALID_FD_VALUE;
     char_type* in_first = nullptr;
     char_type* in_last = nullptr;
     char_type* out_first = nullptr;
     char_type* out_last = nullptr;
+    aio_engine* engine_ = nullptr;
+    char_type* ahead_ = nullptr;
+    future<streamsize> pending_;
+    streamoff position_ = 0;
 };
 
 
@@ -89,13 +140,14 @@ public:
     fd_stream& operator=(fd_stream&&);
 
     // STREAM
-    fd_stream(fd_t fd, bool close = false);
+    fd_stream(fd_t fd, bool close = false, size_t buffer_size = DEFAULT_BUFFER_SIZE);
     void open(fd_t fd, bool close = false);
 
     // MODIFIERS/PROPERTIES
     void close();
     bool is_open() const;
     void swap(fd_stream&);
+    void adaptive(bool enabled);
     streambuf* rdbuf() const;
     void rdbuf(streambuf* buffer);
 
@@ -119,13 +171,14 @@ public:
     fd_istream& operator=(fd_istream&&);
 
     // STREAM
-    fd_istream(fd_t fd, bool close = false);
+    fd_istream(fd_t fd, bool close = false, size_t buffer_size = DEFAULT_BUFFER_SIZE);
     void open(fd_t fd, bool close = false);
 
     // MODIFIERS/PROPERTIES
     void close();
     bool is_open() const;
     void swap(fd_istream&);
+    void adaptive(bool enabled);
     streambuf* rdbuf() const;
     void rdbuf(streambuf* buffer);
 
@@ -149,13 +202,14 @@ public:
     fd_ostream & operator=(fd_ostream&&);
 
     // STREAM
-    fd_ostream(fd_t fd, bool close = false);
+    fd_ostream(fd_t fd, bool close = false, size_t buffer_size = DEFAULT_BUFFER_SIZE);
     void open(fd_t fd, bool close = false);
 
     // MODIFIERS/PROPERTIES
     void close();
     bool is_open() const;
     void swap(fd_ostream&);
+    void adaptive(bool enabled);
     streambuf* rdbuf() const;
     void rdbuf(streambuf* buffer);
 
@@ -73,9 +73,12 @@ filter_streambuf& filter_streambuf::operator=(filter_streambuf&& rhs)
 void filter_streambuf::close()
 {
     sync();
+
+    // flushing the filter may produce more than a single buffer
     streamsize converted = do_callback();
-    if (converted && filebuf && mode & ios_base::out) {
+    while (converted && filebuf && mode & ios_base::out) {
         filebuf->sputn(out_buffer, converted);
+        converted = do_callback();
     }
 
     delete[] in_buffer;
@@ -108,25 +111,30 @@ auto filter_streambuf::underflow() -> int_type
         return traits_type::eof();
     }
 
-    streamsize read, converted;
-
-    if (filebuf) {
+    streamsize read, converted = 0;
+    while (filebuf && !converted) {
         if (first == nullptr) {
             read = filebuf->sgetn(in_buffer, buffer_size);
             first = in_buffer;
             last = in_buffer + read;
         }
 
-        // perform the callback
+        // perform the callback, which may consume input without
+        // producing any output, or flush the filter on empty input
+        char_type* previous = first;
+        bool empty = first == last;
         converted = do_callback();
-        if (!converted) {
-            return traits_type::eof();
+        if (empty || first == previous) {
+            break;
         }
-        setg(out_buffer, out_buffer, out_buffer + converted);
+    }
 
-        return traits_type::to_int_type(*gptr());
+    if (!converted) {
+        return traits_type::eof();
     }
-    return traits_type::eof();
+    setg(out_buffer, out_buffer, out_buffer + converted);
+
+    return traits_type::to_int_type(*gptr());
 }
 
 
@@ -173,6 +181,23 @@ streamsize filter_streambuf::do_callback()
 }
 
 
+void filter_streambuf::flush_input()
+{
+    // the converted data may be larger than the buffer, so convert
+    // until all the buffered input is consumed
+    while (first != nullptr && first != last) {
+        char_type* previous = first;
+        streamsize converted = do_callback();
+        filebuf->sputn(out_buffer, converted);
+        if (first == previous && !converted) {
+            break;
+        }
+    }
+    first = nullptr;
+    last = nullptr;
+}
+
+
 auto filter_streambuf::overflow(int_type c) -> int_type
 {
     if (!(mode & ios_base::out)) {
@@ -180,12 +205,12 @@ auto filter_streambuf::overflow(int_type c) -> int_type
     }
 
     if (filebuf) {
+        if (last == in_buffer + buffer_size) {
+            flush_input();
+        }
         if (first == nullptr) {
             first = in_buffer;
             last = in_buffer;
-        } else if (last == first + buffer_size) {
-            streamsize converted = do_callback();
-            filebuf->sputn(out_buffer, converted);
         }
 
         if (!traits_type::eq_int_type(c, traits_type::eof())) {
@@ -202,8 +227,12 @@ int filter_streambuf::sync()
 
     // flush buffer on output
     if (filebuf && mode & ios_base::out) {
-        streamsize converted = do_callback();
-        filebuf->sputn(out_buffer, converted);
+        if (first == last) {
+            streamsize converted = do_callback();
+            filebuf->sputn(out_buffer, converted);
+        } else {
+            flush_input();
+        }
         filebuf->pubsync();
     }
 
@@ -226,6 +255,62 @@ void filter_streambuf::set_callback(filter_callback c)
 }
 
 
+// VIEW STREAMBUF
+
+view_filter_streambuf::view_filter_streambuf(const string_view& view, filter_callback c)
+{
+    out_buffer = new char_type[buffer_size];
+    set_view(view);
+    set_callback(c);
+}
+
+
+view_filter_streambuf::~view_filter_streambuf()
+{
+    delete[] out_buffer;
+}
+
+
+void view_filter_streambuf::set_view(const string_view& view)
+{
+    first = view.data();
+    last = view.data() + view.size();
+    setg(0, 0, 0);
+}
+
+
+void view_filter_streambuf::set_callback(filter_callback c)
+{
+    callback = c ? c : null_callback;
+}
+
+
+auto view_filter_streambuf::underflow() -> int_type
+{
+    // convert until output is produced, or no progress can be made,
+    // which occurs once the view is consumed and the filter flushed
+    char_type* dst_first = out_buffer;
+    while (dst_first == out_buffer) {
+        const void* src = (const void*) first;
+        void* dst = (void*) dst_first;
+        callback(src, distance(first, last), dst, buffer_size, sizeof(char_type));
+        bool progress = src != (const void*) first || dst != (void*) dst_first;
+        first = (const char_type*) src;
+        dst_first = (char_type*) dst;
+        if (!progress) {
+            break;
+        }
+    }
+
+    if (dst_first == out_buffer) {
+        return traits_type::eof();
+    }
+    setg(out_buffer, out_buffer, dst_first);
+
+    return traits_type::to_int_type(*gptr());
+}
+
+
 // ISTREAM
 
 
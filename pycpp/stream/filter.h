@@ -81,6 +81,7 @@ protected:
 private:
     void set_pointers();
     streamsize do_callback();
+    void flush_input();
 
     friend class filter_istream;
     friend class filter_ostream;
@@ -95,6 +96,49 @@ private:
 };
 
 
+/**
+ *  \brief Read-only buffer that transforms data from a memory view.
+ *
+ *  The source data, such as a memory-mapped file, is passed directly
+ *  to the callback, without an intermediate copy.
+ */
+class view_filter_streambuf: public streambuf
+{
+public:
+    // MEMBER TYPES
+    // ------------
+    using typename streambuf::char_type;
+    using typename streambuf::int_type;
+    using typename streambuf::traits_type;
+
+    // MEMBER VARIABLES
+    // ----------------
+    static constexpr size_t buffer_size = filter_streambuf::buffer_size;
+
+    // MEMBER FUNCTIONS
+    // ----------------
+    view_filter_streambuf(const string_view& = string_view(), filter_callback = nullptr);
+    view_filter_streambuf(const view_filter_streambuf&) = delete;
+    view_filter_streambuf& operator=(const view_filter_streambuf&) = delete;
+    virtual ~view_filter_streambuf();
+
+    // MODIFIERS/PROPERTIES
+    void set_view(const string_view&);
+    void set_callback(filter_callback);
+
+protected:
+    // MEMBER FUNCTIONS
+    // ----------------
+    virtual int_type underflow();
+
+private:
+    filter_callback callback = nullptr;
+    char_type* out_buffer = nullptr;
+    const char_type* first = nullptr;
+    const char_type* last = nullptr;
+};
+
+
 /**
  *  \brief Transform streaming input data via callback.
  */
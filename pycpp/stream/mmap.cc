@@ -4,13 +4,17 @@
 #include <pycpp/filesystem.h>
 #include <pycpp/filesystem/exception.h>
 #include <pycpp/preprocessor/architecture.h>
+#include <pycpp/stl/algorithm.h>
 #include <pycpp/stream/mmap.h>
 #include <assert.h>
+#include <errno.h>
+#include <string.h>
 
 #if defined(HAVE_MMAP) || defined(OS_WINDOWS)           // MMAP
 
 #if defined(HAVE_MMAP)
 #   include <sys/mman.h>
+#   include <unistd.h>
 #   include <pycpp/preprocessor/sysstat.h>
 #elif defined(OS_WINDOWS)
 #   include <pycpp/windows/mman.h>
@@ -34,6 +38,13 @@ static size_t file_length(fd_t fd)
     return sb.st_size;
 }
 
+
+static size_t page_size()
+{
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
 #elif defined(OS_WINDOWS)               // WINDOWS
 
 static size_t file_length(fd_t fd)
@@ -45,11 +56,42 @@ static size_t file_length(fd_t fd)
     return static_cast<size_t>(bytes.QuadPart);
 }
 
+
+static size_t page_size()
+{
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
 #else                                   // UNKNOWN
 #   error "Unsupported operating system."
 #endif                                  // POSIX
 
 
+/**
+ *  \brief Extend a file to `size` bytes, with the blocks allocated.
+ *
+ *  `fd_allocate` returns an error number, or -1 and sets `errno`.
+ *  Truncating only extends the file sparsely, so later writes to
+ *  the mapping fault if the device is full: fall back to it only
+ *  if preallocation is unsupported.
+ */
+static void extend_file(fd_t fd, size_t size)
+{
+    int status = fd_allocate(fd, size);
+    if (status == 0) {
+        return;
+    }
+
+    int error = status == -1 ? errno : status;
+    if ((error == EINVAL || error == EOPNOTSUPP) && fd_truncate(fd, size) == 0) {
+        return;
+    }
+    throw filesystem_error(filesystem_unexpected_error);
+}
+
+
 static int convert_prot(ios_base::openmode mode)
 {
     int prot = 0;
@@ -64,13 +106,20 @@ static int convert_prot(ios_base::openmode mode)
 }
 
 
-static void* open_memory_view(fd_t fd, ios_base::openmode mode, size_t offset, size_t length)
+static void* open_memory_view(fd_t fd, ios_base::openmode mode, size_t offset, size_t length, bool populate = false)
 {
+    int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+    if (populate) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+
 #if defined(OS_WINDOWS)
     int fd_ = _open_osfhandle((intptr_t) fd, 0);
-    void* addr = ::mmap(nullptr, length, convert_prot(mode), MAP_SHARED, fd_, offset);
+    void* addr = ::mmap(nullptr, length, convert_prot(mode), flags, fd_, offset);
 #else
-    void* addr = ::mmap(nullptr, length, convert_prot(mode), MAP_SHARED, fd, offset);
+    void* addr = ::mmap(nullptr, length, convert_prot(mode), flags, fd, offset);
 #endif
     if (addr == MAP_FAILED) {
         return nullptr;
@@ -79,6 +128,41 @@ static void* open_memory_view(fd_t fd, ios_base::openmode mode, size_t offset, s
 }
 
 
+static bool memory_advise(void* addr, size_t length, mmap_advice advice)
+{
+#if defined(HAVE_MADVISE)
+    int flag;
+    switch (advice) {
+        case advice_normal:
+            flag = MADV_NORMAL;
+            break;
+        case advice_sequential:
+            flag = MADV_SEQUENTIAL;
+            break;
+        case advice_random:
+            flag = MADV_RANDOM;
+            break;
+        case advice_willneed:
+            flag = MADV_WILLNEED;
+            break;
+        case advice_dontneed:
+            flag = MADV_DONTNEED;
+            break;
+#if defined(MADV_HUGEPAGE)
+        case advice_hugepage:
+            flag = MADV_HUGEPAGE;
+            break;
+#endif
+        default:
+            return false;
+    }
+    return ::madvise(addr, length, flag) == 0;
+#else
+    return false;
+#endif
+}
+
+
 static int memory_sync(void *addr, size_t length, bool async)
 {
     // on modern Linux, MS_ASYNC is a no-op, however,
@@ -648,6 +732,396 @@ void mmap_ofstream::flush(bool async)
     memory_sync(data_, length_, async);
 }
 
+// MMAP FILE
+
+
+mmap_file::mmap_file()
+{}
+
+
+mmap_file::~mmap_file()
+{
+    close();
+}
+
+
+mmap_file::mmap_file(mmap_file&& rhs):
+    mmap_file()
+{
+    swap(rhs);
+}
+
+
+mmap_file & mmap_file::operator=(mmap_file&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+mmap_file::mmap_file(const string_view& name, ios_base::openmode mode, bool populate)
+{
+    open(name, mode, populate);
+}
+
+
+void mmap_file::open(const string_view& name, ios_base::openmode mode, bool populate)
+{
+    close();
+    if (mode & ios_base::out) {
+        mode |= ios_base::in;
+    }
+    open_fd(fd_open(name, mode, S_IWR_USR_GRP, access_normal), mode, populate);
+}
+
+#if defined(HAVE_WFOPEN)                        // WINDOWS
+
+mmap_file::mmap_file(const wstring_view& name, ios_base::openmode mode, bool populate)
+{
+    open(name, mode, populate);
+}
+
+
+void mmap_file::open(const wstring_view& name, ios_base::openmode mode, bool populate)
+{
+    open(reinterpret_cast<const char16_t*>(name.data()), mode, populate);
+}
+
+
+mmap_file::mmap_file(const u16string_view& name, ios_base::openmode mode, bool populate)
+{
+    open(name, mode, populate);
+}
+
+
+void mmap_file::open(const u16string_view& name, ios_base::openmode mode, bool populate)
+{
+    close();
+    if (mode & ios_base::out) {
+        mode |= ios_base::in;
+    }
+    open_fd(fd_open(name, mode, S_IWR_USR_GRP, access_normal), mode, populate);
+}
+
+#endif                                          // WINDOWS
+
+void mmap_file::reserve(size_t capacity)
+{
+    if (capacity <= capacity_) {
+        return;
+    } else if (!writable_) {
+        throw filesystem_error(filesystem_permissions_error);
+    }
+
+    // the file must span the mapping, or accesses past EOF fault
+    extend_file(fd_, capacity);
+    remap(capacity);
+}
+
+
+void mmap_file::resize(size_t size)
+{
+    if (size > capacity_) {
+        reserve(max(size, max(2 * capacity_, MMAP_FILE_MIN_CAPACITY)));
+    }
+    length_ = size;
+}
+
+
+void mmap_file::shrink_to_fit()
+{
+    if (!writable_ || length_ == capacity_) {
+        return;
+    }
+
+    remap(length_);
+    fd_truncate(fd_, length_);
+}
+
+
+char* mmap_file::append(const void* data, size_t length)
+{
+    size_t offset = length_;
+    resize(length_ + length);
+    memcpy(data_ + offset, data, length);
+
+    return data_ + offset;
+}
+
+
+size_t mmap_file::capacity() const
+{
+    return capacity_;
+}
+
+
+bool mmap_file::advise(mmap_advice advice)
+{
+    return advise(advice, 0, capacity_);
+}
+
+
+bool mmap_file::advise(mmap_advice advice, size_t offset, size_t length)
+{
+    if (!data_ || offset >= capacity_) {
+        return false;
+    }
+
+    // the range must start on a page boundary
+    size_t first = offset - offset % page_size();
+    length = min(length, capacity_ - offset) + (offset - first);
+    return memory_advise(data_ + first, length, advice);
+}
+
+
+bool mmap_file::flush(bool async)
+{
+    return flush(0, length_, async);
+}
+
+
+bool mmap_file::flush(size_t offset, size_t length, bool async)
+{
+    if (!data_ || offset >= capacity_) {
+        return false;
+    }
+
+    // the range must start on a page boundary
+    size_t first = offset - offset % page_size();
+    length = min(length, capacity_ - offset) + (offset - first);
+    return memory_sync(data_ + first, length, async) == 0;
+}
+
+
+bool mmap_file::is_open() const
+{
+    return fd_ != INVALID_FD_VALUE;
+}
+
+
+bool mmap_file::has_mapping() const
+{
+    return data_ != nullptr;
+}
+
+
+void mmap_file::close()
+{
+    if (data_) {
+        close_memory_view(data_, capacity_);
+        data_ = nullptr;
+    }
+    if (fd_ != INVALID_FD_VALUE) {
+        // drop the unused capacity
+        if (writable_ && length_ != capacity_) {
+            fd_truncate(fd_, length_);
+        }
+        fd_close(fd_);
+        fd_ = INVALID_FD_VALUE;
+    }
+    writable_ = false;
+    populate_ = false;
+    length_ = 0;
+    capacity_ = 0;
+}
+
+
+void mmap_file::swap(mmap_file& rhs)
+{
+    using PYCPP_NAMESPACE::swap;
+    swap(fd_, rhs.fd_);
+    swap(writable_, rhs.writable_);
+    swap(populate_, rhs.populate_);
+    swap(data_, rhs.data_);
+    swap(length_, rhs.length_);
+    swap(capacity_, rhs.capacity_);
+}
+
+
+char& mmap_file::operator[](size_t index)
+{
+    assert(data_ && "Memory address cannot be null.");
+    assert(index < length_ && "Index must be less than buffer length.");
+    return data_[index];
+}
+
+
+const char& mmap_file::operator[](size_t index) const
+{
+    assert(data_ && "Memory address cannot be null.");
+    assert(index < length_ && "Index must be less than buffer length.");
+    return data_[index];
+}
+
+
+char* mmap_file::data() const
+{
+    return data_;
+}
+
+
+size_t mmap_file::size() const
+{
+    return length();
+}
+
+
+size_t mmap_file::length() const
+{
+    return length_;
+}
+
+
+void mmap_file::open_fd(fd_t fd, ios_base::openmode mode, bool populate)
+{
+    if (fd == INVALID_FD_VALUE) {
+        return;
+    }
+
+    fd_ = fd;
+    writable_ = (mode & ios_base::out) != 0;
+    populate_ = populate;
+    length_ = file_length(fd_);
+    remap(length_);
+}
+
+
+void mmap_file::remap(size_t capacity)
+{
+    // empty files cannot be mapped
+    if (capacity == 0) {
+        if (data_) {
+            close_memory_view(data_, capacity_);
+            data_ = nullptr;
+        }
+        capacity_ = 0;
+        return;
+    }
+
+    ios_base::openmode mode = writable_ ? ios_base::in | ios_base::out : ios_base::in;
+    void* addr;
+    if (!data_) {
+        addr = open_memory_view(fd_, mode, 0, capacity, populate_);
+    } else {
+#if defined(HAVE_MREMAP)
+        // extend or shrink in place, or move without copying pages
+        addr = ::mremap(data_, capacity_, capacity, MREMAP_MAYMOVE);
+        if (addr == MAP_FAILED) {
+            throw filesystem_error(filesystem_out_of_memory);
+        }
+#else
+        close_memory_view(data_, capacity_);
+        data_ = nullptr;
+        addr = open_memory_view(fd_, mode, 0, capacity, populate_);
+#endif
+    }
+    if (!addr) {
+        throw filesystem_error(filesystem_out_of_memory);
+    }
+
+    size_t previous = data_ ? capacity_ : 0;
+    data_ = reinterpret_cast<char*>(addr);
+    capacity_ = capacity;
+#if defined(HAVE_MREMAP)
+    // pages added by mremap are not populated by the original mapping
+    if (populate_ && capacity > previous && previous != 0) {
+        advise(advice_willneed, previous, capacity - previous);
+    }
+#else
+    (void) previous;
+#endif
+}
+
+// MMAP VIEW
+
+
+mmap_view::mmap_view()
+{}
+
+
+mmap_view::~mmap_view()
+{
+    unmap();
+}
+
+
+mmap_view::mmap_view(mmap_view&& rhs):
+    mmap_view()
+{
+    swap(rhs);
+}
+
+
+mmap_view & mmap_view::operator=(mmap_view&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+mmap_view::mmap_view(fd_t fd, size_t offset, size_t length, ios_base::openmode mode)
+{
+    map(fd, offset, length, mode);
+}
+
+
+void mmap_view::map(fd_t fd, size_t offset, size_t length, ios_base::openmode mode)
+{
+    unmap();
+    data_ = reinterpret_cast<char*>(open_memory_view(fd, mode, offset, length));
+    if (data_) {
+        length_ = length;
+    }
+}
+
+
+void mmap_view::unmap()
+{
+    if (data_) {
+        close_memory_view(data_, length_);
+        data_ = nullptr;
+        length_ = 0;
+    }
+}
+
+
+bool mmap_view::flush(bool async)
+{
+    return data_ && memory_sync(data_, length_, async) == 0;
+}
+
+
+bool mmap_view::has_mapping() const
+{
+    return data_ != nullptr;
+}
+
+
+void mmap_view::swap(mmap_view& rhs)
+{
+    using PYCPP_NAMESPACE::swap;
+    swap(data_, rhs.data_);
+    swap(length_, rhs.length_);
+}
+
+
+char* mmap_view::data() const
+{
+    return data_;
+}
+
+
+size_t mmap_view::size() const
+{
+    return length();
+}
+
+
+size_t mmap_view::length() const
+{
+    return length_;
+}
+
 PYCPP_END_NAMESPACE
 
 #endif                                                  // MMAP
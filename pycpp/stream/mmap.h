@@ -38,6 +38,15 @@
  *  files (`mmap_ofstream`) are implemented using a read/write
  *  file-descriptor, but contain write-only methods at the
  *  stream level.
+ *
+ *  `mmap_file` maps an entire file, and grows the file and the
+ *  mapping together, for append-heavy data. Capacity grows
+ *  geometrically, and on Linux the mapping is extended in place
+ *  with `mremap`, otherwise it is unmapped and mapped again, so
+ *  pointers into the mapping are invalidated by growth.
+ *
+ *  `mmap_view` maps a region of a file descriptor it does not own,
+ *  for callers that map many regions of a single open file.
  */
 
 #pragma once
@@ -50,6 +59,27 @@
 
 PYCPP_BEGIN_NAMESPACE
 
+// CONSTANTS
+// ---------
+
+static constexpr size_t MMAP_FILE_MIN_CAPACITY = 1 << 16;
+
+// ENUMS
+// -----
+
+/**
+ *  \brief Expected access pattern for mapped memory, as if by `madvise`.
+ */
+enum mmap_advice
+{
+    advice_normal = 0,
+    advice_sequential,
+    advice_random,
+    advice_willneed,
+    advice_dontneed,
+    advice_hugepage,
+};
+
 // OBJECTS
 // -------
 
@@ -204,6 +234,117 @@ private:
     size_t length_ = 0;
 };
 
+
+/**
+ *  \brief Growable memory-mapped file.
+ *
+ *  The size is the logical end of the file, and the capacity the
+ *  allocated and mapped length. While open, the file on disk spans
+ *  the capacity, and it is truncated to the size on `close()`.
+ *  Files opened without `ios_base::out` are mapped read-only and
+ *  cannot grow. With `populate`, mapped pages are read ahead of
+ *  the first access (`MAP_POPULATE` on Linux).
+ *
+ *  Growth throws `filesystem_error` if the file cannot be extended
+ *  or mapped.
+ */
+class mmap_file
+{
+public:
+    mmap_file();
+    ~mmap_file();
+    mmap_file(const mmap_file&) = delete;
+    mmap_file & operator=(const mmap_file&) = delete;
+    mmap_file(mmap_file &&other);
+    mmap_file & operator=(mmap_file &&other);
+
+    mmap_file(const string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, bool populate = false);
+    void open(const string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, bool populate = false);
+
+#if defined(HAVE_WFOPEN)                        // WINDOWS
+    mmap_file(const wstring_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, bool populate = false);
+    void open(const wstring_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, bool populate = false);
+    mmap_file(const u16string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, bool populate = false);
+    void open(const u16string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, bool populate = false);
+#endif                                          // WINDOWS
+
+    // CAPACITY
+    void reserve(size_t capacity);
+    void resize(size_t size);
+    void shrink_to_fit();
+    char* append(const void* data, size_t length);
+    size_t capacity() const;
+
+    // HINTS
+    bool advise(mmap_advice advice);
+    bool advise(mmap_advice advice, size_t offset, size_t length);
+    bool flush(bool async = true);
+    bool flush(size_t offset, size_t length, bool async = true);
+
+    // PROPERTIES
+    bool is_open() const;
+    bool has_mapping() const;
+
+    // MODIFIERS
+    void close();
+    void swap(mmap_file &other);
+
+    // DATA
+    char& operator[](size_t index);
+    const char& operator[](size_t index) const;
+    char* data() const;
+    size_t size() const;
+    size_t length() const;
+
+private:
+    void open_fd(fd_t fd, ios_base::openmode mode, bool populate);
+    void remap(size_t capacity);
+
+    fd_t fd_ = INVALID_FD_VALUE;
+    bool writable_ = false;
+    bool populate_ = false;
+    char* data_ = nullptr;
+    size_t length_ = 0;
+    size_t capacity_ = 0;
+};
+
+
+/**
+ *  \brief Mapped region of a borrowed file descriptor.
+ *
+ *  The descriptor must outlive the view, and is not extended.
+ */
+class mmap_view
+{
+public:
+    mmap_view();
+    ~mmap_view();
+    mmap_view(const mmap_view&) = delete;
+    mmap_view & operator=(const mmap_view&) = delete;
+    mmap_view(mmap_view &&other);
+    mmap_view & operator=(mmap_view &&other);
+
+    mmap_view(fd_t fd, size_t offset, size_t length, ios_base::openmode mode = ios_base::in | ios_base::out);
+    void map(fd_t fd, size_t offset, size_t length, ios_base::openmode mode = ios_base::in | ios_base::out);
+    void unmap();
+    bool flush(bool async = true);
+
+    // PROPERTIES
+    bool has_mapping() const;
+
+    // MODIFIERS
+    void swap(mmap_view &other);
+
+    // DATA
+    char* data() const;
+    size_t size() const;
+    size_t length() const;
+
+private:
+    char* data_ = nullptr;
+    size_t length_ = 0;
+};
+
 PYCPP_END_NAMESPACE
 
 #endif                                                  // MMAP
@@ -9,7 +9,7 @@ PYCPP_BEGIN_NAMESPACE
 // VARIABLES
 // ---------
 
-size_t RANDOM_ACCESS_BUFFER_SIZE = 512;
+size_t RANDOM_ACCESS_BUFFER_SIZE = 4096;
 
 // OBJECTS
 // -------
@@ -42,8 +42,8 @@ random_access_fstream & random_access_fstream::operator=(random_access_fstream&&
 }
 
 
-random_access_fstream::random_access_fstream(const string_view& name, ios_base::openmode mode):
-    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_fstream::random_access_fstream(const string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, buffer_size),
     iostream(&buffer)
 {
     open(name, mode);
@@ -59,8 +59,8 @@ void random_access_fstream::open(const string_view& name, ios_base::openmode mod
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
 
-random_access_fstream::random_access_fstream(const wstring_view& name, ios_base::openmode mode):
-    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_fstream::random_access_fstream(const wstring_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, buffer_size),
     iostream(&buffer)
 {
     open(name, mode);
@@ -73,8 +73,8 @@ void random_access_fstream::open(const wstring_view& name, ios_base::openmode mo
 }
 
 
-random_access_fstream::random_access_fstream(const u16string_view& name, ios_base::openmode mode):
-    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_fstream::random_access_fstream(const u16string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, buffer_size),
     iostream(&buffer)
 {
     open(name, mode);
@@ -112,6 +112,12 @@ void random_access_fstream::swap(random_access_fstream& rhs)
     swap(buffer, rhs.buffer);
 }
 
+
+void random_access_fstream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
 // RANDOM ACCESS IFSTREAM
 
 
@@ -141,8 +147,8 @@ random_access_ifstream & random_access_ifstream::operator=(random_access_ifstrea
 }
 
 
-random_access_ifstream::random_access_ifstream(const string_view& name, ios_base::openmode mode):
-    buffer(ios_base::in, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_ifstream::random_access_ifstream(const string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in, INVALID_FD_VALUE, buffer_size),
     istream(&buffer)
 {
     open(name, mode);
@@ -158,8 +164,8 @@ void random_access_ifstream::open(const string_view& name, ios_base::openmode mo
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
 
-random_access_ifstream::random_access_ifstream(const wstring_view& name, ios_base::openmode mode):
-    buffer(ios_base::in, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_ifstream::random_access_ifstream(const wstring_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in, INVALID_FD_VALUE, buffer_size),
     istream(&buffer)
 {
     open(name, mode);
@@ -172,8 +178,8 @@ void random_access_ifstream::open(const wstring_view& name, ios_base::openmode m
 }
 
 
-random_access_ifstream::random_access_ifstream(const u16string_view& name, ios_base::openmode mode):
-    buffer(ios_base::in, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_ifstream::random_access_ifstream(const u16string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in, INVALID_FD_VALUE, buffer_size),
     istream(&buffer)
 {
     open(name, mode);
@@ -211,6 +217,18 @@ void random_access_ifstream::swap(random_access_ifstream& rhs)
     swap(buffer, rhs.buffer);
 }
 
+
+void random_access_ifstream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
+
+void random_access_ifstream::prefetch(aio_engine* engine)
+{
+    buffer.prefetch(engine);
+}
+
 // RANDOM ACCESS OFSTREAM
 
 random_access_ofstream::random_access_ofstream():
@@ -239,8 +257,8 @@ random_access_ofstream & random_access_ofstream::operator=(random_access_ofstrea
 }
 
 
-random_access_ofstream::random_access_ofstream(const string_view& name, ios_base::openmode mode):
-    buffer(ios_base::out, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_ofstream::random_access_ofstream(const string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::out, INVALID_FD_VALUE, buffer_size),
     ostream(&buffer)
 {
     open(name, mode);
@@ -256,8 +274,8 @@ void random_access_ofstream::open(const string_view& name, ios_base::openmode mo
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
 
-random_access_ofstream::random_access_ofstream(const wstring_view& name, ios_base::openmode mode):
-    buffer(ios_base::out, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_ofstream::random_access_ofstream(const wstring_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::out, INVALID_FD_VALUE, buffer_size),
     ostream(&buffer)
 {
     open(name, mode);
@@ -270,8 +288,8 @@ void random_access_ofstream::open(const wstring_view& name, ios_base::openmode m
 }
 
 
-random_access_ofstream::random_access_ofstream(const u16string_view& name, ios_base::openmode mode):
-    buffer(ios_base::out, INVALID_FD_VALUE, RANDOM_ACCESS_BUFFER_SIZE),
+random_access_ofstream::random_access_ofstream(const u16string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::out, INVALID_FD_VALUE, buffer_size),
     ostream(&buffer)
 {
     open(name, mode);
@@ -309,4 +327,10 @@ void random_access_ofstream::swap(random_access_ofstream& rhs)
     swap(buffer, rhs.buffer);
 }
 
+
+void random_access_ofstream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
 PYCPP_END_NAMESPACE
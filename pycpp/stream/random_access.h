@@ -41,12 +41,12 @@ public:
     random_access_fstream& operator=(random_access_fstream&&);
 
     // STREAM
-    random_access_fstream(const string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
+    random_access_fstream(const string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
 #if defined(HAVE_WFOPEN)                        // WINDOWS
-    random_access_fstream(const wstring_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
+    random_access_fstream(const wstring_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const wstring_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
-    random_access_fstream(const u16string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
+    random_access_fstream(const u16string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const u16string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
 #endif                                          // WINDOWS
 
@@ -54,6 +54,7 @@ public:
     bool is_open() const;
     void close();
     void swap(random_access_fstream&);
+    void adaptive(bool enabled);
 
 private:
     fd_streambuf buffer;
@@ -74,12 +75,12 @@ public:
     random_access_ifstream& operator=(random_access_ifstream&&);
 
     // STREAM
-    random_access_ifstream(const string_view& name, ios_base::openmode mode = ios_base::in);
+    random_access_ifstream(const string_view& name, ios_base::openmode mode = ios_base::in, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const string_view& name, ios_base::openmode mode = ios_base::in);
 #if defined(HAVE_WFOPEN)                        // WINDOWS
-    random_access_ifstream(const wstring_view& name, ios_base::openmode mode = ios_base::in);
+    random_access_ifstream(const wstring_view& name, ios_base::openmode mode = ios_base::in, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const wstring_view& name, ios_base::openmode mode = ios_base::in);
-    random_access_ifstream(const u16string_view& name, ios_base::openmode mode = ios_base::in);
+    random_access_ifstream(const u16string_view& name, ios_base::openmode mode = ios_base::in, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const u16string_view& name, ios_base::openmode mode = ios_base::in);
 #endif                                          // WINDOWS
 
@@ -87,6 +88,16 @@ public:
     bool is_open() const;
     void close();
     void swap(random_access_ifstream&);
+    void adaptive(bool enabled);
+
+    // PREFETCH
+    /**
+     *  \brief Read the next block from `engine` while the current one is consumed.
+     *
+     *  Pass `nullptr` to disable prefetching. The engine must outlive
+     *  the stream, or prefetching must be disabled first.
+     */
+    void prefetch(aio_engine* engine);
 
 private:
     fd_streambuf buffer;
@@ -107,12 +118,12 @@ public:
     random_access_ofstream& operator=(random_access_ofstream&&);
 
     // STREAM
-    random_access_ofstream(const string_view& name, ios_base::openmode mode = ios_base::out);
+    random_access_ofstream(const string_view& name, ios_base::openmode mode = ios_base::out, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const string_view& name, ios_base::openmode mode = ios_base::out);
 #if defined(HAVE_WFOPEN)                        // WINDOWS
-    random_access_ofstream(const wstring_view& name, ios_base::openmode mode = ios_base::out);
+    random_access_ofstream(const wstring_view& name, ios_base::openmode mode = ios_base::out, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const wstring_view& name, ios_base::openmode mode = ios_base::out);
-    random_access_ofstream(const u16string_view& name, ios_base::openmode mode = ios_base::out);
+    random_access_ofstream(const u16string_view& name, ios_base::openmode mode = ios_base::out, size_t buffer_size = RANDOM_ACCESS_BUFFER_SIZE);
     void open(const u16string_view& name, ios_base::openmode mode = ios_base::out);
 #endif                                          // WINDOWS
 
@@ -120,6 +131,7 @@ public:
     bool is_open() const;
     void close();
     void swap(random_access_ofstream&);
+    void adaptive(bool enabled);
 
 private:
     fd_streambuf buffer;
@@ -42,8 +42,8 @@ sequential_fstream & sequential_fstream::operator=(sequential_fstream&& rhs)
 }
 
 
-sequential_fstream::sequential_fstream(const string_view& name, ios_base::openmode mode):
-    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_fstream::sequential_fstream(const string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, buffer_size),
     iostream(&buffer)
 {
     open(name, mode);
@@ -59,8 +59,8 @@ void sequential_fstream::open(const string_view& name, ios_base::openmode mode)
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
 
-sequential_fstream::sequential_fstream(const wstring_view& name, ios_base::openmode mode):
-    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_fstream::sequential_fstream(const wstring_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, buffer_size),
     iostream(&buffer)
 {
     open(name, mode);
@@ -73,8 +73,8 @@ void sequential_fstream::open(const wstring_view& name, ios_base::openmode mode)
 }
 
 
-sequential_fstream::sequential_fstream(const u16string_view& name, ios_base::openmode mode):
-    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_fstream::sequential_fstream(const u16string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in | ios_base::out, INVALID_FD_VALUE, buffer_size),
     iostream(&buffer)
 {
     open(name, mode);
@@ -113,6 +113,18 @@ void sequential_fstream::swap(sequential_fstream& rhs)
     swap(buffer, rhs.buffer);
 }
 
+
+void sequential_fstream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
+
+void sequential_fstream::direct(bool enabled)
+{
+    buffer.direct(enabled);
+}
+
 // SEQUENTIAL IFSTREAM
 
 
@@ -142,8 +154,8 @@ sequential_ifstream & sequential_ifstream::operator=(sequential_ifstream&& rhs)
 }
 
 
-sequential_ifstream::sequential_ifstream(const string_view& name, ios_base::openmode mode):
-    buffer(ios_base::in, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_ifstream::sequential_ifstream(const string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in, INVALID_FD_VALUE, buffer_size),
     istream(&buffer)
 {
     open(name, mode);
@@ -159,8 +171,8 @@ void sequential_ifstream::open(const string_view& name, ios_base::openmode mode)
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
 
-sequential_ifstream::sequential_ifstream(const wstring_view& name, ios_base::openmode mode):
-    buffer(ios_base::in, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_ifstream::sequential_ifstream(const wstring_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in, INVALID_FD_VALUE, buffer_size),
     istream(&buffer)
 {
     open(name, mode);
@@ -173,8 +185,8 @@ void sequential_ifstream::open(const wstring_view& name, ios_base::openmode mode
 }
 
 
-sequential_ifstream::sequential_ifstream(const u16string_view& name, ios_base::openmode mode):
-    buffer(ios_base::in, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_ifstream::sequential_ifstream(const u16string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::in, INVALID_FD_VALUE, buffer_size),
     istream(&buffer)
 {
     open(name, mode);
@@ -213,6 +225,24 @@ void sequential_ifstream::swap(sequential_ifstream& rhs)
     swap(buffer, rhs.buffer);
 }
 
+
+void sequential_ifstream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
+
+void sequential_ifstream::direct(bool enabled)
+{
+    buffer.direct(enabled);
+}
+
+
+void sequential_ifstream::prefetch(aio_engine* engine)
+{
+    buffer.prefetch(engine);
+}
+
 // SEQUENTIAL OFSTREAM
 
 sequential_ofstream::sequential_ofstream():
@@ -241,8 +271,8 @@ sequential_ofstream & sequential_ofstream::operator=(sequential_ofstream&& rhs)
 }
 
 
-sequential_ofstream::sequential_ofstream(const string_view& name, ios_base::openmode mode):
-    buffer(ios_base::out, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_ofstream::sequential_ofstream(const string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::out, INVALID_FD_VALUE, buffer_size),
     ostream(&buffer)
 {
     open(name, mode);
@@ -258,8 +288,8 @@ void sequential_ofstream::open(const string_view& name, ios_base::openmode mode)
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
 
-sequential_ofstream::sequential_ofstream(const wstring_view& name, ios_base::openmode mode):
-    buffer(ios_base::out, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_ofstream::sequential_ofstream(const wstring_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::out, INVALID_FD_VALUE, buffer_size),
     ostream(&buffer)
 {
     open(name, mode);
@@ -272,8 +302,8 @@ void sequential_ofstream::open(const wstring_view& name, ios_base::openmode mode
 }
 
 
-sequential_ofstream::sequential_ofstream(const u16string_view& name, ios_base::openmode mode):
-    buffer(ios_base::out, INVALID_FD_VALUE, SEQUENTIAL_BUFFER_SIZE),
+sequential_ofstream::sequential_ofstream(const u16string_view& name, ios_base::openmode mode, size_t buffer_size):
+    buffer(ios_base::out, INVALID_FD_VALUE, buffer_size),
     ostream(&buffer)
 {
     open(name, mode);
@@ -311,4 +341,16 @@ void sequential_ofstream::swap(sequential_ofstream& rhs)
     swap(buffer, rhs.buffer);
 }
 
+
+void sequential_ofstream::adaptive(bool enabled)
+{
+    buffer.adaptive(enabled);
+}
+
+
+void sequential_ofstream::direct(bool enabled)
+{
+    buffer.direct(enabled);
+}
+
 PYCPP_END_NAMESPACE
@@ -7,6 +7,12 @@
  *  Sequential hints for stream behavior significantly improve
  *  performance for sequentially-read files by increasing
  *  read-ahead (doubling it on POSIX systems).
+ *
+ *  Direct streams bypass the page cache, as if by `O_DIRECT`, so
+ *  bulk reads and writes do not evict other cached data. Enable
+ *  direct I/O before reading or writing: buffer sizes are rounded
+ *  to `DIRECT_IO_ALIGNMENT`, and the final partial block is written
+ *  through the page cache on close.
  */
 
 #pragma once
@@ -38,13 +44,13 @@ public:
     sequential_fstream(sequential_fstream &&other);
     sequential_fstream & operator=(sequential_fstream &&other);
 
-    sequential_fstream(const string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
+    sequential_fstream(const string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
-    sequential_fstream(const wstring_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
+    sequential_fstream(const wstring_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const wstring_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
-    sequential_fstream(const u16string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
+    sequential_fstream(const u16string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const u16string_view& name, ios_base::openmode mode = ios_base::in | ios_base::out);
 #endif                                          // WINDOWS
 
@@ -52,6 +58,8 @@ public:
     bool is_open() const;
     void close();
     void swap(sequential_fstream &other);
+    void adaptive(bool enabled);
+    void direct(bool enabled);
 
 private:
     fd_streambuf buffer;
@@ -71,13 +79,13 @@ public:
     sequential_ifstream(sequential_ifstream &&other);
     sequential_ifstream & operator=(sequential_ifstream &&other);
 
-    sequential_ifstream(const string_view& name, ios_base::openmode mode = ios_base::in);
+    sequential_ifstream(const string_view& name, ios_base::openmode mode = ios_base::in, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const string_view& name, ios_base::openmode mode = ios_base::in);
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
-    sequential_ifstream(const wstring_view& name, ios_base::openmode mode = ios_base::in);
+    sequential_ifstream(const wstring_view& name, ios_base::openmode mode = ios_base::in, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const wstring_view& name, ios_base::openmode mode = ios_base::in);
-    sequential_ifstream(const u16string_view& name, ios_base::openmode mode = ios_base::in);
+    sequential_ifstream(const u16string_view& name, ios_base::openmode mode = ios_base::in, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const u16string_view& name, ios_base::openmode mode = ios_base::in);
 #endif                                          // WINDOWS
 
@@ -85,6 +93,17 @@ public:
     bool is_open() const;
     void close();
     void swap(sequential_ifstream &other);
+    void adaptive(bool enabled);
+    void direct(bool enabled);
+
+    // PREFETCH
+    /**
+     *  \brief Read the next block from `engine` while the current one is consumed.
+     *
+     *  Pass `nullptr` to disable prefetching. The engine must outlive
+     *  the stream, or prefetching must be disabled first.
+     */
+    void prefetch(aio_engine* engine);
 
 private:
     fd_streambuf buffer;
@@ -104,13 +123,13 @@ public:
     sequential_ofstream(sequential_ofstream &&other);
     sequential_ofstream & operator=(sequential_ofstream &&other);
 
-    sequential_ofstream(const string_view& name, ios_base::openmode mode = ios_base::out);
+    sequential_ofstream(const string_view& name, ios_base::openmode mode = ios_base::out, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const string_view& name, ios_base::openmode mode = ios_base::out);
 
 #if defined(HAVE_WFOPEN)                        // WINDOWS
-    sequential_ofstream(const wstring_view& name, ios_base::openmode mode = ios_base::out);
+    sequential_ofstream(const wstring_view& name, ios_base::openmode mode = ios_base::out, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const wstring_view& name, ios_base::openmode mode = ios_base::out);
-    sequential_ofstream(const u16string_view& name, ios_base::openmode mode = ios_base::out);
+    sequential_ofstream(const u16string_view& name, ios_base::openmode mode = ios_base::out, size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
     void open(const u16string_view& name, ios_base::openmode mode = ios_base::out);
 #endif                                          // WINDOWS
 
@@ -118,6 +137,8 @@ public:
     bool is_open() const;
     void close();
     void swap(sequential_ofstream &other);
+    void adaptive(bool enabled);
+    void direct(bool enabled);
 
 private:
     fd_streambuf buffer;
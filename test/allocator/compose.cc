@@ -0,0 +1,204 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/compose.h>
+#include <pycpp/allocator/crt.h>
+#include <pycpp/allocator/linear.h>
+#include <pycpp/allocator/null.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+
+PYCPP_USING_NAMESPACE
+
+// TESTS
+// -----
+
+
+TEST(compose, is_relocatable)
+{
+    using linear_type = linear_allocator<int, 200>;
+    using crt_type = crt_allocator<int>;
+    static_assert(is_relocatable<segregator<64, linear_type, crt_type>>::value, "");
+    static_assert(is_relocatable<fallback_allocator<linear_type, crt_type>>::value, "");
+    static_assert(is_relocatable<bucketizer<crt_type, 0, 64, 16>>::value, "");
+}
+
+
+TEST(compose, traits)
+{
+    using linear_type = linear_allocator<int, 200>;
+    using crt_type = crt_allocator<int>;
+    using null_type = null_allocator<int>;
+    static_assert(allocator_has_try_allocate<linear_type>::value, "");
+    static_assert(!allocator_has_try_allocate<crt_type>::value, "");
+    static_assert(allocator_has_owns<linear_type>::value, "");
+    static_assert(!allocator_has_owns<crt_type>::value, "");
+
+    // combinators only own memory if every child does
+    static_assert(allocator_has_owns<fallback_allocator<linear_type, null_type>>::value, "");
+    static_assert(!allocator_has_owns<fallback_allocator<linear_type, crt_type>>::value, "");
+    static_assert(!allocator_has_owns<segregator<64, linear_type, crt_type>>::value, "");
+    static_assert(allocator_has_owns<bucketizer<null_type, 0, 64, 16>>::value, "");
+
+    // rebind
+    using rebound = allocator_traits<fallback_allocator<linear_type, crt_type>>::rebind_alloc<char>;
+    static_assert(is_same<rebound, fallback_allocator<linear_allocator<char, 200>, crt_allocator<char>>>::value, "");
+}
+
+
+TEST(segregator, segregator)
+{
+    using small_type = linear_allocator<int, 200>;
+    using large_type = crt_allocator<int>;
+    using allocator_type = segregator<64, small_type, large_type>;
+
+    typename small_type::arena_type arena;
+    allocator_type allocator{small_type(arena), large_type()};
+
+    // small requests come from the arena
+    int* small = allocator.allocate(16);
+    EXPECT_TRUE(allocator.small().owns(small, 16));
+    EXPECT_EQ(arena.used(), 64);
+
+    // large requests bypass the arena
+    int* large = allocator.allocate(17);
+    EXPECT_FALSE(allocator.small().owns(large, 17));
+    EXPECT_EQ(arena.used(), 64);
+
+    allocator.deallocate(large, 17);
+    allocator.deallocate(small, 16);
+
+    // try_allocate fails without throwing
+    EXPECT_NE(allocator.try_allocate(4), nullptr);
+    EXPECT_EQ(allocator_try_allocate(allocator.small(), 100), nullptr);
+}
+
+
+TEST(fallback_allocator, fallback_allocator)
+{
+    using primary_type = linear_allocator<int, 64>;
+    using secondary_type = crt_allocator<int>;
+    using allocator_type = fallback_allocator<primary_type, secondary_type>;
+
+    typename primary_type::arena_type arena;
+    allocator_type allocator{primary_type(arena), secondary_type()};
+
+    int* p1 = allocator.allocate(8);
+    EXPECT_TRUE(allocator.primary().owns(p1, 8));
+
+    // primary is exhausted
+    int* p2 = allocator.allocate(16);
+    EXPECT_FALSE(allocator.primary().owns(p2, 16));
+    p2[15] = 1;
+
+    // requests larger than the primary
+    int* p3 = allocator.allocate(1000);
+    p3[999] = 1;
+
+    allocator.deallocate(p3, 1000);
+    allocator.deallocate(p2, 16);
+    allocator.deallocate(p1, 8);
+    EXPECT_EQ(arena.used(), 32);
+}
+
+
+TEST(fallback_allocator, null)
+{
+    using primary_type = null_allocator<int>;
+    using secondary_type = crt_allocator<int>;
+    using allocator_type = fallback_allocator<primary_type, secondary_type>;
+
+    allocator_type allocator;
+    int* p = allocator.allocate(10);
+    p[9] = 1;
+    allocator.deallocate(p, 10);
+    EXPECT_EQ(allocator, allocator_type());
+
+    // nothing to fall back to
+    fallback_allocator<primary_type, primary_type> empty;
+    EXPECT_THROW(empty.allocate(1), bad_alloc);
+    EXPECT_EQ(empty.try_allocate(1), nullptr);
+}
+
+
+TEST(bucketizer, bucketizer)
+{
+    using bucket_type = crt_allocator<char>;
+    using allocator_type = bucketizer<bucket_type, 0, 64, 16>;
+    static_assert(allocator_type::bucket_count == 4, "");
+
+    allocator_type allocator;
+    char* p1 = allocator.allocate(1);
+    char* p2 = allocator.allocate(64);
+    p2[63] = 1;
+    allocator.deallocate(p2, 64);
+    allocator.deallocate(p1, 1);
+
+    // out of range
+    EXPECT_THROW(allocator.allocate(0), bad_alloc);
+    EXPECT_THROW(allocator.allocate(65), bad_alloc);
+    EXPECT_EQ(allocator.try_allocate(65), nullptr);
+}
+
+
+TEST(bucketizer, rounding)
+{
+    using bucket_type = linear_allocator<char, 256>;
+    using allocator_type = bucketizer<bucket_type, 16, 48, 16>;
+
+    typename bucket_type::arena_type a1, a2;
+    allocator_type allocator;
+    allocator.bucket(0) = bucket_type(a1);
+    allocator.bucket(1) = bucket_type(a2);
+
+    // requests are rounded up to the bucket size
+    char* p1 = allocator.allocate(17);
+    EXPECT_EQ(a1.used(), 32);
+    char* p2 = allocator.allocate(33);
+    EXPECT_EQ(a2.used(), 48);
+    EXPECT_TRUE(allocator.owns(p1, 17));
+    EXPECT_FALSE(allocator.owns(p1, 40));
+    EXPECT_FALSE(allocator.owns(p1, 4));
+
+    allocator.deallocate(p2, 33);
+    allocator.deallocate(p1, 17);
+}
+
+
+TEST(compose, containers)
+{
+    using small_type = linear_allocator<int, 4096>;
+    using large_type = crt_allocator<int>;
+    using allocator_type = segregator<64, fallback_allocator<small_type, large_type>, large_type>;
+
+    typename small_type::arena_type arena;
+    allocator_type allocator({small_type(arena), large_type()}, large_type());
+
+    std::list<int, allocator_type> l(allocator);
+    vector<int, allocator_type> v(allocator);
+    for (int i = 0; i < 1000; ++i) {
+        l.push_back(i);
+        v.push_back(i);
+    }
+    EXPECT_EQ(l.size(), 1000);
+    EXPECT_EQ(v.back(), 999);
+    EXPECT_GT(arena.used(), 0);
+}
+
+
+TEST(compose, polymorphic)
+{
+    using allocator_type = polymorphic_allocator<int>;
+    using primary_type = linear_allocator<byte, 256>;
+    using resource_type = resource_adaptor<fallback_allocator<primary_type, crt_allocator<byte>>>;
+    using vector = vector<int, allocator_type>;
+
+    typename primary_type::arena_type arena;
+    resource_type resource({primary_type(arena), crt_allocator<byte>()});
+    vector v1 = vector(allocator_type(&resource));
+    for (int i = 0; i < 1000; ++i) {
+        v1.emplace_back(i);
+    }
+    EXPECT_EQ(v1.back(), 999);
+}
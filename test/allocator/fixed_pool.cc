@@ -0,0 +1,216 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/fixed_pool.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/map.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+PYCPP_USING_NAMESPACE
+
+// TESTS
+// -----
+
+
+TEST(fixed_pool, is_relocatable)
+{
+    using allocator_type = fixed_pool_allocator<char>;
+    using arena_type = typename allocator_type::arena_type;
+    using resource_type = fixed_pool_resource<64>;
+    static_assert(is_relocatable<allocator_type>::value, "");
+    static_assert(!is_relocatable<arena_type>::value, "");
+    static_assert(is_relocatable<resource_type>::value, "");
+}
+
+
+TEST(fixed_pool_arena, fixed_pool_arena)
+{
+    using arena_type = fixed_pool_arena<24, 128, 8>;
+    static_assert(arena_type::block_size == 24, "");
+    arena_type arena;
+    EXPECT_EQ(arena.superblocks(), 0);
+
+    // slots are packed densely, lowest address first
+    byte* p1 = static_cast<byte*>(arena.allocate());
+    byte* p2 = static_cast<byte*>(arena.allocate());
+    EXPECT_EQ(p2 - p1, 24);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p1) % 8, 0);
+    EXPECT_TRUE(arena.owns(p1));
+    EXPECT_FALSE(arena.owns(&arena));
+    EXPECT_EQ(arena.size(), 2);
+    EXPECT_EQ(arena.capacity(), 128);
+
+    // freed slots are reused first
+    arena.deallocate(p1);
+    EXPECT_EQ(arena.allocate(), p1);
+
+    // grow to a second superblock
+    vector<void*> slots;
+    for (size_t i = 2; i < 129; ++i) {
+        slots.push_back(arena.allocate());
+    }
+    EXPECT_EQ(arena.superblocks(), 2);
+    EXPECT_EQ(arena.size(), 129);
+    arena.deallocate(p2);
+    EXPECT_EQ(arena.allocate(), p2);
+
+    // reset keeps superblocks
+    arena.reset();
+    EXPECT_EQ(arena.size(), 0);
+    EXPECT_EQ(arena.superblocks(), 2);
+    EXPECT_EQ(arena.begin(), arena.end());
+}
+
+
+TEST(fixed_pool_arena, max_size)
+{
+    using arena_type = fixed_pool_arena<16, 4096>;
+    arena_type arena(100);
+    EXPECT_EQ(arena.max_size(), 100);
+
+    vector<void*> slots(100);
+    arena.allocate(slots.data(), slots.size());
+    EXPECT_EQ(arena.capacity(), 128);
+    EXPECT_THROW(arena.allocate(), bad_alloc);
+    EXPECT_EQ(arena.try_allocate(), nullptr);
+
+    // failed bulk allocations claim nothing
+    arena.deallocate(slots.data(), 10);
+    void* extra[11];
+    EXPECT_THROW(arena.allocate(extra, 11), bad_alloc);
+    EXPECT_EQ(arena.size(), 90);
+    arena.allocate(extra, 10);
+    EXPECT_EQ(arena.size(), 100);
+}
+
+
+TEST(fixed_pool_arena, bulk)
+{
+    using arena_type = fixed_pool_arena<8, 128, 8>;
+    arena_type arena;
+
+    // bulk allocation spans words and superblocks
+    vector<void*> slots(300);
+    arena.allocate(slots.data(), slots.size());
+    EXPECT_EQ(arena.size(), 300);
+    EXPECT_EQ(arena.superblocks(), 3);
+    for (void* p: slots) {
+        *static_cast<uint64_t*>(p) = reinterpret_cast<uintptr_t>(p);
+    }
+
+    // free every other slot, then refill the holes
+    vector<void*> odd;
+    for (size_t i = 1; i < slots.size(); i += 2) {
+        odd.push_back(slots[i]);
+    }
+    arena.deallocate(odd.data(), odd.size());
+    EXPECT_EQ(arena.size(), 150);
+
+    vector<void*> refill(150);
+    arena.allocate(refill.data(), refill.size());
+    EXPECT_EQ(arena.superblocks(), 3);
+    for (size_t i = 0; i < refill.size(); ++i) {
+        EXPECT_EQ(refill[i], odd[i]);
+    }
+    for (size_t i = 0; i < slots.size(); i += 2) {
+        EXPECT_EQ(*static_cast<uint64_t*>(slots[i]), reinterpret_cast<uintptr_t>(slots[i]));
+    }
+}
+
+
+TEST(fixed_pool_arena, iterator)
+{
+    using arena_type = fixed_pool_arena<16, 128>;
+    arena_type arena;
+    EXPECT_EQ(arena.begin(), arena.end());
+
+    vector<void*> slots(200);
+    arena.allocate(slots.data(), slots.size());
+    for (size_t i = 0; i < slots.size(); i += 3) {
+        arena.deallocate(slots[i]);
+    }
+
+    // live slots are visited once, in address order
+    size_t count = 0;
+    const byte* last = nullptr;
+    for (void* p: arena) {
+        const byte* b = static_cast<const byte*>(p);
+        EXPECT_TRUE(last == nullptr || last < b);
+        last = b;
+        ++count;
+    }
+    EXPECT_EQ(count, arena.size());
+    EXPECT_EQ(count, 133);
+}
+
+
+TEST(fixed_pool_allocator, fixed_pool_allocator)
+{
+    using allocator_type = fixed_pool_allocator<int>;
+    using arena_type = typename allocator_type::arena_type;
+    arena_type arena;
+    allocator_type allocator(arena);
+
+    int* p1 = allocator.allocate(1);
+    EXPECT_TRUE(allocator.owns(p1, 1));
+    EXPECT_EQ(arena.size(), 1);
+
+    // arrays are forwarded
+    int* p2 = allocator.allocate(10);
+    EXPECT_FALSE(allocator.owns(p2, 10));
+    EXPECT_EQ(arena.size(), 1);
+
+    allocator.deallocate(p2, 10);
+    allocator.deallocate(p1, 1);
+    EXPECT_EQ(arena.size(), 0);
+
+    // rebound allocators share the arena
+    fixed_pool_allocator<char, sizeof(int), FIXED_POOL_BLOCK_COUNT, alignof(int)> rebound(allocator);
+    EXPECT_EQ(rebound, allocator);
+}
+
+
+TEST(fixed_pool_allocator, containers)
+{
+    using node_allocator = fixed_pool_allocator<int, 64, 256, alignof(max_align_t)>;
+    using arena_type = typename node_allocator::arena_type;
+    arena_type arena;
+
+    std::list<int, node_allocator> l{node_allocator(arena)};
+    std::map<int, int, std::less<int>, fixed_pool_allocator<std::pair<const int, int>, 64, 256, alignof(max_align_t)>> m{node_allocator(arena)};
+    for (int i = 0; i < 1000; ++i) {
+        l.push_back(i);
+        m.emplace(i, i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        m.erase(i);
+    }
+    EXPECT_EQ(l.size(), 1000);
+    EXPECT_EQ(m.size(), 500);
+    EXPECT_EQ(arena.size(), 1500);
+
+    l.clear();
+    m.clear();
+    EXPECT_EQ(arena.size(), 0);
+}
+
+
+TEST(fixed_pool_allocator, polymorphic)
+{
+    using allocator_type = polymorphic_allocator<int>;
+    using resource_type = fixed_pool_resource<64>;
+    using arena_type = typename resource_type::allocator_type::arena_type;
+    using vector = vector<int, allocator_type>;
+
+    arena_type arena;
+    resource_type resource{typename resource_type::allocator_type(arena)};
+    vector v1 = vector(allocator_type(&resource));
+    v1.reserve(4);
+    EXPECT_EQ(arena.size(), 1);
+    for (int i = 0; i < 1000; ++i) {
+        v1.emplace_back(i);
+    }
+    EXPECT_EQ(v1.back(), 999);
+}
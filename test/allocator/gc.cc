@@ -0,0 +1,251 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/gc.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/map.h>
+#include <pycpp/stl/string.h>
+#include <pycpp/stl/thread.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+
+PYCPP_USING_NAMESPACE
+
+// HELPERS
+// -------
+
+/**
+ *  \brief Node in a cyclic graph, with edges allocated from the arena.
+ */
+struct gc_node
+{
+    using allocator_type = gc_allocator<gc_node*>;
+
+    int value;
+    std::vector<gc_node*, allocator_type> edges;
+
+    gc_node(int v, const allocator_type& allocator):
+        value(v),
+        edges(allocator)
+    {}
+};
+
+
+/**
+ *  \brief Record the order of destruction.
+ */
+struct gc_finalized
+{
+    vector<int>* order;
+    int value;
+
+    gc_finalized(vector<int>* o, int v):
+        order(o),
+        value(v)
+    {}
+
+    ~gc_finalized()
+    {
+        order->push_back(value);
+    }
+};
+
+// TESTS
+// -----
+
+
+TEST(gc, is_relocatable)
+{
+    using allocator_type = gc_allocator<char>;
+    using arena_type = typename allocator_type::arena_type;
+    static_assert(is_relocatable<allocator_type>::value, "");
+    static_assert(!is_relocatable<arena_type>::value, "");
+}
+
+
+TEST(gc_arena, gc_arena)
+{
+    using arena_type = gc_arena<>;
+    arena_type arena(256);
+    EXPECT_EQ(arena.epoch(), 0);
+    EXPECT_EQ(arena.regions(), 0);
+
+    // allocations bump within the current region
+    byte* p1 = arena.allocate(16, 8);
+    byte* p2 = arena.allocate(16, 8);
+    EXPECT_EQ(p2 - p1, 16);
+    EXPECT_EQ(arena.regions(), 1);
+    EXPECT_EQ(arena.used(), 32);
+
+    // the most recent allocation is returned
+    arena.deallocate(p2, 16, 8);
+    EXPECT_EQ(arena.used(), 16);
+    EXPECT_EQ(arena.allocate(16, 8), p2);
+    arena.deallocate(p1, 16, 8);
+    EXPECT_EQ(arena.used(), 32);
+
+    // alignment is respected
+    byte* p3 = arena.allocate(1, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p3) % 64, 0);
+
+    // large requests chain blocks
+    arena.allocate(1000, 8);
+    EXPECT_EQ(arena.regions(), 1);
+    EXPECT_GE(arena.size(), 1000);
+
+    // each epoch has its own region
+    EXPECT_EQ(arena.advance(), 1);
+    arena.allocate(16, 8);
+    EXPECT_EQ(arena.advance(), 2);
+    EXPECT_EQ(arena.regions(), 2);
+    arena.allocate(16, 8);
+    EXPECT_EQ(arena.regions(), 3);
+
+    // retire frees every epoch up to the argument
+    arena.retire(1);
+    EXPECT_EQ(arena.regions(), 1);
+    EXPECT_EQ(arena.used(), 16);
+    EXPECT_EQ(arena.epoch(), 2);
+
+    // retiring the current epoch starts a new one
+    arena.retire(2);
+    EXPECT_EQ(arena.regions(), 0);
+    EXPECT_EQ(arena.epoch(), 3);
+    EXPECT_EQ(arena.size(), 0);
+
+    arena.allocate(16, 8);
+    arena.clear();
+    EXPECT_EQ(arena.regions(), 0);
+    EXPECT_EQ(arena.used(), 0);
+}
+
+
+TEST(gc_arena, create)
+{
+    using arena_type = gc_arena<>;
+    vector<int> order;
+    arena_type arena;
+
+    // finalizers run in reverse order, by epoch
+    arena.create<gc_finalized>(&order, 1);
+    arena.create<gc_finalized>(&order, 2);
+    auto epoch = arena.advance();
+    arena.create<gc_finalized>(&order, 3);
+    arena.create<int>(4);
+
+    arena.retire(epoch - 1);
+    EXPECT_EQ(order, vector<int>({2, 1}));
+    arena.retire(epoch);
+    EXPECT_EQ(order, vector<int>({2, 1, 3}));
+
+    // strings may allocate from the arena themselves
+    using string_type = std::basic_string<char, std::char_traits<char>, gc_allocator<char>>;
+    string_type* s = arena.create<string_type>(100, 'a', gc_allocator<char>(arena));
+    EXPECT_EQ(s->size(), 100);
+    arena.clear();
+}
+
+
+TEST(gc_allocator, gc_allocator)
+{
+    using allocator_type = gc_allocator<int>;
+    using arena_type = typename allocator_type::arena_type;
+    arena_type arena;
+    allocator_type allocator(arena);
+
+    int* p1 = allocator.allocate(10);
+    int* p2 = allocator.allocate(10);
+    EXPECT_EQ(p2 - p1, 10);
+    allocator.deallocate(p2, 10);
+    EXPECT_EQ(arena.used(), 40);
+
+    // rebound allocators share the arena
+    gc_allocator<char> rebound(allocator);
+    EXPECT_EQ(rebound, allocator);
+    EXPECT_NE(rebound, gc_allocator<char>());
+}
+
+
+TEST(gc_allocator, graph)
+{
+    using arena_type = gc_arena<>;
+    arena_type arena(1024);
+    gc_node::allocator_type allocator(arena);
+
+    // build a cyclic graph, then retire it without visiting nodes
+    for (int round = 0; round < 4; ++round) {
+        auto epoch = arena.epoch();
+        vector<gc_node*> nodes;
+        for (int i = 0; i < 1000; ++i) {
+            nodes.push_back(arena.create<gc_node>(i, allocator));
+        }
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            nodes[i]->edges.push_back(nodes[(i + 1) % nodes.size()]);
+            nodes[i]->edges.push_back(nodes[(i * 7) % nodes.size()]);
+        }
+        EXPECT_EQ(nodes.back()->edges.front(), nodes.front());
+        EXPECT_EQ(arena.regions(), 1);
+
+        arena.retire(epoch);
+        EXPECT_EQ(arena.regions(), 0);
+    }
+}
+
+
+TEST(gc_allocator, containers)
+{
+    using allocator_type = gc_allocator<int>;
+    using arena_type = typename allocator_type::arena_type;
+    arena_type arena;
+
+    std::list<int, allocator_type> l{allocator_type(arena)};
+    std::map<int, int, std::less<int>, gc_allocator<std::pair<const int, int>>> m{allocator_type(arena)};
+    for (int i = 0; i < 1000; ++i) {
+        l.push_back(i);
+        m.emplace(i, i);
+    }
+    EXPECT_EQ(l.size(), 1000);
+    EXPECT_EQ(m.size(), 1000);
+}
+
+
+TEST(gc_allocator, threads)
+{
+    using allocator_type = gc_locked_allocator<int>;
+    using arena_type = typename allocator_type::arena_type;
+    arena_type arena;
+
+    vector<thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&arena]() {
+            std::vector<int, allocator_type> v{allocator_type(arena)};
+            for (int i = 0; i < 1000; ++i) {
+                v.push_back(i);
+            }
+            EXPECT_EQ(v.back(), 999);
+        });
+    }
+    for (thread& t: threads) {
+        t.join();
+    }
+    arena.clear();
+    EXPECT_EQ(arena.regions(), 0);
+}
+
+
+TEST(gc_allocator, polymorphic)
+{
+    using allocator_type = polymorphic_allocator<int>;
+    using resource_type = gc_resource<>;
+    using arena_type = typename resource_type::allocator_type::arena_type;
+    using vector = vector<int, allocator_type>;
+
+    arena_type arena;
+    resource_type resource{typename resource_type::allocator_type(arena)};
+    vector v1 = vector(allocator_type(&resource));
+    for (int i = 0; i < 1000; ++i) {
+        v1.emplace_back(i);
+    }
+    EXPECT_EQ(v1.back(), 999);
+    EXPECT_EQ(arena.regions(), 1);
+}
@@ -0,0 +1,169 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/growable.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+PYCPP_USING_NAMESPACE
+
+// TESTS
+// -----
+
+
+TEST(growable, is_relocatable)
+{
+    using allocator_type = growable_allocator<char, 200>;
+    using arena_type = typename allocator_type::arena_type;
+    using resource_type = growable_resource<200>;
+    static_assert(is_relocatable<allocator_type>::value, "");
+    static_assert(!is_relocatable<arena_type>::value, "");
+    static_assert(is_relocatable<resource_type>::value, "");
+}
+
+
+TEST(growable_arena, growable_arena)
+{
+    using arena_type = growable_arena<64, 16>;
+    arena_type arena(128);
+    EXPECT_EQ(arena.size(), 64);
+
+    // inline buffer first
+    byte* p1 = arena.allocate<1>(20);
+    byte* p2 = arena.allocate<1>(20);
+    EXPECT_EQ(p2, p1 + 32);
+    EXPECT_EQ(arena.used(), 64);
+    EXPECT_EQ(arena.blocks(), 0);
+
+    // heap blocks grow geometrically, or fit the request
+    byte* p3 = arena.allocate<1>(100);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p3) % 16, 0);
+    EXPECT_EQ(arena.blocks(), 1);
+    EXPECT_EQ(arena.size(), 64 + 128);
+    arena.allocate<1>(100);
+    EXPECT_EQ(arena.size(), 64 + 128 + 256);
+    arena.allocate<1>(1000);
+    EXPECT_EQ(arena.blocks(), 3);
+    EXPECT_EQ(arena.size(), 64 + 128 + 256 + 1008);
+
+    // over-aligned requests
+    byte* p4 = arena.allocate<64>(8);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p4) % 64, 0);
+
+    // the most recent allocation is returned
+    size_t used = arena.used();
+    byte* p5 = arena.allocate<1>(16);
+    arena.deallocate(p5, 16);
+    EXPECT_EQ(arena.used(), used);
+    EXPECT_EQ(arena.allocate<1>(16), p5);
+}
+
+
+TEST(growable_arena, reset)
+{
+    growable_arena<> arena(64);
+    EXPECT_EQ(arena.size(), 0);
+    for (size_t i = 0; i < 10; ++i) {
+        arena.allocate<1>(64);
+    }
+    EXPECT_EQ(arena.blocks(), 4);
+
+    // the largest block is retained for reuse
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0);
+    EXPECT_EQ(arena.blocks(), 0);
+    EXPECT_EQ(arena.size(), 0);
+    arena.allocate<1>(64);
+    EXPECT_EQ(arena.blocks(), 1);
+    EXPECT_EQ(arena.size(), 512);
+}
+
+
+TEST(growable_arena, rewind)
+{
+    byte buffer[64];
+    growable_arena<> arena(buffer, sizeof(buffer), 64);
+    byte* p1 = arena.allocate<1>(32);
+    EXPECT_GE(p1, buffer);
+    EXPECT_LT(p1, buffer + sizeof(buffer));
+
+    auto marker = arena.mark();
+    size_t used = arena.used();
+    byte* p2 = arena.allocate<1>(16);
+    for (size_t i = 0; i < 10; ++i) {
+        arena.allocate<1>(64);
+    }
+    EXPECT_GT(arena.blocks(), 0);
+
+    arena.rewind(marker);
+    EXPECT_EQ(arena.used(), used);
+    EXPECT_EQ(arena.blocks(), 0);
+    EXPECT_EQ(arena.allocate<1>(16), p2);
+
+    // rewind within a heap block
+    arena.allocate<1>(64);
+    marker = arena.mark();
+    byte* p3 = arena.allocate<1>(16);
+    arena.allocate<1>(16);
+    arena.rewind(marker);
+    EXPECT_EQ(arena.blocks(), 1);
+    EXPECT_EQ(arena.allocate<1>(16), p3);
+}
+
+
+TEST(growable_allocator, growable_allocator)
+{
+    using allocator_type = growable_allocator<char, 200>;
+    using arena_type = typename allocator_type::arena_type;
+    arena_type arena;
+    allocator_type allocator(arena);
+
+    char* ptr = allocator.allocate(50);
+    allocator.deallocate(ptr, 50);
+
+    // allocate larger than buffer
+    ptr = allocator.allocate(250);
+    EXPECT_EQ(arena.blocks(), 1);
+    EXPECT_THROW(allocator.allocate(std::numeric_limits<size_t>::max()), bad_alloc);
+}
+
+
+TEST(growable_allocator, containers)
+{
+    using allocator_type = growable_locked_allocator<int, 128>;
+    using arena_type = typename allocator_type::arena_type;
+    using list = std::list<int, allocator_type>;
+    using vector = vector<int, allocator_type>;
+
+    arena_type arena;
+    list l(arena);
+    vector v(arena);
+    for (int i = 0; i < 1000; ++i) {
+        l.push_back(i);
+        v.push_back(i);
+    }
+    EXPECT_EQ(l.back(), 999);
+    EXPECT_EQ(v.back(), 999);
+    EXPECT_GT(arena.blocks(), 1);
+}
+
+
+TEST(growable_allocator, polymorphic)
+{
+    using allocator_type = polymorphic_allocator<int>;
+    using resource_type = growable_resource<64>;
+    using arena_type = typename resource_type::allocator_type::arena_type;
+    using vector = vector<int, allocator_type>;
+
+    arena_type arena;
+    resource_type resource(arena);
+    vector v1 = vector(allocator_type(&resource));
+    for (int i = 0; i < 100; ++i) {
+        v1.emplace_back(i);
+    }
+
+    EXPECT_GE(arena.used(), 100 * sizeof(int));
+    EXPECT_GT(arena.blocks(), 0);
+}
@@ -30,10 +30,12 @@ TEST(linear_allocator, linear_allocator)
     allocator_type allocator(arena);
 
     char* ptr = allocator.allocate(50);
+    EXPECT_TRUE(allocator.owns(ptr, 50));
     allocator.deallocate(ptr, 50);
 
     // allocate larger than buffer
     EXPECT_THROW(allocator.allocate(250), bad_alloc);
+    EXPECT_EQ(allocator.try_allocate(250), nullptr);
 }
 
 
@@ -0,0 +1,132 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/micro.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/map.h>
+#include <pycpp/stl/thread.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+PYCPP_USING_NAMESPACE
+
+// TESTS
+// -----
+
+
+TEST(micro, is_relocatable)
+{
+    using allocator_type = micro_allocator<char>;
+    using resource_type = micro_resource;
+    static_assert(is_relocatable<allocator_type>::value, "");
+    static_assert(is_relocatable<resource_type>::value, "");
+}
+
+
+TEST(micro_allocator, micro_allocator)
+{
+    using allocator_type = micro_allocator<char>;
+    allocator_type allocator;
+
+    // freed blocks are reused by the thread
+    char* ptr = allocator.allocate(50);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignof(max_align_t), 0);
+    allocator.deallocate(ptr, 50);
+    EXPECT_EQ(allocator.allocate(49), ptr);
+    allocator.deallocate(ptr, 49);
+
+    // large requests are forwarded
+    ptr = allocator.allocate(MICRO_MAX_SIZE + 1);
+    allocator.deallocate(ptr, MICRO_MAX_SIZE + 1);
+    EXPECT_THROW(micro_allocator<int>().allocate(std::numeric_limits<size_t>::max()), bad_alloc);
+
+    // rebound allocators compare equal
+    micro_allocator<int> rebound(allocator);
+    EXPECT_EQ(rebound, allocator);
+}
+
+
+TEST(micro_allocator, containers)
+{
+    std::list<int, micro_allocator<int>> l;
+    std::map<int, int, std::less<int>, micro_allocator<std::pair<const int, int>>> m;
+    vector<int, micro_allocator<int>> v;
+    for (int i = 0; i < 1000; ++i) {
+        l.push_back(i);
+        m.emplace(i, i);
+        v.push_back(i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        m.erase(i);
+    }
+
+    EXPECT_EQ(l.size(), 1000);
+    EXPECT_EQ(m.size(), 500);
+    EXPECT_EQ(v.back(), 999);
+}
+
+
+TEST(micro_allocator, threads)
+{
+    // blocks allocated by one thread and freed by another
+    using allocator_type = micro_allocator<size_t>;
+    vector<size_t*> blocks(4000);
+    thread producer([&]() {
+        allocator_type allocator;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            blocks[i] = allocator.allocate(1);
+            *blocks[i] = i;
+        }
+    });
+    producer.join();
+
+    vector<thread> consumers;
+    for (size_t t = 0; t < 4; ++t) {
+        consumers.emplace_back([&, t]() {
+            allocator_type allocator;
+            for (size_t i = t; i < blocks.size(); i += 4) {
+                EXPECT_EQ(*blocks[i], i);
+                allocator.deallocate(blocks[i], 1);
+            }
+            for (size_t round = 0; round < 50; ++round) {
+                vector<size_t*> local;
+                for (size_t i = 0; i < 100; ++i) {
+                    local.push_back(allocator.allocate(1));
+                    *local.back() = t;
+                }
+                for (size_t* p: local) {
+                    EXPECT_EQ(*p, t);
+                    allocator.deallocate(p, 1);
+                }
+            }
+        });
+    }
+    for (thread& t: consumers) {
+        t.join();
+    }
+}
+
+
+TEST(micro_allocator, polymorphic)
+{
+    using allocator_type = polymorphic_allocator<int>;
+    using resource_type = micro_resource;
+    using vector = vector<int, allocator_type>;
+
+    resource_type resource;
+    memory_resource* previous = set_default_resource(&resource);
+    {
+        vector v1 = vector(allocator_type());
+        EXPECT_EQ(v1.get_allocator().resource(), &resource);
+        for (int i = 0; i < 100; ++i) {
+            v1.emplace_back(i);
+        }
+        std::list<int, allocator_type> l;
+        l.push_back(1);
+    }
+    set_default_resource(previous);
+
+    resource_type other;
+    EXPECT_TRUE(resource.is_equal(other));
+}
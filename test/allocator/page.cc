@@ -0,0 +1,133 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/page.h>
+#include <pycpp/preprocessor/os.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <string.h>
+
+PYCPP_USING_NAMESPACE
+
+// HELPERS
+// -------
+
+
+static bool is_aligned(const void* p, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+// TESTS
+// -----
+
+
+TEST(page, is_relocatable)
+{
+    using allocator_type = page_allocator<char>;
+    using resource_type = page_resource;
+    static_assert(is_relocatable<allocator_type>::value, "");
+    static_assert(is_relocatable<resource_type>::value, "");
+}
+
+
+TEST(page_allocator, page_allocator)
+{
+    using allocator_type = page_allocator<char>;
+    allocator_type allocator;
+    size_t page = allocator_type::page_size();
+    EXPECT_EQ(page & (page - 1), 0);
+    EXPECT_GE(allocator_type::huge_page_size(), page);
+
+    char* ptr = allocator.allocate(50);
+    EXPECT_TRUE(is_aligned(ptr, page));
+    memset(ptr, 1, page);
+    allocator.deallocate(ptr, 50);
+
+    EXPECT_THROW(page_allocator<int>().allocate(std::numeric_limits<size_t>::max()), bad_alloc);
+
+    // allocators compare equal if memory is mapped alike
+    page_options options;
+    options.node = 0;
+    EXPECT_EQ(allocator, page_allocator<int>(options));
+    options.huge = page_huge_transparent;
+    EXPECT_NE(allocator, page_allocator<int>(options));
+}
+
+
+TEST(page_allocator, huge)
+{
+    using allocator_type = page_allocator<char>;
+    size_t huge = allocator_type::huge_page_size();
+
+    page_options options;
+    options.huge = page_huge_transparent;
+    allocator_type transparent(options);
+    char* ptr = transparent.allocate(huge + 1);
+#if !defined(OS_WINDOWS)
+    EXPECT_TRUE(is_aligned(ptr, huge));
+#endif
+    memset(ptr, 1, huge + 1);
+    transparent.deallocate(ptr, huge + 1);
+
+    // falls back if no huge pages are reserved
+    options.huge = page_huge_explicit;
+    allocator_type explicit_(options);
+    ptr = explicit_.allocate(100);
+    memset(ptr, 1, 100);
+    explicit_.deallocate(ptr, 100);
+}
+
+
+TEST(page_allocator, node)
+{
+    page_options options;
+    options.node = 0;
+    page_allocator<int> allocator(options);
+    int* ptr = allocator.allocate(1000);
+    ptr[999] = 1;
+    allocator.deallocate(ptr, 1000);
+}
+
+
+TEST(page_allocator, release)
+{
+    using allocator_type = page_allocator<char>;
+    allocator_type allocator;
+    size_t page = allocator_type::page_size();
+
+    char* ptr = allocator.allocate(4 * page);
+    memset(ptr, 1, 4 * page);
+
+    // partial pages are kept
+    allocator.release(ptr + 1, 2 * page);
+    EXPECT_EQ(ptr[0], 1);
+    EXPECT_EQ(ptr[2 * page], 1);
+#if defined(HAVE_MADVISE) || defined(OS_WINDOWS)
+    EXPECT_EQ(ptr[page], 0);
+    EXPECT_EQ(ptr[2 * page - 1], 0);
+#endif
+
+    // released pages remain usable
+    ptr[page] = 2;
+    EXPECT_EQ(ptr[page], 2);
+    allocator.deallocate(ptr, 4 * page);
+}
+
+
+TEST(page_allocator, polymorphic)
+{
+    using allocator_type = polymorphic_allocator<int>;
+    using resource_type = page_resource;
+    using vector = vector<int, allocator_type>;
+
+    page_options options;
+    options.huge = page_huge_transparent;
+    resource_type resource{page_allocator<byte>(options)};
+    vector v1 = vector(allocator_type(&resource));
+    for (int i = 0; i < 10000; ++i) {
+        v1.emplace_back(i);
+    }
+    EXPECT_TRUE(is_aligned(v1.data(), page_allocator<int>::page_size()));
+}
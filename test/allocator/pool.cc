@@ -2,25 +2,245 @@
 //  :license: MIT, see licenses/mit.md for more details.
 
 #include <pycpp/allocator/pool.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/map.h>
+#include <pycpp/stl/thread.h>
+#include <pycpp/stl/unordered_map.h>
+#include <pycpp/stl/vector.h>
 #include <gtest/gtest.h>
+#include <string.h>
 
 PYCPP_USING_NAMESPACE
 
+// HELPERS
+// -------
+
+
+template <typename Allocator>
+static void test_containers()
+{
+    using list_allocator = typename allocator_traits<Allocator>::template rebind_alloc<int>;
+    using map_allocator = typename allocator_traits<Allocator>::template rebind_alloc<std::pair<const int, int>>;
+
+    std::list<int, list_allocator> l;
+    std::map<int, int, std::less<int>, map_allocator> m;
+    std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, map_allocator> u;
+    for (int i = 0; i < 1000; ++i) {
+        l.push_back(i);
+        m.emplace(i, i);
+        u.emplace(i, i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        m.erase(i);
+        u.erase(i);
+    }
+    l.remove_if([](int i) { return i % 2 == 0; });
+
+    EXPECT_EQ(l.size(), 500);
+    EXPECT_EQ(m.size(), 500);
+    EXPECT_EQ(u.size(), 500);
+    EXPECT_EQ(l.front(), 1);
+    EXPECT_EQ(m.begin()->first, 1);
+    EXPECT_EQ(u.at(999), 999);
+}
+
+
+template <typename Allocator>
+static void test_threads()
+{
+    using value_type = typename Allocator::value_type;
+    vector<thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([t]() {
+            Allocator allocator;
+            vector<value_type*> blocks;
+            for (size_t round = 0; round < 50; ++round) {
+                for (size_t i = 0; i < 200; ++i) {
+                    blocks.push_back(allocator.allocate(1));
+                    *blocks.back() = static_cast<value_type>(t);
+                }
+                for (value_type* p: blocks) {
+                    EXPECT_EQ(*p, static_cast<value_type>(t));
+                    allocator.deallocate(p, 1);
+                }
+                blocks.clear();
+            }
+        });
+    }
+    for (thread& t: threads) {
+        t.join();
+    }
+}
+
 // TESTS
 // -----
 
 
+TEST(pool, is_relocatable)
+{
+    using allocator_type = pool_allocator<char>;
+    using arena_type = typename allocator_type::arena_type;
+    using resource_type = pool_resource<64>;
+    static_assert(is_relocatable<allocator_type>::value, "");
+    static_assert(!is_relocatable<arena_type>::value, "");
+    static_assert(!is_relocatable<resource_type>::value, "");
+}
+
+
+TEST(pool_arena, pool_arena)
+{
+    using arena_type = pool_arena<24, 4, 16>;
+    static_assert(arena_type::block_size == 32, "");
+    static_assert(pool_arena<1, 4, 1>::block_size == sizeof(void*), "");
+
+    arena_type arena;
+    vector<void*> blocks;
+    for (size_t i = 0; i < 9; ++i) {
+        blocks.push_back(arena.allocate());
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(blocks.back()) % 16, 0);
+    }
+    EXPECT_EQ(arena.chunks(), 3);
+
+    // freed blocks are reused before growing
+    arena.deallocate(blocks[4]);
+    EXPECT_EQ(arena.allocate(), blocks[4]);
+    for (void* p: blocks) {
+        arena.deallocate(p);
+    }
+    for (size_t i = 0; i < 9; ++i) {
+        arena.allocate();
+    }
+    EXPECT_EQ(arena.chunks(), 3);
+}
+
+
+TEST(pool_arena, lock_free)
+{
+    using arena_type = pool_arena<8, 3, 8, pool_lock_free>;
+    arena_type arena;
+    void* p1 = arena.allocate();
+    void* p2 = arena.allocate();
+    void* p3 = arena.allocate();
+    EXPECT_EQ(arena.chunks(), 1);
+    EXPECT_NE(p1, p2);
+    EXPECT_NE(p2, p3);
+
+    arena.deallocate(p2);
+    EXPECT_EQ(arena.allocate(), p2);
+    arena.allocate();
+    EXPECT_EQ(arena.chunks(), 2);
+    arena.deallocate(p1);
+    arena.deallocate(p3);
+}
+
+
+TEST(pool_arena, lock_free_contention)
+{
+    // freed blocks are overwritten by their next owner while stale
+    // threads may still read them as free list nodes
+    using arena_type = pool_arena<8, 16, 8, pool_lock_free>;
+    arena_type arena;
+    vector<thread> threads;
+    for (size_t t = 0; t < 8; ++t) {
+        threads.emplace_back([&arena, t]() {
+            uint64_t value = ~uint64_t(0) - t;
+            for (size_t i = 0; i < 20000; ++i) {
+                void* blocks[4];
+                for (void*& p: blocks) {
+                    p = arena.allocate();
+                    memcpy(p, &value, sizeof(value));
+                }
+                for (void* p: blocks) {
+                    uint64_t stored;
+                    memcpy(&stored, p, sizeof(stored));
+                    EXPECT_EQ(stored, value);
+                    arena.deallocate(p);
+                }
+            }
+        });
+    }
+    for (thread& t: threads) {
+        t.join();
+    }
+}
+
+
 TEST(pool_allocator, pool_allocator)
 {
-// TODO: restore
-//    using allocator_type = pool_allocator<char>;
-//    allocator_type allocator;
-//
-//    char* ptr = allocator.allocate(50);
-//    allocator.deallocate(ptr, 50);
-//
-//    ptr = allocator.allocate(50);
-//    allocator.construct(ptr, 0);
-//    allocator.destroy(ptr);
-//    allocator.deallocate(ptr, 50);
+    using allocator_type = pool_allocator<char>;
+    allocator_type allocator;
+
+    char* ptr = allocator.allocate(1);
+    allocator.deallocate(ptr, 1);
+    EXPECT_EQ(allocator.allocate(1), ptr);
+    allocator.deallocate(ptr, 1);
+
+    // arrays are not pooled
+    ptr = allocator.allocate(50);
+    allocator.deallocate(ptr, 50);
+
+    // rebound allocators compare equal, and share arenas by block size
+    pool_allocator<int> rebound(allocator);
+    EXPECT_EQ(rebound, allocator);
+    EXPECT_NE(allocator, pool_locked_allocator<char>());
+    EXPECT_EQ(&pool_allocator<int32_t>::arena(), &pool_allocator<uint32_t>::arena());
+}
+
+
+TEST(pool_allocator, containers)
+{
+    test_containers<pool_unlocked_allocator<int>>();
+    test_containers<pool_locked_allocator<int>>();
+    test_containers<pool_lock_free_allocator<int>>();
+}
+
+
+TEST(pool_allocator, threads)
+{
+    test_threads<pool_unlocked_allocator<size_t, 64>>();
+    test_threads<pool_locked_allocator<size_t, 64>>();
+    test_threads<pool_lock_free_allocator<size_t, 64>>();
+}
+
+
+TEST(pool_allocator, thread_arenas)
+{
+    // unlocked allocators use an arena per thread, reused after exit
+    using allocator_type = pool_unlocked_allocator<double>;
+    using arena_type = typename allocator_type::arena_type;
+    arena_type* local = &allocator_type::arena();
+    arena_type* first = nullptr;
+    arena_type* second = nullptr;
+    thread([&]() { first = &allocator_type::arena(); }).join();
+    thread([&]() { second = &allocator_type::arena(); }).join();
+    EXPECT_NE(local, first);
+    EXPECT_EQ(first, second);
+
+    // blocks may be freed on another thread
+    double* p = allocator_type().allocate(1);
+    thread([p]() { allocator_type().deallocate(p, 1); }).join();
+}
+
+
+TEST(pool_resource, polymorphic)
+{
+    using resource_type = pool_resource<32, 16>;
+    resource_type resource;
+    {
+        polymorphic_allocator<int> allocator(&resource);
+        std::list<int, polymorphic_allocator<int>> l(allocator);
+        for (int i = 0; i < 20; ++i) {
+            l.push_back(i);
+        }
+        EXPECT_EQ(resource.arena().chunks(), 2);
+
+        // larger requests are forwarded upstream
+        std::vector<int, polymorphic_allocator<int>> v(100, 0, allocator);
+        EXPECT_EQ(resource.arena().chunks(), 2);
+    }
+
+    EXPECT_EQ(resource.upstream_resource(), new_delete_resource());
+    EXPECT_TRUE(resource.is_equal(resource));
+    resource_type other;
+    EXPECT_FALSE(resource.is_equal(other));
 }
@@ -0,0 +1,157 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see licenses/mit.md for more details.
+
+#include <pycpp/allocator/tracing.h>
+#include <pycpp/preprocessor/os.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/thread.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+
+PYCPP_USING_NAMESPACE
+
+// TESTS
+// -----
+
+
+TEST(tracing, is_relocatable)
+{
+    static_assert(!is_relocatable<tracing_resource>::value, "");
+}
+
+
+TEST(tracing_resource, size_class)
+{
+    EXPECT_EQ(tracing_resource::size_class(0), 0);
+    EXPECT_EQ(tracing_resource::size_class(1), 0);
+    EXPECT_EQ(tracing_resource::size_class(2), 1);
+    EXPECT_EQ(tracing_resource::size_class(3), 2);
+    EXPECT_EQ(tracing_resource::size_class(4), 2);
+    EXPECT_EQ(tracing_resource::size_class(5), 3);
+    EXPECT_EQ(tracing_resource::size_class(4096), 12);
+    EXPECT_EQ(tracing_resource::size_class(std::numeric_limits<size_t>::max()), TRACING_SIZE_CLASSES - 1);
+}
+
+
+TEST(tracing_resource, tracing_resource)
+{
+    tracing_resource resource(new_delete_resource());
+    EXPECT_EQ(resource.upstream_resource(), new_delete_resource());
+
+    void* p1 = resource.allocate(24);
+    void* p2 = resource.allocate(100);
+    EXPECT_EQ(resource.live_bytes(), 124);
+    resource.deallocate(p2, 100);
+    void* p3 = resource.allocate(8);
+    EXPECT_EQ(resource.live_bytes(), 32);
+    EXPECT_EQ(resource.peak_bytes(), 124);
+
+    tracing_snapshot snapshot = resource.snapshot();
+    EXPECT_EQ(snapshot.allocations, 3);
+    EXPECT_EQ(snapshot.deallocations, 1);
+    EXPECT_EQ(snapshot.bytes, 132);
+    EXPECT_EQ(snapshot.live_bytes, 32);
+    EXPECT_EQ(snapshot.peak_bytes, 124);
+    EXPECT_EQ(snapshot.classes[5].size, 32);
+    EXPECT_EQ(snapshot.classes[5].allocations, 1);
+    EXPECT_EQ(snapshot.classes[5].bytes, 24);
+    EXPECT_EQ(snapshot.classes[7].allocations, 1);
+    EXPECT_EQ(snapshot.classes[7].deallocations, 1);
+    EXPECT_EQ(snapshot.classes[3].allocations, 1);
+
+    // reset keeps live bytes
+    resource.reset();
+    snapshot = resource.snapshot();
+    EXPECT_EQ(snapshot.allocations, 0);
+    EXPECT_EQ(snapshot.live_bytes, 32);
+    EXPECT_EQ(snapshot.peak_bytes, 32);
+
+    resource.deallocate(p1, 24);
+    resource.deallocate(p3, 8);
+    EXPECT_EQ(resource.live_bytes(), 0);
+
+    EXPECT_TRUE(resource.is_equal(resource));
+    EXPECT_FALSE(resource.is_equal(*new_delete_resource()));
+}
+
+
+TEST(tracing_resource, samples)
+{
+    tracing_options options;
+    options.sample_rate = 2;
+    options.stack_depth = 8;
+    tracing_resource resource(new_delete_resource(), options);
+
+    tracing_sample samples[TRACING_SAMPLE_COUNT];
+    EXPECT_EQ(resource.samples(samples, TRACING_SAMPLE_COUNT), 0);
+
+    for (size_t i = 1; i <= 200; ++i) {
+        resource.deallocate(resource.allocate(i), i);
+    }
+
+    // the most recent samples are kept, oldest first
+    size_t count = resource.samples(samples, TRACING_SAMPLE_COUNT);
+    EXPECT_EQ(count, TRACING_SAMPLE_COUNT);
+    EXPECT_EQ(samples[0].size, 200 - 2 * TRACING_SAMPLE_COUNT + 1);
+    EXPECT_EQ(samples[count-1].size, 199);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_LE(samples[i].depth, 8);
+    }
+#if defined(HAVE_EXECINFO_H) || defined(OS_WINDOWS)
+    EXPECT_GT(samples[0].depth, 0);
+#endif
+
+    EXPECT_EQ(resource.samples(samples, 2), 2);
+    EXPECT_EQ(samples[1].size, 199);
+}
+
+
+TEST(tracing_resource, threads)
+{
+    tracing_resource resource(new_delete_resource());
+    vector<thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (size_t i = 0; i < 1000; ++i) {
+                void* p = resource.allocate(16);
+                resource.deallocate(p, 16);
+            }
+        });
+    }
+    for (thread& t: threads) {
+        t.join();
+    }
+
+    tracing_snapshot snapshot = resource.snapshot();
+    EXPECT_EQ(snapshot.allocations, 4000);
+    EXPECT_EQ(snapshot.deallocations, 4000);
+    EXPECT_EQ(snapshot.classes[4].bytes, 64000);
+    EXPECT_EQ(snapshot.live_bytes, 0);
+    EXPECT_LE(snapshot.peak_bytes, 64);
+}
+
+
+TEST(tracing_resource, polymorphic)
+{
+    using allocator_type = polymorphic_allocator<int>;
+    using vector = vector<int, allocator_type>;
+
+    tracing_resource resource;
+    EXPECT_EQ(resource.upstream_resource(), get_default_resource());
+    memory_resource* previous = set_default_resource(&resource);
+    {
+        vector v1 = vector(allocator_type());
+        for (int i = 0; i < 100; ++i) {
+            v1.emplace_back(i);
+        }
+        std::list<int, allocator_type> l;
+        l.push_back(1);
+        EXPECT_GT(resource.live_bytes(), 400);
+    }
+    set_default_resource(previous);
+
+    tracing_snapshot snapshot = resource.snapshot();
+    EXPECT_GT(snapshot.allocations, 1);
+    EXPECT_EQ(snapshot.allocations, snapshot.deallocations);
+    EXPECT_EQ(resource.live_bytes(), 0);
+}
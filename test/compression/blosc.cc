@@ -35,4 +35,85 @@ TEST(blosc, blosc_decompress)
     EXPECT_EQ(blosc_decompress(BLOSC_COMPRESSED, BLOSC_DECOMPRESSED.size()), BLOSC_DECOMPRESSED);
 }
 
+
+TEST(blosc, blosc_options)
+{
+    blosc_options options;
+    options.level = 9;
+    options.shuffle = blosc_bitshuffle;
+    options.codec = blosc_lz4;
+    options.typesize = 4;
+    options.threads = 2;
+
+    string compressed = blosc_compress(BLOSC_DECOMPRESSED, options);
+    EXPECT_EQ(blosc_decompressed_size(compressed), BLOSC_DECOMPRESSED.size());
+    EXPECT_EQ(blosc_decompress(compressed), BLOSC_DECOMPRESSED);
+}
+
+
+TEST(blosc, blosc_typed)
+{
+    vector<double> data;
+    for (size_t i = 0; i < 1000; ++i) {
+        data.push_back(i * 0.5);
+    }
+
+    string compressed = blosc_compress(vector_view<double>(data));
+    EXPECT_EQ(blosc_decompress_array<double>(compressed), data);
+    EXPECT_THROW(blosc_decompress_array<double>(""), compression_error);
+}
+
+
+TEST(blosc, blosc_superchunk)
+{
+    blosc_options options;
+    options.typesize = 4;
+    blosc_superchunk chunks(1001, options);
+    EXPECT_EQ(chunks.chunk_size(), 1000);
+
+    string data;
+    for (size_t i = 0; i < 2500; ++i) {
+        data.push_back(static_cast<char>(i % 251));
+    }
+    chunks.append(data.data(), 1500);
+    chunks.append(data.data() + 1500, 1000);
+    EXPECT_EQ(chunks.size(), data.size());
+    EXPECT_EQ(chunks.chunk_count(), 3);
+
+    // full and partial reads, across chunks and the tail
+    EXPECT_EQ(chunks.decompress(), data);
+    EXPECT_EQ(chunks.read(0, 1000), data.substr(0, 1000));
+    EXPECT_EQ(chunks.read(3, 10), data.substr(3, 10));
+    EXPECT_EQ(chunks.read(998, 1005), data.substr(998, 1005));
+    EXPECT_EQ(chunks.read(2400, 100), data.substr(2400, 100));
+    EXPECT_THROW(chunks.read(2400, 101), out_of_range);
+
+    chunks.clear();
+    EXPECT_EQ(chunks.size(), 0);
+    EXPECT_EQ(chunks.chunk_count(), 0);
+
+    // typesizes blosc cannot store are rejected
+    options.typesize = 256;
+    EXPECT_THROW(blosc_superchunk(1024, options), compression_error);
+}
+
+
+TEST(blosc, blosc_array)
+{
+    blosc_array<int32_t> array(100);
+    for (int32_t i = 0; i < 250; ++i) {
+        array.push_back(i);
+    }
+    vector<int32_t> tail = {250, 251, 252};
+    array.append(vector_view<int32_t>(tail));
+
+    EXPECT_EQ(array.size(), 253);
+    EXPECT_EQ(array[0], 0);
+    EXPECT_EQ(array[150], 150);
+    EXPECT_EQ(array[252], 252);
+    EXPECT_EQ(array.slice(98, 103), vector<int32_t>({98, 99, 100, 101, 102}));
+    EXPECT_EQ(array.decompress().size(), 253);
+    EXPECT_THROW(array.slice(103, 98), out_of_range);
+}
+
 #endif                  // HAVE_BLOSC
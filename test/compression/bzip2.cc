@@ -100,6 +100,32 @@ TEST(bz2, bz2_decompressor)
 TEST(bz2, bz2_compress)
 {
     EXPECT_EQ(bz2_compress(BZ2_DECOMPRESSED), BZ2_COMPRESSED);
+
+    // the output buffer must hold the whole stream
+    string compressed = bz2_compress(BZ2_DECOMPRESSED);
+    for (size_t length: {compressed.size() - 1, compressed.size()}) {
+        string buffer(length, '\0');
+        const void* src = BZ2_DECOMPRESSED.data();
+        void* dst = &buffer[0];
+        if (length < compressed.size()) {
+            EXPECT_THROW(bz2_compress(src, BZ2_DECOMPRESSED.size(), dst, length), compression_error);
+        } else {
+            bz2_compress(src, BZ2_DECOMPRESSED.size(), dst, length);
+            EXPECT_EQ(buffer, compressed);
+        }
+    }
+
+    string noise(10000, '\0');
+    uint32_t state = 1;
+    for (char& c: noise) {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 24);
+    }
+    char buffer[64];
+    const void* src = noise.data();
+    void* dst = buffer;
+    EXPECT_THROW(bz2_compress(src, noise.size(), dst, sizeof(buffer)), compression_error);
+    EXPECT_EQ(bz2_decompress(bz2_compress(noise)), noise);
 }
 
 
@@ -109,4 +135,33 @@ TEST(bz2, bz2_decompress)
     EXPECT_EQ(bz2_decompress(BZ2_COMPRESSED, BZ2_DECOMPRESSED.size()), BZ2_DECOMPRESSED);
 }
 
+
+TEST(bz2, bz2_reset)
+{
+    char buffer[4096];
+    const void* src;
+    void* dst;
+
+    // compressor
+    bz2_compressor compressor;
+    for (size_t i = 0; i < 2; ++i) {
+        src = BZ2_DECOMPRESSED.data();
+        dst = buffer;
+        compressor.compress(src, BZ2_DECOMPRESSED.size(), dst, sizeof(buffer));
+        EXPECT_TRUE(compressor.flush(dst, sizeof(buffer) - distance(buffer, (char*) dst)));
+        EXPECT_EQ(string(buffer, distance(buffer, (char*) dst)), BZ2_COMPRESSED);
+        compressor.reset();
+    }
+
+    // decompressor
+    bz2_decompressor decompressor;
+    for (size_t i = 0; i < 2; ++i) {
+        src = BZ2_COMPRESSED.data();
+        dst = buffer;
+        EXPECT_EQ(decompressor.decompress(src, BZ2_COMPRESSED.size(), dst, sizeof(buffer)), compression_eof);
+        EXPECT_EQ(string(buffer, distance(buffer, (char*) dst)), BZ2_DECOMPRESSED);
+        decompressor.reset();
+    }
+}
+
 #endif                  // HAVE_BZIP2
@@ -0,0 +1,49 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Compression dictionary unittests.
+ */
+
+#include <pycpp/compression/dictionary.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+PYCPP_USING_NAMESPACE
+
+// HELPERS
+// -------
+
+
+static vector<string> json_samples(size_t count)
+{
+    vector<string> samples;
+    char buffer[128];
+    for (size_t i = 0; i < count; ++i) {
+        int length = snprintf(buffer, sizeof(buffer), "{\"id\": %zu, \"type\": \"event\", \"status\": \"active\", \"tags\": [\"user\", \"session\"]}", i * 7919);
+        samples.emplace_back(buffer, length);
+    }
+    return samples;
+}
+
+// TESTS
+// -----
+
+
+TEST(dictionary, train_dictionary)
+{
+    vector<string> samples = json_samples(2000);
+    string_wrapper_list_t list(samples.begin(), samples.end());
+
+    // bounded by the maximum size
+    string dictionary = train_dictionary(list, 1024);
+    EXPECT_LE(dictionary.size(), 1024);
+    EXPECT_GT(dictionary.size(), 0);
+    EXPECT_NE(dictionary.find("\"status\": \"active\""), string::npos);
+
+    // samples smaller than the dictionary are used directly
+    string_wrapper_list_t small = {"abc", "def"};
+    EXPECT_EQ(train_dictionary(small), "abcdef");
+    EXPECT_EQ(train_dictionary(small, 4), "cdef");
+    EXPECT_EQ(train_dictionary(string_wrapper_list_t()), "");
+}
@@ -100,6 +100,32 @@ TEST(gzip, gzip_decompressor)
 TEST(gzip, gzip_compress)
 {
     EXPECT_EQ(gzip_compress(GZIP_DECOMPRESSED), GZIP_COMPRESSED);
+
+    // the output buffer must hold the whole stream
+    string compressed = gzip_compress(GZIP_DECOMPRESSED);
+    for (size_t length: {compressed.size() - 1, compressed.size()}) {
+        string buffer(length, '\0');
+        const void* src = GZIP_DECOMPRESSED.data();
+        void* dst = &buffer[0];
+        if (length < compressed.size()) {
+            EXPECT_THROW(gzip_compress(src, GZIP_DECOMPRESSED.size(), dst, length), compression_error);
+        } else {
+            gzip_compress(src, GZIP_DECOMPRESSED.size(), dst, length);
+            EXPECT_EQ(buffer, compressed);
+        }
+    }
+
+    string noise(10000, '\0');
+    uint32_t state = 1;
+    for (char& c: noise) {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 24);
+    }
+    char buffer[64];
+    const void* src = noise.data();
+    void* dst = buffer;
+    EXPECT_THROW(gzip_compress(src, noise.size(), dst, sizeof(buffer)), compression_error);
+    EXPECT_EQ(gzip_decompress(gzip_compress(noise)), noise);
 }
 
 
@@ -109,4 +135,33 @@ TEST(gzip, gzip_decompress)
     EXPECT_EQ(gzip_decompress(GZIP_COMPRESSED, GZIP_DECOMPRESSED.size()), GZIP_DECOMPRESSED);
 }
 
+
+TEST(gzip, gzip_reset)
+{
+    char buffer[4096];
+    const void* src;
+    void* dst;
+
+    // compressor
+    gzip_compressor compressor;
+    for (size_t i = 0; i < 2; ++i) {
+        src = GZIP_DECOMPRESSED.data();
+        dst = buffer;
+        compressor.compress(src, GZIP_DECOMPRESSED.size(), dst, sizeof(buffer));
+        EXPECT_TRUE(compressor.flush(dst, sizeof(buffer) - distance(buffer, (char*) dst)));
+        EXPECT_EQ(string(buffer, distance(buffer, (char*) dst)), GZIP_COMPRESSED);
+        compressor.reset();
+    }
+
+    // decompressor
+    gzip_decompressor decompressor;
+    for (size_t i = 0; i < 2; ++i) {
+        src = GZIP_COMPRESSED.data();
+        dst = buffer;
+        EXPECT_EQ(decompressor.decompress(src, GZIP_COMPRESSED.size(), dst, sizeof(buffer)), compression_eof);
+        EXPECT_EQ(string(buffer, distance(buffer, (char*) dst)), GZIP_DECOMPRESSED);
+        decompressor.reset();
+    }
+}
+
 #endif                  // HAVE_ZLIB
@@ -101,6 +101,32 @@ TEST(lzma, lzma_compress)
 {
     // don't tie to any specific configuration
     EXPECT_EQ(lzma_decompress(lzma_compress(LZMA_DECOMPRESSED)), LZMA_DECOMPRESSED);
+
+    // the output buffer must hold the whole stream
+    string compressed = lzma_compress(LZMA_DECOMPRESSED);
+    for (size_t length: {compressed.size() - 1, compressed.size()}) {
+        string buffer(length, '\0');
+        const void* src = LZMA_DECOMPRESSED.data();
+        void* dst = &buffer[0];
+        if (length < compressed.size()) {
+            EXPECT_THROW(lzma_compress(src, LZMA_DECOMPRESSED.size(), dst, length), compression_error);
+        } else {
+            lzma_compress(src, LZMA_DECOMPRESSED.size(), dst, length);
+            EXPECT_EQ(buffer, compressed);
+        }
+    }
+
+    string noise(10000, '\0');
+    uint32_t state = 1;
+    for (char& c: noise) {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 24);
+    }
+    char buffer[64];
+    const void* src = noise.data();
+    void* dst = buffer;
+    EXPECT_THROW(lzma_compress(src, noise.size(), dst, sizeof(buffer)), compression_error);
+    EXPECT_EQ(lzma_decompress(lzma_compress(noise)), noise);
 }
 
 
@@ -110,4 +136,69 @@ TEST(lzma, lzma_decompress)
     EXPECT_EQ(lzma_decompress(LZMA_COMPRESSED, LZMA_DECOMPRESSED.size()), LZMA_DECOMPRESSED);
 }
 
+
+TEST(lzma, lzma_reset)
+{
+    char buffer[4096];
+    const void* src;
+    void* dst;
+
+    // compressor
+    lzma_compressor compressor;
+    for (size_t i = 0; i < 2; ++i) {
+        src = LZMA_DECOMPRESSED.data();
+        dst = buffer;
+        compressor.compress(src, LZMA_DECOMPRESSED.size(), dst, sizeof(buffer));
+        EXPECT_TRUE(compressor.flush(dst, sizeof(buffer) - distance(buffer, (char*) dst)));
+        EXPECT_EQ(string(buffer, distance(buffer, (char*) dst)), LZMA_COMPRESSED);
+        compressor.reset();
+    }
+
+    // decompressor
+    lzma_decompressor decompressor;
+    for (size_t i = 0; i < 2; ++i) {
+        src = LZMA_COMPRESSED.data();
+        dst = buffer;
+        EXPECT_EQ(decompressor.decompress(src, LZMA_COMPRESSED.size(), dst, sizeof(buffer)), compression_eof);
+        EXPECT_EQ(string(buffer, distance(buffer, (char*) dst)), LZMA_DECOMPRESSED);
+        decompressor.reset();
+    }
+}
+
+
+
+TEST(lzma, lzma_threads)
+{
+    // use small blocks, so the data is split over multiple blocks
+    string data;
+    for (size_t i = 0; i < 64; ++i) {
+        data += LZMA_DECOMPRESSED;
+    }
+    lzma_options options;
+    options.threads = 2;
+    options.block_size = 16384;
+
+    string buffer(data.size() + 4096, '\0');
+    const void* src;
+    void* dst;
+    lzma_compressor compressor(options);
+    for (size_t i = 0; i < 2; ++i) {
+        src = data.data();
+        dst = &buffer[0];
+        compressor.compress(src, data.size(), dst, buffer.size());
+        EXPECT_TRUE(compressor.flush(dst, buffer.size() - distance(&buffer[0], (char*) dst)));
+        string compressed(buffer.data(), distance(&buffer[0], (char*) dst));
+        EXPECT_EQ(lzma_decompress(compressed), data);
+
+        // block-parallel decoder
+        string decompressed(data.size(), '\0');
+        lzma_decompressor decompressor(2);
+        src = compressed.data();
+        dst = &decompressed[0];
+        EXPECT_EQ(decompressor.decompress(src, compressed.size(), dst, decompressed.size()), compression_eof);
+        EXPECT_EQ(decompressed, data);
+        compressor.reset();
+    }
+}
+
 #endif                  // HAVE_LZMA
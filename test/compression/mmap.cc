@@ -0,0 +1,166 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Memory-mapped decompression unittests.
+ */
+
+#include <pycpp/compression/mmap.h>
+#include <pycpp/filesystem.h>
+#include <pycpp/stl/fstream.h>
+#include <pycpp/stl/sstream.h>
+#include <gtest/gtest.h>
+
+#if defined(HAVE_MMAP) || defined(OS_WINDOWS)           // MMAP
+
+PYCPP_USING_NAMESPACE
+
+// DATA
+// ----
+
+static const string INPUT_PATH("sample_mmap_input.bin");
+static const string OUTPUT_PATH("sample_mmap_output.bin");
+
+// HELPERS
+// -------
+
+
+static string make_data()
+{
+    // larger than the stream buffer, with compressible text
+    string data;
+    for (size_t i = 0; data.size() < (1 << 16); ++i) {
+        data += "The quick brown fox jumps over the lazy dog ";
+        data.push_back(static_cast<char>('a' + i % 26));
+    }
+
+    return data;
+}
+
+
+static void write_file(const string& path, const string& data)
+{
+    ofstream stream(path, ios_base::out | ios_base::binary);
+    stream.write(data.data(), data.size());
+}
+
+
+static string read_file(const string& path)
+{
+    ifstream stream(path, ios_base::in | ios_base::binary);
+    ostringstream sstream;
+    sstream << stream.rdbuf();
+    return sstream.str();
+}
+
+
+template <typename IStream>
+static void test_mmap(const string& compressed, const string& decompressed, bool sized)
+{
+    write_file(INPUT_PATH, compressed);
+
+    // stream
+    {
+        IStream stream(INPUT_PATH);
+        EXPECT_TRUE(stream.is_open());
+        ostringstream sstream;
+        sstream << stream.rdbuf();
+        EXPECT_TRUE(sstream.str() == decompressed);
+    }
+
+    // size
+    size_t size = mmap_decompressed_size(INPUT_PATH);
+    if (sized) {
+        EXPECT_EQ(size, decompressed.size());
+    } else {
+        EXPECT_EQ(size, DECOMPRESSED_SIZE_UNKNOWN);
+    }
+
+    // string
+    EXPECT_TRUE(mmap_decompress(INPUT_PATH) == decompressed);
+
+    // buffer
+    string buffer(decompressed.size(), '\0');
+    EXPECT_EQ(mmap_decompress(INPUT_PATH, &buffer[0], buffer.size()), decompressed.size());
+    EXPECT_TRUE(buffer == decompressed);
+    EXPECT_THROW(mmap_decompress(INPUT_PATH, &buffer[0], buffer.size() / 2), compression_error);
+
+    // file
+    EXPECT_EQ(mmap_decompress(INPUT_PATH, OUTPUT_PATH), decompressed.size());
+    EXPECT_TRUE(read_file(OUTPUT_PATH) == decompressed);
+
+    EXPECT_TRUE(remove_file(INPUT_PATH));
+    EXPECT_TRUE(remove_file(OUTPUT_PATH));
+}
+
+// TESTS
+// -----
+
+#if defined(HAVE_BZIP2)
+
+TEST(compression_mmap, bz2)
+{
+    string data = make_data();
+    test_mmap<bz2_mmap_ifstream>(bz2_compress(data), data, false);
+}
+
+#endif                  // HAVE_BZIP2
+
+#if defined(HAVE_ZLIB)
+
+TEST(compression_mmap, zlib)
+{
+    string data = make_data();
+    test_mmap<zlib_mmap_ifstream>(zlib_compress(data), data, false);
+}
+
+
+TEST(compression_mmap, gzip)
+{
+    string data = make_data();
+    string compressed = gzip_compress(data);
+    EXPECT_EQ(gzip_decompressed_size(compressed), data.size());
+    test_mmap<gzip_mmap_ifstream>(compressed, data, true);
+}
+
+
+TEST(compression_mmap, gzip_invalid_size)
+{
+    // the stored size is checked against the decompressed size
+    string data = make_data();
+    string compressed = gzip_compress(data);
+    compressed[compressed.size() - 4] ^= 0x01;
+
+    write_file(INPUT_PATH, compressed);
+    EXPECT_THROW(mmap_decompress(INPUT_PATH), runtime_error);
+    EXPECT_THROW(mmap_decompress(INPUT_PATH, OUTPUT_PATH), runtime_error);
+    EXPECT_TRUE(remove_file(INPUT_PATH));
+    EXPECT_TRUE(remove_file(OUTPUT_PATH));
+}
+
+#endif                  // HAVE_ZLIB
+
+#if defined(HAVE_LZMA)
+
+TEST(compression_mmap, lzma)
+{
+    string data = make_data();
+    string compressed = lzma_compress(data);
+    EXPECT_EQ(lzma_decompressed_size(compressed), data.size());
+    test_mmap<lzma_mmap_ifstream>(compressed, data, true);
+}
+
+#endif                  // HAVE_LZMA
+
+
+TEST(compression_mmap, invalid)
+{
+    EXPECT_THROW(mmap_decompress("nonexistent_mmap_input.bin"), compression_error);
+
+    write_file(INPUT_PATH, "not compressed");
+    EXPECT_EQ(mmap_decompressed_size(INPUT_PATH), DECOMPRESSED_SIZE_UNKNOWN);
+    EXPECT_THROW(mmap_decompress(INPUT_PATH), compression_error);
+    EXPECT_TRUE(remove_file(INPUT_PATH));
+}
+
+#endif                                                  // MMAP
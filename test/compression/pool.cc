@@ -0,0 +1,103 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Compression context pool unittests.
+ */
+
+#if defined(HAVE_ZLIB)
+
+#include <pycpp/compression/pool.h>
+#include <pycpp/compression/zlib.h>
+#include <pycpp/stl/thread.h>
+#include <gtest/gtest.h>
+
+PYCPP_USING_NAMESPACE
+
+// HELPERS
+// -------
+
+
+static string pool_compress(context_pool<zlib_compressor>& pool, const string& str)
+{
+    char buffer[512];
+    const void* src = str.data();
+    void* dst = buffer;
+    auto ctx = pool.acquire();
+    ctx->compress(src, str.size(), dst, sizeof(buffer));
+    ctx->flush(dst, sizeof(buffer) - distance(buffer, (char*) dst));
+
+    return string(buffer, distance(buffer, (char*) dst));
+}
+
+// TESTS
+// -----
+
+
+TEST(context_pool, acquire)
+{
+    context_pool<zlib_compressor> pool(2);
+    EXPECT_EQ(pool.size(), 0);
+    EXPECT_EQ(pool.max_size(), 2);
+
+    string data = "Lorem ipsum dolor sit amet, consectetur adipiscing elit.";
+    string expected = zlib_compress(data);
+    EXPECT_EQ(pool_compress(pool, data), expected);
+    EXPECT_EQ(pool.size(), 1);
+
+    // reused contexts are reset
+    EXPECT_EQ(pool_compress(pool, data), expected);
+    EXPECT_EQ(pool.size(), 1);
+
+    // idle contexts are bounded by the maximum size
+    {
+        auto c1 = pool.acquire();
+        auto c2 = pool.acquire();
+        auto c3 = pool.acquire();
+        EXPECT_EQ(pool.size(), 0);
+    }
+    EXPECT_EQ(pool.size(), 2);
+
+    pool.clear();
+    EXPECT_EQ(pool.size(), 0);
+}
+
+
+TEST(context_pool, factory)
+{
+    string dictionary = "\"status\": \"active\"";
+    context_pool<zlib_compressor> pool([&dictionary]() {
+        return zlib_compressor(dictionary);
+    });
+
+    string data = "{\"status\": \"active\"}";
+    EXPECT_EQ(zlib_decompress(pool_compress(pool, data), dictionary), data);
+}
+
+
+TEST(context_pool, threads)
+{
+    context_pool<zlib_compressor> pool;
+    string data = "Lorem ipsum dolor sit amet, consectetur adipiscing elit.";
+    string expected = zlib_compress(data);
+
+    vector<thread> threads;
+    vector<int> matches(4, 0);
+    for (size_t i = 0; i < matches.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < 100; ++j) {
+                matches[i] += pool_compress(pool, data) == expected;
+            }
+        });
+    }
+    for (thread& t: threads) {
+        t.join();
+    }
+
+    for (int count: matches) {
+        EXPECT_EQ(count, 100);
+    }
+    EXPECT_LE(pool.size(), matches.size());
+}
+
+#endif                  // HAVE_ZLIB
@@ -114,6 +114,43 @@ struct test_ostream
 };
 
 
+/**
+ *  \brief Round-trip data spanning many stream buffers.
+ */
+template <typename IStream, typename OStream>
+struct test_roundtrip
+{
+    void operator()()
+    {
+        // mix compressible text with incompressible bytes
+        string data;
+        uint32_t state = 1;
+        while (data.size() < (1 << 18)) {
+            data += DECOMPRESSED;
+            for (size_t i = 0; i < 4096; ++i) {
+                state = state * 1103515245 + 12345;
+                data.push_back(static_cast<char>(state >> 24));
+            }
+        }
+
+        ostringstream compressed;
+        {
+            OStream ofs(compressed);
+            ofs.write(data.data(), data.size());
+        }
+
+        istringstream sstream(compressed.str());
+        ostringstream decompressed;
+        {
+            IStream ifs(sstream);
+            decompressed << ifs.rdbuf();
+        }
+        EXPECT_EQ(decompressed.str().size(), data.size());
+        EXPECT_TRUE(decompressed.str() == data);
+    }
+};
+
+
 #if BUILD_FILESYSTEM
 
 template <typename IStream>
@@ -239,6 +276,12 @@ TEST(compression_stream, bz2_ostream)
 #endif          // BUILD_FILESYSTEM
 }
 
+
+TEST(compression_stream, bz2_roundtrip)
+{
+    test_roundtrip<bz2_istream, bz2_ostream>()();
+}
+
 #endif                  // HAVE_BZIP2
 
 #if defined(HAVE_ZLIB)
@@ -264,6 +307,12 @@ TEST(compression_stream, zlib_ostream)
 }
 
 
+TEST(compression_stream, zlib_roundtrip)
+{
+    test_roundtrip<zlib_istream, zlib_ostream>()();
+}
+
+
 TEST(compression_stream, gzip_istream)
 {
     test_istream<gzip_istream_wrapper>()(GZIP_COMPRESSED);
@@ -281,6 +330,12 @@ TEST(compression_stream, gzip_ostream)
 #endif          // BUILD_FILESYSTEM
 }
 
+
+TEST(compression_stream, gzip_roundtrip)
+{
+    test_roundtrip<gzip_istream, gzip_ostream>()();
+}
+
 #endif                  // HAVE_ZLIB
 
 #if defined(HAVE_LZMA)
@@ -304,6 +359,34 @@ TEST(compression_stream, lzma_ostream)
 #endif          // BUILD_FILESYSTEM
 }
 
+
+TEST(compression_stream, lzma_roundtrip)
+{
+    test_roundtrip<lzma_istream, lzma_ostream>()();
+}
+
+
+TEST(compression_stream, lzma_threads)
+{
+    lzma_options options;
+    options.threads = 2;
+    options.block_size = 512;
+
+    ostringstream compressed;
+    {
+        lzma_ostream stream(compressed, lzma_compressor(options));
+        stream << DECOMPRESSED;
+    }
+
+    istringstream sstream(compressed.str());
+    ostringstream decompressed;
+    {
+        lzma_istream stream(sstream, lzma_decompressor(2));
+        decompressed << stream.rdbuf();
+    }
+    EXPECT_EQ(decompressed.str(), DECOMPRESSED);
+}
+
 #endif                  // HAVE_LZMA
 
 TEST(compression_stream, decompressing_istream)
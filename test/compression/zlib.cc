@@ -7,6 +7,7 @@
 
 #if defined(HAVE_ZLIB)
 
+#include <pycpp/compression/dictionary.h>
 #include <pycpp/compression/zlib.h>
 #include <pycpp/stl/sstream.h>
 #include <gtest/gtest.h>
@@ -100,6 +101,32 @@ TEST(zlib, zlib_decompressor)
 TEST(zlib, zlib_compress)
 {
     EXPECT_EQ(zlib_compress(ZLIB_DECOMPRESSED), ZLIB_COMPRESSED);
+
+    // the output buffer must hold the whole stream
+    string compressed = zlib_compress(ZLIB_DECOMPRESSED);
+    for (size_t length: {compressed.size() - 1, compressed.size()}) {
+        string buffer(length, '\0');
+        const void* src = ZLIB_DECOMPRESSED.data();
+        void* dst = &buffer[0];
+        if (length < compressed.size()) {
+            EXPECT_THROW(zlib_compress(src, ZLIB_DECOMPRESSED.size(), dst, length), compression_error);
+        } else {
+            zlib_compress(src, ZLIB_DECOMPRESSED.size(), dst, length);
+            EXPECT_EQ(buffer, compressed);
+        }
+    }
+
+    string noise(10000, '\0');
+    uint32_t state = 1;
+    for (char& c: noise) {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 24);
+    }
+    char buffer[64];
+    const void* src = noise.data();
+    void* dst = buffer;
+    EXPECT_THROW(zlib_compress(src, noise.size(), dst, sizeof(buffer)), compression_error);
+    EXPECT_EQ(zlib_decompress(zlib_compress(noise)), noise);
 }
 
 
@@ -109,4 +136,94 @@ TEST(zlib, zlib_decompress)
     EXPECT_EQ(zlib_decompress(ZLIB_COMPRESSED, ZLIB_DECOMPRESSED.size()), ZLIB_DECOMPRESSED);
 }
 
+
+TEST(zlib, zlib_reset)
+{
+    string zlib = ZLIB_DECOMPRESSED;
+    const void* src;
+    void* dst;
+    char* buffer = nullptr;
+
+    try {
+        buffer = new char[4096];
+
+        // compressor
+        zlib_compressor compressor;
+        for (size_t i = 0; i < 2; ++i) {
+            src = zlib.data();
+            dst = buffer;
+            compressor.compress(src, zlib.size(), dst, 4096);
+            EXPECT_TRUE(compressor.flush(dst, 4096 - distance(buffer, (char*) dst)));
+            EXPECT_EQ(string(buffer, distance(buffer, (char*) dst)), ZLIB_COMPRESSED);
+            compressor.reset();
+        }
+
+        // decompressor
+        zlib_decompressor decompressor;
+        for (size_t i = 0; i < 2; ++i) {
+            src = ZLIB_COMPRESSED.data();
+            dst = buffer;
+            EXPECT_EQ(decompressor.decompress(src, ZLIB_COMPRESSED.size(), dst, 4096), compression_eof);
+            EXPECT_EQ(string(buffer, distance(buffer, (char*) dst)), ZLIB_DECOMPRESSED);
+            decompressor.reset();
+        }
+
+    } catch(...) {
+        delete[] buffer;
+        throw;
+    }
+
+    delete[] buffer;
+}
+
+
+TEST(zlib, zlib_dictionary)
+{
+    string_wrapper_list_t samples = {
+        "{\"id\": 1, \"type\": \"event\", \"status\": \"active\"}",
+        "{\"id\": 2, \"type\": \"event\", \"status\": \"inactive\"}",
+        "{\"id\": 3, \"type\": \"event\", \"status\": \"active\"}",
+    };
+    string dictionary = train_dictionary(samples);
+    string message = "{\"id\": 4, \"type\": \"event\", \"status\": \"active\"}";
+
+    // one-shot
+    string compressed = zlib_compress(message, dictionary);
+    EXPECT_LT(compressed.size(), zlib_compress(message).size());
+    EXPECT_EQ(zlib_decompress(compressed, dictionary), message);
+    EXPECT_THROW(zlib_decompress(compressed), compression_error);
+    EXPECT_THROW(zlib_decompress(compressed, string_wrapper("invalid")), compression_error);
+
+    // one-shot contexts are reused, including after errors
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(zlib_compress(message, dictionary), compressed);
+        EXPECT_EQ(zlib_decompress(compressed, dictionary), message);
+        string corrupted = compressed;
+        corrupted.back() ^= 1;
+        EXPECT_THROW(zlib_decompress(corrupted, dictionary), compression_error);
+    }
+    EXPECT_EQ(zlib_decompress(zlib_compress(message, "other"), "other"), message);
+    EXPECT_EQ(zlib_decompress(compressed, dictionary), message);
+
+    // reused contexts
+    zlib_compressor compressor(dictionary);
+    zlib_decompressor decompressor(dictionary);
+    char buffer[256];
+    char output[256];
+    for (const string_wrapper& sample: samples) {
+        const void* src = sample.data();
+        void* dst = buffer;
+        compressor.compress(src, sample.size(), dst, sizeof(buffer));
+        EXPECT_TRUE(compressor.flush(dst, sizeof(buffer) - distance(buffer, (char*) dst)));
+        size_t length = distance(buffer, (char*) dst);
+        compressor.reset();
+
+        src = buffer;
+        dst = output;
+        EXPECT_EQ(decompressor.decompress(src, length, dst, sizeof(output)), compression_eof);
+        EXPECT_EQ(string_wrapper(output, distance(output, (char*) dst)), sample);
+        decompressor.reset();
+    }
+}
+
 #endif                  // HAVE_ZLIB
@@ -6,7 +6,9 @@
  */
 
 #include <pycpp/filesystem.h>
+#include <pycpp/filesystem/exception.h>
 #include <pycpp/stl/fstream.h>
+#include <pycpp/stl/sstream.h>
 #include <pycpp/stl/vector.h>
 #include <gtest/gtest.h>
 
@@ -48,6 +50,22 @@ static void test_fd(fd_t fd)
     EXPECT_EQ(fd_close(fd), 0);
 }
 
+
+static void write_file(const string& path, const string& data)
+{
+    ofstream stream(path, ios_base::out | ios_base::binary);
+    stream.write(data.data(), data.size());
+}
+
+
+static string read_file(const string& path)
+{
+    ifstream stream(path, ios_base::in | ios_base::binary);
+    ostringstream sstream;
+    sstream << stream.rdbuf();
+    return sstream.str();
+}
+
 // TESTS
 // -----
 
@@ -525,3 +543,54 @@ TEST(remove, remove_dir)
     }
 }
 
+
+
+TEST(copy, copy_file)
+{
+    string src("sample_copy_src");
+    string dst("sample_copy_dst");
+
+    // larger than a single buffer, with a partial tail
+    string data;
+    for (size_t i = 0; data.size() < (3 << 20) + 17; ++i) {
+        data += std::to_string(i).c_str();
+    }
+    write_file(src, data);
+
+    EXPECT_TRUE(copy_file(src, dst));
+    EXPECT_EQ(getsize(dst), data.size());
+    EXPECT_TRUE(read_file(dst) == data);
+    EXPECT_THROW(copy_file(src, dst), filesystem_error);
+
+    // replace, with an empty file
+    write_file(src, "");
+    EXPECT_TRUE(copy_file(src, dst, true));
+    EXPECT_EQ(getsize(dst), 0);
+
+    EXPECT_TRUE(remove_file(src));
+    EXPECT_TRUE(remove_file(dst));
+}
+
+
+TEST(copy, copy_dir)
+{
+    string src("sample_copy_dir_src");
+    string dst("sample_copy_dir_dst");
+    ASSERT_TRUE(mkdir(src));
+    ASSERT_TRUE(mkdir(src + "/nested"));
+
+    // enough files to use several workers
+    vector<string> names;
+    for (size_t i = 0; i < 32; ++i) {
+        names.emplace_back(string(i % 2 ? "nested/file" : "file") + std::to_string(i).c_str());
+        write_file(src + "/" + names.back(), string(i * 1000, 'a' + i % 26));
+    }
+
+    EXPECT_TRUE(copy_dir(src, dst));
+    for (size_t i = 0; i < names.size(); ++i) {
+        EXPECT_TRUE(read_file(dst + "/" + names[i]) == string(i * 1000, 'a' + i % 26));
+    }
+
+    EXPECT_TRUE(remove_dir(src, true));
+    EXPECT_TRUE(remove_dir(dst, true));
+}
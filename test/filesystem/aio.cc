@@ -0,0 +1,146 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Asynchronous file I/O unittests.
+ */
+
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/aio.h>
+#include <pycpp/filesystem/exception.h>
+#include <pycpp/stl/atomic.h>
+#include <pycpp/stl/string.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+
+PYCPP_USING_NAMESPACE
+
+// DATA
+// ----
+
+static const string AIO_PATH("sample_aio.bin");
+static constexpr size_t BLOCK_SIZE = 4096;
+static constexpr size_t BLOCK_COUNT = 16;
+
+// HELPERS
+// -------
+
+
+static string make_block(size_t index)
+{
+    return string(BLOCK_SIZE, static_cast<char>('a' + index % 26));
+}
+
+
+static void test_engine(aio_backend backend)
+{
+    aio_engine engine(8, backend);
+    fd_t fd = fd_open(AIO_PATH, ios_base::in | ios_base::out | ios_base::trunc);
+    ASSERT_NE(fd, INVALID_FD_VALUE);
+
+    // batched writes, in reverse order, with callbacks
+    vector<string> blocks;
+    atomic<size_t> wrote(0);
+    for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+        blocks.emplace_back(make_block(i));
+    }
+    for (size_t i = BLOCK_COUNT; i-- > 0; ) {
+        engine.write(fd, blocks[i].data(), BLOCK_SIZE, i * BLOCK_SIZE, [&wrote](streamsize bytes) {
+            wrote += static_cast<size_t>(bytes);
+        });
+    }
+    EXPECT_LE(engine.pending(), BLOCK_COUNT);
+    engine.wait();
+    EXPECT_EQ(engine.pending(), 0);
+    EXPECT_EQ(wrote.load(), BLOCK_COUNT * BLOCK_SIZE);
+
+    // batched reads, with futures
+    vector<string> buffers(BLOCK_COUNT, string(BLOCK_SIZE, '\0'));
+    vector<future<streamsize>> results;
+    for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+        results.emplace_back(engine.read(fd, &buffers[i][0], BLOCK_SIZE, i * BLOCK_SIZE));
+    }
+    engine.submit();
+    for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+        EXPECT_EQ(results[i].get(), BLOCK_SIZE);
+        EXPECT_TRUE(buffers[i] == blocks[i]);
+    }
+
+    // reads do not modify the file offset
+    EXPECT_EQ(fd_tell(fd), 0);
+
+    // short read at EOF
+    string tail(BLOCK_SIZE, '\0');
+    auto eof = engine.read(fd, &tail[0], BLOCK_SIZE, BLOCK_COUNT * BLOCK_SIZE - 10);
+    engine.submit();
+    EXPECT_EQ(eof.get(), 10);
+
+    // registered buffers
+    string fixed(BLOCK_SIZE, '\0');
+    aio_buffer buffer = {&fixed[0], fixed.size()};
+    if (engine.register_buffers(&buffer, 1)) {
+        auto read = engine.read_fixed(fd, 0, BLOCK_SIZE, 3 * BLOCK_SIZE);
+        engine.submit();
+        EXPECT_EQ(read.get(), BLOCK_SIZE);
+        EXPECT_TRUE(fixed == blocks[3]);
+
+        fixed.assign(BLOCK_SIZE, 'z');
+        auto write = engine.write_fixed(fd, 0, BLOCK_SIZE, 0);
+        engine.wait();
+        EXPECT_EQ(write.get(), BLOCK_SIZE);
+        EXPECT_THROW(engine.read_fixed(fd, 1, BLOCK_SIZE, 0), filesystem_error);
+        engine.unregister_buffers();
+
+        auto check = engine.read(fd, &tail[0], BLOCK_SIZE, 0);
+        engine.submit();
+        EXPECT_EQ(check.get(), BLOCK_SIZE);
+        EXPECT_TRUE(tail == fixed);
+    }
+
+    EXPECT_EQ(fd_close(fd), 0);
+
+    // errors are reported as a negative errno
+    auto error = engine.read(INVALID_FD_VALUE, &tail[0], BLOCK_SIZE, 0);
+    engine.submit();
+    EXPECT_LT(error.get(), 0);
+
+    EXPECT_TRUE(remove_file(AIO_PATH));
+}
+
+// TESTS
+// -----
+
+
+TEST(aio_engine, threads)
+{
+    aio_engine engine(AIO_QUEUE_DEPTH, aio_backend_threads);
+    EXPECT_EQ(engine.backend(), aio_backend_threads);
+    test_engine(aio_backend_threads);
+}
+
+
+TEST(aio_engine, default_backend)
+{
+    test_engine(aio_backend_default);
+}
+
+
+TEST(aio_engine, queue_depth)
+{
+    // more requests than the queue depth
+    aio_engine engine(2);
+    fd_t fd = fd_open(AIO_PATH, ios_base::in | ios_base::out | ios_base::trunc);
+    ASSERT_NE(fd, INVALID_FD_VALUE);
+
+    string data(256, 'x');
+    atomic<size_t> count(0);
+    for (size_t i = 0; i < data.size(); ++i) {
+        engine.write(fd, &data[i], 1, i, [&count](streamsize bytes) {
+            count += bytes == 1;
+        });
+    }
+    engine.wait();
+    EXPECT_EQ(count.load(), data.size());
+    EXPECT_EQ(fd_close(fd), 0);
+    EXPECT_TRUE(remove_file(AIO_PATH));
+}
@@ -0,0 +1,141 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Batched metadata unittests.
+ */
+
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/batch.h>
+#include <pycpp/stl/fstream.h>
+#include <gtest/gtest.h>
+#if !defined(OS_WINDOWS)
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+PYCPP_USING_NAMESPACE
+
+// DATA
+// ----
+
+static const string BATCH_ROOT("sample_batch_root");
+static constexpr size_t BATCH_FILES = 600;
+
+// HELPERS
+// -------
+
+
+/**
+ *  \brief Create a directory of files, where file `i` holds `i` bytes.
+ */
+static path_list_t make_files()
+{
+    path_list_t names;
+    EXPECT_TRUE(mkdir(BATCH_ROOT));
+    for (size_t i = 0; i < BATCH_FILES; ++i) {
+        path_t name = path_t("file") + std::to_string(i).c_str();
+        ofstream(BATCH_ROOT + "/" + name) << string(i, 'x');
+        names.push_back(name);
+    }
+
+    return names;
+}
+
+
+static path_list_t full_paths(const path_list_t& names)
+{
+    path_list_t paths;
+    for (const path_t& name: names) {
+        paths.push_back(BATCH_ROOT + "/" + name);
+    }
+
+    return paths;
+}
+
+// TESTS
+// -----
+
+
+TEST(stat_many, paths)
+{
+    path_list_t paths = full_paths(make_files());
+    paths.push_back(BATCH_ROOT + "/missing");
+
+    for (size_t threads: {1, 4, 0}) {
+        stat_many_options options;
+        options.threads = threads;
+        auto results = stat_many(paths, options);
+        ASSERT_EQ(results.size(), paths.size());
+        for (size_t i = 0; i < BATCH_FILES; ++i) {
+            EXPECT_EQ(results[i].error, filesystem_no_error);
+            EXPECT_TRUE(isfile(results[i].stat));
+            EXPECT_EQ(getsize(results[i].stat), static_cast<off_t>(i));
+        }
+        EXPECT_EQ(results.back().error, filesystem_file_not_found);
+    }
+
+    // matches a single stat
+    auto results = stat_many(paths);
+    stat_t data = stat(paths[7]);
+    EXPECT_TRUE(samestat(results[7].stat, data));
+    EXPECT_EQ(getmtime(results[7].stat), getmtime(data));
+
+    EXPECT_TRUE(remove_dir(BATCH_ROOT, true));
+}
+
+
+TEST(stat_many, fields)
+{
+    path_list_t paths = full_paths(make_files());
+
+    stat_many_options options;
+    options.fields = stat_field_type | stat_field_size;
+    auto results = stat_many(paths, options);
+    for (size_t i = 0; i < BATCH_FILES; ++i) {
+        EXPECT_EQ(results[i].error, filesystem_no_error);
+        EXPECT_TRUE(isfile(results[i].stat));
+        EXPECT_EQ(getsize(results[i].stat), static_cast<off_t>(i));
+    }
+
+    EXPECT_TRUE(remove_dir(BATCH_ROOT, true));
+}
+
+
+#if !defined(OS_WINDOWS)
+
+TEST(stat_many, dirfd)
+{
+    path_list_t names = make_files();
+    names.push_back("missing");
+    ASSERT_EQ(::symlink("file5", (BATCH_ROOT + "/link").c_str()), 0);
+    names.push_back("link");
+
+    int fd = ::open(BATCH_ROOT.c_str(), O_RDONLY | O_DIRECTORY);
+    ASSERT_NE(fd, -1);
+
+    stat_many_options options;
+    options.threads = 4;
+    auto results = stat_many(fd, names, options);
+    ASSERT_EQ(results.size(), names.size());
+    for (size_t i = 0; i < BATCH_FILES; ++i) {
+        EXPECT_EQ(results[i].error, filesystem_no_error);
+        EXPECT_EQ(getsize(results[i].stat), static_cast<off_t>(i));
+    }
+    EXPECT_EQ(results[BATCH_FILES].error, filesystem_file_not_found);
+    EXPECT_TRUE(isfile(results.back().stat));
+
+    // do not follow symlinks
+    options.follow_symlinks = false;
+    results = stat_many(fd, names, options);
+    EXPECT_TRUE(islink(results.back().stat));
+
+    // invalid descriptor
+    results = stat_many(-1, names, options);
+    EXPECT_EQ(results.front().error, filesystem_invalid_parameter);
+
+    ::close(fd);
+    EXPECT_TRUE(remove_dir(BATCH_ROOT, true));
+}
+
+#endif
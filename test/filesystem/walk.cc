@@ -0,0 +1,190 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Directory tree walker unittests.
+ */
+
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/exception.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/fstream.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+#if !defined(OS_WINDOWS)
+#   include <unistd.h>
+#endif
+
+#if !defined(OS_WINDOWS)                        // POSIX
+
+PYCPP_USING_NAMESPACE
+
+// DATA
+// ----
+
+static const string WALK_ROOT("sample_walk_root");
+
+// HELPERS
+// -------
+
+
+/**
+ *  \brief Create a tree with 4 directories of 3 subdirectories, each with 5 files.
+ */
+static size_t make_tree()
+{
+    size_t count = 0;
+    EXPECT_TRUE(mkdir(WALK_ROOT));
+    for (int i = 0; i < 4; ++i) {
+        string dir = WALK_ROOT + "/dir" + std::to_string(i).c_str();
+        EXPECT_TRUE(mkdir(dir));
+        ++count;
+        for (int j = 0; j < 3; ++j) {
+            string sub = dir + "/sub" + std::to_string(j).c_str();
+            EXPECT_TRUE(mkdir(sub));
+            ++count;
+            for (int k = 0; k < 5; ++k) {
+                ofstream(sub + "/file" + std::to_string(k).c_str()) << "data";
+                ++count;
+            }
+        }
+    }
+
+    return count;
+}
+
+
+struct collector
+{
+    mutex mutex_;
+    vector<string> paths;
+    size_t files = 0;
+    size_t max_depth = 0;
+
+    void operator()(const walk_entry& entry)
+    {
+        lock_guard<mutex> lock(mutex_);
+        paths.emplace_back(entry.path());
+        files += entry.isfile();
+        max_depth = max(max_depth, entry.depth());
+    }
+};
+
+// TESTS
+// -----
+
+
+TEST(walk, sequential)
+{
+    size_t count = make_tree();
+    collector visited;
+    walk(WALK_ROOT, [&visited](const walk_entry& entry) { visited(entry); });
+
+    EXPECT_EQ(visited.paths.size(), count);
+    EXPECT_EQ(visited.files, 60);
+    EXPECT_EQ(visited.max_depth, 2);
+
+    // directories precede their contents
+    auto dir = find(visited.paths.begin(), visited.paths.end(), WALK_ROOT + "/dir1/sub2");
+    auto file = find(visited.paths.begin(), visited.paths.end(), WALK_ROOT + "/dir1/sub2/file3");
+    ASSERT_NE(dir, visited.paths.end());
+    ASSERT_NE(file, visited.paths.end());
+    EXPECT_LT(dir, file);
+
+    EXPECT_TRUE(remove_dir(WALK_ROOT, true));
+}
+
+
+TEST(walk, parallel)
+{
+    size_t count = make_tree();
+    for (size_t threads: {2, 4, 0}) {
+        collector visited;
+        walk_options options;
+        options.threads = threads;
+        walk(WALK_ROOT, [&visited](const walk_entry& entry) { visited(entry); }, options);
+
+        EXPECT_EQ(visited.paths.size(), count);
+        EXPECT_EQ(visited.files, 60);
+        sort(visited.paths.begin(), visited.paths.end());
+        EXPECT_TRUE(adjacent_find(visited.paths.begin(), visited.paths.end()) == visited.paths.end());
+    }
+
+    EXPECT_TRUE(remove_dir(WALK_ROOT, true));
+}
+
+
+TEST(walk, filter)
+{
+    make_tree();
+    collector visited;
+    walk_options options;
+    options.threads = 2;
+    options.filter = [](const walk_entry& entry) {
+        // prune one subtree, and skip files named file0
+        return entry.basename() != path_view_t("dir0") && entry.basename() != path_view_t("file0");
+    };
+    walk(WALK_ROOT, [&visited](const walk_entry& entry) { visited(entry); }, options);
+
+    // 3 directories, 9 subdirectories, 36 files
+    EXPECT_EQ(visited.paths.size(), 48);
+    EXPECT_EQ(visited.files, 36);
+
+    EXPECT_TRUE(remove_dir(WALK_ROOT, true));
+}
+
+
+TEST(walk, stat)
+{
+    make_tree();
+    size_t files = 0;
+    walk(WALK_ROOT, [&files](const walk_entry& entry) {
+        if (entry.isfile()) {
+            EXPECT_EQ(getsize(entry.stat()), 4);
+            ++files;
+        } else {
+            EXPECT_TRUE(isdir(entry.stat()));
+        }
+    });
+    EXPECT_EQ(files, 60);
+
+    EXPECT_TRUE(remove_dir(WALK_ROOT, true));
+}
+
+
+TEST(walk, symlink)
+{
+    make_tree();
+    ASSERT_EQ(::symlink("../dir1", (WALK_ROOT + "/dir0/link").data()), 0);
+
+    // not followed by default
+    collector visited;
+    walk(WALK_ROOT, [&visited](const walk_entry& entry) { visited(entry); });
+    EXPECT_EQ(visited.files, 60);
+
+    // each directory is visited once when following links
+    collector followed;
+    walk_options options;
+    options.follow_symlinks = true;
+    walk(WALK_ROOT + "/dir0", [&followed](const walk_entry& entry) { followed(entry); }, options);
+    EXPECT_EQ(followed.files, 30);
+
+    EXPECT_TRUE(remove_dir(WALK_ROOT, true));
+}
+
+
+TEST(walk, errors)
+{
+    EXPECT_THROW(walk("nonexistent_walk_root", [](const walk_entry&) {}), filesystem_error);
+
+    // callback exceptions stop the walk
+    make_tree();
+    walk_options options;
+    options.threads = 2;
+    EXPECT_THROW(walk(WALK_ROOT, [](const walk_entry&) { throw runtime_error(""); }, options), runtime_error);
+
+    EXPECT_TRUE(remove_dir(WALK_ROOT, true));
+}
+
+#endif                                          // POSIX
@@ -0,0 +1,190 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Filesystem watcher unittests.
+ */
+
+#include <pycpp/filesystem.h>
+#include <pycpp/filesystem/exception.h>
+#include <pycpp/filesystem/watch.h>
+#include <pycpp/stl/condition_variable.h>
+#include <pycpp/stl/fstream.h>
+#include <pycpp/stl/map.h>
+#include <pycpp/stl/mutex.h>
+#include <gtest/gtest.h>
+
+#if !defined(OS_WINDOWS)                        // POSIX
+
+PYCPP_USING_NAMESPACE
+
+// DATA
+// ----
+
+static const string WATCH_ROOT("sample_watch_root");
+
+// HELPERS
+// -------
+
+
+static watch_options make_options(watch_backend backend)
+{
+    watch_options options;
+    options.debounce = chrono::milliseconds(20);
+    options.interval = chrono::milliseconds(20);
+    options.backend = backend;
+    return options;
+}
+
+
+/**
+ *  \brief Collect batches until `path` is reported, or a timeout.
+ */
+static map<string, int> collect(file_watcher& watcher, const string& path)
+{
+    map<string, int> events;
+    watch_changes changes;
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (events.find(path) == events.end() && chrono::steady_clock::now() < deadline) {
+        if (watcher.wait(changes, chrono::milliseconds(100))) {
+            for (const watch_change& change: changes) {
+                events[change.path] |= change.events;
+            }
+        }
+    }
+
+    return events;
+}
+
+
+static void test_tree(watch_backend backend)
+{
+    EXPECT_TRUE(mkdir(WATCH_ROOT));
+    ofstream(WATCH_ROOT + "/existing") << "data";
+    {
+        file_watcher watcher(make_options(backend));
+        watcher.add(WATCH_ROOT);
+
+        // created, including entries of new directories
+        ofstream(WATCH_ROOT + "/file") << "data";
+        EXPECT_TRUE(mkdir(WATCH_ROOT + "/sub"));
+        ofstream(WATCH_ROOT + "/sub/nested") << "data";
+        ofstream(WATCH_ROOT + "/last") << "data";
+        auto events = collect(watcher, WATCH_ROOT + "/last");
+        EXPECT_EQ(events[WATCH_ROOT + "/file"], watch_created);
+        EXPECT_EQ(events[WATCH_ROOT + "/sub"], watch_created);
+        EXPECT_EQ(events.count(WATCH_ROOT + "/existing"), 0);
+        if (events.find(WATCH_ROOT + "/sub/nested") == events.end()) {
+            events = collect(watcher, WATCH_ROOT + "/sub/nested");
+        }
+        EXPECT_EQ(events[WATCH_ROOT + "/sub/nested"], watch_created);
+
+        // modified and removed
+        ofstream(WATCH_ROOT + "/sub/nested", ios_base::app) << "more data";
+        events = collect(watcher, WATCH_ROOT + "/sub/nested");
+        EXPECT_EQ(events[WATCH_ROOT + "/sub/nested"], watch_modified);
+
+        EXPECT_TRUE(remove_file(WATCH_ROOT + "/existing"));
+        events = collect(watcher, WATCH_ROOT + "/existing");
+        EXPECT_EQ(events[WATCH_ROOT + "/existing"], watch_removed);
+
+        // removed roots are no longer reported
+        watcher.remove(WATCH_ROOT);
+        ofstream(WATCH_ROOT + "/file", ios_base::app) << "more data";
+        watch_changes changes;
+        EXPECT_FALSE(watcher.wait(changes, chrono::milliseconds(100)));
+    }
+
+    EXPECT_TRUE(remove_dir(WATCH_ROOT));
+}
+
+// TESTS
+// -----
+
+
+TEST(file_watcher, polling)
+{
+    file_watcher watcher(make_options(watch_backend_polling));
+    EXPECT_EQ(watcher.backend(), watch_backend_polling);
+    test_tree(watch_backend_polling);
+}
+
+
+TEST(file_watcher, inotify)
+{
+    file_watcher watcher;
+#if defined(HAVE_SYS_INOTIFY_H)
+    EXPECT_EQ(watcher.backend(), watch_backend_inotify);
+#endif
+    test_tree(watcher.backend());
+}
+
+
+TEST(file_watcher, coalesce)
+{
+    EXPECT_TRUE(mkdir(WATCH_ROOT));
+    {
+        file_watcher watcher(make_options(watch_backend_default));
+        watcher.add(WATCH_ROOT);
+
+        // temporary files, replaced files and repeated writes
+        ofstream(WATCH_ROOT + "/temporary") << "data";
+        EXPECT_TRUE(remove_file(WATCH_ROOT + "/temporary"));
+        {
+            ofstream stream(WATCH_ROOT + "/file");
+            for (int i = 0; i < 10; ++i) {
+                stream << "data" << std::endl;
+            }
+        }
+        ofstream(WATCH_ROOT + "/last") << "data";
+
+        auto events = collect(watcher, WATCH_ROOT + "/last");
+        if (watcher.backend() == watch_backend_inotify) {
+            EXPECT_EQ(events.count(WATCH_ROOT + "/temporary"), 0);
+        }
+        EXPECT_EQ(events[WATCH_ROOT + "/file"], watch_created);
+    }
+
+    EXPECT_TRUE(remove_dir(WATCH_ROOT));
+}
+
+
+TEST(file_watcher, callback)
+{
+    EXPECT_TRUE(mkdir(WATCH_ROOT));
+    {
+        mutex mutex_;
+        condition_variable done;
+        watch_changes received;
+        file_watcher watcher(make_options(watch_backend_default));
+        watcher.add(WATCH_ROOT);
+        watcher.start([&](const watch_changes& changes) {
+            lock_guard<mutex> lock(mutex_);
+            received.insert(received.end(), changes.begin(), changes.end());
+            done.notify_all();
+        });
+
+        ofstream(WATCH_ROOT + "/file") << "data";
+        {
+            unique_lock<mutex> lock(mutex_);
+            done.wait_for(lock, chrono::seconds(5), [&]() {
+                return !received.empty();
+            });
+            ASSERT_EQ(received.size(), 1);
+            EXPECT_EQ(received.front().path, WATCH_ROOT + "/file");
+            EXPECT_EQ(received.front().events, watch_created);
+        }
+        watcher.stop();
+    }
+
+    EXPECT_TRUE(remove_dir(WATCH_ROOT));
+}
+
+
+TEST(file_watcher, missing)
+{
+    file_watcher watcher;
+    EXPECT_THROW(watcher.add(WATCH_ROOT + "/missing"), filesystem_error);
+}
+
+#endif                                          // POSIX
@@ -0,0 +1,206 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Memory-mapped array unittests.
+ */
+
+#include <pycpp/filesystem.h>
+#include <pycpp/memmap/array.h>
+#include <pycpp/stl/algorithm.h>
+#include <pycpp/stl/numeric.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+
+#if defined(HAVE_MMAP) || defined(OS_WINDOWS)           // MMAP
+
+PYCPP_USING_NAMESPACE
+
+// DATA
+// ----
+
+static const path_t MEMMAP_PATH("sample_memmap_array.bin");
+
+// elements per 64 KB window for a 4-byte type
+static constexpr size_t WINDOW = MEMMAP_WINDOW_GRANULARITY / sizeof(uint32_t);
+
+// TESTS
+// -----
+
+
+TEST(memmap_array, resize)
+{
+    {
+        memmap_array<uint32_t> array(MEMMAP_PATH, 0, 2);
+        EXPECT_TRUE(array.is_open());
+        EXPECT_TRUE(array.empty());
+        EXPECT_EQ(array.window_size(), MEMMAP_WINDOW_GRANULARITY);
+
+        array.resize(5 * WINDOW / 2);
+        EXPECT_EQ(array.size(), 5 * WINDOW / 2);
+        EXPECT_EQ(getsize(MEMMAP_PATH), static_cast<off_t>(array.size() * sizeof(uint32_t)));
+        EXPECT_EQ(array.front(), 0);
+        EXPECT_EQ(array.back(), 0);
+
+        array.back() = 7;
+        array.resize(array.size() + 1);
+        EXPECT_EQ(array[array.size() - 2], 7);
+        EXPECT_THROW(array.at(array.size()), out_of_range);
+
+        array.resize(10);
+        EXPECT_EQ(array.size(), 10);
+        array.flush(false);
+    }
+
+    EXPECT_TRUE(remove_file(MEMMAP_PATH));
+}
+
+
+TEST(memmap_array, window)
+{
+    // windows hold whole elements, at mappable offsets
+    struct triple { uint32_t a, b, c; };
+    {
+        memmap_array<triple> array(MEMMAP_PATH, 1);
+        EXPECT_EQ(array.window_size(), 3 * MEMMAP_WINDOW_GRANULARITY);
+        array.resize(3 * MEMMAP_WINDOW_GRANULARITY / sizeof(triple) + 1);
+        array.back() = {1, 2, 3};
+        EXPECT_EQ(array.back().c, 3);
+    }
+    EXPECT_TRUE(remove_file(MEMMAP_PATH));
+
+    memmap_array<uint32_t> array(MEMMAP_PATH, MEMMAP_WINDOW_GRANULARITY + 1);
+    EXPECT_EQ(array.window_size(), 2 * MEMMAP_WINDOW_GRANULARITY);
+    array.close();
+    EXPECT_FALSE(array.is_open());
+    EXPECT_TRUE(remove_file(MEMMAP_PATH));
+}
+
+
+TEST(memmap_array, eviction)
+{
+    {
+        // more windows than the cache holds
+        memmap_array<uint32_t> array(MEMMAP_PATH, 0, 2);
+        array.resize(8 * WINDOW + 3);
+        for (size_t i = 0; i < array.size(); i += 17) {
+            array[i] = static_cast<uint32_t>(i);
+        }
+        for (size_t i = 0; i < array.size(); i += 17) {
+            EXPECT_EQ(array[i], static_cast<uint32_t>(i));
+        }
+
+        // strided access between windows
+        for (size_t i = 0; i < 8; ++i) {
+            size_t index = (i % 2 ? i : 8 - i) * WINDOW;
+            array[index + 1] = static_cast<uint32_t>(index);
+        }
+        for (size_t i = 0; i < 8; ++i) {
+            EXPECT_EQ(array[i * WINDOW + 1], static_cast<uint32_t>(i * WINDOW));
+        }
+    }
+
+    // persists after closing
+    memmap_array<uint32_t> array(MEMMAP_PATH);
+    EXPECT_EQ(array.size(), 8 * WINDOW + 3);
+    EXPECT_EQ(array[34], 34);
+    EXPECT_EQ(array[7 * WINDOW + 1], 7 * WINDOW);
+    array.close();
+    EXPECT_TRUE(remove_file(MEMMAP_PATH));
+}
+
+
+#if defined(OS_POSIX)
+
+TEST(memmap_array, unlinked)
+{
+    // windows map the open file, even once its path is gone
+    memmap_array<uint32_t> array(MEMMAP_PATH, 0, 1);
+    array.resize(2 * WINDOW);
+    array[WINDOW] = 5;
+    EXPECT_EQ(array[0], 0);
+    EXPECT_TRUE(remove_file(MEMMAP_PATH));
+
+    EXPECT_EQ(array[WINDOW], 5);
+    array[1] = 3;
+    EXPECT_EQ(array[1], 3);
+}
+
+#endif
+
+
+TEST(memmap_array, iterator)
+{
+    {
+        memmap_array<uint32_t> array(MEMMAP_PATH, 0, 3);
+        array.resize(4 * WINDOW + 5);
+        iota(array.begin(), array.end(), 0);
+        EXPECT_EQ(array.end() - array.begin(), static_cast<ptrdiff_t>(array.size()));
+        EXPECT_EQ(array.begin()[WINDOW + 1], WINDOW + 1);
+        EXPECT_EQ(*(array.end() - 1), array.size() - 1);
+        EXPECT_EQ(*array.rbegin(), array.size() - 1);
+
+        const memmap_array<uint32_t>& ref = array;
+        EXPECT_TRUE(is_sorted(ref.begin(), ref.end()));
+        EXPECT_EQ(*lower_bound(ref.begin(), ref.end(), 3 * WINDOW), 3 * WINDOW);
+        EXPECT_EQ(count(ref.cbegin(), ref.cend(), 5), 1);
+
+        reverse(array.begin(), array.end());
+        EXPECT_EQ(array.front(), array.size() - 1);
+        EXPECT_EQ(array.back(), 0);
+        sort(array.begin(), array.end());
+        EXPECT_EQ(array[2 * WINDOW], 2 * WINDOW);
+    }
+
+    EXPECT_TRUE(remove_file(MEMMAP_PATH));
+}
+
+
+TEST(memmap_array, bulk)
+{
+    {
+        memmap_array<uint32_t> array(MEMMAP_PATH, 0, 2);
+        array.resize(5 * WINDOW);
+
+        // copy in across window boundaries
+        vector<uint32_t> src(3 * WINDOW);
+        iota(src.begin(), src.end(), 1);
+        array.write(WINDOW / 2, src.data(), src.size());
+        EXPECT_EQ(array[WINDOW / 2 - 1], 0);
+        EXPECT_EQ(array[WINDOW / 2], 1);
+        EXPECT_EQ(array[7 * WINDOW / 2 - 1], 3 * WINDOW);
+        EXPECT_EQ(array[7 * WINDOW / 2], 0);
+
+        // copy out
+        vector<uint32_t> dst(src.size());
+        array.read(WINDOW / 2, dst.data(), dst.size());
+        EXPECT_EQ(src, dst);
+        array.read(WINDOW, dst.data(), 1);
+        EXPECT_EQ(dst.front(), WINDOW / 2 + 1);
+
+        EXPECT_THROW(array.read(4 * WINDOW, dst.data(), dst.size()), out_of_range);
+        EXPECT_THROW(array.write(5 * WINDOW + 1, src.data(), 0), out_of_range);
+    }
+
+    EXPECT_TRUE(remove_file(MEMMAP_PATH));
+}
+
+
+TEST(memmap_array, move)
+{
+    memmap_array<uint32_t> array(MEMMAP_PATH);
+    array.resize(10);
+    array[3] = 3;
+
+    memmap_array<uint32_t> other(move(array));
+    EXPECT_FALSE(array.is_open());
+    EXPECT_EQ(other.size(), 10);
+    EXPECT_EQ(other[3], 3);
+
+    array = move(other);
+    EXPECT_EQ(array[3], 3);
+    array.close();
+    EXPECT_TRUE(remove_file(MEMMAP_PATH));
+}
+
+#endif                                                  // MMAP
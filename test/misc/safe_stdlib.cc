@@ -23,3 +23,13 @@ TEST(stdlib, safe_alloc)
     ptr = safe_calloc(100, 1);
     safe_free(ptr);
 }
+
+
+TEST(stdlib, safe_aligned_alloc)
+{
+    for (size_t alignment: {1, 16, 4096}) {
+        auto *ptr = safe_aligned_malloc(100, alignment);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignment, 0);
+        safe_aligned_free(ptr);
+    }
+}
@@ -1,11 +1,48 @@
 //  :copyright: (c) 2017 Alex Huszagh.
 //  :license: MIT, see licenses/mit.md for more details.
 
+#include <pycpp/stl/condition_variable.h>
+#include <pycpp/stl/deque.h>
+#include <pycpp/stl/list.h>
+#include <pycpp/stl/mutex.h>
+#include <pycpp/stl/thread.h>
 #include <pycpp/stl/vector.h>
 #include <gtest/gtest.h>
+#include <stdint.h>
 
 PYCPP_USING_NAMESPACE
 
+// HELPERS
+// -------
+
+/**
+ *  \brief Upstream resource recording the peak of outstanding bytes.
+ */
+struct counting_resource: memory_resource
+{
+    size_t bytes = 0;
+    size_t peak = 0;
+
+protected:
+    virtual void* do_allocate(size_t n, size_t alignment) override
+    {
+        bytes += n;
+        peak = bytes > peak ? bytes : peak;
+        return new_delete_resource()->allocate(n, alignment);
+    }
+
+    virtual void do_deallocate(void* p, size_t n, size_t alignment) override
+    {
+        bytes -= n;
+        new_delete_resource()->deallocate(p, n, alignment);
+    }
+
+    virtual bool do_is_equal(const memory_resource& rhs) const noexcept override
+    {
+        return this == &rhs;
+    }
+};
+
 // TESTS
 // -----
 
@@ -15,6 +52,10 @@ TEST(polymorphic, is_relocatable)
     using allocator_type = polymorphic_allocator<char>;
     static_assert(is_relocatable<memory_resource>::value, "");
     static_assert(is_relocatable<allocator_type>::value, "");
+    static_assert(is_relocatable<pool_options>::value, "");
+    static_assert(!is_relocatable<monotonic_buffer_resource>::value, "");
+    static_assert(!is_relocatable<unsynchronized_pool_resource>::value, "");
+    static_assert(!is_relocatable<synchronized_pool_resource>::value, "");
 }
 
 
@@ -61,3 +102,157 @@ TEST(polymorphic_allocator, vector)
     vector_type v1;
     v1.emplace_back(1);
 }
+
+
+TEST(polymorphic_allocator, monotonic_buffer_resource)
+{
+    alignas(16) byte buffer[64];
+    monotonic_buffer_resource resource(buffer, sizeof(buffer), new_delete_resource());
+    EXPECT_EQ(resource.upstream_resource(), new_delete_resource());
+
+    // allocations bump from the initial buffer
+    void* p1 = resource.allocate(8, 8);
+    void* p2 = resource.allocate(8, 8);
+    EXPECT_EQ(p1, static_cast<void*>(buffer));
+    EXPECT_EQ(static_cast<byte*>(p2) - static_cast<byte*>(p1), 8);
+    void* p3 = resource.allocate(1, 1);
+    void* p4 = resource.allocate(16, 16);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p4) % 16, 0);
+    EXPECT_EQ(static_cast<byte*>(p4), buffer + 32);
+    resource.deallocate(p3, 1, 1);
+
+    // then from the upstream resource
+    void* p5 = resource.allocate(64, 64);
+    EXPECT_TRUE(p5 < static_cast<void*>(buffer) || p5 >= static_cast<void*>(buffer + sizeof(buffer)));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p5) % 64, 0);
+    for (size_t i = 0; i < 100; ++i) {
+        resource.allocate(100);
+    }
+
+    // release reuses the initial buffer
+    resource.release();
+    EXPECT_EQ(resource.allocate(8, 8), static_cast<void*>(buffer));
+}
+
+
+TEST(polymorphic_allocator, unsynchronized_pool_resource)
+{
+    pool_options options;
+    options.largest_required_pool_block = 100;
+    unsynchronized_pool_resource resource(options, new_delete_resource());
+    EXPECT_EQ(resource.options().largest_required_pool_block, 128);
+    EXPECT_GT(resource.options().max_blocks_per_chunk, 0);
+    EXPECT_EQ(resource.upstream_resource(), new_delete_resource());
+
+    // freed blocks are reused by the same size class
+    void* p1 = resource.allocate(24);
+    void* p2 = resource.allocate(32);
+    EXPECT_EQ(static_cast<byte*>(p2) - static_cast<byte*>(p1), 32);
+    resource.deallocate(p1, 24);
+    EXPECT_EQ(resource.allocate(17), p1);
+    resource.deallocate(p2, 32);
+
+    // alignment selects a larger class
+    void* p3 = resource.allocate(8, 16);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p3) % 16, 0);
+
+    // oversized requests go upstream
+    void* p4 = resource.allocate(1000);
+    void* p5 = resource.allocate(8, 64);
+    void* p6 = resource.allocate(5000, 256);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p5) % 64, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p6) % 256, 0);
+    for (size_t i = 0; i < 200; ++i) {
+        void* p = resource.allocate(8 * i + 1, 128);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 128, 0);
+        resource.deallocate(p, 8 * i + 1, 128);
+    }
+    resource.deallocate(p6, 5000, 256);
+    resource.deallocate(p4, 1000);
+    resource.allocate(2000);
+
+    EXPECT_TRUE(resource.is_equal(resource));
+    EXPECT_FALSE(resource.is_equal(*new_delete_resource()));
+    resource.release();
+}
+
+
+TEST(polymorphic_allocator, synchronized_pool_resource)
+{
+    using allocator_type = polymorphic_allocator<int>;
+    using list_type = std::list<int, allocator_type>;
+
+    synchronized_pool_resource resource;
+    EXPECT_EQ(resource.options().largest_required_pool_block, 4096);
+
+    // blocks may be freed from another thread
+    list_type shared{allocator_type(&resource)};
+    for (int i = 0; i < 1000; ++i) {
+        shared.push_back(i);
+    }
+
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&resource, &shared, t]() {
+            list_type l{allocator_type(&resource)};
+            vector<int, allocator_type> v{allocator_type(&resource)};
+            for (int i = 0; i < 10000; ++i) {
+                l.push_back(i);
+                v.push_back(i);
+            }
+            if (t == 0) {
+                shared.clear();
+            }
+            EXPECT_EQ(l.size(), 10000);
+            EXPECT_EQ(v.back(), 9999);
+        });
+    }
+    for (thread& t: threads) {
+        t.join();
+    }
+    EXPECT_TRUE(shared.empty());
+
+    resource.release();
+    shared.push_back(1);
+    EXPECT_EQ(shared.front(), 1);
+}
+
+
+TEST(polymorphic_allocator, synchronized_pool_handoff)
+{
+    // blocks allocated by a producer and freed by a consumer are reused
+    static constexpr size_t COUNT = 100000;
+    static constexpr size_t QUEUED = 64;
+    counting_resource upstream;
+    synchronized_pool_resource resource(&upstream);
+    mutex m;
+    condition_variable cv;
+    deque<void*> queue;
+
+    thread producer([&]() {
+        for (size_t i = 0; i < COUNT; ++i) {
+            void* p = resource.allocate(64);
+            unique_lock<mutex> lock(m);
+            cv.wait(lock, [&]() { return queue.size() < QUEUED; });
+            queue.push_back(p);
+            cv.notify_all();
+        }
+    });
+    thread consumer([&]() {
+        for (size_t i = 0; i < COUNT; ++i) {
+            unique_lock<mutex> lock(m);
+            cv.wait(lock, [&]() { return !queue.empty(); });
+            void* p = queue.front();
+            queue.pop_front();
+            cv.notify_all();
+            lock.unlock();
+            resource.deallocate(p, 64);
+        }
+    });
+    producer.join();
+    consumer.join();
+
+    EXPECT_LT(upstream.peak, 256 * 1024);
+    resource.release();
+    EXPECT_EQ(upstream.bytes, 0);
+}
@@ -0,0 +1,192 @@
+//  :copyright: (c) 2017 Alex Huszagh.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup Tests
+ *  \brief Atomic file writer unittests.
+ */
+
+#include <pycpp/filesystem.h>
+#include <pycpp/stream/atomic.h>
+#include <pycpp/stream/sequential.h>
+#include <pycpp/stl/string.h>
+#include <pycpp/stl/thread.h>
+#include <pycpp/stl/vector.h>
+#include <gtest/gtest.h>
+
+#if !defined(OS_WINDOWS)
+#   include <signal.h>
+#   include <sys/resource.h>
+#endif
+
+PYCPP_USING_NAMESPACE
+
+// DATA
+// ----
+
+static const path_t ATOMIC_PATH("sample_atomic.txt");
+
+// HELPERS
+// -------
+
+
+static string read_file(const path_t& path)
+{
+    sequential_ifstream stream(path);
+    string data;
+    getline(stream, data);
+    return data;
+}
+
+
+static path_t numbered_path(size_t i)
+{
+    return ATOMIC_PATH + std::to_string(i).c_str();
+}
+
+
+static void write_file(const path_t& path, const string& data)
+{
+    sequential_ofstream stream(path);
+    stream << data;
+}
+
+// TESTS
+// -----
+
+
+TEST(atomic_ofstream, commit)
+{
+    write_file(ATOMIC_PATH, "old");
+    {
+        atomic_ofstream stream(ATOMIC_PATH);
+        EXPECT_TRUE(stream.is_open());
+        EXPECT_EQ(stream.path(), ATOMIC_PATH);
+        stream << "new";
+
+        // unchanged until committed
+        EXPECT_EQ(read_file(ATOMIC_PATH), "old");
+        EXPECT_TRUE(stream.commit());
+        EXPECT_FALSE(stream.is_open());
+        EXPECT_FALSE(stream.commit());
+    }
+
+    EXPECT_EQ(read_file(ATOMIC_PATH), "new");
+    EXPECT_TRUE(remove_file(ATOMIC_PATH));
+}
+
+
+TEST(atomic_ofstream, discard)
+{
+    write_file(ATOMIC_PATH, "old");
+    size_t files = listdir(path_prefix(".")).size();
+    {
+        atomic_ofstream stream(ATOMIC_PATH);
+        stream << "new";
+        EXPECT_EQ(listdir(path_prefix(".")).size(), files + 1);
+    }
+    EXPECT_EQ(listdir(path_prefix(".")).size(), files);
+    EXPECT_EQ(read_file(ATOMIC_PATH), "old");
+
+    atomic_ofstream stream(ATOMIC_PATH);
+    stream << "new";
+    stream.discard();
+    EXPECT_FALSE(stream.is_open());
+    EXPECT_EQ(listdir(path_prefix(".")).size(), files);
+    EXPECT_EQ(read_file(ATOMIC_PATH), "old");
+
+    EXPECT_TRUE(remove_file(ATOMIC_PATH));
+}
+
+
+TEST(atomic_ofstream, replace)
+{
+    write_file(ATOMIC_PATH, "old");
+    {
+        atomic_ofstream stream(ATOMIC_PATH, false);
+        stream << "new";
+        EXPECT_FALSE(stream.commit());
+    }
+    EXPECT_EQ(read_file(ATOMIC_PATH), "old");
+    EXPECT_TRUE(remove_file(ATOMIC_PATH));
+
+    atomic_ofstream stream(ATOMIC_PATH, false);
+    stream << "new";
+    EXPECT_TRUE(stream.commit());
+    EXPECT_EQ(read_file(ATOMIC_PATH), "new");
+    EXPECT_TRUE(remove_file(ATOMIC_PATH));
+}
+
+
+TEST(atomic_ofstream, move)
+{
+    atomic_ofstream stream(ATOMIC_PATH);
+    stream << "new";
+
+    atomic_ofstream other(move(stream));
+    EXPECT_FALSE(stream.is_open());
+    EXPECT_TRUE(other.is_open());
+    EXPECT_TRUE(other.commit());
+    EXPECT_EQ(read_file(ATOMIC_PATH), "new");
+    EXPECT_TRUE(remove_file(ATOMIC_PATH));
+}
+
+
+#if !defined(OS_WINDOWS)
+
+TEST(atomic_ofstream, write_error)
+{
+    // limit the file size, so writes fail partway through
+    write_file(ATOMIC_PATH, "old");
+    size_t files = listdir(path_prefix(".")).size();
+    struct rlimit previous;
+    ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &previous), 0);
+    auto handler = ::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit limit = previous;
+    limit.rlim_cur = 1000;
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limit), 0);
+
+    bool committed;
+    {
+        atomic_ofstream stream(ATOMIC_PATH);
+        stream << string(100000, 'a');
+        committed = stream.commit();
+        EXPECT_FALSE(stream.good());
+    }
+
+    ::setrlimit(RLIMIT_FSIZE, &previous);
+    ::signal(SIGXFSZ, handler);
+    EXPECT_FALSE(committed);
+    EXPECT_EQ(listdir(path_prefix(".")).size(), files);
+    EXPECT_EQ(read_file(ATOMIC_PATH), "old");
+    EXPECT_TRUE(remove_file(ATOMIC_PATH));
+}
+
+#endif
+
+
+TEST(fsync_group, commit)
+{
+    static constexpr size_t WRITERS = 8;
+    fsync_group group;
+    vector<thread> threads;
+    vector<int> results(WRITERS);
+    for (size_t i = 0; i < WRITERS; ++i) {
+        threads.emplace_back([&, i]() {
+            atomic_ofstream stream(numbered_path(i));
+            stream << "data" << i;
+            results[i] = stream.commit(group);
+        });
+    }
+    for (thread& t: threads) {
+        t.join();
+    }
+
+    EXPECT_GE(group.batches(), 1);
+    EXPECT_LE(group.batches(), WRITERS);
+    for (size_t i = 0; i < WRITERS; ++i) {
+        path_t path = numbered_path(i);
+        EXPECT_TRUE(results[i]);
+        EXPECT_EQ(read_file(path), string("data") + std::to_string(i).c_str());
+        EXPECT_TRUE(remove_file(path));
+    }
+}
@@ -8,6 +8,7 @@
 #include <pycpp/filesystem.h>
 #include <pycpp/preprocessor/byteorder.h>
 #include <pycpp/preprocessor/os.h>
+#include <pycpp/stl/algorithm.h>
 #include <pycpp/stl/vector.h>
 #include <pycpp/stream/fd.h>
 #include <warnings/push.h>
@@ -126,6 +127,97 @@ TEST(fd_streambuf, fd_streambuf)
 }
 
 
+TEST(fd_streambuf, adaptive)
+{
+    string path("sample_path");
+    std::string expected;
+    for (size_t i = 0; expected.size() < (1 << 18); ++i) {
+        expected += std::to_string(i);
+        expected.push_back('\n');
+    }
+
+    // sequential writes grow the buffer
+    fd_t fd = fd_open(path, ios_base::out);
+    {
+        fd_streambuf buf(ios_base::out, fd, 512);
+        buf.adaptive(true);
+        for (size_t i = 0; i < expected.size(); i += 100) {
+            size_t count = min<size_t>(100, expected.size() - i);
+            EXPECT_EQ((size_t) buf.sputn(expected.data() + i, count), count);
+        }
+        EXPECT_GT(buf.buffer_size(), 512);
+        EXPECT_LE(buf.buffer_size(), ADAPTIVE_BUFFER_MAX);
+        buf.close();
+    }
+    fd_close(fd);
+
+    // sequential reads grow the buffer, and seeks reset it
+    fd = fd_open(path, ios_base::in);
+    {
+        fd_streambuf buf(ios_base::in, fd, 512);
+        buf.adaptive(true);
+        EXPECT_TRUE(buf.adaptive());
+        vector<char> out(expected.size());
+        EXPECT_EQ((size_t) buf.sgetn(out.data(), out.size()), out.size());
+        EXPECT_EQ(expected, std::string(out.data(), out.size()));
+        EXPECT_GT(buf.buffer_size(), 512);
+
+        EXPECT_EQ((size_t) buf.pubseekpos(100), 100);
+        EXPECT_EQ((size_t) buf.sgetn(out.data(), 10), 10);
+        EXPECT_EQ(expected.substr(100, 10), std::string(out.data(), 10));
+        EXPECT_EQ(buf.buffer_size(), 512);
+    }
+    fd_close(fd);
+
+    EXPECT_TRUE(remove_file(path));
+}
+
+
+TEST(fd_streambuf, direct)
+{
+    string path("sample_path");
+    std::string expected;
+    for (size_t i = 0; expected.size() < 3 * DIRECT_IO_ALIGNMENT + 100; ++i) {
+        expected += std::to_string(i);
+        expected.push_back('\n');
+    }
+
+    // buffers are aligned, and the unaligned tail is written on close
+    fd_t fd = fd_open(path, ios_base::out, S_IWR_USR_GRP, access_direct);
+    ASSERT_NE(fd, INVALID_FD_VALUE);
+    {
+        fd_streambuf buf(ios_base::out, fd, 1000);
+        buf.direct(true);
+        EXPECT_TRUE(buf.direct());
+        EXPECT_EQ(buf.buffer_size(), DIRECT_IO_ALIGNMENT);
+        EXPECT_EQ((size_t) buf.sputn(expected.data(), 5000), 5000);
+        EXPECT_EQ(buf.pubsync(), 0);
+        EXPECT_EQ((size_t) buf.pubseekoff(0, ios_base::cur), 5000);
+        EXPECT_EQ((size_t) buf.sputn(expected.data() + 5000, expected.size() - 5000), expected.size() - 5000);
+        buf.close();
+    }
+    fd_close(fd);
+    EXPECT_EQ(getsize(path), static_cast<off_t>(expected.size()));
+
+    // unaligned seeks fall back to buffered reads
+    fd = fd_open(path, ios_base::in, S_IWR_USR_GRP, access_direct);
+    {
+        fd_streambuf buf(ios_base::in, fd, DIRECT_IO_ALIGNMENT);
+        buf.direct(true);
+        vector<char> out(expected.size());
+        EXPECT_EQ((size_t) buf.sgetn(out.data(), out.size()), out.size());
+        EXPECT_EQ(expected, std::string(out.data(), out.size()));
+
+        EXPECT_EQ((size_t) buf.pubseekpos(100), 100);
+        EXPECT_EQ((size_t) buf.sgetn(out.data(), 10), 10);
+        EXPECT_EQ(expected.substr(100, 10), std::string(out.data(), 10));
+    }
+    fd_close(fd);
+
+    EXPECT_TRUE(remove_file(path));
+}
+
+
 TEST(fd_stream, fd_stream)
 {
     using tester = test_stream<fd_stream, fd_stream>;
@@ -6,6 +6,7 @@
  */
 
 #include <pycpp/filesystem.h>
+#include <pycpp/filesystem/exception.h>
 #include <pycpp/stream/mmap.h>
 #include <warnings/push.h>
 #include <warnings/narrowing-conversions.h>
@@ -13,6 +14,10 @@
 #if defined(HAVE_WFOPEN)
 #   include <io.h>
 #endif
+#if defined(OS_POSIX)
+#   include <signal.h>
+#   include <sys/resource.h>
+#endif
 
 #if defined(HAVE_MMAP) || defined(OS_WINDOWS)           // MMAP
 
@@ -127,6 +132,111 @@ TEST(mmap_fstream, mmap_iofstream)
 #endif
 }
 
+
+TEST(mmap_file, append)
+{
+    std::string path("sample_mmap_file.bin");
+    std::string expected;
+    {
+        mmap_file file(path, ios_base::out, true);
+        EXPECT_TRUE(file.is_open());
+        EXPECT_FALSE(file.has_mapping());
+        EXPECT_EQ(file.size(), 0);
+
+        // capacity grows geometrically, and pointers follow the mapping
+        for (size_t i = 0; expected.size() < 3 * MMAP_FILE_MIN_CAPACITY; ++i) {
+            std::string line = std::to_string(i) + "\n";
+            char* first = file.append(line.data(), line.size());
+            EXPECT_EQ(first, file.data() + expected.size());
+            expected += line;
+        }
+        EXPECT_EQ(file.size(), expected.size());
+        EXPECT_GE(file.capacity(), file.size());
+        EXPECT_EQ(file.capacity(), 4 * MMAP_FILE_MIN_CAPACITY);
+        EXPECT_EQ(std::string(file.data(), file.size()), expected);
+
+        // hints
+        EXPECT_TRUE(file.advise(advice_sequential));
+        EXPECT_TRUE(file.advise(advice_willneed, 100, 5000));
+        EXPECT_TRUE(file.flush(100, 5000, false));
+        EXPECT_TRUE(file.flush());
+    }
+
+    // the unused capacity is truncated on close
+    EXPECT_EQ(getsize(path), static_cast<off_t>(expected.size()));
+
+    // reopen read-only
+    {
+        mmap_file file(path, ios_base::in);
+        EXPECT_TRUE(file.has_mapping());
+        EXPECT_EQ(file.size(), expected.size());
+        EXPECT_EQ(std::string(file.data(), file.size()), expected);
+        EXPECT_THROW(file.reserve(2 * expected.size()), filesystem_error);
+    }
+
+    EXPECT_TRUE(remove_file(path));
+}
+
+
+TEST(mmap_file, resize)
+{
+    std::string path("sample_mmap_file.bin");
+    mmap_file file(path, ios_base::out);
+    file.resize(100);
+    memset(file.data(), 'a', file.size());
+    EXPECT_EQ(file.capacity(), MMAP_FILE_MIN_CAPACITY);
+
+    file.reserve(10 * MMAP_FILE_MIN_CAPACITY);
+    EXPECT_EQ(file.capacity(), 10 * MMAP_FILE_MIN_CAPACITY);
+    EXPECT_EQ(file.size(), 100);
+    EXPECT_EQ(file[99], 'a');
+
+    file.shrink_to_fit();
+    EXPECT_EQ(file.capacity(), 100);
+    EXPECT_EQ(getsize(path), 100);
+    EXPECT_EQ(file[0], 'a');
+
+    // moves
+    mmap_file other(std::move(file));
+    EXPECT_FALSE(file.is_open());
+    EXPECT_TRUE(other.has_mapping());
+    other.resize(0);
+    other.shrink_to_fit();
+    EXPECT_FALSE(other.has_mapping());
+    other.close();
+    EXPECT_EQ(getsize(path), 0);
+
+    EXPECT_TRUE(remove_file(path));
+}
+
+
+#if defined(OS_POSIX)
+
+TEST(mmap_file, reserve_error)
+{
+    // limit the file size, so the file cannot span the mapping
+    std::string path("sample_mmap_file.bin");
+    struct rlimit previous;
+    ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &previous), 0);
+    auto handler = ::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit limit = previous;
+    limit.rlim_cur = MMAP_FILE_MIN_CAPACITY;
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limit), 0);
+
+    {
+        mmap_file file(path, ios_base::out);
+        file.resize(100);
+        EXPECT_THROW(file.reserve(10 * MMAP_FILE_MIN_CAPACITY), filesystem_error);
+        EXPECT_EQ(file.capacity(), MMAP_FILE_MIN_CAPACITY);
+    }
+
+    ::setrlimit(RLIMIT_FSIZE, &previous);
+    ::signal(SIGXFSZ, handler);
+    EXPECT_TRUE(remove_file(path));
+}
+
+#endif
+
 #endif                                                  // MMAP
 
 #include <warnings/pop.h>
@@ -115,4 +115,81 @@ TEST(random_access_fstream, random_access_iofstream)
 #endif
 }
 
+
+TEST(random_access_fstream, buffer_size)
+{
+    std::string path("sample_buffer_size.bin");
+    std::string expected;
+    for (size_t i = 0; expected.size() < (1 << 16); ++i) {
+        expected += std::to_string(i);
+        expected.push_back('\n');
+    }
+    {
+        random_access_ofstream ofs(path, ios_base::out, 256);
+        ofs.write(expected.data(), expected.size());
+    }
+
+    // random reads, each within or past the buffered block
+    random_access_ifstream ifs(path, ios_base::in, 256);
+    std::string result(16, '\0');
+    for (size_t offset: {40000, 40100, 100, 65000, 120}) {
+        ifs.seekg(offset);
+        EXPECT_EQ(ifs.tellg(), offset);
+        ifs.read(&result[0], 16);
+        EXPECT_EQ(result, expected.substr(offset, 16));
+    }
+
+    EXPECT_TRUE(remove_file(path));
+}
+
+
+TEST(random_access_fstream, prefetch)
+{
+    std::string path("sample_prefetch.bin");
+    std::string expected;
+    for (size_t i = 0; expected.size() < (1 << 17); ++i) {
+        expected += std::to_string(i);
+        expected.push_back('\n');
+    }
+    {
+        random_access_ofstream ofs(path, ios_base::out);
+        ofs.write(expected.data(), expected.size());
+    }
+
+    for (aio_backend backend: {aio_backend_threads, aio_backend_default}) {
+        aio_engine engine(AIO_QUEUE_DEPTH, backend);
+        random_access_ifstream ifs(path, ios_base::in);
+        ifs.prefetch(&engine);
+
+        // sequential reads
+        std::string result(expected.size(), '\0');
+        ifs.read(&result[0], 1000);
+        EXPECT_EQ(ifs.tellg(), 1000);
+        ifs.read(&result[1000], result.size() - 1000);
+        EXPECT_EQ(result, expected);
+
+        // seeks discard the prefetched data
+        ifs.clear();
+        ifs.seekg(12345);
+        EXPECT_EQ(ifs.tellg(), 12345);
+        std::string line;
+        std::getline(ifs, line);
+        EXPECT_EQ(line, expected.substr(12345, expected.find('\n', 12345) - 12345));
+        ifs.seekg(-10, ios_base::end);
+        result.assign(20, '\0');
+        ifs.read(&result[0], 20);
+        EXPECT_EQ(ifs.gcount(), 10);
+
+        // disable prefetching mid-stream
+        ifs.clear();
+        ifs.seekg(100);
+        ifs.read(&result[0], 10);
+        ifs.prefetch(nullptr);
+        ifs.read(&result[10], 10);
+        EXPECT_EQ(result, expected.substr(100, 20));
+    }
+
+    EXPECT_TRUE(remove_file(path));
+}
+
 #include <warnings/pop.h>
@@ -112,4 +112,121 @@ TEST(sequential_fstream, sequential_iofstream)
 #endif
 }
 
+
+TEST(sequential_fstream, buffer_size)
+{
+    std::string path("sample_buffer_size.bin");
+    std::string expected;
+    for (size_t i = 0; expected.size() < (1 << 16); ++i) {
+        expected += std::to_string(i);
+        expected.push_back('\n');
+    }
+    {
+        sequential_ofstream ofs(path, ios_base::out, 100);
+        ofs.adaptive(true);
+        ofs.write(expected.data(), expected.size());
+    }
+
+    for (bool adaptive: {false, true}) {
+        sequential_ifstream ifs(path, ios_base::in, 64);
+        ifs.adaptive(adaptive);
+
+        // sequential reads
+        std::string result(expected.size(), '\0');
+        ifs.read(&result[0], 1000);
+        EXPECT_EQ(ifs.tellg(), 1000);
+        ifs.read(&result[1000], result.size() - 1000);
+        EXPECT_EQ(result, expected);
+
+        // seeks discard the buffered data
+        ifs.clear();
+        ifs.seekg(12345);
+        result.assign(10, '\0');
+        ifs.read(&result[0], 10);
+        EXPECT_EQ(result, expected.substr(12345, 10));
+        ifs.seekg(-5, ios_base::cur);
+        EXPECT_EQ(ifs.tellg(), 12350);
+        ifs.read(&result[0], 10);
+        EXPECT_EQ(result, expected.substr(12350, 10));
+    }
+
+    EXPECT_TRUE(remove_file(path));
+}
+
+
+TEST(sequential_fstream, direct)
+{
+    std::string path("sample_direct.bin");
+    std::string expected;
+    for (size_t i = 0; expected.size() < (1 << 16) + 7; ++i) {
+        expected += std::to_string(i);
+        expected.push_back('\n');
+    }
+    {
+        sequential_ofstream ofs(path, ios_base::out, 1 << 14);
+        ofs.direct(true);
+        ofs.write(expected.data(), 1000);
+        ofs.flush();
+        ofs.write(expected.data() + 1000, expected.size() - 1000);
+    }
+    EXPECT_EQ(getsize(path), static_cast<off_t>(expected.size()));
+
+    sequential_ifstream ifs(path, ios_base::in, 1 << 14);
+    ifs.direct(true);
+    std::string result(expected.size(), '\0');
+    ifs.read(&result[0], result.size());
+    EXPECT_EQ(result, expected);
+    EXPECT_TRUE(remove_file(path));
+}
+
+
+TEST(sequential_fstream, prefetch)
+{
+    std::string path("sample_prefetch.bin");
+    std::string expected;
+    for (size_t i = 0; expected.size() < (1 << 17); ++i) {
+        expected += std::to_string(i);
+        expected.push_back('\n');
+    }
+    {
+        sequential_ofstream ofs(path, ios_base::out);
+        ofs.write(expected.data(), expected.size());
+    }
+
+    for (aio_backend backend: {aio_backend_threads, aio_backend_default}) {
+        aio_engine engine(AIO_QUEUE_DEPTH, backend);
+        sequential_ifstream ifs(path, ios_base::in);
+        ifs.prefetch(&engine);
+
+        // sequential reads
+        std::string result(expected.size(), '\0');
+        ifs.read(&result[0], 1000);
+        EXPECT_EQ(ifs.tellg(), 1000);
+        ifs.read(&result[1000], result.size() - 1000);
+        EXPECT_EQ(result, expected);
+
+        // seeks discard the prefetched data
+        ifs.clear();
+        ifs.seekg(12345);
+        EXPECT_EQ(ifs.tellg(), 12345);
+        std::string line;
+        std::getline(ifs, line);
+        EXPECT_EQ(line, expected.substr(12345, expected.find('\n', 12345) - 12345));
+        ifs.seekg(-10, ios_base::end);
+        result.assign(20, '\0');
+        ifs.read(&result[0], 20);
+        EXPECT_EQ(ifs.gcount(), 10);
+
+        // disable prefetching mid-stream
+        ifs.clear();
+        ifs.seekg(100);
+        ifs.read(&result[0], 10);
+        ifs.prefetch(nullptr);
+        ifs.read(&result[10], 10);
+        EXPECT_EQ(result, expected.substr(100, 20));
+    }
+
+    EXPECT_TRUE(remove_file(path));
+}
+
 #include <warnings/pop.h>